@@ -0,0 +1,111 @@
+#include "DPCMConverter.h"
+#include "SimpleFile.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Usage: ft0cc-dpcm [-q <quality>] [-v <dB>] [-e greedy|lookahead|trellis] [-j <threads>] [-o <dir>] <file.wav>...
+//
+// Converts each wave file to a raw DPCM sample with the same name and the
+// extension .dmc, written next to the input or into the output directory.
+// Quality is the DPCM pitch from 0 to 15, defaulting to 15. The size and the
+// signal-to-noise ratio of each sample are printed, along with the ratio the
+// greedy encoder would give.
+
+int main(int argc, char *argv[]) try {
+	unsigned quality = CDPCMConverter::MAX_QUALITY;
+	int volume = 0;
+	dpcm_encoder_t encoder = dpcm_encoder_t::greedy;
+	unsigned threads = std::thread::hardware_concurrency();
+	fs::path outDir;
+	std::vector<fs::path> inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string_view arg = argv[i];
+		if (arg == "-q" && i + 1 < argc)
+			quality = std::stoul(argv[++i]);
+		else if (arg == "-v" && i + 1 < argc)
+			volume = std::stoi(argv[++i]);
+		else if (arg == "-e" && i + 1 < argc) {
+			std::string_view name = argv[++i];
+			if (name == "greedy")
+				encoder = dpcm_encoder_t::greedy;
+			else if (name == "lookahead")
+				encoder = dpcm_encoder_t::lookahead;
+			else if (name == "trellis")
+				encoder = dpcm_encoder_t::trellis;
+			else {
+				std::cerr << "Unknown encoder: " << name << '\n';
+				return 2;
+			}
+		}
+		else if (arg == "-j" && i + 1 < argc)
+			threads = std::stoul(argv[++i]);
+		else if (arg == "-o" && i + 1 < argc)
+			outDir = fs::u8path(argv[++i]);
+		else if (!arg.empty() && arg[0] == '-') {
+			std::cerr << "Unknown argument: " << arg << '\n';
+			return 2;
+		}
+		else
+			inputs.push_back(fs::u8path(arg));
+	}
+	if (inputs.empty() || quality > CDPCMConverter::MAX_QUALITY || volume < -CDPCMConverter::MAX_VOLUME || volume > CDPCMConverter::MAX_VOLUME) {
+		std::cerr << "Usage: ft0cc-dpcm [-q <0-15>] [-v <-12-12>] [-e greedy|lookahead|trellis] [-j <threads>] [-o <dir>] <file.wav>...\n";
+		return 2;
+	}
+
+	const CDPCMConverter converter {quality, volume, encoder};
+	const CDPCMConverter greedy {quality, volume};
+	std::atomic<std::size_t> next {0};
+	std::atomic<std::size_t> failed {0};
+	std::mutex lock;
+
+	const auto worker = [&] {
+		for (std::size_t i = next++; i < inputs.size(); i = next++) {
+			const fs::path &input = inputs[i];
+			fs::path output = (outDir.empty() ? input.parent_path() : outDir) / input.filename();
+			output.replace_extension(".dmc");
+			std::string message;
+			try {
+				const stPCMWave wave = CDPCMConverter::ReadWaveFile(input);
+				const std::vector<float> levels = converter.Resample(wave.Samples, wave.SampleRate);
+				std::vector<std::uint8_t> bytes = converter.Encode(levels);
+				const double snr = converter.GetSNR(levels, bytes);
+				const double greedySNR = encoder == dpcm_encoder_t::greedy ? snr : greedy.GetSNR(levels, greedy.Encode(levels));
+				auto pSample = CDPCMConverter::MakeSample(std::move(bytes));
+				CSimpleFile file {output, std::ios::out | std::ios::binary};
+				if (!file)
+					throw std::runtime_error("Could not open output file");
+				file.WriteBytes(array_view<unsigned char> {pSample->data(), pSample->size()});
+				char stats[64] = { };
+				std::snprintf(stats, std::size(stats), "%zu bytes, SNR %.2f dB (greedy %.2f dB)", pSample->size(), snr, greedySNR);
+				message = output.u8string() + ": " + stats;
+			}
+			catch (std::exception &e) {
+				++failed;
+				message = input.u8string() + ": " + e.what();
+			}
+			std::lock_guard<std::mutex> guard {lock};
+			std::cout << message << std::endl;
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned i = 1; i < std::min<std::size_t>(std::max(threads, 1u), inputs.size()); ++i)
+		pool.emplace_back(worker);
+	worker();
+	for (auto &th : pool)
+		th.join();
+
+	return failed ? 1 : 0;
+}
+catch (std::exception &e) {
+	std::cerr << "C++ exception: " << e.what() << '\n';
+	return 2;
+}
@@ -0,0 +1,128 @@
+#include "BatchExporter.h"
+#include "json/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+// Usage: ft0cc-export <manifest.json> [-j <threads>] [-l <log.jsonl>]
+//
+// The manifest is a JSON array of jobs:
+//   [{"input": "song.0cc", "output": "song.nsf"},
+//    {"input": "song.0cc", "format": "bin", "output": "music.bin", "dpcm": "samples.bin"}]
+// "format" defaults to the extension of "output". "import" lists modules whose
+// songs are appended to the input, sharing instruments and grooves that are
+// already present and adding the missing ones. Relative paths are
+// resolved against the directory of the manifest. One JSON object per job
+// is written to the log as each job finishes.
+
+namespace {
+
+// Set on Ctrl+C; jobs that have not started yet are skipped
+std::atomic_bool cancelled {false};
+
+void OnInterrupt(int) {
+	cancelled = true;
+}
+
+std::vector<stBatchExportJob> ReadManifest(const fs::path &fname) {
+	std::ifstream file {fname};
+	if (!file)
+		throw std::runtime_error("Could not open manifest: " + fname.u8string());
+
+	const fs::path dir = fname.parent_path();
+	const auto path = [&] (const nlohmann::json &j, const char *key) {
+		fs::path p = fs::u8path(j.at(key).get<std::string>());
+		return p.is_relative() ? dir / p : p;
+	};
+
+	std::vector<stBatchExportJob> jobs;
+	for (const auto &j : nlohmann::json::parse(file)) {
+		stBatchExportJob &job = jobs.emplace_back();
+		job.Input = path(j, "input");
+		job.Output = path(j, "output");
+		if (j.count("dpcm"))
+			job.DPCMOutput = path(j, "dpcm");
+		if (j.count("import"))
+			for (const auto &x : j["import"]) {
+				fs::path p = fs::u8path(x.get<std::string>());
+				job.Imports.push_back(p.is_relative() ? dir / p : p);
+			}
+		const std::pair<const char *, unsigned *> wavOptions[] = {
+			{"track", &job.Track}, {"loops", &job.Loops}, {"seconds", &job.Seconds},
+			{"rate", &job.SampleRate}, {"bits", &job.SampleSize},
+		};
+		for (auto [key, value] : wavOptions)
+			if (j.count(key))
+				*value = j[key].get<unsigned>();
+		if (j.count("format"))
+			job.Format = j["format"].get<std::string>();
+		else if (auto ext = job.Output.extension().u8string(); !ext.empty())
+			job.Format = ext.substr(1);
+		std::transform(job.Format.begin(), job.Format.end(), job.Format.begin(),
+			[] (unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	}
+	return jobs;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) try {
+	fs::path manifest, logName;
+	unsigned threads = std::thread::hardware_concurrency();
+
+	for (int i = 1; i < argc; ++i) {
+		std::string_view arg = argv[i];
+		if (arg == "-j" && i + 1 < argc)
+			threads = std::stoul(argv[++i]);
+		else if (arg == "-l" && i + 1 < argc)
+			logName = fs::u8path(argv[++i]);
+		else if (manifest.empty())
+			manifest = fs::u8path(arg);
+		else {
+			std::cerr << "Unknown argument: " << arg << '\n';
+			return 2;
+		}
+	}
+	if (manifest.empty()) {
+		std::cerr << "Usage: ft0cc-export <manifest.json> [-j <threads>] [-l <log.jsonl>]\n";
+		return 2;
+	}
+
+	std::ofstream logFile;
+	if (!logName.empty())
+		logFile.open(logName);
+	std::ostream &log = logName.empty() ? std::cout : logFile;
+
+	CBatchExporter exporter {ReadManifest(manifest)};
+	std::signal(SIGINT, OnInterrupt);
+	std::size_t failed = exporter.Run(threads, [&] (const stBatchExportJob &job, const stBatchExportResult &result) {
+		nlohmann::json j = {
+			{"job", result.Index},
+			{"input", job.Input.u8string()},
+			{"format", job.Format},
+			{"output", job.Output.u8string()},
+			{"status", result.Success ? "ok" : "error"},
+			{"seconds", result.Seconds},
+			{"log", result.Log},
+		};
+		if (!result.Success)
+			j["message"] = result.Message;
+		log << j.dump() << std::endl;
+	}, &cancelled);
+
+	if (cancelled) {
+		std::cerr << "Export cancelled\n";
+		return 130;
+	}
+	return failed ? 1 : 0;
+}
+catch (std::exception &e) {
+	std::cerr << "C++ exception: " << e.what() << '\n';
+	return 2;
+}
@@ -0,0 +1,229 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+#include "APU/ext/FDSSound_new.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// CFDS::Process skips the clocks reported by NES_FDS::GetQuietClocks instead of
+// rendering every 32-cycle step; these tests run the same loop directly on the
+// emulator and compare its output changes against the plain 32-cycle loop.
+
+namespace {
+
+constexpr std::uint32_t TIME_STEP = 32u;
+constexpr std::uint32_t FRAME_CYCLES = 29781u;
+
+struct write_t {
+	std::uint32_t time;
+	std::uint32_t addr;
+	std::uint32_t value;
+};
+
+struct event_t {
+	std::uint64_t time;
+	std::int32_t value;
+	bool operator==(const event_t &other) const {
+		return time == other.time && value == other.value;
+	}
+};
+
+// Runs a register write stream and records every change of the rendered output
+std::vector<event_t> Render(const std::vector<write_t> &writes, std::uint32_t frames, bool skipQuiet) {
+	xgm::NES_FDS emu;
+	emu.Reset();
+	std::vector<event_t> events;
+	std::int32_t last = 0;
+	std::uint64_t time = 0u;
+
+	const auto process = [&] (std::uint32_t clocks) {
+		while (clocks) {
+			if (skipQuiet) {
+				std::uint32_t quiet = std::min(emu.GetQuietClocks(), clocks);
+				if (quiet < clocks)
+					quiet -= quiet % TIME_STEP;
+				if (quiet) {
+					emu.Tick(quiet);
+					time += quiet;
+					clocks -= quiet;
+					continue;
+				}
+			}
+
+			const std::uint32_t t = std::min(clocks, TIME_STEP);
+			emu.Tick(t);
+			if (std::int32_t value = emu.Render(); value != last) {
+				events.push_back({time, value});
+				last = value;
+			}
+			time += t;
+			clocks -= t;
+		}
+	};
+
+	auto it = writes.begin();
+	for (std::uint32_t f = 0; f < frames; ++f) {
+		std::uint32_t now = 0u;
+		for (; it != writes.end() && it->time / FRAME_CYCLES == f; ++it) {
+			const std::uint32_t t = it->time % FRAME_CYCLES;
+			process(t - now);
+			now = t;
+			emu.Write(it->addr, it->value);
+		}
+		process(FRAME_CYCLES - now);
+	}
+
+	return events;
+}
+
+void WriteWave(std::vector<write_t> &writes, std::uint32_t time, const std::uint32_t (&wave)[64]) {
+	writes.push_back({time, 0x4089, 0x80});
+	for (std::uint32_t i = 0; i < 64; ++i)
+		writes.push_back({time + 1, 0x4040 + i, wave[i]});
+	writes.push_back({time + 2, 0x4089, 0x00});
+}
+
+// Random notes, halts, envelopes, master volume and modulation, one event per frame
+std::vector<write_t> RandomWrites(unsigned seed, std::uint32_t frames, bool modulation) {
+	std::mt19937 rng {seed};
+	std::vector<write_t> writes;
+
+	std::uint32_t wave[64];
+	for (auto &x : wave)
+		x = rng() % 64;
+	WriteWave(writes, 0, wave);
+
+	for (std::uint32_t f = 0; f < frames; ++f) {
+		const std::uint32_t t = f * FRAME_CYCLES + rng() % 2000;
+		switch (rng() % 10) {
+		case 0: // halt
+			writes.push_back({t, 0x4083, 0x80});
+			break;
+		case 1: case 2: // note, sometimes with envelopes halted
+			writes.push_back({t, 0x4082, rng() & 0xFF});
+			writes.push_back({t + 5, 0x4083, (rng() & 0x0F) | (rng() % 4 == 0 ? 0x40 : 0x00)});
+			break;
+		case 3: // direct volume
+			writes.push_back({t, 0x4080, 0x80 | rng() % 33});
+			break;
+		case 4: // volume envelope
+			writes.push_back({t, 0x4080, rng() & 0x7F});
+			break;
+		case 5:
+			if (modulation) {
+				writes.push_back({t, 0x4087, 0x80});
+				for (std::uint32_t i = 0; i < 32; ++i)
+					writes.push_back({t + 1 + i, 0x4088, rng() & 0x07});
+				writes.push_back({t + 40, 0x4086, rng() & 0xFF});
+				writes.push_back({t + 41, 0x4087, rng() & 0x03});
+				writes.push_back({t + 42, 0x4084, 0x80 | rng() % 20});
+			}
+			break;
+		case 6: // modulation off
+			writes.push_back({t, 0x4084, 0x80});
+			break;
+		case 7: // master volume
+			writes.push_back({t, 0x4089, rng() & 0x03});
+			break;
+		case 8: // envelope speed
+			writes.push_back({t, 0x408A, rng() & 0xFF});
+			break;
+		}
+	}
+
+	std::stable_sort(writes.begin(), writes.end(), [] (const write_t &a, const write_t &b) {
+		return a.time < b.time;
+	});
+	return writes;
+}
+
+// Sustained square-ish note held for half a second, then halted for half a second
+std::vector<write_t> SustainedWrites(std::uint32_t frames) {
+	std::vector<write_t> writes;
+
+	std::uint32_t wave[64];
+	for (std::uint32_t i = 0; i < 64; ++i)
+		wave[i] = i < 32 ? 63 : 0;
+	WriteWave(writes, 0, wave);
+
+	for (std::uint32_t f = 0; f < frames; ++f) {
+		const std::uint32_t t = f * FRAME_CYCLES + 100;
+		if (f % 60 == 0) {
+			writes.push_back({t, 0x4082, 0x40});
+			writes.push_back({t + 1, 0x4083, 0x02});
+			writes.push_back({t + 2, 0x4080, 0x80 | 32});
+		}
+		else if (f % 60 == 30)
+			writes.push_back({t, 0x4083, 0x80});
+	}
+
+	return writes;
+}
+
+} // namespace
+
+TEST(FDSSound, QuietClocksMatchReference) {
+	const std::uint32_t frames = 600u;
+	for (unsigned seed = 1; seed <= 40; ++seed) {
+		const auto writes = RandomWrites(seed, frames, seed % 3 == 0);
+		const auto expected = Render(writes, frames, false);
+		const auto actual = Render(writes, frames, true);
+		ASSERT_FALSE(expected.empty()) << "seed " << seed;
+		EXPECT_EQ(actual, expected) << "seed " << seed;
+	}
+}
+
+TEST(FDSSound, QuietClocksMatchReferenceSustained) {
+	const std::uint32_t frames = 600u;
+	const auto writes = SustainedWrites(frames);
+	EXPECT_EQ(Render(writes, frames, true), Render(writes, frames, false));
+}
+
+TEST(FDSSound, HaltedWaveIsQuiet) {
+	xgm::NES_FDS emu;
+	emu.Reset();
+	emu.Write(0x4083, 0x80);
+	emu.Tick(TIME_STEP * 64);
+	EXPECT_EQ(emu.GetQuietClocks(), UINT32_MAX);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(FDSSound, DISABLED_Throughput) {
+	const std::uint32_t frames = 3600u; // one minute
+	const auto writes = SustainedWrites(frames);
+
+	double ms[2] = { };
+	for (bool skipQuiet : {false, true}) {
+		const auto start = std::chrono::steady_clock::now();
+		Render(writes, frames, skipQuiet);
+		ms[skipQuiet] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::cout << "32-cycle steps: " << ms[0] << " ms, quiet skipping: " << ms[1] <<
+		" ms (" << ms[0] / ms[1] << "x) for " << frames / 60 << " s of audio\n";
+}
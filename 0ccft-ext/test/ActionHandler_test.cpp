@@ -0,0 +1,284 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+
+#include "ActionHandler.h"
+#include "Action.h"
+#include "PatternClipData.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "SongView.h"
+#include "PatternData.h"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Snapshot = std::vector<stChanNote>;
+
+class UndoHistoryTest : public ::testing::Test {
+protected:
+	// Edits a random selection in place; its undo state is a CPatternDelta, as in CPActionEditNote and friends
+	class CRandomEdit : public CAction {
+	public:
+		explicit CRandomEdit(UndoHistoryTest &test) : test_(test) {
+			auto &rng = test.rng;
+			const unsigned Channels = test.Channels.size();
+			t0_ = rng() % Channels;
+			t1_ = std::min(Channels - 1, t0_ + static_cast<unsigned>(rng() % 4));
+			f_ = rng() % test.Frames;
+			r_ = rng() % test.Rows;
+			rows_ = 1 + rng() % (rng() % 8 ? test.Rows : test.Rows * 3);
+			seed_ = rng();
+			density_ = 1 + rng() % 100;
+		}
+
+		std::size_t GetFootprint() const override {
+			return sizeof(*this) + clip_.GetFootprint() + (delta_ ? sizeof(CPatternDelta) + delta_->GetFootprint() : 0);
+		}
+
+		const CPatternDelta *GetDelta() const {
+			return delta_.get();
+		}
+
+	private:
+		bool SaveState(const CMainFrame &) override {
+			clip_ = CopyRaw();
+			return true;
+		}
+
+		void Undo(CMainFrame &) override {
+			delta_->Undo(*test_.View);
+		}
+
+		void Redo(CMainFrame &) override {
+			if (delta_)
+				return delta_->Redo(*test_.View);
+			std::mt19937 g {seed_};
+			const unsigned PackedPos = (f_ + test_.Frames) * test_.Rows + r_;
+			for (unsigned i = t0_; i <= t1_; ++i)
+				for (unsigned k = 0; k < rows_; ++k)
+					if (g() % 100 < density_) {
+						stChanNote Note;
+						Note.Note = static_cast<note_t>(g() % 13);
+						Note.Octave = g() % 8;
+						Note.Instrument = g() % 64;
+						Note.Vol = g() % 17;
+						if (g() % 2)
+							Note.Effects[0] = {effect_t::VOLUME, static_cast<std::uint8_t>(g())};
+						const unsigned Pos = PackedPos + k;
+						test_.View->GetPatternOnFrame(i, Pos / test_.Rows % test_.Frames).SetNoteOn(Pos % test_.Rows, Note);
+					}
+		}
+
+		void SaveUndoState(const CMainFrame &) override {
+		}
+
+		void SaveRedoState(const CMainFrame &) override {
+			delta_ = std::make_unique<CPatternDelta>(clip_, *test_.View, CCursorPos {static_cast<int>(r_), static_cast<int>(t0_), cursor_column_t::NOTE, static_cast<int>(f_)});
+			test_.ClipBytes += 2 * clip_.GetFootprint();
+			test_.DeltaBytes += delta_->GetFootprint();
+			clip_ = CPatternClipData { };
+		}
+
+		void RestoreUndoState(CMainFrame &) const override {
+		}
+
+		void RestoreRedoState(CMainFrame &) const override {
+		}
+
+		void UpdateViews(CMainFrame &) const override {
+		}
+
+		// Same as CPatternEditor::CopyRaw for a normalized, unwarped selection
+		CPatternClipData CopyRaw() const {
+			CPatternClipData Clip {static_cast<int>(t1_ - t0_ + 1), static_cast<int>(rows_)};
+			const unsigned PackedPos = (f_ + test_.Frames) * test_.Rows + r_;
+			for (unsigned i = 0; i <= t1_ - t0_; ++i)
+				for (unsigned k = 0; k < rows_; ++k) {
+					const unsigned Pos = PackedPos + k;
+					*Clip.GetPattern(i, k) = std::as_const(*test_.View).GetPatternOnFrame(i + t0_, Pos / test_.Rows % test_.Frames).GetNoteOn(Pos % test_.Rows);
+				}
+			return Clip;
+		}
+
+		UndoHistoryTest &test_;
+		unsigned t0_, t1_, f_, r_, rows_;
+		unsigned density_;
+		unsigned seed_;
+		CPatternClipData clip_;
+		std::unique_ptr<CPatternDelta> delta_;
+	};
+
+	static constexpr unsigned PATTERNS = 16;
+
+	UndoHistoryTest() {
+		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+		modfile.GetChannelOrder().ForeachChannel([&] (stChannelID Chan) {
+			Channels.push_back(Chan);
+		});
+	}
+
+	// Gives the song a random frame list over PATTERNS patterns per channel
+	void SetSize(unsigned frames, unsigned rows) {
+		Frames = frames;
+		Rows = rows;
+		auto &Song = *modfile.GetSong(0);
+		Song.SetFrameCount(Frames);
+		Song.SetPatternLength(Rows);
+		for (auto Chan : Channels)
+			for (unsigned f = 0; f < Frames; ++f)
+				Song.SetFramePattern(f, Chan, rng() % PATTERNS);
+		View = std::make_unique<CSongView>(modfile.GetChannelOrder(), Song, false);
+	}
+
+	Snapshot Take() const {
+		Snapshot s;
+		const auto &Song = *std::as_const(modfile).GetSong(0);
+		for (auto Chan : Channels)
+			for (unsigned p = 0; p < PATTERNS; ++p)
+				for (unsigned r = 0; r < Rows; ++r)
+					s.push_back(Song.GetPattern(Chan, p).GetNoteOn(r));
+		return s;
+	}
+
+	// The actions never touch the main frame, so the handler only needs a reference to pass along
+	CMainFrame &Frame() {
+		return reinterpret_cast<CMainFrame &>(*this);
+	}
+
+	std::mt19937 rng {4242};
+	CFamiTrackerModule modfile;
+	std::vector<stChannelID> Channels;
+	std::unique_ptr<CSongView> View;
+	unsigned Frames = 0;
+	unsigned Rows = 0;
+	std::size_t ClipBytes = 0;
+	std::size_t DeltaBytes = 0;
+};
+
+} // namespace
+
+TEST_F(UndoHistoryTest, RandomEditsRoundTrip) {
+	for (int i = 0; i < 8; ++i) {
+		SetSize(1 + rng() % 32, 1 + rng() % MAX_PATTERN_LENGTH);
+		CActionHandler Handler {64 + static_cast<unsigned>(rng() % 1000), static_cast<std::size_t>(1024 + rng() % 200000)};
+
+		std::vector<Snapshot> States {Take()};		// States[k] is the song after k actions
+		std::size_t Pos = 0;
+		for (int step = 0; step < 600; ++step) {
+			const unsigned op = rng() % 10;
+			if (op < 5) {
+				ASSERT_TRUE(Handler.AddAction(Frame(), std::make_unique<CRandomEdit>(*this)));
+				States.resize(++Pos);
+				States.push_back(Take());
+			}
+			else if (op < 8) {
+				if (Handler.CanUndo()) {
+					Handler.UndoLastAction(Frame());
+					--Pos;
+				}
+			}
+			else if (Handler.CanRedo()) {
+				Handler.RedoLastAction(Frame());
+				++Pos;
+			}
+			ASSERT_EQ(Take(), States[Pos]) << "iteration " << i << ", step " << step;
+
+			if (step % 50)
+				continue;
+			// unwind and replay the whole remaining history; evicted actions can no longer be undone
+			const bool Redoable = Handler.CanRedo();
+			unsigned Undoable = 0;
+			for (; Handler.CanUndo(); ++Undoable)
+				Handler.UndoLastAction(Frame());
+			ASSERT_LE(Undoable, Pos);
+			ASSERT_EQ(Take(), States[Pos - Undoable]) << "iteration " << i << ", step " << step;
+			for (unsigned k = 0; k < Undoable; ++k)
+				Handler.RedoLastAction(Frame());
+			ASSERT_EQ(Handler.CanRedo(), Redoable);
+			ASSERT_EQ(Take(), States[Pos]) << "iteration " << i << ", step " << step;
+		}
+	}
+}
+
+TEST_F(UndoHistoryTest, FootprintStaysWithinBudget) {
+	SetSize(16, 64);
+	const std::size_t Budget = 20000;
+	CActionHandler Handler {1000, Budget};
+
+	for (int step = 0; step < 2000; ++step) {
+		ASSERT_TRUE(Handler.AddAction(Frame(), std::make_unique<CRandomEdit>(*this)));
+		if (Handler.GetFootprint() <= Budget)
+			continue;
+		// only the newest action may exceed the budget on its own
+		Handler.UndoLastAction(Frame());
+		EXPECT_FALSE(Handler.CanUndo());
+		Handler.RedoLastAction(Frame());
+	}
+	EXPECT_TRUE(Handler.ActionsLost());
+}
+
+TEST_F(UndoHistoryTest, UndoLevelLimit) {
+	SetSize(4, 16);
+	CActionHandler Handler {8, static_cast<std::size_t>(-1)};
+
+	for (int step = 0; step < 8; ++step)
+		ASSERT_TRUE(Handler.AddAction(Frame(), std::make_unique<CRandomEdit>(*this)));
+	EXPECT_FALSE(Handler.ActionsLost());
+	ASSERT_TRUE(Handler.AddAction(Frame(), std::make_unique<CRandomEdit>(*this)));
+	EXPECT_TRUE(Handler.ActionsLost());
+
+	unsigned Undoable = 0;
+	for (; Handler.CanUndo(); ++Undoable)
+		Handler.UndoLastAction(Frame());
+	EXPECT_EQ(Undoable, 8u);
+}
+
+TEST_F(UndoHistoryTest, DeltaSmallerThanClips) {
+	SetSize(16, 128);
+	CActionHandler Handler {1000, static_cast<std::size_t>(-1)};
+
+	for (int step = 0; step < 500; ++step) {
+		const Snapshot Before = Take();
+		auto pAction = std::make_unique<CRandomEdit>(*this);
+		const auto &Action = *pAction;
+		ASSERT_TRUE(Handler.AddAction(Frame(), std::move(pAction)));
+
+		// the delta holds exactly the cells the edit changed
+		const Snapshot After = Take();
+		std::size_t Changed = 0;
+		for (std::size_t i = 0; i < Before.size(); ++i)
+			Changed += Before[i] != After[i];
+		ASSERT_NE(Action.GetDelta(), nullptr);
+		EXPECT_LE(Changed, Action.GetDelta()->GetCellCount());
+	}
+	EXPECT_LT(DeltaBytes, ClipBytes);
+}
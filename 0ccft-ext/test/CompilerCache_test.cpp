@@ -0,0 +1,153 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+#include "CompilerCache.h"
+#include "Compiler.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "Kraid.h"
+#include "SimpleFile.h"
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace {
+
+using bytes_t = std::vector<unsigned char>;
+
+const bytes_t CONTEXT_A = {1, 2, 3};
+const bytes_t CONTEXT_B = {1, 2, 4};
+const bytes_t INPUT_A = {0x10, 0x20};
+const bytes_t INPUT_B = {0x10, 0x21};
+const bytes_t DATA_A = {0xAA, 0xAB, 0xAC};
+const bytes_t DATA_B = {0xBB};
+
+class CompilerCacheTest : public ::testing::Test {
+protected:
+	~CompilerCacheTest() {
+		std::filesystem::remove(CachePath);
+	}
+
+	bytes_t Export(std::shared_ptr<CCompilerCache> pCache) const {
+		const auto Dir = std::filesystem::temp_directory_path();
+		const auto BinPath = Dir / "ft0cc-cache-test.bin";
+		const auto DPCMPath = Dir / "ft0cc-cache-test.dmc";
+		{
+			CSimpleFile BinFile(BinPath, std::ios::out | std::ios::binary);
+			CSimpleFile DPCMFile(DPCMPath, std::ios::out | std::ios::binary);
+			CCompiler Compiler(modfile, nullptr);
+			Compiler.SetCache(std::move(pCache));
+			Compiler.ExportBIN(BinFile, DPCMFile);
+		}
+		std::ifstream File(BinPath, std::ios::binary);
+		bytes_t Data {std::istreambuf_iterator<char> {File}, { }};
+		File.close();
+		std::filesystem::remove(BinPath);
+		std::filesystem::remove(DPCMPath);
+		return Data;
+	}
+
+	const std::filesystem::path CachePath = std::filesystem::temp_directory_path() / "ft0cc-cache-test.cache";
+	CFamiTrackerModule modfile;
+};
+
+} // namespace
+
+TEST_F(CompilerCacheTest, CollidingInputsMiss) {
+	CCompilerCache Cache {CachePath};
+	ASSERT_TRUE(Cache.AddContext(1u, CONTEXT_A));
+	Cache.Store(5u, 1u, INPUT_A, DATA_A);
+
+	EXPECT_EQ(Cache.Find(5u, 1u, INPUT_B), nullptr);
+	EXPECT_EQ(Cache.Peek(5u, 1u, INPUT_B), nullptr);
+	EXPECT_EQ(Cache.Find(5u, 2u, INPUT_A), nullptr);
+	EXPECT_EQ(Cache.GetMissCount(), 2u);
+
+	const auto *pData = Cache.Find(5u, 1u, INPUT_A);
+	ASSERT_NE(pData, nullptr);
+	EXPECT_EQ(*pData, DATA_A);
+	EXPECT_EQ(Cache.GetHitCount(), 1u);
+
+	// A colliding entry replaces the old one
+	Cache.Store(5u, 1u, INPUT_B, DATA_B);
+	EXPECT_EQ(Cache.Peek(5u, 1u, INPUT_A), nullptr);
+	ASSERT_NE(Cache.Peek(5u, 1u, INPUT_B), nullptr);
+	EXPECT_EQ(*Cache.Peek(5u, 1u, INPUT_B), DATA_B);
+}
+
+TEST_F(CompilerCacheTest, CollidingContextsAreRejected) {
+	CCompilerCache Cache {CachePath};
+	EXPECT_TRUE(Cache.CheckContext(1u, CONTEXT_B));
+	EXPECT_TRUE(Cache.AddContext(1u, CONTEXT_A));
+	EXPECT_TRUE(Cache.AddContext(1u, CONTEXT_A));
+	EXPECT_TRUE(Cache.CheckContext(1u, CONTEXT_A));
+	EXPECT_FALSE(Cache.AddContext(1u, CONTEXT_B));
+	EXPECT_FALSE(Cache.CheckContext(1u, CONTEXT_B));
+	EXPECT_TRUE(Cache.AddContext(2u, CONTEXT_B));
+}
+
+TEST_F(CompilerCacheTest, SaveAndLoad) {
+	{
+		CCompilerCache Cache {CachePath};
+		ASSERT_TRUE(Cache.AddContext(1u, CONTEXT_A));
+		Cache.Store(5u, 1u, INPUT_A, DATA_A);
+		Cache.Store(6u, 1u, INPUT_B, DATA_B);
+		Cache.Store(7u, 3u, INPUT_A, DATA_B);		// unknown context, not saved
+		ASSERT_TRUE(Cache.Save());
+	}
+
+	CCompilerCache Cache {CachePath};
+	ASSERT_TRUE(Cache.Load());
+	EXPECT_TRUE(Cache.CheckContext(1u, CONTEXT_A));
+	EXPECT_FALSE(Cache.CheckContext(1u, CONTEXT_B));
+	ASSERT_NE(Cache.Peek(5u, 1u, INPUT_A), nullptr);
+	EXPECT_EQ(*Cache.Peek(5u, 1u, INPUT_A), DATA_A);
+	EXPECT_EQ(Cache.Peek(5u, 1u, INPUT_B), nullptr);
+	ASSERT_NE(Cache.Peek(6u, 1u, INPUT_B), nullptr);
+	EXPECT_EQ(*Cache.Peek(6u, 1u, INPUT_B), DATA_B);
+	EXPECT_EQ(Cache.Peek(7u, 3u, INPUT_A), nullptr);
+}
+
+TEST_F(CompilerCacheTest, ReusesPatterns) {
+	modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	Kraid { }(modfile);
+
+	const bytes_t Expected = Export(nullptr);
+	ASSERT_FALSE(Expected.empty());
+
+	auto pCache = std::make_shared<CCompilerCache>(CachePath);
+	EXPECT_EQ(Export(pCache), Expected);
+	EXPECT_GT(pCache->GetMissCount(), 0u);
+	EXPECT_EQ(pCache->GetHitCount(), 0u);
+	ASSERT_TRUE(pCache->Save());
+
+	auto pReloaded = std::make_shared<CCompilerCache>(CachePath);
+	ASSERT_TRUE(pReloaded->Load());
+	EXPECT_EQ(Export(pReloaded), Expected);
+	EXPECT_EQ(pReloaded->GetMissCount(), 0u);
+	EXPECT_GT(pReloaded->GetHitCount(), 0u);
+}
@@ -0,0 +1,301 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+
+
+#include "Compiler.h"
+#include "CompilerCache.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "SoundChipSet.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SimpleFile.h"
+#include "SongData.h"
+#include "PatternData.h"
+#include "PatternNote.h"
+#include "DSampleManager.h"
+#include "InstrumentManager.h"
+#include "Instrument2A03.h"
+#include "InstrumentVRC7.h"
+#include "InstrumentFDS.h"
+#include "InstrumentN163.h"
+#include "Sequence.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include "ft0cc/doc/groove.hpp"
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <memory>
+#include <random>
+
+namespace {
+
+// Instrument slots used by each chip's channels
+constexpr unsigned INST_2A03_FIRST = 0, INST_VRC6_FIRST = 4, INST_VRC7_FIRST = 6, INST_FDS_FIRST = 8,
+	INST_N163_FIRST = 12, INST_S5B_FIRST = 16, INST_DPCM = 18, INST_FDS_UNUSED = 20;
+
+class CompilerEstimateTest : public ::testing::Test {
+protected:
+	unsigned Random(unsigned n) {
+		return rng() % n;
+	}
+
+	void FillSequence(CSequence &Seq) {
+		const unsigned Count = 1 + Random(20);
+		Seq.SetItemCount(Count);
+		for (unsigned i = 0; i < Count; ++i)
+			Seq.SetItem(i, Random(16));
+		if (Random(2))
+			Seq.SetLoopPoint(Random(Count));
+	}
+
+	// Sequence instruments pick from a few shared sequence slots so some are reused
+	void AddSeqInstrument(inst_type_t Type, unsigned Index) {
+		auto &Im = *pModule->GetInstrumentManager();
+		Im.InsertInstrument(Index, Im.CreateNew(Type));
+		auto pInst = std::dynamic_pointer_cast<CSeqInstrument>(Im.GetInstrument(Index));
+		for (auto i : enum_values<sequence_t>())
+			if (Random(3)) {
+				const unsigned SeqIndex = Random(3);
+				pInst->SetSeqEnable(i, true);
+				pInst->SetSeqIndex(i, SeqIndex);
+				if (auto pSeq = Im.GetSequence(Type, i, SeqIndex); pSeq->GetItemCount() == 0)
+					FillSequence(*pSeq);
+			}
+	}
+
+	void AddFDSInstrument(unsigned Index) {
+		auto &Im = *pModule->GetInstrumentManager();
+		Im.InsertInstrument(Index, Im.CreateNew(INST_FDS));
+		auto pInst = std::dynamic_pointer_cast<CInstrumentFDS>(Im.GetInstrument(Index));
+		for (int i = 0; i < 64; ++i)
+			pInst->SetSample(i, Random(64));
+		for (auto i : enum_values<sequence_t>())
+			if (auto pSeq = pInst->GetSequence(i); pSeq && Random(2)) {
+				pInst->SetSeqEnable(i, true);
+				FillSequence(*pSeq);
+			}
+	}
+
+	// The first two N163 instruments share their waves
+	void AddN163Instrument(unsigned Index) {
+		AddSeqInstrument(INST_N163, Index);
+		auto pInst = std::dynamic_pointer_cast<CInstrumentN163>(pModule->GetInstrumentManager()->GetInstrument(Index));
+		pInst->SetWaveSize(4 * (1 + Random(8)));
+		pInst->SetWaveCount(1 + Random(4));
+		if (Index >= INST_N163_FIRST + 2)
+			pInst->SetSample(0, 0, 1 + Random(15));
+	}
+
+	void AddVRC7Instrument(unsigned Index) {
+		auto &Im = *pModule->GetInstrumentManager();
+		Im.InsertInstrument(Index, Im.CreateNew(INST_VRC7));
+		auto pInst = std::dynamic_pointer_cast<CInstrumentVRC7>(Im.GetInstrument(Index));
+		pInst->SetPatch(Random(2) ? 0 : 1 + Random(15));
+		for (int i = 0; i < 8; ++i)
+			pInst->SetCustomReg(i, Random(256));
+	}
+
+	void AddDPCMInstrument() {
+		auto &Im = *pModule->GetInstrumentManager();
+		Im.InsertInstrument(INST_DPCM, Im.CreateNew(INST_2A03));
+		auto pInst = std::dynamic_pointer_cast<CInstrument2A03>(Im.GetInstrument(INST_DPCM));
+		for (unsigned i = 0; i < 6; ++i) {
+			std::vector<std::uint8_t> Data(16 * (1 + Random(20)) + Random(2));
+			pModule->GetDSampleManager()->SetDSample(i, std::make_shared<ft0cc::doc::dpcm_sample>(std::move(Data), "sample"));
+			pInst->SetSampleIndex(24 + i * 2, i);
+			pInst->SetSamplePitch(24 + i * 2, Random(16));
+		}
+	}
+
+	unsigned PickInstrument(stChannelID Chan) {
+		if (Chan == stChannelID {apu_subindex_t::dpcm})
+			return INST_DPCM;
+		switch (Chan.Chip) {
+		case sound_chip_t::VRC6: return INST_VRC6_FIRST + Random(2);
+		case sound_chip_t::VRC7: return INST_VRC7_FIRST + Random(2);
+		case sound_chip_t::FDS:  return INST_FDS_FIRST + Random(4);
+		case sound_chip_t::N163: return INST_N163_FIRST + Random(4);
+		case sound_chip_t::S5B:  return INST_S5B_FIRST + Random(2);
+		default:                 return INST_2A03_FIRST + Random(4);
+		}
+	}
+
+	void FillSong(CSongData &Song, unsigned Patterns) {
+		Song.SetFrameCount(1 + Random(12));
+		Song.SetPatternLength(16 + Random(48));
+		pModule->GetChannelOrder().ForeachChannel([&] (stChannelID Chan) {
+			Song.SetEffectColumnCount(Chan, Random(3));
+			for (unsigned p = 0; p < Patterns; ++p)
+				for (unsigned r = 0; r < Song.GetPatternLength(); ++r) {
+					if (Random(4))
+						continue;
+					stChanNote Note;
+					Note.Note = enum_cast<note_t>(1 + Random(12));
+					Note.Octave = Chan == stChannelID {apu_subindex_t::dpcm} ? 2 : Random(8);
+					Note.Instrument = PickInstrument(Chan);
+					if (Random(3) == 0)
+						Note.Vol = Random(16);
+					if (Random(4) == 0)
+						Note.Effects[0] = {effect_t::VOLUME_SLIDE, static_cast<std::uint8_t>(Random(256))};
+					Song.GetPattern(Chan, p).SetNoteOn(r, Note);
+				}
+			for (unsigned f = 0; f < Song.GetFrameCount(); ++f)
+				Song.SetFramePattern(f, Chan, Random(Patterns));
+		});
+	}
+
+	void MakeModule(CSoundChipSet Chips, unsigned Seed) {
+		rng.seed(Seed);
+		pModule = std::make_unique<CFamiTrackerModule>();
+		pModule->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(Chips, Chips.ContainsChip(sound_chip_t::N163) ? 4 : 0));
+
+		for (unsigned i = 0; i < 4; ++i) {
+			AddSeqInstrument(INST_2A03, INST_2A03_FIRST + i);
+			AddFDSInstrument(INST_FDS_FIRST + i);
+			AddN163Instrument(INST_N163_FIRST + i);
+		}
+		for (unsigned i = 0; i < 2; ++i) {
+			AddSeqInstrument(INST_VRC6, INST_VRC6_FIRST + i);
+			AddVRC7Instrument(INST_VRC7_FIRST + i);
+			AddSeqInstrument(INST_S5B, INST_S5B_FIRST + i);
+		}
+		AddFDSInstrument(INST_FDS_UNUSED);
+		AddDPCMInstrument();
+
+		for (unsigned i = 0; i < 3; ++i)
+			if (Random(2))
+				pModule->SetGroove(i * 2, std::make_shared<ft0cc::doc::groove>(std::initializer_list<std::uint8_t> {6, 5, 4}));
+
+		FillSong(*pModule->GetSong(0), 6);
+		auto pSong = pModule->MakeNewSong();
+		FillSong(*pSong, 3);
+		pSong->SetSongGroove(true);
+		pSong->SetSongSpeed(2);
+		pModule->InsertSong(1, std::move(pSong));
+	}
+
+	// Music data and DPCM sizes of a real binary export
+	std::pair<std::uintmax_t, std::uintmax_t> ExportSize() const {
+		const auto Dir = std::filesystem::temp_directory_path();
+		const auto BinPath = Dir / "ft0cc-estimate.bin";
+		const auto DPCMPath = Dir / "ft0cc-estimate.dmc";
+		{
+			CSimpleFile BinFile(BinPath, std::ios::out | std::ios::binary);
+			CSimpleFile DPCMFile(DPCMPath, std::ios::out | std::ios::binary);
+			CCompiler(*pModule, nullptr).ExportBIN(BinFile, DPCMFile);
+		}
+		std::pair Sizes {std::filesystem::file_size(BinPath), std::filesystem::file_size(DPCMPath)};
+		std::filesystem::remove(BinPath);
+		std::filesystem::remove(DPCMPath);
+		return Sizes;
+	}
+
+	std::unique_ptr<CFamiTrackerModule> pModule;
+	std::mt19937 rng;
+};
+
+const CSoundChipSet CHIP_SETS[] = {
+	sound_chip_t::APU,
+	CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::VRC6),
+	CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::VRC7),
+	CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::FDS),
+	CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::N163),
+	CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::S5B),
+	CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::VRC6).WithChip(sound_chip_t::VRC7).WithChip(sound_chip_t::FDS)
+		.WithChip(sound_chip_t::MMC5).WithChip(sound_chip_t::N163).WithChip(sound_chip_t::S5B),
+};
+
+} // namespace
+
+TEST_F(CompilerEstimateTest, MatchesBinaryExport) {
+	for (std::size_t c = 0; c < std::size(CHIP_SETS); ++c)
+		for (unsigned Seed = 0; Seed < 4; ++Seed) {
+			SCOPED_TRACE(::testing::Message() << "chip set " << c << ", seed " << Seed);
+			MakeModule(CHIP_SETS[c], Seed);
+
+			const stExportSizeInfo Info = CCompiler(*pModule, nullptr).EstimateSize();
+			const auto [MusicSize, DPCMSize] = ExportSize();
+			ASSERT_GT(MusicSize, 0u);
+			EXPECT_EQ(Info.GetMusicDataSize(), MusicSize);
+			EXPECT_EQ(Info.SampleSize, DPCMSize);
+		}
+}
+
+TEST_F(CompilerEstimateTest, BreakdownsAddUp) {
+	MakeModule(CHIP_SETS[std::size(CHIP_SETS) - 1], 1);
+	const stExportSizeInfo Info = CCompiler(*pModule, nullptr).EstimateSize();
+
+	ASSERT_EQ(Info.Songs.size(), pModule->GetSongCount());
+	for (const auto &Song : Info.Songs) {
+		unsigned ChannelTotal = 0;
+		for (const auto &[Chan, Size] : Song.ChannelSize)
+			ChannelTotal += Size;
+		EXPECT_EQ(ChannelTotal, Song.PatternSize);
+	}
+
+	// Every stored instrument byte belongs to exactly one instrument, except for the
+	// sequences of the FDS instrument no pattern uses
+	unsigned UnusedSequences = 0;
+	auto pUnused = std::dynamic_pointer_cast<CInstrumentFDS>(pModule->GetInstrumentManager()->GetInstrument(INST_FDS_UNUSED));
+	for (auto i : enum_values<sequence_t>())
+		if (auto pSeq = pUnused->GetSequence(i); pSeq && pSeq->GetItemCount() > 0)
+			UnusedSequences += pSeq->GetItemCount() + 4;
+
+	unsigned InstrumentTotal = 0;
+	for (const auto &[Index, Size] : Info.Instruments) {
+		EXPECT_NE(Index, INST_FDS_UNUSED);
+		EXPECT_GT(Size, 0u);
+		InstrumentTotal += Size;
+	}
+	EXPECT_EQ(InstrumentTotal + UnusedSequences, Info.InstrumentSize + Info.SequenceSize);
+}
+
+TEST_F(CompilerEstimateTest, LeavesCacheUntouched) {
+	MakeModule(CHIP_SETS[3], 2);
+	const auto CachePath = std::filesystem::temp_directory_path() / "ft0cc-estimate.cache";
+	auto pCache = std::make_shared<CCompilerCache>(CachePath);
+	CCompiler Compiler(*pModule, nullptr);
+	Compiler.SetCache(pCache);
+
+	const unsigned Before = Compiler.EstimateSize().GetMusicDataSize();
+	EXPECT_EQ(pCache->GetHitCount() + pCache->GetMissCount(), 0u);
+	const auto [MusicSize, DPCMSize] = ExportSize();
+	EXPECT_EQ(Before, MusicSize);
+
+	// Estimates from a warm cache agree with a cold one
+	{
+		CSimpleFile File(std::filesystem::temp_directory_path() / "ft0cc-estimate.nsf", std::ios::out | std::ios::binary);
+		CCompiler Exporter(*pModule, nullptr);
+		Exporter.SetCache(pCache);
+		Exporter.ExportNSF(File, 0);
+	}
+	const unsigned Hits = pCache->GetHitCount(), Misses = pCache->GetMissCount();
+	EXPECT_EQ(Compiler.EstimateSize().GetMusicDataSize(), Before);
+	EXPECT_EQ(pCache->GetHitCount(), Hits);
+	EXPECT_EQ(pCache->GetMissCount(), Misses);
+
+	std::filesystem::remove(std::filesystem::temp_directory_path() / "ft0cc-estimate.nsf");
+	std::filesystem::remove(CachePath);
+}
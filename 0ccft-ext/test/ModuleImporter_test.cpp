@@ -0,0 +1,143 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+
+#include "ModuleImporter.h"
+#include "RunParallel.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "InstrumentManager.h"
+#include "Instrument.h"
+#include "SongData.h"
+#include "PatternData.h"
+#include "PatternNote.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <string_view>
+
+namespace {
+
+class ModuleImporterTest : public ::testing::Test {
+protected:
+	ModuleImporterTest() {
+		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+		imported.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	}
+
+	static void AddInstrument(CFamiTrackerModule &Module, unsigned Index, std::string_view Name) {
+		auto *pManager = Module.GetInstrumentManager();
+		auto pInst = pManager->CreateNew(INST_2A03);
+		pInst->SetName(Name);
+		pManager->InsertInstrument(Index, std::move(pInst));
+	}
+
+	static CPatternData &FirstPattern(CFamiTrackerModule &Module, unsigned Track) {
+		return Module.GetSong(Track)->GetPattern(stChannelID {apu_subindex_t::pulse1}, 0);
+	}
+
+	CFamiTrackerModule modfile;
+	CFamiTrackerModule imported;
+};
+
+} // namespace
+
+TEST(RunParallel, RunsEveryCall) {
+	std::atomic<unsigned> Calls {0u};
+	EXPECT_TRUE(RunParallel(1000, 4, [&] (std::size_t) { ++Calls; }));
+	EXPECT_EQ(Calls, 1000u);
+}
+
+TEST(RunParallel, StopsWhenCancelled) {
+	std::atomic_bool Cancel {false};
+	unsigned Calls = 0;
+	EXPECT_FALSE(RunParallel(1000, 1, [&] (std::size_t i) {
+		++Calls;
+		if (i == 10)
+			Cancel = true;
+	}, &Cancel));
+	EXPECT_EQ(Calls, 11u);
+
+	// a flag set after the last call does not count as cancelling
+	Cancel = false;
+	EXPECT_TRUE(RunParallel(4, 1, [&] (std::size_t i) {
+		if (i == 3)
+			Cancel = true;
+	}, &Cancel));
+}
+
+TEST_F(ModuleImporterTest, ImportMissingSharesInstruments) {
+	AddInstrument(modfile, 0, "shared");
+	AddInstrument(imported, 1, "shared");
+	AddInstrument(imported, 2, "new");
+	stChanNote Note;
+	Note.Note = note_t::C;
+	Note.Instrument = 1;
+	FirstPattern(imported, 0).SetNoteOn(0, Note);
+	Note.Instrument = 2;
+	FirstPattern(imported, 0).SetNoteOn(1, Note);
+
+	CModuleImporter Importer {modfile, imported, import_mode_t::import_missing, import_mode_t::import_missing};
+	ASSERT_EQ(Importer.Validate(), import_error_t::none);
+	ASSERT_TRUE(Importer.DoImport(false));
+
+	ASSERT_EQ(modfile.GetSongCount(), 2u);
+	EXPECT_EQ(modfile.GetInstrumentManager()->GetInstrumentCount(), 2u);
+	EXPECT_FALSE(modfile.GetInstrumentManager()->HasInstrument(1));
+	EXPECT_EQ(FirstPattern(modfile, 1).GetNoteOn(0).Instrument, 0u);
+	EXPECT_EQ(FirstPattern(modfile, 1).GetNoteOn(1).Instrument, 2u);
+}
+
+TEST_F(ModuleImporterTest, HashHitsCompareContents) {
+	AddInstrument(modfile, 0, "shared");
+	AddInstrument(imported, 0, "shared");
+	AddInstrument(imported, 1, "sharee");
+	auto *pManager = modfile.GetInstrumentManager();
+	auto *pImported = imported.GetInstrumentManager();
+	EXPECT_TRUE(pManager->GetInstrument(0)->HasSameContent(*pImported->GetInstrument(0)));
+	EXPECT_FALSE(pManager->GetInstrument(0)->HasSameContent(*pImported->GetInstrument(1)));
+
+	CModuleImporter Importer {modfile, imported, import_mode_t::import_missing, import_mode_t::import_missing};
+	ASSERT_TRUE(Importer.DoImport(false));
+	EXPECT_EQ(pManager->GetInstrumentCount(), 2u);
+	EXPECT_EQ(pManager->GetInstrument(1)->GetName(), "sharee");
+}
+
+TEST_F(ModuleImporterTest, CancelLeavesTargetUnchanged) {
+	AddInstrument(imported, 0, "first");
+	AddInstrument(imported, 1, "second");
+	AddInstrument(modfile, 0, "existing");
+	stChanNote Note;
+	Note.Note = note_t::C;
+	Note.Instrument = 1;
+	FirstPattern(imported, 0).SetNoteOn(0, Note);
+
+	std::atomic_bool Cancel {true};
+	CModuleImporter Importer {modfile, imported, import_mode_t::duplicate_all, import_mode_t::none, 1, &Cancel};
+	ASSERT_EQ(Importer.Validate(), import_error_t::none);
+	EXPECT_FALSE(Importer.DoImport(false));
+	EXPECT_EQ(modfile.GetSongCount(), 1u);
+	EXPECT_EQ(modfile.GetInstrumentManager()->GetInstrumentCount(), 1u);
+}
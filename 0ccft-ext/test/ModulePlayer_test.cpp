@@ -0,0 +1,129 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+#include "ModulePlayer.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "Kraid.h"
+#include "AudioSink.h"
+#include "WaveRenderer.h"
+#include "WaveRendererFactory.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+constexpr unsigned RATE = 44100;
+
+// Keeps every rendered sample
+class CCaptureAudioSink final : public CAudioSink {
+public:
+	CCaptureAudioSink(std::vector<float> &Samples, unsigned PeriodFrames) :
+		samples_(Samples), buffer_(PeriodFrames)
+	{
+	}
+
+	bool Pump(IAudioSource &Source) override {
+		if (!Source.RenderAudio(buffer_.data(), buffer_.size()))
+			return false;
+		samples_.insert(samples_.end(), buffer_.begin(), buffer_.end());
+		return true;
+	}
+
+	unsigned GetSampleRate() const override { return RATE; }
+	unsigned GetSampleSize() const override { return 32; }
+	unsigned GetPeriodFrames() const override { return static_cast<unsigned>(buffer_.size()); }
+	unsigned GetLatencyFrames() const override { return 0; }
+
+private:
+	std::vector<float> &samples_;
+	std::vector<float> buffer_;
+};
+
+class ModulePlayerTest : public ::testing::Test {
+protected:
+	ModulePlayerTest() {
+		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+		Kraid { }(modfile);
+	}
+
+	std::vector<float> Render(render_type_t Type, unsigned Param, unsigned PeriodFrames, const std::atomic_bool *pCancel = nullptr) {
+		std::vector<float> Samples;
+		auto pRenderer = CWaveRendererFactory::Make(modfile, 0, Type, Param);
+		CModulePlayer Player {modfile, RATE};
+		Result = Player.Render(0, *pRenderer, std::make_unique<CCaptureAudioSink>(Samples, PeriodFrames), pCancel);
+		return Samples;
+	}
+
+	CFamiTrackerModule modfile;
+	bool Result = false;
+};
+
+} // namespace
+
+TEST_F(ModulePlayerTest, RendersRequestedLength) {
+	const unsigned Seconds = 2;
+	const auto Samples = Render(render_type_t::Seconds, Seconds, 256);
+	ASSERT_TRUE(Result);
+	// the renderer lets the last notes ring for a few frames, and the sink pads the last period
+	EXPECT_GE(Samples.size(), Seconds * RATE);
+	EXPECT_LE(Samples.size(), Seconds * RATE + RATE / 4);
+
+	bool Silent = true;
+	for (float x : Samples)
+		if (x != 0.f)
+			Silent = false;
+	EXPECT_FALSE(Silent);
+}
+
+TEST_F(ModulePlayerTest, OutputDoesNotDependOnPeriod) {
+	const auto Expected = Render(render_type_t::Seconds, 1, 256);
+	ASSERT_TRUE(Result);
+	for (unsigned Period : {1u, 100u, 441u, 4096u}) {
+		const auto Samples = Render(render_type_t::Seconds, 1, Period);
+		ASSERT_TRUE(Result);
+		// only the padding of the last period may differ
+		const std::size_t Common = std::min(Samples.size(), Expected.size()) - std::max(Period, 256u);
+		for (std::size_t i = 0; i < Common; ++i)
+			ASSERT_EQ(Samples[i], Expected[i]) << "period " << Period << ", sample " << i;
+	}
+}
+
+TEST_F(ModulePlayerTest, StopsAfterLoops) {
+	const auto Once = Render(render_type_t::Loops, 1, 512);
+	ASSERT_TRUE(Result);
+	const auto Twice = Render(render_type_t::Loops, 2, 512);
+	ASSERT_TRUE(Result);
+	EXPECT_GT(Once.size(), 0u);
+	EXPECT_GT(Twice.size(), Once.size());
+}
+
+TEST_F(ModulePlayerTest, Cancel) {
+	const std::atomic_bool Cancel {true};
+	const auto Samples = Render(render_type_t::Seconds, 60, 256, &Cancel);
+	EXPECT_FALSE(Result);
+	EXPECT_LT(Samples.size(), RATE);
+}
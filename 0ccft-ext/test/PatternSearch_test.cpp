@@ -0,0 +1,401 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+
+
+#include "PatternSearch.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "TrackData.h"
+#include "PatternData.h"
+#include "PatternNote.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using ft0cc::doc::is_note;
+using ft0cc::doc::midi_note;
+
+// The cell comparison of the find dialog before the matcher was introduced, with the effect
+// column and negation passed in instead of read from the dialog controls
+bool CompareFields(const searchTerm &Term, int EffColumn, bool Negate, const stChanNote &Target, bool Noise, int EffCount) {
+	if (EffColumn > EffCount && EffColumn != MAX_EFFECT_COLUMNS)
+		EffColumn = EffCount;
+	bool EffectMatch = false;
+	const auto &Note = *Term.Note;
+	const auto &Oct = *Term.Oct;
+	bool Melodic = is_note(Note.Min) && is_note(Note.Max) && Term.Definite[WC_OCT];
+
+	if (Term.Definite[WC_NOTE]) {
+		if (Term.NoiseChan) {
+			if (!Noise && Melodic)
+				return false;
+			if (!is_note(Note.Min) || !is_note(Note.Max)) {
+				if (!Note.IsMatch(Target.Note))
+					return Negate;
+			}
+			else {
+				int NoiseNote = Target.ToMidiNote() % 16;
+				int Low = midi_note(Oct.Min, Note.Min) % 16;
+				int High = midi_note(Oct.Max, Note.Max) % 16;
+				if ((NoiseNote < Low && NoiseNote < High) || (NoiseNote > Low && NoiseNote > High))
+					return Negate;
+			}
+		}
+		else {
+			if (Noise && Melodic)
+				return false;
+			if (Melodic) {
+				if (!is_note(Target.Note))
+					return Negate;
+				int NoteValue = Target.ToMidiNote();
+				int Low = midi_note(Oct.Min, Note.Min);
+				int High = midi_note(Oct.Max, Note.Max);
+				if ((NoteValue < Low && NoteValue < High) || (NoteValue > Low && NoteValue > High))
+					return Negate;
+			}
+			else {
+				if (!Note.IsMatch(Target.Note))
+					return Negate;
+				if (Term.Definite[WC_OCT] && !Oct.IsMatch(Target.Octave))
+					return Negate;
+			}
+		}
+	}
+	if (Term.Definite[WC_INST] && !Term.Inst->IsMatch(Target.Instrument))
+		return Negate;
+	if (Term.Definite[WC_VOL] && !Term.Vol->IsMatch(Target.Vol))
+		return Negate;
+
+	int Limit = MAX_EFFECT_COLUMNS - 1;
+	if (EffCount < Limit)
+		Limit = EffCount;
+	if (EffColumn < Limit)
+		Limit = EffColumn;
+	for (int i = EffColumn % MAX_EFFECT_COLUMNS; i <= Limit; ++i)
+		if ((!Term.Definite[WC_EFF] || Term.EffNumber[value_cast(Target.Effects[i].fx)]) &&
+			(!Term.Definite[WC_PARAM] || Term.EffParam->IsMatch(Target.Effects[i].param)))
+			EffectMatch = true;
+	if (!EffectMatch)
+		return Negate;
+
+	return !Negate;
+}
+
+// Values are drawn from small ranges so that both outcomes are common
+class PatternMatcherTest : public ::testing::Test {
+protected:
+	note_t RandomNote() {
+		return enum_cast<note_t>(rng() % (value_cast(note_t::echo) + 1));
+	}
+
+	effect_t RandomEffect() {
+		return enum_cast<effect_t>(rng() % 6);
+	}
+
+	stChanNote MakeCell() {
+		stChanNote Cell;
+		Cell.Note = RandomNote();
+		Cell.Octave = rng() % 8;
+		Cell.Instrument = rng() % 4 ? rng() % 4 : MAX_INSTRUMENTS;
+		Cell.Vol = rng() % 4 ? rng() % 4 : MAX_VOLUME;
+		for (auto &Cmd : Cell.Effects)
+			if (rng() % 2) {
+				Cmd.fx = RandomEffect();
+				Cmd.param = rng() % 8;
+			}
+		return Cell;
+	}
+
+	searchTerm MakeTerm() {
+		searchTerm Term;
+		for (auto &x : Term.Definite)
+			x = rng() % 3 == 0;
+		Term.NoiseChan = rng() % 2;
+		*Term.Note = NoteRange {RandomNote(), rng() % 2 ? RandomNote() : note_t::none};
+		if (rng() % 2)
+			Term.Note->Max = Term.Note->Min;
+		*Term.Oct = CharRange(rng() % 8, rng() % 8);
+		*Term.Inst = CharRange(rng() % 4, rng() % 4);
+		*Term.Vol = CharRange(rng() % 4, rng() % 4);
+		*Term.EffParam = CharRange(rng() % 8, rng() % 8);
+		for (int i = 0; i < 6; ++i)
+			Term.EffNumber[i] = rng() % 2;
+		return Term;
+	}
+
+	std::mt19937 rng {41};
+};
+
+} // namespace
+
+TEST_F(PatternMatcherTest, AgreesWithCompareFields) {
+	unsigned Matches = 0, Cells = 0;
+	for (int i = 0; i < 2000; ++i) {
+		const searchTerm Term = MakeTerm();
+		const unsigned EffColumn = rng() % 2 ? CPatternMatcher::ANY_COLUMN : rng() % MAX_EFFECT_COLUMNS;
+		const bool Negate = rng() % 2;
+		const CPatternMatcher Matcher {Term, EffColumn, Negate};
+		for (int j = 0; j < 100; ++j) {
+			const stChanNote Cell = MakeCell();
+			const bool Noise = rng() % 2;
+			const unsigned EffCount = 1 + rng() % MAX_EFFECT_COLUMNS;
+			const bool Expected = CompareFields(Term, EffColumn, Negate, Cell, Noise, EffCount);
+			ASSERT_EQ(Matcher.IsMatch(Cell, Noise, EffCount), Expected) << "term " << i << ", cell " << j;
+			Matches += Expected;
+			++Cells;
+		}
+	}
+	EXPECT_GT(Matches, Cells / 10);
+	EXPECT_LT(Matches, Cells - Cells / 10);
+}
+
+TEST(PatternMatcher, NoiseNotes) {
+	searchTerm Term;
+	Term.Definite[WC_NOTE] = Term.Definite[WC_OCT] = true;
+	Term.NoiseChan = true;
+	*Term.Note = NoteRange {note_t::D, note_t::F};
+	*Term.Oct = CharRange(0, 0);
+	const CPatternMatcher Matcher {Term};
+
+	stChanNote Cell;
+	Cell.Note = note_t::E;
+	Cell.Octave = 3;		// noise pitches repeat every 16 semitones
+	EXPECT_FALSE(Matcher.IsMatch(Cell, true, 1));
+	Cell.Octave = 4;
+	EXPECT_TRUE(Matcher.IsMatch(Cell, true, 1));
+	EXPECT_EQ(Matcher.IsMatch(Cell, true, 1), CompareFields(Term, MAX_EFFECT_COLUMNS, false, Cell, true, 1));
+	EXPECT_FALSE(Matcher.IsMatch(Cell, false, 1));		// melodic noise terms skip other channels
+
+	Term.NoiseChan = false;
+	const CPatternMatcher Melodic {Term};
+	EXPECT_FALSE(Melodic.IsMatch(Cell, true, 1));		// and vice versa
+}
+
+TEST(PatternMatcher, MelodicRanges) {
+	searchTerm Term;
+	Term.Definite[WC_NOTE] = Term.Definite[WC_OCT] = true;
+	*Term.Note = NoteRange {note_t::A, note_t::D};
+	*Term.Oct = CharRange(2, 3);		// A-2 to D-3, spanning an octave boundary
+	const CPatternMatcher Matcher {Term};
+	const CPatternMatcher Negated {Term, CPatternMatcher::ANY_COLUMN, true};
+
+	for (int Octave = 0; Octave < 8; ++Octave)
+		for (int n = value_cast(note_t::C); n <= value_cast(note_t::B); ++n) {
+			stChanNote Cell;
+			Cell.Note = enum_cast<note_t>(n);
+			Cell.Octave = Octave;
+			const bool Inside = Cell.ToMidiNote() >= midi_note(2, note_t::A) && Cell.ToMidiNote() <= midi_note(3, note_t::D);
+			EXPECT_EQ(Matcher.IsMatch(Cell, false, 1), Inside) << Octave << ' ' << n;
+			EXPECT_EQ(Negated.IsMatch(Cell, false, 1), !Inside) << Octave << ' ' << n;
+		}
+
+	stChanNote Halt;
+	Halt.Note = note_t::halt;
+	EXPECT_FALSE(Matcher.IsMatch(Halt, false, 1));
+	EXPECT_TRUE(Negated.IsMatch(Halt, false, 1));
+}
+
+TEST(PatternMatcher, EffectColumns) {
+	searchTerm Term;
+	Term.Definite[WC_EFF] = true;
+	Term.EffNumber[value_cast(effect_t::VIBRATO)] = true;
+
+	stChanNote Cell;
+	Cell.Effects[2] = {effect_t::VIBRATO, 0x34};
+
+	const CPatternMatcher Any {Term};
+	EXPECT_TRUE(Any.IsMatch(Cell, false, 4));
+	EXPECT_FALSE(Any.IsMatch(Cell, false, 1));		// the column is hidden
+	const CPatternMatcher Third {Term, 2};
+	EXPECT_TRUE(Third.IsMatch(Cell, false, 4));
+	const CPatternMatcher First {Term, 0};
+	EXPECT_FALSE(First.IsMatch(Cell, false, 4));
+	const CPatternMatcher NotFirst {Term, 0, true};
+	EXPECT_TRUE(NotFirst.IsMatch(Cell, false, 4));
+
+	for (unsigned EffColumn : {0u, 1u, 2u, 3u, CPatternMatcher::ANY_COLUMN})
+		for (unsigned EffCount = 1; EffCount <= MAX_EFFECT_COLUMNS; ++EffCount)
+			for (bool Negate : {false, true})
+				EXPECT_EQ(CPatternMatcher(Term, EffColumn, Negate).IsMatch(Cell, false, EffCount),
+					CompareFields(Term, EffColumn, Negate, Cell, false, EffCount)) << EffColumn << ' ' << EffCount << ' ' << Negate;
+}
+
+
+
+namespace {
+
+// Compares usage queries against a walk over every cell of the song
+class PatternUsageIndexTest : public ::testing::Test {
+protected:
+	static constexpr unsigned PATTERNS = 8;
+	static constexpr unsigned INSTRUMENTS = 4;
+	static constexpr effect_t EFFECTS[] = {effect_t::ARPEGGIO, effect_t::VIBRATO, effect_t::VOLUME};
+
+	PatternUsageIndexTest() {
+		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+		modfile.GetChannelOrder().ForeachChannel([&] (stChannelID Chan) {
+			Channels.push_back(Chan);
+		});
+	}
+
+	stChanNote MakeCell() {
+		stChanNote Cell;
+		if (rng() % 2)
+			Cell.Instrument = rng() % INSTRUMENTS;
+		for (auto &Cmd : Cell.Effects)
+			if (rng() % 3 == 0)
+				Cmd.fx = EFFECTS[rng() % std::size(EFFECTS)];
+		return Cell;
+	}
+
+	void MakeSong(CSongData &song, unsigned Frames) {
+		song.SetFrameCount(Frames);
+		for (auto Chan : Channels) {
+			song.SetEffectColumnCount(Chan, 1 + rng() % MAX_EFFECT_COLUMNS);
+			for (unsigned f = 0; f < Frames; ++f)
+				song.SetFramePattern(f, Chan, rng() % PATTERNS);
+		}
+		for (int i = 0; i < 200; ++i)
+			Edit(song);
+	}
+
+	void Edit(CSongData &song) {
+		const auto Chan = Channels[rng() % Channels.size()];
+		const unsigned Frame = rng() % song.GetFrameCount();
+		switch (rng() % 8) {
+		case 0:
+			song.SetFramePattern(Frame, Chan, rng() % PATTERNS);
+			break;
+		case 1:
+			song.SetEffectColumnCount(Chan, 1 + rng() % MAX_EFFECT_COLUMNS);
+			break;
+		default:
+			song.GetPatternOnFrame(Chan, Frame).SetNoteOn(rng() % song.GetPatternLength(), rng() % 4 ? MakeCell() : stChanNote { });
+		}
+	}
+
+	template <typename F>
+	std::vector<stPatternMatch> FindAll(const CSongData &song, F f) const {
+		std::vector<stPatternMatch> Matches;
+		for (unsigned Frame = 0; Frame < song.GetFrameCount(); ++Frame)
+			for (unsigned Row = 0; Row < song.GetPatternLength(); ++Row)
+				for (auto Chan : Channels) {
+					const unsigned Pattern = song.GetFramePattern(Frame, Chan);
+					if (f(song.GetPattern(Chan, Pattern).GetNoteOn(Row), song.GetEffectColumnCount(Chan)))
+						Matches.push_back({0u, Frame, Row, Chan, Pattern});
+				}
+		return Matches;
+	}
+
+	void ExpectSameMatches(const std::vector<stPatternMatch> &Actual, const std::vector<stPatternMatch> &Expected) const {
+		ASSERT_EQ(Actual.size(), Expected.size());
+		for (std::size_t i = 0; i < Actual.size(); ++i) {
+			const auto &x = Actual[i];
+			const auto &y = Expected[i];
+			ASSERT_EQ(std::tie(x.Track, x.Frame, x.Row, x.Pattern), std::tie(y.Track, y.Frame, y.Row, y.Pattern)) << "match " << i;
+			ASSERT_EQ(x.Channel, y.Channel) << "match " << i;
+		}
+	}
+
+	void ExpectSameUsage(const CSongData &song) {
+		auto &Index = song.GetUsageIndex();
+		const CChannelOrder &Order = modfile.GetChannelOrder();
+		for (unsigned Inst = 0; Inst < INSTRUMENTS; ++Inst)
+			ExpectSameMatches(Index.FindInstrument(song, Order, Inst), FindAll(song, [&] (const stChanNote &Cell, unsigned) {
+				return Cell.Instrument == Inst;
+			}));
+		for (effect_t fx : EFFECTS)
+			ExpectSameMatches(Index.FindEffect(song, Order, fx), FindAll(song, [&] (const stChanNote &Cell, unsigned EffCount) {
+				for (unsigned i = 0; i < EffCount; ++i)
+					if (Cell.Effects[i].fx == fx)
+						return true;
+				return false;
+			}));
+	}
+
+	std::mt19937 rng {43};
+	CFamiTrackerModule modfile;
+	std::vector<stChannelID> Channels;
+};
+
+} // namespace
+
+TEST_F(PatternUsageIndexTest, FollowsEdits) {
+	CSongData Song {32};
+	MakeSong(Song, 16);
+	for (int i = 0; i < 300; ++i) {
+		for (int j = 0, n = rng() % 4; j < n; ++j)
+			Edit(Song);
+		if (i % 50 == 49)
+			Song.SetPatternLength(8 + rng() % 25);
+		ExpectSameUsage(Song);
+		if (HasFatalFailure())
+			FAIL() << "after " << i << " edits";
+	}
+}
+
+TEST_F(PatternUsageIndexTest, DropsStalePatterns) {
+	CSongData Song {16};
+	Song.SetFrameCount(2);
+	const auto Chan = Channels[0];
+	const CChannelOrder &Order = modfile.GetChannelOrder();
+	auto &Index = Song.GetUsageIndex();
+
+	stChanNote Cell;
+	Cell.Instrument = 5;
+	Song.GetPattern(Chan, 1).SetNoteOn(3, Cell);
+	EXPECT_TRUE(Index.FindInstrument(Song, Order, 5).empty());		// not on any frame yet
+
+	Song.SetFramePattern(1, Chan, 1);
+	ASSERT_EQ(Index.FindInstrument(Song, Order, 5).size(), 1u);
+
+	Song.GetPattern(Chan, 1).SetNoteOn(3, stChanNote { });		// overwritten
+	EXPECT_TRUE(Index.FindInstrument(Song, Order, 5).empty());
+
+	Song.GetPattern(Chan, 1).SetNoteOn(3, Cell);
+	ASSERT_EQ(Index.FindInstrument(Song, Order, 5).size(), 1u);
+	Song.SetFramePattern(1, Chan, 0);		// no longer used
+	EXPECT_TRUE(Index.FindInstrument(Song, Order, 5).empty());
+}
+
+TEST_F(PatternUsageIndexTest, CopiesShareTheIndex) {
+	CSongData Song {32};
+	MakeSong(Song, 8);
+	CSongData Edited {Song};
+	ASSERT_EQ(&Song.GetUsageIndex(), &Edited.GetUsageIndex());
+	for (int i = 0; i < 100; ++i) {
+		Edit(Edited);
+		ExpectSameUsage(Edited);
+		ExpectSameUsage(Song);		// its patterns were dropped by the previous query
+		if (HasFatalFailure())
+			FAIL() << "after " << i << " edits";
+	}
+}
@@ -0,0 +1,189 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+#include "SPSCRing.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct block_t {
+	std::uint64_t seq = 0u;
+	std::vector<std::int16_t> samples;
+};
+
+constexpr std::size_t BLOCK_SIZE = 800u;
+
+void FillBlock(block_t &block, std::uint64_t seq) {
+	block.seq = seq;
+	block.samples.resize(BLOCK_SIZE);
+	for (std::size_t i = 0; i < BLOCK_SIZE; ++i)
+		block.samples[i] = static_cast<std::int16_t>(seq * 31u + i);
+}
+
+bool CheckBlock(const block_t &block) {
+	if (block.samples.size() != BLOCK_SIZE)
+		return false;
+	for (std::size_t i = 0; i < BLOCK_SIZE; ++i)
+		if (block.samples[i] != static_cast<std::int16_t>(block.seq * 31u + i))
+			return false;
+	return true;
+}
+
+} // namespace
+
+TEST(SPSCRing, EmptyAndFull) {
+	CSPSCRing<int, 4> ring;
+	EXPECT_EQ(ring.BeginRead(), nullptr);
+
+	for (int i = 0; i < 4; ++i) {
+		int *p = ring.BeginWrite();
+		ASSERT_NE(p, nullptr);
+		*p = i;
+		ring.EndWrite();
+	}
+	EXPECT_EQ(ring.BeginWrite(), nullptr);
+
+	for (int i = 0; i < 4; ++i) {
+		const int *p = ring.BeginRead();
+		ASSERT_NE(p, nullptr);
+		EXPECT_EQ(*p, i);
+		ring.EndRead();
+	}
+	EXPECT_EQ(ring.BeginRead(), nullptr);
+	EXPECT_NE(ring.BeginWrite(), nullptr);
+}
+
+TEST(SPSCRing, DeliversInOrderAcrossThreads) {
+	// The producer never waits and drops blocks while the ring is full; every block that
+	// arrives must be complete and newer than the previous one
+	const std::uint64_t BLOCKS = 200000u;
+	CSPSCRing<block_t, 4> ring;
+	std::atomic<bool> done {false};
+	std::uint64_t received = 0u;
+	std::uint64_t outOfOrder = 0u;
+	std::uint64_t corrupt = 0u;
+
+	std::thread consumer([&] {
+		std::uint64_t next = 0u;
+		const auto drain = [&] {
+			while (block_t *p = ring.BeginRead()) {
+				if (p->seq < next)
+					++outOfOrder;
+				if (!CheckBlock(*p))
+					++corrupt;
+				next = p->seq + 1;
+				++received;
+				ring.EndRead();
+			}
+		};
+		while (!done.load(std::memory_order_acquire))
+			drain();
+		drain();
+	});
+
+	std::uint64_t dropped = 0u;
+	for (std::uint64_t i = 0; i < BLOCKS; ++i)
+		if (block_t *p = ring.BeginWrite()) {
+			FillBlock(*p, i);
+			ring.EndWrite();
+		}
+		else
+			++dropped;
+
+	done.store(true, std::memory_order_release);
+	consumer.join();
+
+	EXPECT_GT(received, 0u);
+	EXPECT_EQ(outOfOrder, 0u);
+	EXPECT_EQ(corrupt, 0u);
+	EXPECT_EQ(received + dropped, BLOCKS);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(SPSCRing, DISABLED_ProducerLatency) {
+	// Time spent by the producer handing over one block, against a mutex-guarded buffer
+	// whose consumer holds the lock while copying
+	using clock = std::chrono::steady_clock;
+	const int BLOCKS = 200000;
+	std::vector<std::int16_t> source(BLOCK_SIZE, 3);
+
+	const auto measure = [&] (auto &&handOver) {
+		double total = 0., worst = 0.;
+		for (int i = 0; i < BLOCKS; ++i) {
+			const auto start = clock::now();
+			handOver();
+			const double us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+			total += us;
+			worst = std::max(worst, us);
+		}
+		return std::make_pair(total / BLOCKS, worst);
+	};
+
+	std::atomic<bool> done {false};
+
+	CSPSCRing<std::vector<std::int16_t>, 4> ring;
+	std::thread ringConsumer([&] {
+		std::vector<std::int16_t> mine;
+		while (!done.load(std::memory_order_acquire))
+			if (auto *p = ring.BeginRead()) {
+				p->swap(mine);
+				ring.EndRead();
+			}
+	});
+	const auto [ringAvg, ringWorst] = measure([&] {
+		if (auto *p = ring.BeginWrite()) {
+			p->assign(source.begin(), source.end());
+			ring.EndWrite();
+		}
+	});
+	done.store(true, std::memory_order_release);
+	ringConsumer.join();
+
+	done.store(false);
+	std::mutex lock;
+	std::vector<std::int16_t> shared;
+	std::thread mutexConsumer([&] {
+		std::vector<std::int16_t> mine;
+		while (!done.load(std::memory_order_acquire)) {
+			std::lock_guard<std::mutex> guard {lock};
+			mine = shared;
+		}
+	});
+	const auto [mutexAvg, mutexWorst] = measure([&] {
+		std::lock_guard<std::mutex> guard {lock};
+		shared.assign(source.begin(), source.end());
+	});
+	done.store(true, std::memory_order_release);
+	mutexConsumer.join();
+
+	std::cout << "ring: avg " << ringAvg << " us, worst " << ringWorst << " us\n";
+	std::cout << "mutex: avg " << mutexAvg << " us, worst " << mutexWorst << " us\n";
+}
@@ -0,0 +1,197 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+
+#include "SongDirtyRows.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "PatternData.h"
+#include "PatternNote.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Checks the ranges against one flag per row: sorted, neither overlapping nor touching
+void ExpectSameRows(const CSongDirtyRows &Dirty, const std::vector<std::vector<bool>> &Expected) {
+	const auto &Ranges = Dirty.GetRanges();
+	for (std::size_t i = 0; i < Ranges.size(); ++i) {
+		ASSERT_LT(Ranges[i].FirstRow, Ranges[i].EndRow);
+		if (i > 0) {
+			const auto &Prev = Ranges[i - 1];
+			ASSERT_TRUE(Prev.Frame < Ranges[i].Frame || Prev.EndRow < Ranges[i].FirstRow) << "range " << i;
+		}
+	}
+	for (unsigned f = 0; f < Expected.size(); ++f)
+		for (unsigned r = 0; r < Expected[f].size(); ++r)
+			ASSERT_EQ(Dirty.IsDirty(f, r, r + 1), Expected[f][r]) << "frame " << f << ", row " << r;
+}
+
+class SongDirtyRowsTest : public ::testing::Test {
+protected:
+	static constexpr unsigned PATTERNS = 8;
+
+	SongDirtyRowsTest() {
+		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+		modfile.GetChannelOrder().ForeachChannel([&] (stChannelID Chan) {
+			Channels.push_back(Chan);
+		});
+	}
+
+	stChanNote MakeNote() {
+		stChanNote Note;
+		Note.Note = enum_cast<note_t>(1 + rng() % 12);
+		Note.Octave = rng() % 8;
+		Note.Instrument = rng() % 4;
+		return Note;
+	}
+
+	void MakeSong(CSongData &song, unsigned Frames, unsigned Rows) {
+		song.SetFrameCount(Frames);
+		song.SetPatternLength(Rows);
+		for (auto Chan : Channels)
+			for (unsigned f = 0; f < Frames; ++f) {
+				song.SetFramePattern(f, Chan, rng() % PATTERNS);
+				song.GetPatternOnFrame(Chan, f).SetNoteOn(rng() % Rows, MakeNote());
+			}
+	}
+
+	std::vector<std::vector<bool>> CompareRows(const CSongData &x, const CSongData &y) const {
+		std::vector<std::vector<bool>> Rows(y.GetFrameCount(), std::vector<bool>(y.GetPatternLength()));
+		for (auto Chan : Channels)
+			for (unsigned f = 0; f < y.GetFrameCount(); ++f)
+				for (unsigned r = 0; r < y.GetPatternLength(); ++r)
+					if (x.GetPatternOnFrame(Chan, f).GetNoteOn(r) != y.GetPatternOnFrame(Chan, f).GetNoteOn(r))
+						Rows[f][r] = true;
+		return Rows;
+	}
+
+	std::mt19937 rng {99};
+	CFamiTrackerModule modfile;
+	std::vector<stChannelID> Channels;
+};
+
+} // namespace
+
+TEST(SongDirtyRows, MarkRowsJoinsRanges) {
+	CSongDirtyRows Dirty;
+	EXPECT_TRUE(Dirty.IsClean());
+	Dirty.MarkRows(1, 2, 4);
+	Dirty.MarkRows(1, 6, 8);
+	Dirty.MarkRows(0, 6, 8);
+	Dirty.MarkRows(1, 3, 3);		// empty
+	ASSERT_EQ(Dirty.GetRanges().size(), 3u);
+	EXPECT_TRUE(Dirty.IsDirty(1, 0, 3));
+	EXPECT_FALSE(Dirty.IsDirty(1, 4, 6));
+	EXPECT_FALSE(Dirty.IsDirty(2, 0, 8));
+
+	Dirty.MarkRows(1, 4, 6);		// touches both ranges of frame 1
+	ASSERT_EQ(Dirty.GetRanges().size(), 2u);
+	EXPECT_EQ(Dirty.GetRanges()[1].FirstRow, 2u);
+	EXPECT_EQ(Dirty.GetRanges()[1].EndRow, 8u);
+
+	CSongDirtyRows Other;
+	Other.MarkRows(2, 0, 1);
+	Dirty.Merge(Other);
+	EXPECT_TRUE(Dirty.IsDirty(2, 0, 8));
+	EXPECT_FALSE(Dirty.IsAllDirty());
+
+	Other.MarkAll();
+	Dirty.Merge(Other);
+	EXPECT_TRUE(Dirty.IsAllDirty());
+	EXPECT_TRUE(Dirty.GetRanges().empty());
+	EXPECT_TRUE(Dirty.IsDirty(5, 0, 1));
+	Dirty.MarkRows(0, 0, 1);
+	EXPECT_TRUE(Dirty.GetRanges().empty());
+}
+
+TEST(SongDirtyRows, RandomMarks) {
+	std::mt19937 rng {7};
+	for (int i = 0; i < 200; ++i) {
+		const unsigned Frames = 1 + rng() % 8;
+		const unsigned Rows = 1 + rng() % 64;
+		std::vector<std::vector<bool>> Expected(Frames, std::vector<bool>(Rows));
+		CSongDirtyRows Dirty, Merged;
+		for (int j = 0, n = rng() % 20; j < n; ++j) {
+			const unsigned f = rng() % Frames;
+			const unsigned First = rng() % Rows;
+			const unsigned End = First + rng() % (Rows - First + 1);
+			for (unsigned r = First; r < End; ++r)
+				Expected[f][r] = true;
+			(rng() % 2 ? Dirty : Merged).MarkRows(f, First, End);
+		}
+		Dirty.Merge(Merged);
+		ExpectSameRows(Dirty, Expected);
+	}
+}
+
+TEST_F(SongDirtyRowsTest, CompareFindsEditedRows) {
+	for (int i = 0; i < 50; ++i) {
+		CSongData Song {1 + static_cast<unsigned>(rng() % 128)};
+		MakeSong(Song, 1 + rng() % 64, Song.GetPatternLength());
+		CSongData Edited {Song};		// shares the patterns until they are written
+		for (int j = 0, n = rng() % 8; j < n; ++j) {
+			const auto Chan = Channels[rng() % Channels.size()];
+			const unsigned Frame = rng() % Edited.GetFrameCount();
+			const unsigned Row = rng() % Edited.GetPatternLength();
+			switch (rng() % 4) {
+			case 0:
+				Edited.SetFramePattern(Frame, Chan, rng() % PATTERNS);
+				break;
+			case 1:		// writes the same row back
+				Edited.GetPatternOnFrame(Chan, Frame).SetNoteOn(Row, std::as_const(Edited).GetPatternOnFrame(Chan, Frame).GetNoteOn(Row));
+				break;
+			default:
+				Edited.GetPatternOnFrame(Chan, Frame).SetNoteOn(Row, rng() % 4 ? MakeNote() : stChanNote { });
+			}
+		}
+
+		const CSongDirtyRows Dirty = CSongDirtyRows::Compare(Song, Edited);
+		ASSERT_FALSE(Dirty.IsAllDirty());
+		ExpectSameRows(Dirty, CompareRows(Song, Edited));
+		EXPECT_TRUE(CSongDirtyRows::Compare(Edited, Edited).IsClean());
+	}
+}
+
+TEST_F(SongDirtyRowsTest, LayoutChangesMarkEverything) {
+	CSongData Song {16};
+	MakeSong(Song, 4, 16);
+
+	CSongData Frames {Song};
+	Frames.SetFrameCount(5);
+	EXPECT_TRUE(CSongDirtyRows::Compare(Song, Frames).IsAllDirty());
+
+	CSongData Rows {Song};
+	Rows.SetPatternLength(8);
+	EXPECT_TRUE(CSongDirtyRows::Compare(Song, Rows).IsAllDirty());
+
+	CSongData Columns {Song};
+	Columns.SetEffectColumnCount(Channels[0], Song.GetEffectColumnCount(Channels[0]) + 1);
+	EXPECT_TRUE(CSongDirtyRows::Compare(Song, Columns).IsAllDirty());
+}
@@ -0,0 +1,385 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+#include "SongLengthScanner.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "SongView.h"
+#include "TrackData.h"
+#include "PatternNote.h"
+#include "ft0cc/doc/groove.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <memory>
+#include <random>
+
+namespace {
+
+// The row-by-row scanner that CSongLengthIndex replaced, kept as the reference
+class loop_visitor {
+public:
+	explicit loop_visitor(const CConstSongView &view) :
+		song_view_(view.GetChannelOrder().Canonicalize(), view.GetSong(), false)
+	{
+	}
+
+	template <typename F, typename G>
+	void Visit(F cb, G fx) {
+		const unsigned FrameCount = song_view_.GetSong().GetFrameCount();
+		const unsigned Rows = song_view_.GetSong().GetPatternLength();
+		auto RowVisited = std::make_unique<std::bitset<MAX_PATTERN_LENGTH>[]>(MAX_FRAMES);
+
+		while (!RowVisited[f_][r_]) {
+			RowVisited[f_][r_] = true;
+			int Bxx = -1;
+			int Dxx = -1;
+			bool Cxx = false;
+			song_view_.ForeachTrack([&] (const CTrackData &track) {
+				const auto &Note = track.GetPatternOnFrame(f_).GetNoteOn(r_);
+				for (unsigned l = 0, m = track.GetEffectColumnCount(); l < m; ++l)
+					switch (Note.Effects[l].fx) {
+					case effect_t::JUMP: Bxx = Note.Effects[l].param; break;
+					case effect_t::SKIP: Dxx = Note.Effects[l].param; break;
+					case effect_t::HALT: Cxx = true; break;
+					default: fx(Note.Effects[l]);
+					}
+			});
+
+			if (Cxx && !first_)
+				break;
+			cb();
+			if (Cxx)
+				break;
+
+			if (Bxx != -1) {
+				f_ = std::min(static_cast<unsigned>(Bxx), FrameCount - 1);
+				r_ = 0;
+			}
+			else if (Dxx != -1) {
+				if (++f_ >= FrameCount)
+					f_ = 0;
+				r_ = std::min(static_cast<unsigned>(Dxx), Rows - 1);
+			}
+			else if (++r_ >= Rows) {
+				r_ = 0;
+				if (++f_ >= FrameCount)
+					f_ = 0;
+			}
+		}
+
+		first_ = false;
+	}
+
+private:
+	CConstSongView song_view_;
+	unsigned f_ = 0;
+	unsigned r_ = 0;
+	bool first_ = true;
+};
+
+CSongLengthIndex::stSongLength ReferenceLength(const CFamiTrackerModule &modfile, const CConstSongView &view) {
+	const auto &song = view.GetSong();
+	double Tempo = song.GetSongTempo();
+	if (!Tempo)
+		Tempo = 2.5 * modfile.GetFrameRate();
+	const bool AllowTempo = song.GetSongTempo() != 0;
+	const int Split = modfile.GetSpeedSplitPoint();
+	int Speed = song.GetSongSpeed();
+	int GrooveIndex = song.GetSongGroove() ? Speed : -1;
+	int GroovePointer = 0;
+	if (GrooveIndex != -1 && !modfile.HasGroove(Speed)) {
+		GrooveIndex = -1;
+		Speed = DEFAULT_SPEED;
+	}
+
+	const auto fxhandler = [&] (stEffectCommand cmd) {
+		switch (cmd.fx) {
+		case effect_t::SPEED:
+			if (AllowTempo && cmd.param >= Split)
+				Tempo = cmd.param;
+			else {
+				GrooveIndex = -1;
+				Speed = cmd.param;
+			}
+			break;
+		case effect_t::GROOVE:
+			if (modfile.HasGroove(cmd.param)) {
+				GrooveIndex = cmd.param;
+				GroovePointer = 0;
+			}
+			break;
+		default:
+			break;
+		}
+	};
+
+	unsigned Rows[2] = { };
+	double Seconds[2] = { };
+	loop_visitor visitor {view};
+	for (int i = 0; i < 2; ++i)
+		visitor.Visit([&] {
+			if (auto pGroove = modfile.GetGroove(GrooveIndex))
+				Speed = pGroove->entry(GroovePointer++);
+			Seconds[i] += Speed / Tempo;
+			++Rows[i];
+		}, fxhandler);
+
+	CSongLengthIndex::stSongLength Length;
+	Length.IntroRows = Rows[0] - Rows[1];
+	Length.LoopRows = Rows[1];
+	Length.IntroSeconds = (Seconds[0] - Seconds[1]) * 2.5;
+	Length.LoopSeconds = Seconds[1] * 2.5;
+	return Length;
+}
+
+class SongLengthScannerTest : public ::testing::Test {
+protected:
+	SongLengthScannerTest() {
+		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+		SetSize(4, 16);
+	}
+
+	CSongData &Song() {
+		return *modfile.GetSong(0);
+	}
+
+	// Gives every frame its own pattern
+	void SetSize(unsigned Frames, unsigned Rows) {
+		Song().SetFrameCount(Frames);
+		Song().SetPatternLength(Rows);
+		modfile.GetChannelOrder().ForeachChannel([&] (stChannelID Chan) {
+			Song().SetEffectColumnCount(Chan, MAX_EFFECT_COLUMNS - 1);
+			for (unsigned f = 0; f < Frames; ++f)
+				Song().SetFramePattern(f, Chan, f);
+		});
+	}
+
+	void SetEffect(stChannelID Chan, unsigned Frame, unsigned Row, unsigned Column, effect_t fx, unsigned char param) {
+		auto &Pattern = Song().GetPatternOnFrame(Chan, Frame);
+		stChanNote Note = Pattern.GetNoteOn(Row);
+		Note.Effects[Column] = {fx, param};
+		Pattern.SetNoteOn(Row, Note);
+	}
+
+	void SetGroove(unsigned Index, std::initializer_list<std::uint8_t> Entries) {
+		modfile.SetGroove(Index, std::make_shared<ft0cc::doc::groove>(Entries));
+	}
+
+	// Scans the song and checks the result against the reference scanner
+	CSongLengthIndex::stSongLength Scan() {
+		CConstSongView View {modfile.GetChannelOrder(), Song(), false};
+		const auto Expected = ReferenceLength(modfile, View);
+
+		CSongLengthScanner Scanner {modfile, View};
+		const auto [IntroRows, LoopRows] = Scanner.GetRowCount();
+		const auto [IntroSeconds, LoopSeconds] = Scanner.GetSecondsCount();
+		EXPECT_EQ(IntroRows, Expected.IntroRows);
+		EXPECT_EQ(LoopRows, Expected.LoopRows);
+		EXPECT_NEAR(IntroSeconds, Expected.IntroSeconds, 1e-9 * std::max(1., Expected.IntroSeconds));
+		EXPECT_NEAR(LoopSeconds, Expected.LoopSeconds, 1e-9 * std::max(1., Expected.LoopSeconds));
+
+		return {IntroRows, LoopRows, IntroSeconds, LoopSeconds};
+	}
+
+	CFamiTrackerModule modfile;
+};
+
+const stChannelID PULSE1 = apu_subindex_t::pulse1;
+const stChannelID PULSE2 = apu_subindex_t::pulse2;
+const stChannelID TRIANGLE = apu_subindex_t::triangle;
+const stChannelID NOISE = apu_subindex_t::noise;
+
+} // namespace
+
+TEST_F(SongLengthScannerTest, NoControlFlow) {
+	const auto Length = Scan();
+	EXPECT_EQ(Length.IntroRows, 0u);
+	EXPECT_EQ(Length.LoopRows, 64u);
+}
+
+TEST_F(SongLengthScannerTest, JumpBeyondLastFrame) {
+	// Bxx past the end goes to the last frame
+	SetEffect(PULSE1, 1, 3, 0, effect_t::JUMP, 0x20);
+	SetEffect(PULSE2, 3, 7, 0, effect_t::JUMP, 0x02);
+	const auto Length = Scan();
+	EXPECT_EQ(Length.IntroRows, 20u);
+	EXPECT_EQ(Length.LoopRows, 24u);
+}
+
+TEST_F(SongLengthScannerTest, SkipBeyondLastRow) {
+	// Dxx past the end goes to the last row of the next frame, also when wrapping around
+	SetEffect(TRIANGLE, 0, 5, 0, effect_t::SKIP, 0x40);
+	SetEffect(TRIANGLE, 3, 2, 1, effect_t::SKIP, 0xFF);
+	Scan();
+
+	SetSize(1, 8);
+	SetEffect(NOISE, 0, 0, 0, effect_t::SKIP, 0x10);
+	Scan();
+}
+
+TEST_F(SongLengthScannerTest, SeveralJumpsOnOneRow) {
+	// the last channel and column in order wins, and Bxx takes precedence over Dxx
+	SetEffect(PULSE1, 1, 4, 0, effect_t::JUMP, 3);
+	SetEffect(PULSE1, 1, 4, 1, effect_t::JUMP, 0);
+	SetEffect(NOISE, 1, 4, 0, effect_t::JUMP, 2);
+	SetEffect(TRIANGLE, 1, 4, 2, effect_t::SKIP, 9);
+	SetEffect(PULSE2, 2, 6, 0, effect_t::SKIP, 1);
+	SetEffect(NOISE, 2, 6, 1, effect_t::SKIP, 12);
+	SetEffect(PULSE1, 3, 0, 0, effect_t::SKIP, 5);
+	SetEffect(PULSE2, 3, 0, 0, effect_t::JUMP, 1);
+	Scan();
+}
+
+TEST_F(SongLengthScannerTest, HaltOnFirstRow) {
+	SetEffect(PULSE1, 0, 0, 0, effect_t::HALT, 0);
+	const auto Length = Scan();
+	EXPECT_EQ(Length.IntroRows, 1u);
+	EXPECT_EQ(Length.LoopRows, 0u);
+}
+
+TEST_F(SongLengthScannerTest, HaltAfterJumps) {
+	SetEffect(PULSE2, 0, 8, 0, effect_t::JUMP, 2);
+	SetEffect(TRIANGLE, 2, 3, 1, effect_t::HALT, 0);
+	SetEffect(NOISE, 2, 3, 0, effect_t::JUMP, 0);
+	const auto Length = Scan();
+	EXPECT_EQ(Length.IntroRows, 13u);
+	EXPECT_EQ(Length.LoopRows, 0u);
+}
+
+TEST_F(SongLengthScannerTest, SpeedAndTempo) {
+	modfile.SetSpeedSplitPoint(0x20);
+	Song().SetSongTempo(150);
+	SetEffect(PULSE1, 0, 4, 0, effect_t::SPEED, 3);
+	SetEffect(PULSE2, 0, 4, 0, effect_t::SPEED, 0x80);
+	SetEffect(NOISE, 1, 0, 0, effect_t::SPEED, 0x1F);
+	SetEffect(NOISE, 2, 9, 0, effect_t::SPEED, 0x20);
+	SetEffect(PULSE1, 3, 15, 0, effect_t::JUMP, 1);
+	Scan();
+
+	Song().SetSongTempo(0);
+	Scan();
+}
+
+TEST_F(SongLengthScannerTest, GrooveChanges) {
+	SetGroove(0, {6, 5});
+	SetGroove(3, {2, 9, 4});
+	Song().SetSongGroove(true);
+	Song().SetSongSpeed(0);
+	SetEffect(PULSE1, 1, 3, 0, effect_t::GROOVE, 3);
+	SetEffect(PULSE2, 2, 5, 0, effect_t::SPEED, 4);
+	SetEffect(TRIANGLE, 2, 11, 0, effect_t::GROOVE, 0);
+	SetEffect(NOISE, 3, 1, 0, effect_t::GROOVE, 7);		// missing groove, ignored
+	SetEffect(NOISE, 3, 9, 0, effect_t::JUMP, 1);
+	Scan();
+
+	// groove pointer position carried into the loop
+	SetEffect(PULSE1, 3, 9, 1, effect_t::SKIP, 2);
+	Scan();
+}
+
+TEST_F(SongLengthScannerTest, EmptyGroove) {
+	// an empty groove runs at the default speed
+	modfile.SetGroove(2, std::make_shared<ft0cc::doc::groove>());
+	SetGroove(5, {3});
+	Song().SetSongGroove(true);
+	Song().SetSongSpeed(2);
+	SetEffect(PULSE1, 1, 0, 0, effect_t::GROOVE, 5);
+	SetEffect(PULSE1, 2, 8, 0, effect_t::GROOVE, 2);
+	Scan();
+
+	Song().SetSongSpeed(4);		// missing song groove falls back to the default speed
+	Scan();
+}
+
+TEST_F(SongLengthScannerTest, RandomSongs) {
+	std::mt19937 rng {777};
+	const auto R = [&] (unsigned n) { return static_cast<unsigned>(rng() % n); };
+
+	std::vector<stChannelID> Chans;
+	modfile.GetChannelOrder().ForeachChannel([&] (stChannelID Chan) { Chans.push_back(Chan); });
+
+	for (int it = 0; it < 200; ++it) {
+		for (unsigned i = 0; i < MAX_GROOVE; ++i)
+			modfile.SetGroove(i, nullptr);
+		for (unsigned i = 0; i < 8; ++i)
+			if (R(2)) {
+				auto pGroove = std::make_shared<ft0cc::doc::groove>();
+				pGroove->resize(R(9));
+				for (std::size_t k = 0; k < pGroove->size(); ++k)
+					pGroove->set_entry(k, 1 + R(12));
+				modfile.SetGroove(i, pGroove);
+			}
+		modfile.SetSpeedSplitPoint(R(2) ? 0x20 : 0x40);
+
+		const unsigned Frames = 1 + R(it % 10 == 0 ? 64 : 12);
+		const unsigned Rows = 1 + R(it % 7 == 0 ? 256 : 32);
+		Song().SetFrameCount(Frames);
+		Song().SetPatternLength(Rows);
+		Song().SetSongGroove(R(3) == 0);
+		Song().SetSongSpeed(R(3) == 0 ? R(8) : 1 + R(20));
+		Song().SetSongTempo(R(4) == 0 ? 0 : 32 + R(200));
+		for (auto Chan : Chans) {
+			Song().SetEffectColumnCount(Chan, R(4));
+			for (unsigned f = 0; f < Frames; ++f)
+				Song().SetFramePattern(f, Chan, R(8));
+		}
+
+		const auto Edit = [&] {
+			stChanNote Note;
+			for (auto &cmd : Note.Effects)
+				if (R(3) == 0) {
+					const unsigned k = R(10);
+					cmd.fx = k < 2 ? effect_t::JUMP : k < 4 ? effect_t::SKIP : k < 5 ? effect_t::HALT :
+						k < 7 ? effect_t::SPEED : k < 8 ? effect_t::GROOVE : effect_t::VOLUME;
+					cmd.param = cmd.fx == effect_t::JUMP ? R(Frames + 3) : cmd.fx == effect_t::SKIP ? R(Rows + 3) :
+						cmd.fx == effect_t::GROOVE ? R(9) : R(256);
+					if (cmd.fx == effect_t::HALT && R(4))
+						cmd.fx = effect_t::VOLUME;
+				}
+			Song().GetPattern(Chans[R(Chans.size())], R(8)).SetNoteOn(R(Rows), Note);
+		};
+		for (unsigned k = 0, n = (1 + R(30)) * Frames * Rows / 64 + 1; k < n; ++k)
+			Edit();
+
+		// the song length index is reused between scans of the same song
+		for (int Round = 0; Round < 4; ++Round) {
+			SCOPED_TRACE("iteration " + std::to_string(it) + ", round " + std::to_string(Round));
+			Scan();
+			switch (R(6)) {
+			case 0: case 1: case 2: Edit(); break;
+			case 3: Song().SetFramePattern(R(Frames), Chans[R(Chans.size())], R(8)); break;
+			case 4: Song().SetEffectColumnCount(Chans[R(Chans.size())], R(4)); break;
+			default: modfile.SetGroove(R(8), R(2) ? nullptr : std::make_shared<ft0cc::doc::groove>(std::initializer_list<std::uint8_t> {3, 4}));
+			}
+		}
+
+		if (HasFailure())
+			break;
+	}
+}
@@ -0,0 +1,215 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+
+
+#include "SongState.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "SoundChipSet.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "PatternData.h"
+#include "PatternNote.h"
+#include "ft0cc/doc/groove.hpp"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+const effect_t EFFECTS[] = {
+	effect_t::SPEED, effect_t::GROOVE, effect_t::VOLUME, effect_t::NOTE_CUT, effect_t::FDS_MOD_DEPTH,
+	effect_t::FDS_MOD_SPEED_HI, effect_t::FDS_MOD_SPEED_LO, effect_t::DUTY_CYCLE, effect_t::SAMPLE_OFFSET,
+	effect_t::FDS_VOLUME, effect_t::FDS_MOD_BIAS, effect_t::VIBRATO, effect_t::TREMOLO, effect_t::PITCH,
+	effect_t::VOLUME_SLIDE, effect_t::SWEEPUP, effect_t::SLIDE_UP, effect_t::PORTAMENTO, effect_t::ARPEGGIO,
+	effect_t::PORTA_UP, effect_t::PORTA_DOWN, effect_t::TRANSPOSE, effect_t::DELAY,
+};
+
+::testing::AssertionResult IsSameState(const CSongState &Actual, const CSongState &Expected) {
+	if (Actual.Tempo != Expected.Tempo || Actual.Speed != Expected.Speed || Actual.GroovePos != Expected.GroovePos)
+		return ::testing::AssertionFailure() << "tempo " << Actual.Tempo << '/' << Expected.Tempo <<
+			", speed " << Actual.Speed << '/' << Expected.Speed << ", groove " << Actual.GroovePos << '/' << Expected.GroovePos;
+	for (const auto &[Chan, x] : Expected.State) {
+		const stChannelState &y = Actual.State.at(Chan);
+		if (x.Instrument != y.Instrument || x.Volume != y.Volume || x.Effect != y.Effect ||
+			x.Effect_LengthCounter != y.Effect_LengthCounter || x.Effect_AutoFMMult != y.Effect_AutoFMMult)
+			return ::testing::AssertionFailure() << "channel " << Chan.ToInteger() << ": " << y.GetStateString() << " / " << x.GetStateString();
+		if (x.Echo != y.Echo)
+			return ::testing::AssertionFailure() << "channel " << Chan.ToInteger() << ": echo buffer " <<
+				::testing::PrintToString(y.Echo) << " / " << ::testing::PrintToString(x.Echo);
+	}
+	return ::testing::AssertionSuccess();
+}
+
+class SongStateTest : public ::testing::Test {
+protected:
+	static constexpr unsigned PATTERNS = 24;
+
+	SongStateTest() {
+		const auto Chips = CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::FDS);
+		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(Chips, 0));
+		modfile.GetChannelOrder().ForeachChannel([&] (stChannelID Chan) {
+			Channels.push_back(Chan);
+		});
+		for (unsigned i = 0; i < 8; i += 2)
+			modfile.SetGroove(i, std::make_shared<ft0cc::doc::groove>(std::initializer_list<std::uint8_t> {6, 5, 4}));
+	}
+
+	CSongData &Song() {
+		return *modfile.GetSong(0);
+	}
+
+	stChanNote MakeNote(unsigned Density) {
+		stChanNote Note;
+		if (rng() % 100 < Density) {
+			const unsigned k = rng() % 20;
+			Note.Note = k < 3 ? note_t::echo : k < 4 ? note_t::halt : k < 5 ? note_t::release : enum_cast<note_t>(1 + rng() % 12);
+			Note.Octave = Note.Note == note_t::echo ? rng() % ECHO_BUFFER_LENGTH : rng() % 8;
+		}
+		if (rng() % 100 < Density / 2)
+			Note.Instrument = rng() % 10;
+		if (rng() % 100 < Density / 3)
+			Note.Vol = rng() % 16;
+		for (auto &cmd : Note.Effects)
+			if (rng() % 100 < Density / 2) {
+				cmd.fx = EFFECTS[rng() % std::size(EFFECTS)];
+				const unsigned k = rng() % 4;
+				cmd.param = k == 0 ? rng() % 0x20 : k == 1 ? 0xE0 + rng() % 4 : rng() % 0x100;
+				if (cmd.fx == effect_t::GROOVE)
+					cmd.param = rng() % 8;
+			}
+			else if (rng() % 3000 == 0)
+				cmd.fx = effect_t::HALT;
+		return Note;
+	}
+
+	// Fills the song with random rows, shared by the frames through PATTERNS patterns per channel
+	void MakeSong(unsigned Frames, unsigned Rows, unsigned Density) {
+		Song().SetFrameCount(Frames);
+		Song().SetPatternLength(Rows);
+		Song().SetSongGroove(rng() % 2);
+		Song().SetSongSpeed(2);
+		for (auto Chan : Channels) {
+			Song().SetEffectColumnCount(Chan, rng() % MAX_EFFECT_COLUMNS);
+			for (unsigned p = 0; p < PATTERNS; ++p)
+				for (unsigned r = 0; r < Rows; ++r)
+					Song().GetPattern(Chan, p).SetNoteOn(r, MakeNote(Density));
+			for (unsigned f = 0; f < Frames; ++f)
+				Song().SetFramePattern(f, Chan, rng() % PATTERNS);
+		}
+	}
+
+	// Compares a keyframed retrieval with a full scan at a random row
+	::testing::AssertionResult CheckRandomRow() {
+		const unsigned Frame = rng() % Song().GetFrameCount();
+		const unsigned Row = rng() % Song().GetPatternLength();
+		CSongState Actual, Expected;
+		Actual.Retrieve(modfile, 0, Frame, Row);
+		Expected.RetrieveFullScan(modfile, 0, Frame, Row);
+		if (auto Result = IsSameState(Actual, Expected); !Result)
+			return Result << " (frame " << Frame << ", row " << Row << ')';
+		return ::testing::AssertionSuccess();
+	}
+
+	stChannelID RandomChannel() {
+		return Channels[rng() % Channels.size()];
+	}
+
+	std::mt19937 rng {12345};
+	CFamiTrackerModule modfile;
+	std::vector<stChannelID> Channels;
+};
+
+} // namespace
+
+TEST_F(SongStateTest, EchoNotesBeyondKeyframe) {
+	// a keyframe segment full of echo notes keeps only some of them, the real note before them must still be found
+	const unsigned Rows = 4;
+	const unsigned Frames = 3 * CSongStateIndex::KEYFRAME_ROWS / Rows;
+	Song().SetFrameCount(Frames);
+	Song().SetPatternLength(Rows);
+	stChanNote Note;
+	Note.Note = note_t::C;
+	Note.Octave = 3;
+	Song().GetPattern(Channels[0], 0).SetNoteOn(0, Note);
+	Note.Note = note_t::echo;
+	Note.Octave = 0;
+	for (unsigned r = 1; r < Rows; ++r)
+		Song().GetPattern(Channels[0], 0).SetNoteOn(r, Note);
+	for (unsigned r = 0; r < Rows; ++r)
+		Song().GetPattern(Channels[0], 1).SetNoteOn(r, Note);
+	for (unsigned f = 1; f < Frames; ++f)
+		Song().SetFramePattern(f, Channels[0], 1);
+
+	for (unsigned Frame = 0; Frame < Frames; Frame += 7) {
+		CSongState Actual, Expected;
+		Actual.Retrieve(modfile, 0, Frame, 2);
+		Expected.RetrieveFullScan(modfile, 0, Frame, 2);
+		EXPECT_TRUE(IsSameState(Actual, Expected)) << "frame " << Frame;
+	}
+}
+
+TEST_F(SongStateTest, KeyframesMatchFullScan) {
+	const unsigned LENGTHS[] = {1, 3, 4, 16, 64, 256};
+	for (unsigned Rows : LENGTHS)
+		for (unsigned Density : {10u, 30u, 60u}) {
+			MakeSong(1 + rng() % (Rows > 16 ? 64 : 256), Rows, Density);
+			for (int i = 0; i < 200; ++i)
+				ASSERT_TRUE(CheckRandomRow()) << Rows << " rows, density " << Density;
+		}
+}
+
+TEST_F(SongStateTest, KeyframesFollowEdits) {
+	for (unsigned Rows : {4u, 16u, 64u}) {
+		MakeSong(Rows > 16 ? 64 : 256, Rows, 30);
+		for (int i = 0; i < 1500; ++i) {
+			ASSERT_TRUE(CheckRandomRow()) << Rows << " rows, step " << i;
+			switch (rng() % 10) {
+			case 0: case 1: case 2: case 3:
+				Song().GetPattern(RandomChannel(), rng() % PATTERNS).SetNoteOn(rng() % Rows, MakeNote(60));
+				break;
+			case 4: case 5:		// edits near the end of the song, as while writing it
+				Song().GetPatternOnFrame(RandomChannel(), Song().GetFrameCount() - 1 - rng() % 4).SetNoteOn(rng() % Rows, MakeNote(60));
+				break;
+			case 6:
+				Song().SetFramePattern(rng() % Song().GetFrameCount(), RandomChannel(), rng() % PATTERNS);
+				break;
+			case 7:
+				if (rng() % 5 == 0)
+					Song().SetEffectColumnCount(RandomChannel(), rng() % MAX_EFFECT_COLUMNS);
+				break;
+			case 8:
+				if (rng() % 10 == 0)
+					modfile.SetSpeedSplitPoint(rng() % 2 ? 0x20 : 0x40);
+				break;
+			case 9:
+				if (rng() % 10 == 0)
+					modfile.SetGroove(rng() % 8, rng() % 2 ? nullptr :
+						std::make_shared<ft0cc::doc::groove>(std::initializer_list<std::uint8_t> {3, 4}));
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,339 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 2, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/. */
+
+#include "TextExporter.h"
+#include "MappedFile.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "SoundChipSet.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "PatternData.h"
+#include "PatternNote.h"
+#include "DSampleManager.h"
+#include "InstrumentManager.h"
+#include "InstrumentService.h"
+#include "Instrument2A03.h"
+#include "InstrumentVRC7.h"
+#include "InstrumentFDS.h"
+#include "InstrumentN163.h"
+#include "Sequence.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include "ft0cc/doc/groove.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+const effect_t EFFECTS[] = {
+	effect_t::SPEED, effect_t::JUMP, effect_t::SKIP, effect_t::HALT, effect_t::VOLUME, effect_t::PORTAMENTO,
+	effect_t::ARPEGGIO, effect_t::VIBRATO, effect_t::TREMOLO, effect_t::PITCH, effect_t::DELAY, effect_t::PORTA_UP,
+	effect_t::PORTA_DOWN, effect_t::SLIDE_UP, effect_t::SLIDE_DOWN, effect_t::VOLUME_SLIDE, effect_t::NOTE_CUT,
+	effect_t::NOTE_RELEASE, effect_t::GROOVE, effect_t::TRANSPOSE,
+};
+
+// Strings that need quoting or escaping in the text format
+const char *const STRINGS[] = {"", "abc", "with \"quotes\"", "\"\"", "space  tab\t", "x"};
+
+class TextExporterTest : public ::testing::Test {
+protected:
+	unsigned Random(unsigned n) {
+		return std::uniform_int_distribution<unsigned> {0, n - 1}(rng);
+	}
+
+	int Random(int lo, int hi) {
+		return std::uniform_int_distribution<int> {lo, hi}(rng);
+	}
+
+	std::string RandomString() {
+		return STRINGS[Random(std::size(STRINGS))];
+	}
+
+	// Fills a new module with random contents of every kind the text format stores
+	std::unique_ptr<CFamiTrackerModule> MakeModule(unsigned Seed, unsigned Scale = 0) {
+		rng.seed(Seed);
+		auto pModule = std::make_unique<CFamiTrackerModule>();
+		auto &modfile = *pModule;
+
+		CSoundChipSet Chips {sound_chip_t::APU};
+		for (auto c : {sound_chip_t::VRC6, sound_chip_t::VRC7, sound_chip_t::FDS, sound_chip_t::MMC5, sound_chip_t::N163, sound_chip_t::S5B})
+			if (!Random(3u))
+				Chips = Chips.WithChip(c);
+		const unsigned N163Channels = Chips.ContainsChip(sound_chip_t::N163) ? 1 + Random(8u) : 0;
+		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(Chips, N163Channels));
+
+		modfile.SetModuleName(RandomString());
+		modfile.SetModuleArtist(RandomString());
+		modfile.SetModuleCopyright(RandomString());
+		modfile.SetComment(Random(2u) ? "line one\r\nline \"two\"\r\n\r\nend" : RandomString(), false);
+		modfile.SetMachine(Random(2u) && !modfile.HasExpansionChips() ? machine_t::PAL : machine_t::NTSC);
+		modfile.SetEngineSpeed(Random(3u) ? 0 : Random(400u));
+		modfile.SetSpeedSplitPoint(Random(256u));
+		if (Random(2u))
+			modfile.SetTuning(Random(-12, 12), Random(-100, 100));
+
+		auto &Manager = *modfile.GetInstrumentManager();
+		const inst_type_t SEQ_TYPES[] = {INST_2A03, INST_VRC6, INST_N163, INST_S5B};
+		for (int i = 0; i < 10; ++i) {
+			auto pSeq = Manager.GetSequence(SEQ_TYPES[Random(std::size(SEQ_TYPES))], enum_cast<sequence_t>(Random(5u)), Random(MAX_SEQUENCES));
+			const unsigned Count = 1 + Random(40u);
+			pSeq->SetItemCount(Count);
+			for (unsigned j = 0; j < Count; ++j)
+				pSeq->SetItem(j, Random(-128, 127));
+			pSeq->SetLoopPoint(Random(-1, Count - 1));
+			pSeq->SetReleasePoint(Random(-1, Count - 1));
+			pSeq->SetSetting(static_cast<seq_setting_t>(Random(3u)));
+		}
+
+		for (int i = 0; i < 4; ++i) {
+			auto pSample = std::make_shared<ft0cc::doc::dpcm_sample>(
+				std::vector<ft0cc::doc::dpcm_sample::sample_t>(1 + Random(200u)), RandomString());
+			for (std::size_t j = 0; j < pSample->size(); ++j)
+				pSample->set_sample_at(j, Random(256u));
+			modfile.GetDSampleManager()->SetDSample(Random(MAX_DSAMPLES), pSample);
+		}
+
+		for (int i = 0; i < 5; ++i)
+			modfile.SetDetuneOffset(Random(6u), Random(NOTE_COUNT), Random(-1000, 1000));
+
+		for (int i = 0; i < 3; ++i) {
+			auto pGroove = std::make_shared<ft0cc::doc::groove>();
+			pGroove->resize(1 + Random(10u));
+			for (auto &x : *pGroove)
+				x = 1 + Random(255u);
+			modfile.SetGroove(Random(MAX_GROOVE), pGroove);
+		}
+
+		for (int i = 0; i < 12; ++i)
+			Manager.InsertInstrument(Random(MAX_INSTRUMENTS), MakeInstrument());
+
+		const unsigned Songs = 1 + Random(3u);
+		for (unsigned i = 0; i < Songs; ++i) {
+			if (i)
+				modfile.InsertSong(i, modfile.MakeNewSong());
+			FillSong(modfile, *modfile.GetSong(i), Scale ? Scale : 1 + Seed % 4);
+		}
+
+		return pModule;
+	}
+
+	std::unique_ptr<CInstrument> MakeInstrument() {
+		const inst_type_t TYPES[] = {INST_2A03, INST_VRC6, INST_VRC7, INST_FDS, INST_N163, INST_S5B};
+		const inst_type_t Type = TYPES[Random(std::size(TYPES))];
+		auto pInst = FTEnv.GetInstrumentService()->Make(Type);
+		pInst->SetName(RandomString());
+
+		if (auto pSeqInst = dynamic_cast<CSeqInstrument *>(pInst.get()); pSeqInst && Type != INST_FDS)
+			for (auto s : enum_values<sequence_t>()) {
+				pSeqInst->SetSeqEnable(s, Random(2u));
+				pSeqInst->SetSeqIndex(s, Random(MAX_SEQUENCES));
+			}
+
+		switch (Type) {
+		case INST_2A03: {
+			auto &Inst = static_cast<CInstrument2A03 &>(*pInst);
+			for (int i = 0; i < 5; ++i) {
+				const unsigned Note = Random(NOTE_COUNT);
+				Inst.SetSampleIndex(Note, Random(MAX_DSAMPLES));
+				Inst.SetSamplePitch(Note, Random(16u));
+				Inst.SetSampleLoop(Note, Random(2u));
+				Inst.SetSampleLoopOffset(Note, Random(100u));
+				Inst.SetSampleDeltaValue(Note, Random(-1, 127));
+			}
+		}	break;
+		case INST_VRC7: {
+			auto &Inst = static_cast<CInstrumentVRC7 &>(*pInst);
+			Inst.SetPatch(Random(16u));
+			for (int i = 0; i < 8; ++i)
+				Inst.SetCustomReg(i, Random(256u));
+		}	break;
+		case INST_FDS: {
+			auto &Inst = static_cast<CInstrumentFDS &>(*pInst);
+			for (int i = 0; i < 64; ++i)
+				Inst.SetSample(i, Random(64u));
+			for (int i = 0; i < 32; ++i)
+				Inst.SetModulation(i, Random(8u));
+			Inst.SetModulationEnable(Random(2u));
+			Inst.SetModulationSpeed(Random(4096u));
+			Inst.SetModulationDepth(Random(64u));
+			Inst.SetModulationDelay(Random(256u));
+		}	break;
+		case INST_N163: {
+			auto &Inst = static_cast<CInstrumentN163 &>(*pInst);
+			Inst.SetWaveSize(4 * (1 + Random(8u)));
+			Inst.SetWavePos(Random(32u));
+			Inst.SetWaveCount(1 + Random(4u));
+			for (int w = 0; w < Inst.GetWaveCount(); ++w)
+				for (unsigned i = 0; i < Inst.GetWaveSize(); ++i)
+					Inst.SetSample(w, i, Random(16u));
+		}	break;
+		default:
+			break;
+		}
+
+		return pInst;
+	}
+
+	void FillSong(CFamiTrackerModule &modfile, CSongData &Song, unsigned Scale) {
+		Song.SetTitle(RandomString());
+		Song.SetSongGroove(!Random(3u));
+		Song.SetSongSpeed(1 + Random(20u));
+		Song.SetSongTempo(Random(256u));
+		const unsigned Frames = 1 + Random(4 * Scale);
+		const unsigned Rows = 1 + Random(std::min<unsigned>(64 * Scale, MAX_PATTERN_LENGTH));
+		const unsigned Patterns = std::min<unsigned>(8 * Scale, MAX_PATTERN);
+		Song.SetFrameCount(Frames);
+		Song.SetPatternLength(Rows);
+
+		modfile.GetChannelOrder().ForeachChannel([&] (stChannelID Chan) {
+			Song.SetEffectColumnCount(Chan, 1 + Random(4u));
+			for (unsigned f = 0; f < Frames; ++f)
+				Song.SetFramePattern(f, Chan, Random(Patterns));
+			for (unsigned i = 0; i < Rows * Frames / 2; ++i)
+				Song.GetPattern(Chan, Random(Patterns)).SetNoteOn(Random(Rows), MakeNote(Chan, Song.GetEffectColumnCount(Chan)));
+		});
+	}
+
+	stChanNote MakeNote(stChannelID Chan, unsigned EffColumns) {
+		stChanNote Note;
+		const unsigned n = Random(10u);
+		Note.Note = n < 6 ? enum_cast<note_t>(1 + Random(12u)) : n == 6 ? note_t::halt : n == 7 ? note_t::release : n == 8 ? note_t::echo : note_t::none;
+		Note.Octave = Note.Note == note_t::echo ? Random(ECHO_BUFFER_LENGTH) : Random(8u);
+		if (IsAPUNoise(Chan)) {
+			if (is_note(Note.Note)) {
+				const int Midi = Random(16u);
+				Note.Note = ft0cc::doc::pitch_from_midi(Midi);
+				Note.Octave = ft0cc::doc::oct_from_midi(Midi);
+			}
+			else if (Note.Note == note_t::echo)
+				Note.Note = note_t::halt;
+		}
+		const unsigned i = Random(10u);
+		Note.Instrument = i < 7 ? Random(MAX_INSTRUMENTS) : i < 9 ? MAX_INSTRUMENTS : HOLD_INSTRUMENT;
+		Note.Vol = Random(17u);
+		for (unsigned j = 0; j < EffColumns; ++j)
+			if (Random(2u))
+				Note.Effects[j] = {EFFECTS[Random(std::size(EFFECTS))], static_cast<std::uint8_t>(Random(256u))};
+		return Note;
+	}
+
+	static std::string Export(CFamiTrackerModule &modfile) {
+		std::ostringstream os;
+		CTextExport { }.ExportText(os, modfile);
+		return os.str();
+	}
+
+	static std::unique_ptr<CFamiTrackerModule> Import(std::string_view Text) {
+		auto pModule = std::make_unique<CFamiTrackerModule>();
+		pModule->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+		CTextExport { }.ImportText(Text, *pModule);
+		return pModule;
+	}
+
+	std::mt19937 rng;
+};
+
+const std::filesystem::path TEMP_PATH = std::filesystem::temp_directory_path() / "ft0cc-text-test.txt";
+
+} // namespace
+
+TEST_F(TextExporterTest, RoundTripIsByteIdentical) {
+	for (unsigned Seed = 0; Seed < 24; ++Seed) {
+		SCOPED_TRACE(::testing::Message() << "seed " << Seed);
+		const std::string Text = Export(*MakeModule(Seed));
+		ASSERT_FALSE(Text.empty());
+		std::unique_ptr<CFamiTrackerModule> pImported;
+		ASSERT_NO_THROW(pImported = Import(Text));
+		EXPECT_EQ(Export(*pImported), Text);
+	}
+}
+
+TEST_F(TextExporterTest, ImportIgnoresCarriageReturns) {
+	const std::string Text = Export(*MakeModule(7));
+	std::string CRLF;
+	for (char c : Text) {
+		if (c == '\n')
+			CRLF += '\r';
+		CRLF += c;
+	}
+	EXPECT_EQ(Export(*Import(CRLF)), Text);
+}
+
+TEST_F(TextExporterTest, FileRoundTrip) {
+	auto pModule = MakeModule(3);
+	const std::string Text = Export(*pModule);
+	ASSERT_EQ(CTextExport { }.ExportFile(TEMP_PATH, *pModule), "");
+
+	{
+		CMappedFile File {TEMP_PATH};
+		EXPECT_EQ(File.GetSize(), Text.size());
+		EXPECT_EQ(File.GetText(), Text);
+	}
+
+	CFamiTrackerModule Imported;
+	Imported.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	CTextExport { }.ImportFile(TEMP_PATH, Imported);
+	EXPECT_EQ(Export(Imported), Text);
+	std::filesystem::remove(TEMP_PATH);
+}
+
+TEST(MappedFile, EmptyAndMissingFiles) {
+	std::ofstream {TEMP_PATH};
+	{
+		CMappedFile File {TEMP_PATH};
+		EXPECT_EQ(File.GetSize(), 0u);
+		EXPECT_TRUE(File.GetText().empty());
+	}
+	std::filesystem::remove(TEMP_PATH);
+	EXPECT_THROW(CMappedFile {TEMP_PATH}, std::runtime_error);
+}
+
+TEST_F(TextExporterTest, DISABLED_Throughput) {
+	auto pModule = MakeModule(99, 32);
+	double ms[2] = { };
+	std::string Text;
+	for (int i = 0; i < 3; ++i) {
+		const auto t0 = std::chrono::steady_clock::now();
+		Text = Export(*pModule);
+		const auto t1 = std::chrono::steady_clock::now();
+		Import(Text);
+		const auto t2 = std::chrono::steady_clock::now();
+		const double ExportTime = std::chrono::duration<double, std::milli>(t1 - t0).count();
+		const double ImportTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		ms[0] = i ? std::min(ms[0], ExportTime) : ExportTime;
+		ms[1] = i ? std::min(ms[1], ImportTime) : ImportTime;
+	}
+
+	std::cout << Text.size() << " bytes, export " << ms[0] << " ms (" << Text.size() / 1e3 / ms[0] <<
+		" MB/s), import " << ms[1] << " ms (" << Text.size() / 1e3 / ms[1] << " MB/s)\n";
+}
@@ -26,6 +26,9 @@ int main() try {
 
 	Kraid { }(modfile);
 
+	auto est = CCompiler(modfile, nullptr).EstimateSize();
+	std::cout << "Estimated music data size: " << est.GetMusicDataSize() << " bytes\n";
+
 	CSimpleFile nsffile("kraid.nsf", std::ios::out | std::ios::binary);
 	CCompiler compiler(modfile, std::make_unique<CStdoutLog>());
 	compiler.ExportNSF(nsffile, 0);
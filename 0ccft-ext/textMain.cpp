@@ -0,0 +1,103 @@
+#include "TextExporter.h"
+#include "MappedFile.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+// Usage: ft0cc-text [-n <runs>] <file.txt>...
+//
+// Benchmarks the text importer and exporter, and checks that they agree. Each
+// file is imported from a memory map and exported again, keeping the fastest
+// of the given number of runs. The export is then imported and exported once
+// more, which must give byte-identical text. Files that fail to import are
+// reported and skipped, so a directory of mutated text exports can be used as
+// a fuzzing corpus; the exit code is 1 if any round trip differed.
+
+namespace {
+
+std::unique_ptr<CFamiTrackerModule> Import(std::string_view text) {
+	auto pModule = std::make_unique<CFamiTrackerModule>();
+	pModule->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	CTextExport { }.ImportText(text, *pModule);
+	return pModule;
+}
+
+std::string Export(CFamiTrackerModule &modfile) {
+	std::ostringstream os;
+	CTextExport { }.ExportText(os, modfile);
+	return os.str();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) try {
+	unsigned runs = 1;
+	std::vector<fs::path> inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string_view arg = argv[i];
+		if (arg == "-n" && i + 1 < argc)
+			runs = std::max(1ul, std::stoul(argv[++i]));
+		else if (!arg.empty() && arg[0] == '-') {
+			std::cerr << "Unknown argument: " << arg << '\n';
+			return 2;
+		}
+		else
+			inputs.push_back(fs::u8path(arg));
+	}
+	if (inputs.empty()) {
+		std::cerr << "Usage: ft0cc-text [-n <runs>] <file.txt>...\n";
+		return 2;
+	}
+
+	using clock_type = std::chrono::steady_clock;
+	const auto ms = [] (clock_type::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count();
+	};
+
+	unsigned failed = 0;
+	for (const auto &input : inputs) {
+		const std::string name = input.u8string();
+		try {
+			const CMappedFile file {input};
+			double importTime = 0., exportTime = 0.;
+			std::string text;
+			for (unsigned r = 0; r < runs; ++r) {
+				auto t0 = clock_type::now();
+				auto pModule = Import(file.GetText());
+				auto t1 = clock_type::now();
+				text = Export(*pModule);
+				auto t2 = clock_type::now();
+				importTime = r ? std::min(importTime, ms(t1 - t0)) : ms(t1 - t0);
+				exportTime = r ? std::min(exportTime, ms(t2 - t1)) : ms(t2 - t1);
+			}
+
+			const bool same = Export(*Import(text)) == text;
+			if (!same)
+				++failed;
+			char stats[128] = { };
+			std::snprintf(stats, std::size(stats), "%zu bytes, import %.2f ms (%.1f MB/s), export %.2f ms (%.1f MB/s), round trip %s",
+				file.GetSize(), importTime, file.GetSize() / 1e3 / std::max(importTime, 1e-3),
+				exportTime, text.size() / 1e3 / std::max(exportTime, 1e-3), same ? "ok" : "DIFFERS");
+			std::cout << name << ": " << stats << '\n';
+		}
+		catch (std::runtime_error &e) {
+			std::cout << name << ": " << e.what() << '\n';
+		}
+	}
+
+	return failed ? 1 : 0;
+}
+catch (std::exception &e) {
+	std::cerr << "C++ exception: " << e.what() << '\n';
+	return 2;
+}
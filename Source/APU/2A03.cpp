@@ -104,6 +104,22 @@ void C2A03::Write(uint16_t Address, uint8_t Value)
 	}
 }
 
+bool C2A03::IsAddressMapped(uint16_t Address) const		// // //
+{
+	return Address >= 0x4000U && Address <= 0x401FU;
+}
+
+bool C2A03::IsRegisterIdempotent(uint16_t Address) const		// // //
+{
+	// Sweep units modify the square periods, other registers restart counters or sequencers
+	switch (Address) {
+	case 0x4000: case 0x4004: case 0x4008: case 0x400A:
+	case 0x400C: case 0x400E: case 0x4012: case 0x4013:
+		return true;
+	}
+	return false;
+}
+
 uint8_t C2A03::Read(uint16_t Address, bool &Mapped)
 {
 	switch (Address) {
@@ -37,7 +37,7 @@ class dpcm_sample;
 #include "APU/Noise.h"
 #include "APU/DPCM.h"
 
-class C2A03 : public CSoundChip
+class C2A03 final : public CSoundChip		// // //
 {
 public:
 	C2A03(CMixer &Mixer, std::uint8_t nInstance);
@@ -49,6 +49,8 @@ public:
 	void EndFrame() override;
 
 	void Write(uint16_t Address, uint8_t Value) override;
+	bool IsAddressMapped(uint16_t Address) const override;		// // //
+	bool IsRegisterIdempotent(uint16_t Address) const override;		// // //
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
 
 	double GetFreq(int Channel) const override;		// // //
@@ -67,6 +67,8 @@ CAPU::~CAPU()
 //
 void CAPU::Process()
 {
+	FlushWrites();		// // //
+
 	while (m_iCyclesToRun > 0) {
 
 		uint32_t Time = std::min(m_iCyclesToRun, m_iSequencerNext - m_iSequencerClock);		// // //
@@ -99,7 +101,9 @@ void CAPU::StepSequence()		// // //
 // End of audio frame, flush the buffer if enough samples has been produced, and start a new frame
 void CAPU::EndFrame()
 {
-	// The APU will always output audio in 32 bit signed format
+	// The APU will always output audio in 32 bit float format, clipping is left to the receiver		// // //
+
+	FlushWrites();		// // //
 
 	for (auto *Chip : m_pActiveChips)		// // //
 		Chip->EndFrame();
@@ -124,6 +128,8 @@ void CAPU::Reset()
 	// Reset APU
 	//
 
+	FlushWrites();		// // //
+
 	m_iSequencerCount	= 0;		// // //
 	m_iSequencerClock	= 0;		// // //
 	m_iSequencerNext	= MASTER_CLOCK_NTSC / C2A03Chan::SEQUENCER_FREQUENCY;
@@ -140,6 +146,10 @@ void CAPU::Reset()
 		Chip->Reset();
 	}
 
+	for (auto &x : m_iRegisterShadow)		// // //
+		if (x != REG_VOLATILE)
+			x = REG_UNKNOWN;
+
 	m_pMixer->ClearBuffer();
 
 #ifdef LOGGING
@@ -163,6 +173,8 @@ void CAPU::SetCallback(IAudioCallback &pCallback) {
 
 void CAPU::SetExternalSound(CSoundChipSet Chip) {
 	// Set expansion chip
+	FlushWrites();		// // //
+
 	m_iExternalSoundChip = Chip;
 	m_pMixer->ExternalSound(Chip);
 
@@ -172,6 +184,7 @@ void CAPU::SetExternalSound(CSoundChipSet Chip) {
 		if (Chip.ContainsChip(c->GetID()))
 			m_pActiveChips.push_back(c.get());
 
+	UpdateAddressMap();		// // //
 	Reset();
 }
 
@@ -210,7 +223,7 @@ bool CAPU::SetupSound(int SampleRate, int NrChannels, machine_t Machine)		// //
 
 	m_pMixer->SetClockRate(BaseFreq);
 
-	m_pSoundBuffer = std::make_unique<int16_t[]>(m_iSoundBufferSize << 1);
+	m_pSoundBuffer = std::make_unique<float[]>(m_iSoundBufferSize << 1);		// // //
 	if (!m_pSoundBuffer)
 		return false;
 
@@ -228,14 +241,56 @@ void CAPU::AddTime(int32_t Cycles)
 
 void CAPU::Write(uint16_t Address, uint8_t Value)
 {
-	// Data was written to an external sound chip
+	// Data was written to an external sound chip, the write is staged until the
+	// APU runs again or another chip access needs it
 
-	Process();
+	if (m_iCyclesToRun > 0)		// // //
+		Process();
 
-	for (auto *Chip : m_pActiveChips)		// // //
-		Chip->Write(Address, Value);
+	m_RegisterWrites.push_back({Address, Value});		// // //
+}
+
+void CAPU::FlushWrites()		// // //
+{
+	// Applies the staged writes in order, only to the chips that decode each address;
+	// rewriting the value an idempotent register already holds is only logged
+
+	for (auto [Address, Value] : m_RegisterWrites) {
+		int16_t &Shadow = m_iRegisterShadow[Address];
+		const bool Redundant = Shadow == Value;
+		if (Shadow != REG_VOLATILE)
+			Shadow = Value;
+
+		for (unsigned Mask = m_iAddressChips[Address], i = 0; Mask; Mask >>= 1, ++i)
+			if (Mask & 1u) {
+				if (!Redundant)
+					m_pActiveChips[i]->Write(Address, Value);
+				m_pActiveChips[i]->Log(Address, Value);
+			}
+	}
+
+	m_RegisterWrites.clear();
+}
 
-	LogWrite(Address, Value);
+void CAPU::UpdateAddressMap()		// // //
+{
+	// Builds the address decoding table for the active chips
+
+	Assert(m_pActiveChips.size() <= 8);
+
+	m_iAddressChips.assign(0x10000, 0);
+	m_iRegisterShadow.assign(0x10000, REG_VOLATILE);
+
+	for (unsigned Address = 0; Address < 0x10000; ++Address) {
+		bool Idempotent = true;
+		for (std::size_t i = 0; i < m_pActiveChips.size(); ++i)
+			if (m_pActiveChips[i]->IsAddressMapped(Address)) {
+				m_iAddressChips[Address] |= 1u << i;
+				Idempotent = Idempotent && m_pActiveChips[i]->IsRegisterIdempotent(Address);
+			}
+		if (m_iAddressChips[Address] && Idempotent)
+			m_iRegisterShadow[Address] = REG_UNKNOWN;
+	}
 }
 
 uint8_t CAPU::Read(uint16_t Address)
@@ -337,6 +392,13 @@ void CAPU::SetNamcoMixing(bool bLinear)		// // //
 			pN163->SetMixingMethod(bLinear);
 }
 
+void CAPU::SetVRC7NativeRate(bool bNative)		// // //
+{
+	for (auto &c : m_pSoundChips)
+		if (auto *pVRC7 = dynamic_cast<CVRC7 *>(c.get()))
+			pVRC7->SetNativeRate(bNative);
+}
+
 void CAPU::SetMeterDecayRate(decay_rate_t Type) const		// // // 050B
 {
 	m_pMixer->SetMeterDecayRate(Type);
@@ -347,12 +409,6 @@ decay_rate_t CAPU::GetMeterDecayRate() const		// // // 050B
 	return m_pMixer->GetMeterDecayRate();
 }
 
-void CAPU::LogWrite(uint16_t Address, uint8_t Value)
-{
-	for (auto *r : m_pActiveChips)		// // //
-		r->Log(Address, Value);
-}
-
 uint8_t CAPU::GetReg(sound_chip_t Chip, int Reg) const
 {
 	if (auto *r = GetRegState(Chip, Reg))		// // //
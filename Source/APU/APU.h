@@ -43,7 +43,7 @@ enum chip_level_t : unsigned char;		// // //
 class CFile;
 #endif
 
-class CAPU : public CAPUInterface {
+class CAPU final : public CAPUInterface {		// // //
 public:
 	explicit CAPU(IAudioCallback *pCallback = nullptr);		// // //
 	~CAPU();
@@ -70,6 +70,7 @@ public:
 	void	SetChipLevel(chip_level_t Chip, float Level);
 
 	void	SetNamcoMixing(bool bLinear);		// // //
+	void	SetVRC7NativeRate(bool bNative);		// // //
 
 	void	SetMeterDecayRate(decay_rate_t Type) const;		// // // 050B
 	decay_rate_t GetMeterDecayRate() const;		// // // 050B
@@ -83,7 +84,17 @@ public:
 private:
 	void StepSequence();		// // //
 
-	void LogWrite(uint16_t Address, uint8_t Value);
+	void FlushWrites();		// // //
+	void UpdateAddressMap();		// // //
+
+private:
+	struct stRegisterWrite {		// // //
+		uint16_t Address;
+		uint8_t Value;
+	};
+
+	static constexpr int16_t REG_VOLATILE = -2;		// // // Register writes always reach the chip
+	static constexpr int16_t REG_UNKNOWN = -1;		// // // Register is idempotent, value not known yet
 
 private:
 	std::unique_ptr<CMixer> m_pMixer;		// // //
@@ -93,6 +104,11 @@ private:
 	std::vector<std::unique_ptr<CSoundChip>> m_pSoundChips;		// // //
 	std::vector<CSoundChip *> m_pActiveChips;		// // //
 
+	// // // Register writes
+	std::vector<stRegisterWrite> m_RegisterWrites;		// Writes staged since the last flush, all at the current time
+	std::vector<uint8_t> m_iAddressChips;				// Bit mask of the active chips that decode each address
+	std::vector<int16_t> m_iRegisterShadow;				// Last value written to each idempotent register
+
 	CSoundChipSet m_iExternalSoundChip;				// // // External sound chip, if used
 
 	uint32_t	m_iSampleRate;						// // //
@@ -105,7 +121,7 @@ private:
 	uint32_t	m_iSampleSizeShift;					// To convert samples to bytes
 	uint32_t	m_iSoundBufferSize;					// Size of buffer, in samples
 	uint32_t	m_iBufferPointer;					// Fill pos in buffer
-	std::unique_ptr<int16_t[]> m_pSoundBuffer;			// // // Sound transfer buffer
+	std::unique_ptr<float[]> m_pSoundBuffer;			// // // Sound transfer buffer
 
 	uint32_t	m_iFrameCycles;						// Cycles emulated from start of frame
 	uint32_t	m_iSequencerClock;					// Clock for frame sequencer
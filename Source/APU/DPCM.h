@@ -27,7 +27,7 @@
 #include "APU/SampleMem.h"		// // //
 #include "array_view.h"		// // //
 
-class CDPCM : public C2A03Chan {
+class CDPCM final : public C2A03Chan {		// // //
 public:
 	CDPCM(CMixer &Mixer, std::uint8_t nInstance);		// // //
 
@@ -24,6 +24,7 @@
 #include "RegisterState.h"		// // //
 #include "APU/ext/FDSSound_new.h"		// // //
 #include "APU/Types.h"		// // //
+#include <algorithm>		// // //
 
 // FDS interface, actual FDS emulation is in FDSSound.cpp
 
@@ -53,6 +54,11 @@ void CFDS::Write(uint16_t Address, uint8_t Value)
 	emu_->Write(Address, Value);
 }
 
+bool CFDS::IsAddressMapped(uint16_t Address) const		// // //
+{
+	return Address == 0x4023 || (Address >= 0x4040 && Address <= 0x408F);
+}
+
 uint8_t CFDS::Read(uint16_t Address, bool &Mapped)
 {
 	uint32_t val = 0;
@@ -73,6 +79,18 @@ void CFDS::Process(uint32_t Time)
 	const uint32_t TIME_STEP = 32u; // ???
 
 	while (Time) {
+		// // // Skip whole steps during which the output cannot change, this gives
+		// the same result as rendering every step since only Tick has side effects
+		uint32_t Quiet = std::min(emu_->GetQuietClocks(), Time);
+		if (Quiet < Time)
+			Quiet -= Quiet % TIME_STEP;
+		if (Quiet) {
+			emu_->Tick(Quiet);
+			m_iTime += Quiet;
+			Time -= Quiet;
+			continue;
+		}
+
 		const uint32_t t = Time < TIME_STEP ? Time : TIME_STEP;
 		emu_->Tick(t);
 		Mix(emu_->Render());
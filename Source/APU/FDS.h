@@ -30,7 +30,7 @@ namespace xgm {		// // //
 class NES_FDS;
 } // namespace xgm
 
-class CFDS : public CSoundChip, public CChannel {
+class CFDS final : public CSoundChip, public CChannel {		// // //
 public:
 	CFDS(CMixer &Mixer, std::uint8_t nInstance);		// // //
 	virtual ~CFDS();
@@ -42,6 +42,7 @@ public:
 	void	EndFrame() override;
 
 	void	Write(uint16_t Address, uint8_t Value) override;
+	bool	IsAddressMapped(uint16_t Address) const override;		// // //
 	uint8_t	Read(uint16_t Address, bool &Mapped) override;
 
 	double	GetFreq(int Channel) const override;		// // //
@@ -94,6 +94,22 @@ void CMMC5::Write(uint16_t Address, uint8_t Value)
 	}
 }
 
+bool CMMC5::IsAddressMapped(uint16_t Address) const		// // //
+{
+	return (Address >= 0x5000 && Address <= 0x5015) ||
+		Address == 0x5205 || Address == 0x5206 ||
+		(Address >= 0x5C00 && Address <= 0x5FF5);
+}
+
+bool CMMC5::IsRegisterIdempotent(uint16_t Address) const		// // //
+{
+	switch (Address) {
+	case 0x5000: case 0x5002: case 0x5004: case 0x5006:
+		return true;
+	}
+	return false;
+}
+
 uint8_t CMMC5::Read(uint16_t Address, bool &Mapped)
 {
 	if (Address >= 0x5C00 && Address <= 0x5FF5) {
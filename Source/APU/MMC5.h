@@ -26,7 +26,7 @@
 #include "APU/SoundChip.h"
 #include "APU/Square.h"		// // //
 
-class CMMC5 : public CSoundChip {
+class CMMC5 final : public CSoundChip {		// // //
 public:
 	CMMC5(CMixer &Mixer, std::uint8_t nInstance);		// // //
 
@@ -37,6 +37,8 @@ public:
 	void EndFrame() override;
 
 	void Write(uint16_t Address, uint8_t Value) override;
+	bool IsAddressMapped(uint16_t Address) const override;		// // //
+	bool IsRegisterIdempotent(uint16_t Address) const override;		// // //
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
 
 	double GetFreq(int Channel) const override;		// // //
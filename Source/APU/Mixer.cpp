@@ -190,10 +190,12 @@ void CMixer::UpdateSettings(int LowCut,	int HighCut, int HighDamp, float Overall
 	VisitMixers([&] (auto &levels) {
 		levels.SetVolume(Volume);
 	});
+	levelsN163_.SetVolume(Volume * m_fNamcoVolume);		// // //
 }
 
 void CMixer::SetNamcoVolume(float fVol)
 {
+	m_fNamcoVolume = fVol;		// // // kept for later settings changes
 	float fVolume = fVol * m_fOverallVol * GetAttenuation();
 
 	levelsN163_.SetVolume(fVolume);
@@ -286,9 +288,9 @@ void CMixer::AddValue(stChannelID ChanID, int Value, int FrameCycles) {		// // /
 	});
 }
 
-int CMixer::ReadBuffer(int Size, void *Buffer, bool Stereo)
+int CMixer::ReadBuffer(int Size, float *Buffer, bool Stereo)		// // //
 {
-	return BlipBuffer.read_samples((blip_sample_t*)Buffer, Size);
+	return BlipBuffer.read_samples(Buffer, Size);
 }
 
 int32_t CMixer::GetChanOutput(stChannelID Chan) const		// // //
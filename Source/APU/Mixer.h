@@ -60,7 +60,7 @@ public:
 	uint32_t	GetMixSampleCount(int t) const;
 
 	void	AddSample(int ChanID, int Value);
-	int		ReadBuffer(int Size, void *Buffer, bool Stereo);
+	int		ReadBuffer(int Size, float *Buffer, bool Stereo);		// // //
 
 	int32_t	GetChanOutput(stChannelID Chan) const;		// // //
 	void	SetChipLevel(chip_level_t Chip, float Level);
@@ -113,6 +113,7 @@ private:
 	int			m_iHighCut = 0;
 	int			m_iHighDamp = 0;
 	float		m_fOverallVol = 1.f;
+	float		m_fNamcoVolume = 1.f;		// // //
 
 	bool		m_bNamcoMixing = false;		// // //
 };
@@ -42,14 +42,14 @@
 CN163::CN163(CMixer &Mixer, std::uint8_t nInstance) :
 	CSoundChip(Mixer, nInstance),		// // //
 	m_Channels {
-		{Mixer, nInstance, *this, n163_subindex_t::ch1, m_iWaveData},
-		{Mixer, nInstance, *this, n163_subindex_t::ch2, m_iWaveData},
-		{Mixer, nInstance, *this, n163_subindex_t::ch3, m_iWaveData},
-		{Mixer, nInstance, *this, n163_subindex_t::ch4, m_iWaveData},
-		{Mixer, nInstance, *this, n163_subindex_t::ch5, m_iWaveData},
-		{Mixer, nInstance, *this, n163_subindex_t::ch6, m_iWaveData},
-		{Mixer, nInstance, *this, n163_subindex_t::ch7, m_iWaveData},
-		{Mixer, nInstance, *this, n163_subindex_t::ch8, m_iWaveData},
+		{Mixer, nInstance, *this, n163_subindex_t::ch1, m_iWaveSamples},
+		{Mixer, nInstance, *this, n163_subindex_t::ch2, m_iWaveSamples},
+		{Mixer, nInstance, *this, n163_subindex_t::ch3, m_iWaveSamples},
+		{Mixer, nInstance, *this, n163_subindex_t::ch4, m_iWaveSamples},
+		{Mixer, nInstance, *this, n163_subindex_t::ch5, m_iWaveSamples},
+		{Mixer, nInstance, *this, n163_subindex_t::ch6, m_iWaveSamples},
+		{Mixer, nInstance, *this, n163_subindex_t::ch7, m_iWaveSamples},
+		{Mixer, nInstance, *this, n163_subindex_t::ch8, m_iWaveSamples},
 	}
 {
 	m_pRegisterLogger->AddRegisterRange(0x00, 0x7F);		// // //
@@ -71,6 +71,8 @@ void CN163::Reset()
 	m_iChannelCntr = 0;
 	m_iLastChan = m_iActiveChan = 7;		// // //
 	m_iCycle = 0;
+
+	UpdateMixerVolume();		// // //
 }
 
 void CN163::SetMixingMethod(bool bLinear)		// // //
@@ -78,6 +80,16 @@ void CN163::SetMixingMethod(bool bLinear)		// // //
 	m_bOldMixing = bLinear;
 	for (auto &ch : m_Channels)
 		ch.Reset();
+	UpdateMixerVolume();
+}
+
+void CN163::UpdateMixerVolume()		// // //
+{
+	// only changes with the channel count, so this is done on register writes instead of every update
+	if (m_bOldMixing)
+		m_pMixer->SetNamcoVolume((m_iChansInUse == 0) ? 1.0f : 0.75f);
+	else
+		m_pMixer->SetNamcoVolume((m_iChansInUse == 0) ? 1.3f : (1.5f + float(m_iChansInUse - 1) / 1.5f));
 }
 
 void CN163::Process(uint32_t Time)
@@ -89,13 +101,26 @@ void CN163::Process(uint32_t Time)
 
 	const uint32_t CHAN_PERIOD = 15;		// 15 cycles/channel
 
-	m_pMixer->SetNamcoVolume((m_iChansInUse == 0) ? 1.3f : (1.5f + float(m_iChansInUse - 1) / 1.5f));
+	// // // a single running channel never hands the DAC over, so it is synthesized in one block
+	if (Time > 0 && m_iChansInUse == 0 && m_iActiveChan == MAX_CHANNELS_N163 - 1 && m_iLastChan == m_iActiveChan &&
+		m_Channels[m_iActiveChan].IsRunning()) {
+		m_Channels[m_iActiveChan].Process(Time, false);
+		m_iGlobalTime += Time;
+		m_iChannelCntr = (m_iChannelCntr + Time) % CHAN_PERIOD;
+		return;
+	}
 
 	while (Time > 0) {
 		uint32_t TimeToRun = std::min(Time, CHAN_PERIOD - m_iChannelCntr);		// // //
-
-		Mix(0, 0, m_Channels[m_iLastChan].GetChannelType());		// // //
-		m_Channels[m_iActiveChan].Process(TimeToRun, m_iChansInUse + 1);		// // //
+		uint32_t NextChan = m_iActiveChan;
+		if (TimeToRun == CHAN_PERIOD - m_iChannelCntr && TimeToRun < Time)
+			NextChan = (m_iActiveChan + m_iChansInUse < MAX_CHANNELS_N163 ? MAX_CHANNELS_N163 : m_iActiveChan) - 1;
+
+		// // // the DAC is only released when another channel takes it over, and a sample
+		// computed right at a handover within this update is never heard
+		if (m_iLastChan != m_iActiveChan)
+			Mix(0, 0, m_Channels[m_iLastChan].GetChannelType());
+		m_Channels[m_iActiveChan].Process(TimeToRun, NextChan != m_iActiveChan);
 		m_iLastChan = m_iActiveChan;
 
 		Time -= TimeToRun;
@@ -113,8 +138,6 @@ void CN163::Process(uint32_t Time)
 
 void CN163::ProcessOld(uint32_t Time)		// // //
 {
-	m_pMixer->SetNamcoVolume((m_iChansInUse == 0) ? 1.0f : 0.75f);
-
 	for (int i = 7 - m_iChansInUse; i < MAX_CHANNELS_N163; ++i)
 		m_Channels[i].ProcessClean(Time, m_iChansInUse + 1);
 }
@@ -156,13 +179,17 @@ void CN163::Write(uint16_t Address, uint8_t Value)
 	switch (Address) {
 		case 0x4800:
 			m_iWaveData[Area] = Value;
+			m_iWaveSamples[Area << 1] = Value & 0x0F;		// // //
+			m_iWaveSamples[(Area << 1) | 1] = Value >> 4;
 
 			if (Area >= 0x40) {
 				int Channel = (Area & 0x3F) >> 3;
 				m_Channels[Channel].Write(Area & 0x07, Value);
 
-				if (Area == 0x7F)
+				if (Area == 0x7F && m_iChansInUse != ((Value >> 4) & 0x07)) {		// // //
 					m_iChansInUse = (Value >> 4) & 0x07;
+					UpdateMixerVolume();
+				}
 			}
 
 			if (m_iExpandAddr & 0x80)
@@ -175,6 +202,11 @@ void CN163::Write(uint16_t Address, uint8_t Value)
 	}
 }
 
+bool CN163::IsAddressMapped(uint16_t Address) const		// // //
+{
+	return Address == 0x4800 || Address == 0xF800;
+}
+
 void CN163::Log(uint16_t Address, uint8_t Value)		// // //
 {
 	switch (Address) {
@@ -229,9 +261,9 @@ uint8_t CN163::ReadMem(uint8_t Reg)
 // N163 channels
 //
 
-CN163Chan::CN163Chan(CMixer &Mixer, std::uint8_t nInstance, CN163 &parent, n163_subindex_t subindex, uint8_t *pWaveData) :		// // //
+CN163Chan::CN163Chan(CMixer &Mixer, std::uint8_t nInstance, CN163 &parent, n163_subindex_t subindex, const uint8_t *pWaveSamples) :		// // //
 	CChannel(Mixer, {nInstance, sound_chip_t::N163, value_cast(subindex)}),
-	m_pWaveData(pWaveData), parent_(parent)
+	m_pWaveSamples(pWaveSamples), parent_(parent)
 {
 	Reset();
 }
@@ -282,13 +314,13 @@ void CN163Chan::Write(uint16_t Address, uint8_t Value)
 	}
 }
 
-void CN163Chan::Process(uint32_t Time, uint8_t ChannelsActive)		// // //
+void CN163Chan::Process(uint32_t Time, bool bHandover)		// // //
 {
 	uint32_t TimeStamp = 0;
 
 	parent_.Mix(m_iLastSample, TimeStamp, m_iChanId);
 
-	if (!m_iFrequency || !m_iWaveLength) {
+	if (!IsRunning()) {
 		m_iLastSample = 0;
 		m_iTime += Time;
 		return;
@@ -300,18 +332,10 @@ void CN163Chan::Process(uint32_t Time, uint8_t ChannelsActive)		// // //
 		TimeStamp += m_iCounter;
 		m_iCounter = 15;
 
-		m_iPhase = (m_iPhase + m_iFrequency) % m_iWaveLength;
-
-		int WavePtr = m_iPhase >> 16;
-
-		uint8_t Sample = m_pWaveData[((WavePtr + m_iWaveOffset) & 0xFF) >> 1];
+		m_iLastSample = Step() * m_iVolume;
 
-		if (WavePtr & 1)
-			Sample >>= 4;
-
-		m_iLastSample = (Sample & 0x0F) * m_iVolume;
-
-		parent_.Mix(m_iLastSample, TimeStamp, m_iChanId);
+		if (Time > 0 || !bHandover)		// // //
+			parent_.Mix(m_iLastSample, TimeStamp, m_iChanId);
 	}
 
 	m_iCounter -= Time;
@@ -322,7 +346,7 @@ void CN163Chan::ProcessClean(uint32_t Time, uint8_t ChannelsActive)
 {
 	// legacy
 
-	if (!m_iFrequency || !m_iWaveLength) {
+	if (!IsRunning()) {		// // //
 		m_iTime += Time;
 		return;
 	}
@@ -332,22 +356,29 @@ void CN163Chan::ProcessClean(uint32_t Time, uint8_t ChannelsActive)
 		m_iTime += m_iCounter;
 		m_iCounter = 15 * ChannelsActive;
 
-		m_iPhase = (m_iPhase + m_iFrequency) % m_iWaveLength;
-
-		int WavePtr = m_iPhase >> 16;
-
-		uint8_t Sample = m_pWaveData[((WavePtr + m_iWaveOffset) & 0xFF) >> 1];
-
-		if (WavePtr & 1)
-			Sample >>= 4;
-
-		Mix((Sample & 0x0F) * m_iVolume);
+		Mix(Step() * m_iVolume);		// // //
 	}
 
 	m_iCounter -= Time;
 	m_iTime += Time;
 }
 
+uint8_t CN163Chan::Step()		// // //
+{
+	m_iPhase += m_iFrequency;
+	if (m_iPhase >= m_iWaveLength)
+		m_iPhase %= m_iWaveLength;
+
+	// the sample offset selects the byte, the phase alone selects the nibble
+	int WavePtr = m_iPhase >> 16;
+	return m_pWaveSamples[((WavePtr + m_iWaveOffset) & 0xFE) | (WavePtr & 1)];
+}
+
+bool CN163Chan::IsRunning() const		// // //
+{
+	return m_iFrequency && m_iWaveLength;
+}
+
 uint8_t CN163Chan::ReadMem(uint8_t Reg)
 {
 	switch (Reg & 7) {
@@ -31,20 +31,24 @@ class CMixer;
 
 class CN163;		// // //
 
-class CN163Chan : public CChannel {
+class CN163Chan final : public CChannel {		// // //
 public:
-	CN163Chan(CMixer &Mixer, std::uint8_t nInstance, CN163 &parent, n163_subindex_t subindex, uint8_t *pWaveData);		// // //
+	CN163Chan(CMixer &Mixer, std::uint8_t nInstance, CN163 &parent, n163_subindex_t subindex, const uint8_t *pWaveSamples);		// // //
 
 	void Reset();
 	void Write(uint16_t Address, uint8_t Value);
 
-	void Process(uint32_t Time, uint8_t ChannelsActive);		// // //
+	void Process(uint32_t Time, bool bHandover);		// // //
 	void ProcessClean(uint32_t Time, uint8_t ChannelsActive);		// // //
 
 	uint8_t ReadMem(uint8_t Reg);
+	bool IsRunning() const;		// // //
 	void ResetCounter();
 	double GetFrequency() const;		// // //
 
+private:
+	uint8_t Step();		// // //
+
 private:
 	uint32_t	m_iCounter, m_iFrequency;
 	uint32_t	m_iPhase;
@@ -52,14 +56,14 @@ private:
 
 	uint8_t		m_iVolume;
 	uint8_t		m_iWaveOffset;
-	uint8_t		*m_pWaveData;
+	const uint8_t	*m_pWaveSamples;		// // //
 
 	uint8_t		m_iLastSample;
 
 	CN163		&parent_;
 };
 
-class CN163 : public CSoundChip {
+class CN163 final : public CSoundChip {		// // //
 public:
 	CN163(CMixer &Mixer, std::uint8_t nInstance);		// // //
 
@@ -70,6 +74,7 @@ public:
 	void EndFrame() override;
 
 	void Write(uint16_t Address, uint8_t Value) override;
+	bool IsAddressMapped(uint16_t Address) const override;		// // //
 	uint8_t Read(uint16_t Address, bool &Mapped);
 	uint8_t ReadMem(uint8_t Reg);
 
@@ -82,11 +87,13 @@ public:
 
 protected:
 	void ProcessOld(uint32_t Time);		// // //
+	void UpdateMixerVolume();		// // //
 
 private:
 	CN163Chan	m_Channels[MAX_CHANNELS_N163];		// // //
 
 	uint8_t		m_iWaveData[0x80] = { };		// // //
+	uint8_t		m_iWaveSamples[0x100] = { };		// // // 4-bit samples unpacked from the wave RAM
 	uint8_t		m_iExpandAddr = 0;
 	uint8_t		m_iChansInUse = 0;
 
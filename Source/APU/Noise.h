@@ -31,7 +31,7 @@
 #include "APU/2A03Chan.h"		// // //
 #include "array_view.h"		// // //
 
-class CNoise : public C2A03Chan {
+class CNoise final : public C2A03Chan {		// // //
 public:
 	CNoise(CMixer &Mixer, std::uint8_t nInstance);		// // //
 
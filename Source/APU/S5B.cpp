@@ -176,6 +176,11 @@ void CS5B::Write(uint16_t Address, uint8_t Value)
 	}
 }
 
+bool CS5B::IsAddressMapped(uint16_t Address) const		// // //
+{
+	return Address == 0xC000 || Address == 0xE000;
+}
+
 uint8_t CS5B::Read(uint16_t Address, bool &Mapped)
 {
 	Mapped = false;
@@ -28,7 +28,7 @@
 
 // // // 050B
 
-class CS5BChannel : public CChannel
+class CS5BChannel final : public CChannel		// // //
 {
 public:
 	friend class CS5B;
@@ -53,7 +53,7 @@ private:
 	bool m_bNoiseDisable;
 };
 
-class CS5B : public CSoundChip
+class CS5B final : public CSoundChip		// // //
 {
 public:
 	CS5B(CMixer &Mixer, std::uint8_t nInstance);
@@ -65,6 +65,7 @@ public:
 	void	EndFrame() override;
 
 	void	Write(uint16_t Address, uint8_t Value) override;
+	bool	IsAddressMapped(uint16_t Address) const override;		// // //
 	uint8_t	Read(uint16_t Address, bool &Mapped) override;
 
 	void	Log(uint16_t Address, uint8_t Value) override;		// // //
@@ -38,6 +38,11 @@ double CSoundChip::GetFreq(int Channel) const		// // //
 	return 0.0;
 }
 
+bool CSoundChip::IsRegisterIdempotent(uint16_t Address) const		// // //
+{
+	return false;
+}
+
 void CSoundChip::Log(uint16_t Address, uint8_t Value)		// // //
 {
 	// default logger operation
@@ -44,6 +44,10 @@ public:
 	virtual void	Write(uint16_t Address, uint8_t Value) = 0;
 	virtual uint8_t	Read(uint16_t Address, bool &Mapped) = 0;
 
+	// // // Address decoding, used by the APU to route register writes
+	virtual bool	IsAddressMapped(uint16_t Address) const = 0;		// Writes or logs to this address may have an effect
+	virtual bool	IsRegisterIdempotent(uint16_t Address) const;		// Writing the current value again changes nothing
+
 	virtual double	GetFreq(int Channel) const;		// // //
 
 	virtual void	Log(uint16_t Address, uint8_t Value);		// // //
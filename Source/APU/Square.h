@@ -30,7 +30,7 @@
 
 #include "APU/2A03Chan.h"		// // //
 
-class CSquare : public C2A03Chan {
+class CSquare final : public C2A03Chan {		// // //
 public:
 	CSquare(CMixer &Mixer, std::uint8_t nInstance, sound_chip_t Chip, std::uint8_t subindex);		// // //
 	~CSquare();
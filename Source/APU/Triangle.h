@@ -30,7 +30,7 @@
 
 #include "APU/2A03Chan.h"		// // //
 
-class CTriangle : public C2A03Chan {
+class CTriangle final : public C2A03Chan {		// // //
 public:
 	CTriangle(CMixer &Mixer, std::uint8_t nInstance);		// // //
 	~CTriangle();
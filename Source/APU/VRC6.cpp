@@ -207,6 +207,23 @@ void CVRC6::Write(uint16_t Address, uint8_t Value)
 	}
 }
 
+bool CVRC6::IsAddressMapped(uint16_t Address) const		// // //
+{
+	return (Address >= 0x9000 && Address <= 0x9003) ||
+		(Address >= 0xA000 && Address <= 0xA002) ||
+		(Address >= 0xB000 && Address <= 0xB002);
+}
+
+bool CVRC6::IsRegisterIdempotent(uint16_t Address) const		// // //
+{
+	// Pulse volume writes mix immediately, enable writes may reset the phase
+	switch (Address) {
+	case 0x9001: case 0xA001: case 0xB000: case 0xB001:
+		return true;
+	}
+	return false;
+}
+
 uint8_t CVRC6::Read(uint16_t Address, bool &Mapped)
 {
 	Mapped = false;
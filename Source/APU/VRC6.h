@@ -26,7 +26,7 @@
 #include "APU/SoundChip.h"
 #include "APU/Channel.h"
 
-class CVRC6_Pulse : public CChannel {
+class CVRC6_Pulse final : public CChannel {		// // //
 public:
 	CVRC6_Pulse(CMixer &Mixer, std::uint8_t nInstance, vrc6_subindex_t subindex);		// // //
 	void Reset();
@@ -46,7 +46,7 @@ private:
 	uint8_t	m_iDutyCycleCounter;
 };
 
-class CVRC6_Sawtooth : public CChannel {
+class CVRC6_Sawtooth final : public CChannel {		// // //
 public:
 	CVRC6_Sawtooth(CMixer &Mixer, std::uint8_t nInstance);		// // //
 	void Reset();
@@ -65,7 +65,7 @@ private:
 	int32_t	m_iCounter;
 };
 
-class CVRC6 : public CSoundChip {
+class CVRC6 final : public CSoundChip {		// // //
 public:
 	explicit CVRC6(CMixer &Mixer, std::uint8_t nInstance);
 
@@ -76,6 +76,8 @@ public:
 	void EndFrame() override;
 
 	void Write(uint16_t Address, uint8_t Value) override;
+	bool IsAddressMapped(uint16_t Address) const override;		// // //
+	bool IsRegisterIdempotent(uint16_t Address) const override;		// // //
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
 
 	double GetFreq(int Channel) const override;		// // //
@@ -23,9 +23,67 @@
 #include "APU/VRC7.h"
 #include "APU/Mixer.h"		// // //
 #include "RegisterState.h"		// // //
+#include "resampler/sinc.hpp"		// // //
+#include <algorithm>		// // //
+#include <cmath>		// // //
 
 const float  CVRC7::AMPLIFY	  = 4.6f;		// Mixing amplification, VRC7 patch 14 is 4,88 times stronger than a 50% square @ v=15
 const uint32_t CVRC7::OPL_CLOCK = 3579545;	// Clock frequency
+const uint32_t CVRC7::OPL_RATE  = 49716;	// // // Native sample rate, OPL_CLOCK / 72
+
+// // // Converts native rate OPLL output to the output rate with a polyphase FIR filter
+// built from a windowed sinc, generating native samples on demand
+class CVRC7::CResampler
+{
+public:
+	CResampler(OPLL *pOPLL, double Ratio) :
+		m_pOPLL(pOPLL), m_iStep(uint64_t(std::llround(double(1ull << FRAC_BITS) / Ratio)))
+	{
+		const jarh::sinc Sinc(512, 64);
+		const float Step = std::min(1.f, float(Ratio)) * CUTOFF;		// also scales the filter to unity gain
+		m_iTaps = 1 + unsigned(2 * Sinc.range() / Step);
+		m_fCoefs.resize(PHASES * m_iTaps);
+		for (unsigned p = 0; p < PHASES; ++p)
+			for (unsigned k = 0; k < m_iTaps; ++k)
+				m_fCoefs[p * m_iTaps + k] = Sinc((float(m_iTaps / 2) + float(p) / PHASES - k) * Step) * Step;
+	}
+
+	void Get(float *pOut, uint32_t Count) {
+		for (uint32_t i = 0; i < Count; ++i) {
+			const uint64_t Pos = (m_iPos + (1ull << (FRAC_BITS - PHASE_BITS - 1))) >> (FRAC_BITS - PHASE_BITS);
+			const std::size_t Index = std::size_t(Pos >> PHASE_BITS);
+			// Clipping is slightly asymmetric
+			while (m_fInput.size() < Index + m_iTaps)
+				m_fInput.push_back((float)std::clamp<int32_t>(OPLL_calc(m_pOPLL), -3200, 3600));
+
+			const float *x = m_fInput.data() + Index;
+			const float *h = m_fCoefs.data() + (Pos & (PHASES - 1)) * m_iTaps;
+			float Sum = 0.f;
+			for (unsigned k = 0; k < m_iTaps; ++k)
+				Sum += x[k] * h[k];
+			pOut[i] = Sum;
+			m_iPos += m_iStep;
+		}
+
+		// drop the input that no later output can reach
+		const std::size_t Used = std::min(std::size_t(m_iPos >> FRAC_BITS), m_fInput.size());
+		m_fInput.erase(m_fInput.begin(), m_fInput.begin() + Used);
+		m_iPos -= uint64_t(Used) << FRAC_BITS;
+	}
+
+private:
+	static constexpr int FRAC_BITS = 32;
+	static constexpr int PHASE_BITS = 9;
+	static constexpr unsigned PHASES = 1u << PHASE_BITS;
+	static constexpr float CUTOFF = .9f;
+
+	OPLL *m_pOPLL;
+	unsigned m_iTaps = 0;
+	std::vector<float> m_fCoefs;		// PHASES rows of m_iTaps coefficients
+	std::vector<float> m_fInput;
+	uint64_t m_iPos = 0;		// input position of the next output sample, fixed point
+	uint64_t m_iStep;
+};
 
 CVRC7::CVRC7(CMixer &Mixer, std::uint8_t nInstance) : CSoundChip(Mixer, nInstance)
 {
@@ -36,6 +94,8 @@ CVRC7::CVRC7(CMixer &Mixer, std::uint8_t nInstance) : CSoundChip(Mixer, nInstanc
 	Reset();
 }
 
+CVRC7::~CVRC7() = default;		// // //
+
 sound_chip_t CVRC7::GetID() const {		// // //
 	return sound_chip_t::VRC7;
 }
@@ -48,14 +108,43 @@ void CVRC7::Reset()
 
 void CVRC7::SetSampleSpeed(uint32_t SampleRate, double ClockRate, uint32_t FrameRate)
 {
-	m_pOPLLInt.reset(OPLL_new(OPL_CLOCK, SampleRate));		// // //
+	m_iSampleRate = SampleRate;		// // //
+	m_iFrameRate = FrameRate;
+	CreateOPLL();
+}
+
+void CVRC7::SetNativeRate(bool bNative)		// // //
+{
+	// OPLL runs at its own 49716 Hz rate and is resampled once per frame, so that
+	// the envelope and phase tables no longer depend on the output rate. This is a
+	// quality option: below 48 kHz it costs more than direct synthesis, since more
+	// samples are synthesized than are output
+	if (m_bNativeRate != bNative) {
+		m_bNativeRate = bNative;
+		if (m_iSampleRate)
+			CreateOPLL();
+	}
+}
+
+void CVRC7::CreateOPLL()		// // //
+{
+	m_pOPLLInt.reset(OPLL_new(OPL_CLOCK, m_bNativeRate ? OPL_RATE : m_iSampleRate));
 
 	OPLL_reset(m_pOPLLInt.get());
 	OPLL_reset_patch(m_pOPLLInt.get(), 1);
 
-	m_iMaxSamples = (SampleRate / FrameRate) * 2;	// Allow some overflow
+	m_iMaxSamples = (m_iSampleRate / m_iFrameRate) * 2;	// Allow some overflow
 
-	m_iBuffer = std::vector<int16_t>(m_iMaxSamples);		// // //
+	m_iBuffer = std::vector<int16_t>(m_iMaxSamples);
+
+	if (m_bNativeRate) {
+		m_pResampler = std::make_unique<CResampler>(m_pOPLLInt.get(), m_iSampleRate / (OPL_CLOCK / 72.));
+		m_fResampled = std::vector<float>(m_iMaxSamples);
+	}
+	else {
+		m_pResampler.reset();
+		m_fResampled.clear();
+	}
 }
 
 void CVRC7::SetVolume(float Volume)
@@ -75,6 +164,11 @@ void CVRC7::Write(uint16_t Address, uint8_t Value)
 	}
 }
 
+bool CVRC7::IsAddressMapped(uint16_t Address) const		// // //
+{
+	return Address == 0x9010 || Address == 0x9030;
+}
+
 void CVRC7::Log(uint16_t Address, uint8_t Value)		// // //
 {
 	switch (Address) {
@@ -94,6 +188,13 @@ void CVRC7::EndFrame()
 
 	static int32_t LastSample = 0;
 
+	if (m_pResampler) {		// // // resample one frame of native rate output
+		m_pResampler->Get(m_fResampled.data(), WantSamples);
+		for (uint32_t i = 0; i < WantSamples; ++i)
+			m_iBuffer[i] = int16_t(std::clamp(int(m_fResampled[i] * m_fVolume), -32768, 32767));
+		m_iBufferPtr = WantSamples;
+	}
+
 	// Generate VRC7 samples
 	while (m_iBufferPtr < WantSamples) {
 		int32_t RawSample = OPLL_calc(m_pOPLLInt.get());
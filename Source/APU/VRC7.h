@@ -26,6 +26,7 @@
 #include "APU/SoundChip.h"
 #include "APU/ext/emu2413.h"		// // //
 #include <vector>		// // //
+#include <memory>		// // //
 
 struct OPLL_deleter {
 	void operator()(void *ptr) {
@@ -33,13 +34,15 @@ struct OPLL_deleter {
 	}
 };
 
-class CVRC7 : public CSoundChip {
+class CVRC7 final : public CSoundChip {		// // //
 public:
 	CVRC7(CMixer &Mixer, std::uint8_t nInstance);		// // //
+	~CVRC7();		// // //
 
 	sound_chip_t GetID() const override;		// // //
 
 	void SetSampleSpeed(uint32_t SampleRate, double ClockRate, uint32_t FrameRate);
+	void SetNativeRate(bool bNative);		// // //
 	void SetVolume(float Volume);
 
 	void Reset() override;
@@ -47,6 +50,7 @@ public:
 	void EndFrame() override;
 
 	void Write(uint16_t Address, uint8_t Value) override;
+	bool IsAddressMapped(uint16_t Address) const override;		// // //
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
 
 	void Log(uint16_t Address, uint8_t Value) override;		// // //
@@ -56,6 +60,12 @@ public:
 protected:
 	static const float  AMPLIFY;
 	static const uint32_t OPL_CLOCK;
+	static const uint32_t OPL_RATE;		// // //
+
+private:
+	class CResampler;		// // //
+
+	void CreateOPLL();		// // //
 
 private:
 	std::unique_ptr<OPLL, OPLL_deleter> m_pOPLLInt;		// // //
@@ -67,5 +77,12 @@ private:
 
 	float		m_fVolume = 1.f;
 
+	// // // native rate synthesis
+	bool		m_bNativeRate = false;
+	uint32_t	m_iSampleRate = 0;
+	uint32_t	m_iFrameRate = 0;
+	std::unique_ptr<CResampler> m_pResampler;
+	std::vector<float> m_fResampled;
+
 	uint8_t		m_iSoundReg = 0;
 };
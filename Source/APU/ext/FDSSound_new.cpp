@@ -24,11 +24,21 @@
 #include "APU/Types.h"
 #include <cstring>
 #include <cmath>
+#include <algorithm>		// // //
 
 namespace xgm {
 
 const int RC_BITS = 12;
 
+// 8 bit approximation of master volume
+const double MASTER_VOL = 2.4 * 1223.0; // max FDS vol vs max APU square (arbitrarily 1223)
+const double MAX_OUT = 32.0f * 63.0f; // value that should map to master vol
+const int32_t MASTER[4] = {
+    int((MASTER_VOL / MAX_OUT) * 256.0 * 2.0f / 2.0f),
+    int((MASTER_VOL / MAX_OUT) * 256.0 * 2.0f / 3.0f),
+    int((MASTER_VOL / MAX_OUT) * 256.0 * 2.0f / 4.0f),
+    int((MASTER_VOL / MAX_OUT) * 256.0 * 2.0f / 5.0f) };
+
 NES_FDS::NES_FDS ()
 {
     option[OPT_CUTOFF] = 2000;
@@ -82,6 +92,7 @@ void NES_FDS::Reset ()
     last_vol = 0;
 
     rc_accum = 0;
+    fout = 0;		// // //
 
     for (int i=0; i<2; ++i)
     {
@@ -244,15 +255,6 @@ void NES_FDS::Tick (uint32_t clocks)
 
 int32_t NES_FDS::Render ()		// // //
 {
-    // 8 bit approximation of master volume
-    const double MASTER_VOL = 2.4 * 1223.0; // max FDS vol vs max APU square (arbitrarily 1223)
-    const double MAX_OUT = 32.0f * 63.0f; // value that should map to master vol
-    const int32_t MASTER[4] = {
-        int((MASTER_VOL / MAX_OUT) * 256.0 * 2.0f / 2.0f),
-        int((MASTER_VOL / MAX_OUT) * 256.0 * 2.0f / 3.0f),
-        int((MASTER_VOL / MAX_OUT) * 256.0 * 2.0f / 4.0f),
-        int((MASTER_VOL / MAX_OUT) * 256.0 * 2.0f / 5.0f) };
-
     int32_t v = fout * MASTER[master_vol] >> 8;
 
     // lowpass RC filter
@@ -261,6 +263,58 @@ int32_t NES_FDS::Render ()		// // //
     return rc_out;		// // //
 }
 
+uint32_t NES_FDS::GetQuietClocks () const		// // //
+{
+    // the last Tick must have produced the current output,
+    // and the lowpass filter must have settled on it
+    int32_t vol_out = std::min<uint32_t>(env_out[EVOL], 32);
+    if (!wav_write && fout != wave[TWAV][(phase[TWAV]>>16)&0x3F] * vol_out)
+        return 0;
+    int32_t v = fout * MASTER[master_vol] >> 8;
+    if ((((rc_accum * rc_k) + (v * rc_l)) >> RC_BITS) != rc_accum)
+        return 0;
+
+    // only the mod table is clocked, which does not affect the output
+    if (wav_halt)
+        return UINT32_MAX;
+
+    // an active modulator makes the wav phase depend on the tick size
+    if (env_out[EMOD] != 0)
+        return 0;
+
+    uint32_t quiet = UINT32_MAX;
+
+    // clocks until an envelope changes its output
+    if (!env_halt && (master_env_speed != 0))
+    {
+        for (int i=0; i<2; ++i)
+        {
+            if (env_disable[i] || (env_mode[i] ? env_out[i] >= 32 : env_out[i] == 0))
+                continue;
+            uint32_t period = ((env_speed[i]+1) * master_env_speed) << 3;
+            if (env_timer[i] >= period)
+                return 0;
+            quiet = std::min(quiet, period - env_timer[i] - 1);
+        }
+    }
+
+    // clocks until the wav table reaches a different sample
+    if (!wav_write && (vol_out != 0) && (freq[TWAV] != 0))
+    {
+        uint32_t pos = (phase[TWAV]>>16)&0x3F;
+        uint32_t steps = 1;
+        while (steps < 64 && wave[TWAV][(pos + steps) & 0x3F] == wave[TWAV][pos])
+            ++steps;
+        if (steps < 64)
+        {
+            uint32_t remaining = (steps << 16) - (phase[TWAV] & 0xFFFF);
+            quiet = std::min(quiet, (remaining - 1) / freq[TWAV]);
+        }
+    }
+
+    return quiet;
+}
+
 bool NES_FDS::Write (uint32_t adr, uint32_t val)
 {
     // $4023 master I/O enable/disable
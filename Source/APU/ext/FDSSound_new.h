@@ -85,6 +85,9 @@ public:
     void Reset ();
     void Tick (uint32_t clocks);
     int32_t Render ();		// // //
+    // // // Number of clocks Tick can advance in one call without changing the
+    // output of Render, i.e. until the next sample or envelope step
+    uint32_t GetQuietClocks () const;
     bool Write (uint32_t adr, uint32_t val);
     bool Read (uint32_t adr, uint32_t & val);
     void SetRate (double);
@@ -29,6 +29,10 @@ bool CAction::Merge(const CAction &Other) {		// // //
 	return false;
 }
 
+std::size_t CAction::GetFootprint() const {		// // //
+	return sizeof(CAction);
+}
+
 bool CAction::Commit(CMainFrame &cxt) {
 	if (done_)
 		return false;
@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include <cstddef>		// // //
+
 class CMainFrame;		// // //
 
 // Base class for action commands
@@ -39,6 +41,8 @@ public:
 	void PerformRedo(CMainFrame &cxt);		// // //
 	// combine current action with another one, return true if permissible
 	virtual bool Merge(const CAction &Other);		// // //
+	// // // return the approximate amount of memory held by the action, in bytes
+	virtual std::size_t GetFootprint() const;
 
 protected:
 	friend class CCompoundAction;		// // //
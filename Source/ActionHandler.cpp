@@ -26,8 +26,8 @@
 #include "stdafx.h" // ???
 #endif
 
-CActionHandler::CActionHandler(unsigned capacity) :
-	redoPtr_(undoList_.cbegin()), capacity_(capacity)
+CActionHandler::CActionHandler(unsigned capacity, std::size_t budget) :		// // //
+	redoPtr_(undoList_.begin()), capacity_(capacity), budget_(budget)
 {
 }
 
@@ -35,26 +35,47 @@ bool CActionHandler::AddAction(CMainFrame &cxt, std::unique_ptr<CAction> pAction
 	if (!pAction || !pAction->Commit(cxt))
 		return false;
 
-	redoPtr_ = undoList_.erase(redoPtr_, undoList_.cend());
-	if (!(CanUndo() && (*std::prev(redoPtr_))->Merge(*pAction))) {
-		undoList_.push_back(std::move(pAction));
-		if (undoList_.size() > capacity_) {
-			undoList_.pop_front();
-			lost_ = true;
-		}
+	for (auto it = redoPtr_; it != undoList_.end(); ++it)		// // //
+		footprint_ -= it->Footprint;
+	redoPtr_ = undoList_.erase(redoPtr_, undoList_.end());
+
+	if (CanUndo() && std::prev(redoPtr_)->pAction->Merge(*pAction)) {		// // //
+		stEntry &last = *std::prev(redoPtr_);
+		footprint_ -= last.Footprint;
+		last.Footprint = last.pAction->GetFootprint();
+		footprint_ += last.Footprint;
+	}
+	else {
+		std::size_t Size = pAction->GetFootprint();		// // //
+		undoList_.push_back({std::move(pAction), Size});
+		footprint_ += Size;
 	}
 
+	Trim();		// // //
 	return true;
 }
 
 void CActionHandler::UndoLastAction(CMainFrame &cxt) {		// // //
 	if (CanUndo())
-		(*--redoPtr_)->PerformUndo(cxt);
+		(--redoPtr_)->pAction->PerformUndo(cxt);
 }
 
 void CActionHandler::RedoLastAction(CMainFrame &cxt) {		// // //
 	if (CanRedo())
-		(*redoPtr_++)->PerformRedo(cxt);
+		(redoPtr_++)->pAction->PerformRedo(cxt);
+}
+
+std::size_t CActionHandler::GetFootprint() const {		// // //
+	return footprint_;
+}
+
+void CActionHandler::Trim() {		// // //
+	// only called right after adding an action, so every entry is undoable
+	while (undoList_.size() > 1 && (undoList_.size() > capacity_ || footprint_ > budget_)) {
+		footprint_ -= undoList_.front().Footprint;
+		undoList_.pop_front();
+		lost_ = true;
+	}
 }
 
 bool CActionHandler::ActionsLost() const {		// // //
@@ -25,6 +25,7 @@
 
 #include <list>
 #include <memory>
+#include <cstddef>		// // //
 
 class CAction;
 class CMainFrame;
@@ -33,7 +34,9 @@ class CMainFrame;
 class CActionHandler
 {
 public:
-	explicit CActionHandler(unsigned capacity);
+	// // // Oldest actions are discarded once either the action count or the total footprint
+	// exceeds its limit; the latest action is always kept
+	CActionHandler(unsigned capacity, std::size_t budget);
 
 	// Add new action to undo list, return true if action is performed
 	bool AddAction(CMainFrame &cxt, std::unique_ptr<CAction> pAction);		// // //
@@ -50,9 +53,22 @@ public:
 	// Returns true if there are redo objects available
 	bool CanRedo() const;
 
+	// // // Returns the total footprint of all stored actions, in bytes
+	std::size_t GetFootprint() const;
+
+private:
+	void Trim();		// // //
+
 private:
-	std::list<std::unique_ptr<CAction>> undoList_;
-	std::list<std::unique_ptr<CAction>>::const_iterator redoPtr_;
+	struct stEntry {		// // //
+		std::unique_ptr<CAction> pAction;
+		std::size_t Footprint = 0u;
+	};
+
+	std::list<stEntry> undoList_;
+	std::list<stEntry>::iterator redoPtr_;
 	unsigned capacity_;
+	std::size_t budget_;		// // //
+	std::size_t footprint_ = 0u;		// // //
 	bool lost_ = false;
 };
@@ -21,26 +21,17 @@
 */
 
 #include "AudioDriver.h"
-#include "DirectSound.h"
+#include <algorithm>		// // //
+#include <cmath>
+#include <limits>		// // //
 
 // 1kHz test tone
 //#define AUDIO_TEST
 
-// Enable audio dithering
-//#define DITHERING
-
-#ifdef DITHERING
-int dither(long size);
-#endif
-
-CAudioDriver::CAudioDriver(IAudioCallback &Parent, std::unique_ptr<CDSoundChannel> pDevice, unsigned SampleSize) :
-	m_Parent(Parent),
-	m_pDSoundChannel(std::move(pDevice)),
-	m_iSampleSize(SampleSize),
-	m_iBufSizeBytes(m_pDSoundChannel ? m_pDSoundChannel->GetBlockSize() : 0),
-	m_iBufSizeSamples(m_iBufSizeBytes / (SampleSize / 8)),
-	m_pAccumBuffer(std::make_unique<char[]>(m_iBufSizeBytes)),		// // //
-	m_iGraphBuffer(std::make_unique<int16_t[]>(m_iBufSizeSamples))
+CAudioDriver::CAudioDriver(std::function<bool ()> RenderFrame, std::unique_ptr<CAudioSink> pSink) :		// // //
+	m_pSink(std::move(pSink)),
+	m_RenderFrame(std::move(RenderFrame)),
+	m_GraphBuffer(m_pSink ? m_pSink->GetPeriodFrames() : 0)
 {
 }
 
@@ -49,19 +40,64 @@ CAudioDriver::~CAudioDriver() {
 }
 
 void CAudioDriver::Reset() {
-	m_iBufferPtr = 0;
-	if (m_pDSoundChannel)
-		m_pDSoundChannel->ClearBuffer();
+	m_Queue.clear();		// // //
+	if (m_pSink)
+		m_pSink->Reset();
 }
 
-void CAudioDriver::FlushBuffer(array_view<int16_t> Buffer) {
-	if (!m_pDSoundChannel)
-		return;
+void CAudioDriver::FlushBuffer(array_view<float> Buffer) {		// // //
+	// Called when the APU audio buffer is full
+	m_Queue.insert(m_Queue.end(), Buffer.begin(), Buffer.end());
+}
+
+bool CAudioDriver::Pump() {		// // //
+	// Waits for the audio device, which then asks for samples through RenderAudio
+	return m_pSink && m_pSink->Pump(*this);
+}
+
+bool CAudioDriver::RenderAudio(float *Buffer, std::size_t Frames) {		// // //
+	// Run the player until enough samples are ready; a frame may also reset the queue
+	while (m_Queue.size() < Frames) {
+		const std::size_t Queued = m_Queue.size();
+		if (!m_RenderFrame())
+			return false;
+		if (m_Queue.size() <= Queued)		// nothing rendered, pad with silence
+			m_Queue.resize(Frames);
+	}
+
+	for (std::size_t i = 0; i < Frames; ++i) {
+		float Sample = m_Queue[i];
+
+		// 1000 Hz test tone
+#ifdef AUDIO_TEST
+		static double sine_phase = 0;
+		Sample = float(sin(sine_phase) * 10000.0 / 32768.0);
 
-	if (m_iSampleSize == 8)
-		FillBuffer<uint8_t, 8>(Buffer);
-	else
-		FillBuffer<int16_t, 0>(Buffer);
+		static double freq = 1000;
+		// Sweep
+		//freq+=0.1;
+		if (freq > 20000)
+			freq = 20;
+
+		sine_phase += freq / (double(m_pSink->GetSampleRate()) / 6.283184);
+		if (sine_phase > 6.283184)
+			sine_phase -= 6.283184;
+#endif /* AUDIO_TEST */
+
+		// // // Clip to 16 bits, float output is passed on unclipped
+		auto Sample16 = static_cast<int16_t>(std::clamp(std::floor(Sample * 32768.f), -32768.f, 32767.f));
+
+		// Clip detection
+		if (Sample16 == std::numeric_limits<int16_t>::max() || Sample16 == std::numeric_limits<int16_t>::min())
+			++m_iClipCounter;
+
+		// Visualizer
+		if (i < m_GraphBuffer.size())
+			m_GraphBuffer[i] = Sample16;
+
+		Buffer[i] = Sample;
+	}
+	m_Queue.erase(m_Queue.begin(), m_Queue.begin() + Frames);
 
 	if (m_iClipCounter > 50) {
 		// Ignore some clipping to allow the HP-filter adjust itself
@@ -70,75 +106,40 @@ void CAudioDriver::FlushBuffer(array_view<int16_t> Buffer) {
 	}
 	else if (m_iClipCounter > 0)
 		--m_iClipCounter;
-}
-
-bool CAudioDriver::PlayBuffer() {
-	return m_Parent.PlayBuffer();
-}
-
-bool CAudioDriver::DoPlayBuffer() {
-	const int AUDIO_TIMEOUT = 2000;		// // // 2s buffer timeout
-
-	// Output to direct sound
-	DWORD dwEvent;
-
-	// Wait for a buffer event
-	while ((dwEvent = m_pDSoundChannel->WaitForSyncEvent(AUDIO_TIMEOUT)) != BUFFER_IN_SYNC) {
-		switch (dwEvent) {
-			case BUFFER_TIMEOUT:
-				// Buffer timeout
-				m_bBufferTimeout = true;
-			case BUFFER_CUSTOM_EVENT:
-				// Custom event, quit
-				m_iBufferPtr = 0;
-				return false;
-			case BUFFER_OUT_OF_SYNC:
-				// Buffer underrun detected
-				++m_iAudioUnderruns;
-				m_bBufferUnderrun = true;
-				break;
-		}
-	}
-
-	// Write audio to buffer
-	m_pDSoundChannel->WriteBuffer(ReleaseSoundBuffer());		// // //
-
-	// Reset buffer position
-	m_bBufferTimeout = false;
 
 	return true;
 }
 
-array_view<char> CAudioDriver::ReleaseSoundBuffer() {
-	m_iBufferPtr = 0;
-	return {m_pAccumBuffer.get(), m_iBufSizeBytes};
+array_view<std::int16_t> CAudioDriver::ReleaseGraphBuffer() {
+	return {m_GraphBuffer.data(), m_GraphBuffer.size()};		// // //
 }
 
-array_view<std::int16_t> CAudioDriver::ReleaseGraphBuffer() {
-	return {m_iGraphBuffer.get(), m_iBufSizeSamples};
+unsigned CAudioDriver::GetSampleRate() const noexcept {		// // //
+	return m_pSink ? m_pSink->GetSampleRate() : 0;
 }
 
 unsigned CAudioDriver::GetSampleSize() const noexcept {		// // //
-	return m_iSampleSize;
+	return m_pSink ? m_pSink->GetSampleSize() : 0;
+}
+
+unsigned CAudioDriver::GetLatencyFrames() const noexcept {		// // //
+	return m_pSink ? m_pSink->GetLatencyFrames() : 0;
 }
 
 void CAudioDriver::CloseAudioDevice() {
-	if (m_pDSoundChannel) {
-		m_pDSoundChannel->Stop();
-		m_pDSoundChannel.reset();		// // //
-	}
+	m_pSink.reset();		// // //
 }
 
 bool CAudioDriver::IsAudioDeviceOpen() const {
-	return static_cast<bool>(m_pDSoundChannel);
+	return static_cast<bool>(m_pSink);		// // //
 }
 
 bool CAudioDriver::GetSoundTimeout() const {
-	return m_bBufferTimeout;
+	return m_pSink && m_pSink->GetSoundTimeout();		// // //
 }
 
 bool CAudioDriver::DidBufferUnderrun() {
-	return std::exchange(m_bBufferUnderrun, false);
+	return m_pSink && m_pSink->DidBufferUnderrun();		// // //
 }
 
 bool CAudioDriver::WasAudioClipping() {
@@ -146,60 +147,5 @@ bool CAudioDriver::WasAudioClipping() {
 }
 
 unsigned CAudioDriver::GetUnderruns() const {
-	return m_iAudioUnderruns;
-}
-
-template <class T, int SHIFT>
-void CAudioDriver::FillBuffer(array_view<int16_t> Buffer)		// // //
-{
-	// Called when the APU audio buffer is full and
-	// ready for playing
-
-	auto pConversionBuffer = reinterpret_cast<T *>(m_pAccumBuffer.get());		// // //
-
-	for (int16_t Sample : Buffer) {		// // //
-		// 1000 Hz test tone
-#ifdef AUDIO_TEST
-		static double sine_phase = 0;
-		Sample = int32_t(sin(sine_phase) * 10000.0);
-
-		static double freq = 1000;
-		// Sweep
-		//freq+=0.1;
-		if (freq > 20000)
-			freq = 20;
-
-		sine_phase += freq / (double(m_pDSoundChannel->GetSampleRate()) / 6.283184);
-		if (sine_phase > 6.283184)
-			sine_phase -= 6.283184;
-#endif /* AUDIO_TEST */
-
-		// Clip detection
-		if (Sample == std::numeric_limits<int16_t>::max() || Sample == std::numeric_limits<int16_t>::min())
-			++m_iClipCounter;
-
-		ASSERT(m_iBufferPtr < m_iBufSizeSamples);
-
-		// Visualizer
-		m_iGraphBuffer[m_iBufferPtr] = (short)Sample;
-
-		// Convert sample and store in temp buffer
-#ifdef DITHERING
-		if (SHIFT > 0)
-			Sample = (Sample + dither(1 << SHIFT)) >> SHIFT;
-#else
-		Sample >>= SHIFT;
-#endif
-
-		if (SHIFT == 8)
-			Sample ^= 0x80;
-
-		pConversionBuffer[m_iBufferPtr++] = (T)Sample;
-
-		// If buffer is filled, throw it to direct sound
-		if (m_iBufferPtr >= m_iBufSizeSamples) {
-			if (!PlayBuffer())
-				return;
-		}
-	}
+	return m_pSink ? m_pSink->GetUnderruns() : 0;		// // //
 }
@@ -24,28 +24,33 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>		// // //
 #include <memory>
 #include <utility>
+#include <vector>		// // //
 #include "Common.h"
 #include "array_view.h"
+#include "AudioSink.h"		// // //
 
-class CDSoundChannel;
-
-class CAudioDriver : public IAudioCallback {
+// // // Queues the samples of each emulated frame and hands them to an audio sink in the
+// sink's period size, running more frames whenever the sink asks for more samples
+class CAudioDriver : public IAudioCallback, public IAudioSource {
 public:
 	CAudioDriver(const CAudioDriver &) = delete;
 	virtual ~CAudioDriver();
 
-	CAudioDriver(IAudioCallback &Parent, std::unique_ptr<CDSoundChannel> pDevice, unsigned SampleSize);
+	// RenderFrame runs the player for one frame, which flushes its samples to this driver
+	CAudioDriver(std::function<bool ()> RenderFrame, std::unique_ptr<CAudioSink> pSink);		// // //
 
 	void Reset();
-	void FlushBuffer(array_view<int16_t> Buffer) override;
-	bool PlayBuffer() override;
-	bool DoPlayBuffer();
-	array_view<char> ReleaseSoundBuffer();
+	void FlushBuffer(array_view<float> Buffer) override;		// // //
+	bool RenderAudio(float *Buffer, std::size_t Frames) override;		// // //
+	bool Pump();		// // //
 	array_view<std::int16_t> ReleaseGraphBuffer();
 
+	unsigned GetSampleRate() const noexcept;		// // //
 	unsigned GetSampleSize() const noexcept;		// // //
+	unsigned GetLatencyFrames() const noexcept;		// // //
 
 	void CloseAudioDevice();
 	bool IsAudioDeviceOpen() const;
@@ -56,22 +61,11 @@ public:
 	unsigned GetUnderruns() const;
 
 private:
-	template <class T, int SHIFT>
-	void FillBuffer(array_view<int16_t> Buffer);		// // //
-
-private:
-	std::unique_ptr<CDSoundChannel> m_pDSoundChannel;		// // // directsound channel
-	IAudioCallback		&m_Parent;							// // //
+	std::unique_ptr<CAudioSink> m_pSink;						// // //
+	std::function<bool ()> m_RenderFrame;						// // //
 
-	unsigned int		m_iSampleSize;						// Size of samples, in bits
-	unsigned int		m_iBufSizeBytes = 0;				// Buffer size in bytes
-	unsigned int		m_iBufSizeSamples = 0;				// Buffer size in samples
-	unsigned int		m_iBufferPtr = 0;					// This will point in samples
-	std::unique_ptr<char[]> m_pAccumBuffer;					// // //
-	std::unique_ptr<int16_t[]> m_iGraphBuffer;
-	unsigned int		m_iAudioUnderruns = 0;				// Keep track of underruns to inform user
-	bool				m_bBufferTimeout = false;
-	bool				m_bBufferUnderrun = false;
+	std::vector<float>	m_Queue;								// // // Rendered samples not yet requested by the sink
+	std::vector<std::int16_t> m_GraphBuffer;					// // // Last period, for the visualizer
 	bool				m_bAudioClipping = false;
 	unsigned int		m_iClipCounter = 0;
 };
@@ -0,0 +1,156 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#include "AudioSink.h"
+#include "SimpleFile.h"
+#include "WaveStream.h"
+#include "array_view.h"
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+// // // CAudioSink
+
+unsigned CAudioSink::GetUnderruns() const {
+	return underruns_;
+}
+
+bool CAudioSink::DidBufferUnderrun() {
+	return std::exchange(underrun_, false);
+}
+
+bool CAudioSink::GetSoundTimeout() const {
+	return timeout_;
+}
+
+void CAudioSink::AddUnderrun() {
+	++underruns_;
+	underrun_ = true;
+}
+
+void CAudioSink::SetSoundTimeout(bool Timeout) {
+	timeout_ = Timeout;
+}
+
+// // // CNullAudioSink
+
+CNullAudioSink::CNullAudioSink(unsigned SampleRate, unsigned PeriodFrames, unsigned Periods, bool RealTime) :
+	sample_rate_(SampleRate), periods_(Periods), real_time_(RealTime), buffer_(PeriodFrames)
+{
+}
+
+bool CNullAudioSink::Pump(IAudioSource &Source) {
+	if (real_time_) {
+		// the simulated device starts with the first period
+		if (!queued_)
+			start_ = clock_type::now();
+
+		// samples played by the simulated device so far
+		const std::size_t Now = static_cast<std::size_t>(
+			std::chrono::duration<double>(clock_type::now() - start_).count() * sample_rate_);
+		if (Now > queued_) {
+			// the device ran out of samples and played silence
+			AddUnderrun();
+			queued_ = Now;
+		}
+
+		// wait for a free period
+		const std::size_t Limit = static_cast<std::size_t>(periods_ - 1) * buffer_.size();
+		if (queued_ - Now > Limit)
+			std::this_thread::sleep_until(start_ + std::chrono::duration_cast<clock_type::duration>(
+				std::chrono::duration<double>(static_cast<double>(queued_ - Limit) / sample_rate_)));
+	}
+
+	if (!Source.RenderAudio(buffer_.data(), buffer_.size()))
+		return false;
+	rendered_ += buffer_.size();
+	queued_ += buffer_.size();
+	return true;
+}
+
+void CNullAudioSink::Reset() {
+	queued_ = 0;
+}
+
+unsigned CNullAudioSink::GetSampleRate() const {
+	return sample_rate_;
+}
+
+unsigned CNullAudioSink::GetSampleSize() const {
+	return 32;
+}
+
+unsigned CNullAudioSink::GetPeriodFrames() const {
+	return static_cast<unsigned>(buffer_.size());
+}
+
+unsigned CNullAudioSink::GetLatencyFrames() const {
+	return real_time_ ? GetPeriodFrames() * periods_ : 0;
+}
+
+std::size_t CNullAudioSink::GetFramesRendered() const {
+	return rendered_;
+}
+
+// // // CWaveFileAudioSink
+
+CWaveFileAudioSink::CWaveFileAudioSink(const fs::path &fname, unsigned SampleRate, unsigned SampleSize, unsigned PeriodFrames) :
+	sample_rate_(SampleRate), sample_size_(SampleSize), buffer_(PeriodFrames)
+{
+	auto pFile = std::make_shared<CSimpleFile>(fname, std::ios::out | std::ios::binary);
+	if (!*pFile)
+		throw std::runtime_error {"Could not open output file: " + fname.u8string()};
+
+	stream_ = std::make_unique<COutputWaveStream>(std::move(pFile), CWaveFileFormat {
+		SampleSize == 32 ? CWaveFileFormat::format_code::ieee_float : CWaveFileFormat::format_code::pcm,
+		1,
+		static_cast<std::uint32_t>(SampleRate),
+		static_cast<std::uint16_t>(SampleSize),
+	});
+	stream_->WriteWAVHeader();
+}
+
+CWaveFileAudioSink::~CWaveFileAudioSink() noexcept = default;
+
+bool CWaveFileAudioSink::Pump(IAudioSource &Source) {
+	if (!Source.RenderAudio(buffer_.data(), buffer_.size()))
+		return false;
+	stream_->WriteSamples(array_view<float> {buffer_.data(), buffer_.size()});
+	return true;
+}
+
+unsigned CWaveFileAudioSink::GetSampleRate() const {
+	return sample_rate_;
+}
+
+unsigned CWaveFileAudioSink::GetSampleSize() const {
+	return sample_size_;
+}
+
+unsigned CWaveFileAudioSink::GetPeriodFrames() const {
+	return static_cast<unsigned>(buffer_.size());
+}
+
+unsigned CWaveFileAudioSink::GetLatencyFrames() const {
+	return 0;
+}
@@ -0,0 +1,144 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "ft0cc/fs.h"
+
+class COutputWaveStream;
+
+// // // Pull-model audio output
+
+// Renders samples on request of an audio sink
+class IAudioSource {
+public:
+	virtual ~IAudioSource() noexcept = default;
+
+	// Writes exactly Frames samples, normalized to +/-1.0 and not clipped; returns false if it failed
+	virtual bool RenderAudio(float *Buffer, std::size_t Frames) = 0;
+};
+
+/*!
+	\brief An audio output that requests a fixed number of samples from its source whenever it
+	has room for them.
+*/
+class CAudioSink {
+public:
+	virtual ~CAudioSink() noexcept = default;
+
+	/*!	\brief Waits until the output has room for one period, then renders it from the source.
+		\param Source The audio source.
+		\return False if the wait was interrupted or timed out, or if the source failed. */
+	virtual bool Pump(IAudioSource &Source) = 0;
+
+	/*!	\brief Discards all samples queued on the output. */
+	virtual void Reset() { }
+
+	virtual unsigned GetSampleRate() const = 0;
+	/*!	\brief Returns the size of one sample in bits. */
+	virtual unsigned GetSampleSize() const = 0;
+	/*!	\brief Returns the number of samples requested by each call to Pump. */
+	virtual unsigned GetPeriodFrames() const = 0;
+	/*!	\brief Returns the number of samples the output may hold before they are heard. */
+	virtual unsigned GetLatencyFrames() const = 0;
+
+	unsigned GetUnderruns() const;
+	bool DidBufferUnderrun();
+	bool GetSoundTimeout() const;
+
+protected:
+	void AddUnderrun();
+	void SetSoundTimeout(bool Timeout);
+
+private:
+	unsigned underruns_ = 0;
+	bool underrun_ = false;
+	bool timeout_ = false;
+};
+
+/*!
+	\brief An audio sink without a device, for headless playback and benchmarks.
+	\details In real time mode it behaves like a device with a ring buffer of the given number of
+	periods, playing samples at the sample rate. Pump waits until a period is free, and an
+	underrun is counted whenever the buffer ran empty before the next period was rendered.
+	Otherwise samples are discarded as fast as they are rendered.
+*/
+class CNullAudioSink final : public CAudioSink {
+public:
+	CNullAudioSink(unsigned SampleRate, unsigned PeriodFrames, unsigned Periods = 2, bool RealTime = false);
+
+	bool Pump(IAudioSource &Source) override;
+	void Reset() override;
+
+	unsigned GetSampleRate() const override;
+	unsigned GetSampleSize() const override;
+	unsigned GetPeriodFrames() const override;
+	unsigned GetLatencyFrames() const override;
+
+	/*!	\brief Returns the number of samples rendered so far. */
+	std::size_t GetFramesRendered() const;
+
+private:
+	using clock_type = std::chrono::steady_clock;
+
+	unsigned sample_rate_;
+	unsigned periods_;
+	bool real_time_;
+	std::vector<float> buffer_;
+	std::size_t rendered_ = 0;
+	std::size_t queued_ = 0;			// Samples written to the simulated device since start_
+	clock_type::time_point start_;
+};
+
+/*!
+	\brief An audio sink writing to a wave file, as fast as samples are rendered.
+*/
+class CWaveFileAudioSink final : public CAudioSink {
+public:
+	/*!	\brief Constructor of the wave file sink.
+		\param fname The output file name.
+		\param SampleRate The sample rate.
+		\param SampleSize The sample size in bits; 32 writes floating-point samples.
+		\param PeriodFrames The number of samples rendered per call to Pump.
+		\throw std::runtime_error if the file cannot be opened. */
+	CWaveFileAudioSink(const fs::path &fname, unsigned SampleRate, unsigned SampleSize, unsigned PeriodFrames);
+	~CWaveFileAudioSink() noexcept;
+
+	bool Pump(IAudioSource &Source) override;
+
+	unsigned GetSampleRate() const override;
+	unsigned GetSampleSize() const override;
+	unsigned GetPeriodFrames() const override;
+	unsigned GetLatencyFrames() const override;
+
+private:
+	std::unique_ptr<COutputWaveStream> stream_;
+	unsigned sample_rate_;
+	unsigned sample_size_;
+	std::vector<float> buffer_;
+};
@@ -0,0 +1,244 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "BatchExporter.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerDocIO.h"
+#include "FamiTrackerDocOldIO.h"
+#include "FamiTrackerDocIOJson.h"
+#include "DocumentFile.h"
+#include "ModuleException.h"
+#include "Compiler.h"
+#include "SimpleFile.h"
+#include "ModuleImporter.h"
+#include "RunParallel.h"
+#include "ModulePlayer.h"
+#include "AudioSink.h"
+#include "WaveRenderer.h"
+#include "WaveRendererFactory.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace {
+
+// Collects the compiler log of a single job
+class CStringLog : public CCompilerLog {
+public:
+	void WriteLog(std::string_view text) override {
+		log_ += text;
+	}
+	void Clear() override {
+		log_.clear();
+	}
+	const std::string &GetText() const {
+		return log_;
+	}
+
+private:
+	std::string log_;
+};
+
+const std::string_view FORMATS[] = {"nsf", "nsfe", "nes", "prg", "bin", "asm", "json", "0cc", "ftm", "wav"};
+
+// Samples requested from the player at a time by WAV exports
+const unsigned WAV_PERIOD_FRAMES = 256;
+
+void LoadModule(CFamiTrackerModule &modfile, const fs::path &fname) {
+	CDocumentFile file;
+	try {
+		file.Open(fname, std::ios::in | std::ios::binary);
+	}
+	catch (std::runtime_error &e) {
+		throw std::runtime_error("Could not open input file " + fname.u8string() + ": " + e.what());
+	}
+	file.ValidateFile();
+
+	if (file.GetFileVersion() < 0x0200U) {
+		if (!compat::OpenDocumentOld(modfile, file.GetCSimpleFile()))
+			file.RaiseModuleException("General error");
+	}
+	else if (!CFamiTrackerDocIO {file, module_error_level_t::MODULE_ERROR_DEFAULT}.Load(modfile))
+		file.RaiseModuleException("Failed to load module");
+}
+
+void ImportModule(CFamiTrackerModule &modfile, const fs::path &fname, const std::atomic_bool *pCancel) {
+	CFamiTrackerModule imported;
+	LoadModule(imported, fname);
+	CModuleImporter::MergeSoundChips(modfile, imported);
+
+	// jobs already run on every core, so the import stays on this thread
+	CModuleImporter importer {modfile, imported, import_mode_t::import_missing, import_mode_t::import_missing, 1, pCancel};
+	if (import_error_t err = importer.Validate(); err != import_error_t::none)
+		throw std::runtime_error("Could not import " + fname.u8string() + ": " + std::string {CModuleImporter::GetErrorMessage(err)});
+	if (!importer.DoImport(false))
+		throw std::runtime_error("Cancelled");
+}
+
+template <typename T>
+void OpenOutput(T &file, const fs::path &fname) {
+	try {
+		if (fname.has_parent_path())
+			fs::create_directories(fname.parent_path());
+		file.Open(fname, std::ios::out | std::ios::binary);
+	}
+	catch (std::exception &e) {
+		throw std::runtime_error("Could not open output file " + fname.u8string() + ": " + e.what());
+	}
+}
+
+void RenderModule(const CFamiTrackerModule &modfile, const stBatchExportJob &Job, const std::atomic_bool *pCancel) {
+	if (Job.Track >= modfile.GetSongCount())
+		throw std::runtime_error("Song index out of range: " + std::to_string(Job.Track));
+	if (!Job.SampleRate)
+		throw std::runtime_error("Invalid sample rate");
+	if (Job.SampleSize != 8 && Job.SampleSize != 16 && Job.SampleSize != 24 && Job.SampleSize != 32)
+		throw std::runtime_error("Unsupported sample size: " + std::to_string(Job.SampleSize));
+
+	auto pRenderer = Job.Seconds ?
+		CWaveRendererFactory::Make(modfile, Job.Track, render_type_t::Seconds, Job.Seconds) :
+		CWaveRendererFactory::Make(modfile, Job.Track, render_type_t::Loops, Job.Loops);
+	if (!pRenderer)
+		throw std::runtime_error("Song has no length to render");
+
+	std::unique_ptr<CAudioSink> pSink;
+	try {
+		if (Job.Output.has_parent_path())
+			fs::create_directories(Job.Output.parent_path());
+		pSink = std::make_unique<CWaveFileAudioSink>(Job.Output, Job.SampleRate, Job.SampleSize, WAV_PERIOD_FRAMES);
+	}
+	catch (std::exception &e) {
+		throw std::runtime_error("Could not open output file " + Job.Output.u8string() + ": " + e.what());
+	}
+
+	CModulePlayer player {modfile, Job.SampleRate};
+	if (!player.Render(Job.Track, *pRenderer, std::move(pSink), pCancel))
+		throw std::runtime_error(pCancel && *pCancel ? "Cancelled" : "Rendering failed");
+}
+
+void ExportModule(const CFamiTrackerModule &modfile, const stBatchExportJob &Job, std::shared_ptr<CStringLog> pLog, const std::atomic_bool *pCancel) {
+	const std::string &fmt = Job.Format;
+
+	if (fmt == "wav")
+		return RenderModule(modfile, Job, pCancel);
+
+	if (fmt == "json") {
+		CSimpleFile file;
+		OpenOutput(file, Job.Output);
+		file.WriteBytes(nlohmann::json(modfile).dump() + '\n');
+		return;
+	}
+	if (fmt == "0cc" || fmt == "ftm") {
+		CDocumentFile file;
+		OpenOutput(file, Job.Output);
+		if (!CFamiTrackerDocIO {file, module_error_level_t::MODULE_ERROR_DEFAULT}.Save(modfile))
+			throw std::runtime_error("Could not save module");
+		file.Close();
+		return;
+	}
+
+	if (fmt == "bin" && Job.DPCMOutput.empty())
+		throw std::runtime_error("BIN export requires a DPCM output file");
+
+	CSimpleFile file;
+	OpenOutput(file, Job.Output);
+	CCompiler compiler(modfile, pLog);
+	if (fmt == "nsf")
+		compiler.ExportNSF(file, value_cast(modfile.GetMachine()));
+	else if (fmt == "nsfe")
+		compiler.ExportNSFE(file, value_cast(modfile.GetMachine()));
+	else if (fmt == "nes")
+		compiler.ExportNES(file, modfile.GetMachine() == machine_t::PAL);
+	else if (fmt == "prg")
+		compiler.ExportPRG(file, modfile.GetMachine() == machine_t::PAL);
+	else if (fmt == "asm")
+		compiler.ExportASM(file);
+	else if (fmt == "bin") {
+		CSimpleFile dpcmFile;
+		OpenOutput(dpcmFile, Job.DPCMOutput);
+		compiler.ExportBIN(file, dpcmFile);
+	}
+
+	if (compiler.HasErrors()) {
+		// Quote the first error line of the log in the job result
+		const std::string &text = pLog->GetText();
+		if (auto pos = text.find("Error: "); pos != std::string::npos)
+			throw std::runtime_error(text.substr(pos, text.find_first_of("\r\n", pos) - pos));
+		throw std::runtime_error("Export failed");
+	}
+}
+
+} // namespace
+
+CBatchExporter::CBatchExporter(std::vector<stBatchExportJob> Jobs) : m_Jobs(std::move(Jobs))
+{
+}
+
+bool CBatchExporter::IsFormatSupported(std::string_view Format) {
+	return std::find(std::begin(FORMATS), std::end(FORMATS), Format) != std::end(FORMATS);
+}
+
+stBatchExportResult CBatchExporter::RunJob(const stBatchExportJob &Job, const std::atomic_bool *pCancel) {
+	stBatchExportResult Result;
+	auto pLog = std::make_shared<CStringLog>();
+	const auto Start = std::chrono::steady_clock::now();
+
+	try {
+		if (!IsFormatSupported(Job.Format))
+			throw std::runtime_error("Unsupported export format: " + Job.Format);
+		CFamiTrackerModule modfile;
+		LoadModule(modfile, Job.Input);
+		for (const auto &fname : Job.Imports)
+			ImportModule(modfile, fname, pCancel);
+		ExportModule(modfile, Job, pLog, pCancel);
+		Result.Success = true;
+	}
+	catch (CModuleException &e) {
+		Result.Message = e.GetErrorString();
+	}
+	catch (std::exception &e) {
+		Result.Message = e.what();
+	}
+
+	Result.Log = pLog->GetText();
+	Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	return Result;
+}
+
+std::size_t CBatchExporter::Run(unsigned Threads, const report_func_t &Report, const std::atomic_bool *pCancel) const {
+	std::atomic<std::size_t> Failed {0u};
+	std::mutex ReportMutex;
+
+	RunParallel(m_Jobs.size(), Threads, [&] (std::size_t i) {
+		stBatchExportResult Result = RunJob(m_Jobs[i], pCancel);
+		Result.Index = i;
+		if (!Result.Success)
+			++Failed;
+		if (Report) {
+			std::lock_guard<std::mutex> lock {ReportMutex};
+			Report(m_Jobs[i], Result);
+		}
+	}, pCancel);
+
+	return Failed;
+}
@@ -0,0 +1,74 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include "ft0cc/fs.h"
+
+// // // Portable batch exporter, runs many module exports in one process
+
+struct stBatchExportJob {
+	fs::path Input;
+	std::vector<fs::path> Imports;	// Modules whose songs are appended to the input before exporting
+	std::string Format;		// Lowercase extension without the dot, e.g. "nsf"
+	fs::path Output;
+	fs::path DPCMOutput;	// BIN export only
+	unsigned Track = 0;		// WAV export only: song index
+	unsigned Loops = 1;		// WAV export only: times the song loop is played
+	unsigned Seconds = 0;	// WAV export only: fixed length instead of a loop count if not zero
+	unsigned SampleRate = 44100;	// WAV export only
+	unsigned SampleSize = 16;		// WAV export only: bits per sample, 32 writes floating-point samples
+};
+
+struct stBatchExportResult {
+	std::size_t Index = 0;	// Position of the job in the job list
+	bool Success = false;
+	std::string Message;	// Error description if the job failed
+	std::string Log;		// Compiler log output
+	double Seconds = 0.;
+};
+
+class CBatchExporter
+{
+public:
+	using report_func_t = std::function<void (const stBatchExportJob &, const stBatchExportResult &)>;
+
+	explicit CBatchExporter(std::vector<stBatchExportJob> Jobs);
+
+	// Runs all jobs on a pool of worker threads, calling Report once per
+	// finished job from a single thread at a time; returns the failed job count
+	// Once *pCancel is set, jobs still importing modules or rendering audio
+	// fail and no new jobs start; jobs that never started are neither
+	// reported nor counted
+	std::size_t Run(unsigned Threads, const report_func_t &Report, const std::atomic_bool *pCancel = nullptr) const;
+
+	static stBatchExportResult RunJob(const stBatchExportJob &Job, const std::atomic_bool *pCancel = nullptr);
+	static bool IsFormatSupported(std::string_view Format);
+
+private:
+	std::vector<stBatchExportJob> m_Jobs;
+};
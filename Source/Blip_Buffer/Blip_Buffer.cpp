@@ -43,7 +43,7 @@ Blip_Buffer::Blip_Buffer()
 		long i = LONG_MIN;
 		assert( (i >> 1) == LONG_MIN / 2 );
 		i = LONG_MIN;
-		assert( (i >> 31) == -1 );
+		assert( (i >> (sizeof i * CHAR_BIT - 1)) == -1 );		// // // long may be 64 bits
 
 		// casting to smaller signed type truncates bits and extends sign
 		i = (SHRT_MAX + 1) * 5;
@@ -416,6 +416,36 @@ long Blip_Buffer::read_samples( blip_sample_t* out, long max_samples, int stereo
 	return count;
 }
 
+long Blip_Buffer::read_samples( float* out, long max_samples, int stereo )		// // //
+{
+	long count = samples_avail();
+	if ( count > max_samples )
+		count = max_samples;
+
+	if ( count )
+	{
+		// keep 24 significant bits so that the conversion to float is exact
+		int const sample_shift = blip_sample_bits - 24;
+		float const scale = 1.0f / (1L << 23);
+		int const bass_shift_ = this->bass_shift;
+		int const step = stereo ? 2 : 1;
+		long accum = reader_accum;
+		buf_t_* in = buffer_;
+
+		for ( long n = count; n--; )
+		{
+			*out = (accum >> sample_shift) * scale;
+			out += step;
+			accum -= accum >> bass_shift_;
+			accum += *in++;
+		}
+
+		reader_accum = accum;
+		remove_samples( count );
+	}
+	return count;
+}
+
 void Blip_Buffer::mix_samples( blip_sample_t const* in, long count )
 {
 	buf_t_* out = buffer_ + (offset_ >> BLIP_BUFFER_ACCURACY) + blip_widest_impulse_ / 2;
@@ -36,6 +36,9 @@ public:
 	// easy interleving of two channels into a stereo output buffer.
 	long read_samples( blip_sample_t* dest, long max_samples, int stereo = 0 );
 
+	// Same as above, but writes samples normalized to +/-1.0 without clamping them		// // //
+	long read_samples( float* dest, long max_samples, int stereo = 0 );
+
 // Additional optional features
 
 	// Current output sample rate
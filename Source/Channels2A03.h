@@ -51,7 +51,7 @@ protected:
 };
 
 // // // 2A03 Square
-class C2A03Square : public CChannelHandler2A03 {
+class C2A03Square final : public CChannelHandler2A03 {		// // //
 public:
 	explicit C2A03Square(stChannelID ch);		// // //
 	void	RefreshChannel() override;
@@ -72,7 +72,7 @@ protected:
 };
 
 // Triangle
-class CTriangleChan : public CChannelHandler2A03 {
+class CTriangleChan final : public CChannelHandler2A03 {		// // //
 public:
 	explicit CTriangleChan(stChannelID ch);		// // //
 	void	RefreshChannel() override;
@@ -87,7 +87,7 @@ private:
 };
 
 // Noise
-class CNoiseChan : public CChannelHandler2A03 {
+class CNoiseChan final : public CChannelHandler2A03 {		// // //
 public:
 	explicit CNoiseChan(stChannelID ch);		// // //
 	void	RefreshChannel();
@@ -108,7 +108,7 @@ class dpcm_sample;
 } // namespace ft0cc::doc
 
 // DPCM
-class CDPCMChan : public CChannelHandler, public CChannelHandlerInterfaceDPCM {		// // //
+class CDPCMChan final : public CChannelHandler, public CChannelHandlerInterfaceDPCM {		// // //
 public:
 	explicit CDPCMChan(stChannelID ch);		// // //
 	void	RefreshChannel() override;
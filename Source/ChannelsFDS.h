@@ -26,7 +26,7 @@
 #include <array>		// // //
 #include "ChannelHandler.h"
 
-class CChannelHandlerFDS : public CChannelHandlerInverted, public CChannelHandlerInterfaceFDS {
+class CChannelHandlerFDS final : public CChannelHandlerInverted, public CChannelHandlerInterfaceFDS {		// // //
 public:
 	explicit CChannelHandlerFDS(stChannelID ch);		// // //
 	void	RefreshChannel() override;
@@ -29,7 +29,7 @@
 // Derived channels, MMC5
 //
 
-class CChannelHandlerMMC5 : public CChannelHandler {
+class CChannelHandlerMMC5 final : public CChannelHandler {		// // //
 public:
 	explicit CChannelHandlerMMC5(stChannelID ch);		// // //
 	void	ResetChannel() override;
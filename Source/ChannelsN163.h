@@ -29,7 +29,7 @@
 // Derived channels, N163
 //
 
-class CChannelHandlerN163 : public CChannelHandlerInverted, public CChannelHandlerInterfaceN163 {
+class CChannelHandlerN163 final : public CChannelHandlerInverted, public CChannelHandlerInterfaceN163 {		// // //
 public:
 	explicit CChannelHandlerN163(stChannelID ch);		// // //
 	void	RefreshChannel() override;
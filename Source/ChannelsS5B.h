@@ -31,7 +31,7 @@ class CChipHandlerS5B;		// // //
 // Derived channels, 5B
 //
 
-class CChannelHandlerS5B : public CChannelHandler, public CChannelHandlerInterfaceS5B {
+class CChannelHandlerS5B final : public CChannelHandler, public CChannelHandlerInterfaceS5B {		// // //
 public:
 	CChannelHandlerS5B(stChannelID ch, CChipHandlerS5B &parent);		// / //
 	void	ResetChannel() override;
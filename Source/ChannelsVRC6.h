@@ -44,7 +44,7 @@ protected:
 	void	ClearRegisters() override;		// // //
 };
 
-class CVRC6Square : public CChannelHandlerVRC6 {
+class CVRC6Square final : public CChannelHandlerVRC6 {		// // //
 public:
 	explicit CVRC6Square(stChannelID ch) : CChannelHandlerVRC6(ch, 0xFFF, 0x0F) { }
 	void	RefreshChannel() override;
@@ -52,7 +52,7 @@ protected:
 	int		ConvertDuty(int Duty) const override;		// // //
 };
 
-class CVRC6Sawtooth : public CChannelHandlerVRC6 {
+class CVRC6Sawtooth final : public CChannelHandlerVRC6 {		// // //
 public:
 	explicit CVRC6Sawtooth(stChannelID ch) : CChannelHandlerVRC6(ch, 0xFFF, 0x3F) { }
 	void	RefreshChannel() override;
@@ -40,7 +40,7 @@ enum vrc7_command_t {
 
 class CChipHandlerVRC7;		// // //
 
-class CChannelHandlerVRC7 : public CChannelHandlerInverted, public CChannelHandlerInterfaceVRC7 {		// // //
+class CChannelHandlerVRC7 final : public CChannelHandlerInverted, public CChannelHandlerInterfaceVRC7 {		// // //
 public:
 	CChannelHandlerVRC7(stChannelID ch, CChipHandlerVRC7 &parent);		// // //
 
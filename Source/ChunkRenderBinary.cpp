@@ -106,8 +106,7 @@ void CChunkRenderBinary::StoreSample(const ft0cc::doc::dpcm_sample &DSample)
 
 CChunkRenderNSF::CChunkRenderNSF(CSimpleFile &File, unsigned int StartAddr) :
 	CBinaryFileWriter(File),
-	m_iStartAddr(StartAddr),
-	m_iSampleAddr(0)
+	m_iStartAddr(StartAddr)
 {
 }
 
@@ -143,15 +142,18 @@ void CChunkRenderNSF::StoreSamples(const std::vector<std::shared_ptr<const ft0cc
 		StoreSample(*ptr);
 }
 
-void CChunkRenderNSF::StoreSamplesBankswitched(const std::vector<std::shared_ptr<const ft0cc::doc::dpcm_sample>> &Samples)
+void CChunkRenderNSF::StoreSamplesBankswitched(const std::vector<std::shared_ptr<const ft0cc::doc::dpcm_sample>> &Samples,
+	const std::vector<stDPCMSampleWindow> &Windows)		// // //
 {
-	// Start samples on a clean bank
-	if ((GetAbsoluteAddr() & 0xFFF) != 0)
-		AllocateNewBank();
-
-	m_iSampleAddr = CCompiler::PAGE_SAMPLES;
-	for (auto ptr : Samples)		// // //
-		StoreSampleBankswitched(*ptr);
+	// Start each sample window on the bank assigned by the compiler
+	for (const auto &Window : Windows) {
+		if ((GetAbsoluteAddr() & 0xFFF) != 0)
+			AllocateNewBank();
+		while (GetBank() < static_cast<int>(Window.Bank))
+			AllocateNewBank();
+		for (std::size_t i : Window.Samples)
+			StoreSampleBankswitched(*Samples[i]);
+	}
 }
 
 void CChunkRenderNSF::StoreSample(const ft0cc::doc::dpcm_sample &DSample)
@@ -163,19 +165,9 @@ void CChunkRenderNSF::StoreSample(const ft0cc::doc::dpcm_sample &DSample)
 
 void CChunkRenderNSF::StoreSampleBankswitched(const ft0cc::doc::dpcm_sample &DSample)
 {
-	unsigned int SampleSize = DSample.size();
-
-	if (m_iSampleAddr + SampleSize >= (unsigned)CCompiler::DPCM_SWITCH_ADDRESS) {
-		// Allocate new bank
-		if (GetRemainingSize() != 0x1000)	// Skip if already on beginning of new bank
-			AllocateNewBank();
-		m_iSampleAddr = CCompiler::PAGE_SAMPLES;
-	}
-
-	int Adjust = CCompiler::AdjustSampleAddress(m_iSampleAddr + SampleSize);
+	// Windows are always aligned to NSF banks, so aligning the absolute address is enough
 	Store(DSample);
-	Fill(Adjust);
-	m_iSampleAddr += SampleSize + Adjust;
+	Fill(CCompiler::AdjustSampleAddress(GetAbsoluteAddr()));		// // //
 }
 
 int CChunkRenderNSF::GetBankCount() const
@@ -36,6 +36,7 @@ class dpcm_sample;
 } // namespace ft0cc::doc
 class CChunk;		// // //
 class CSimpleFile;		// // //
+struct stDPCMSampleWindow;		// // //
 
 // Base class
 class CBinaryFileWriter
@@ -79,7 +80,8 @@ public:
 	void StoreChunks(const std::vector<std::shared_ptr<CChunk>> &Chunks);		// // //
 	void StoreChunksBankswitched(const std::vector<std::shared_ptr<CChunk>> &Chunks);
 	void StoreSamples(const std::vector<std::shared_ptr<const ft0cc::doc::dpcm_sample>> &Samples);
-	void StoreSamplesBankswitched(const std::vector<std::shared_ptr<const ft0cc::doc::dpcm_sample>> &Samples);
+	void StoreSamplesBankswitched(const std::vector<std::shared_ptr<const ft0cc::doc::dpcm_sample>> &Samples,
+		const std::vector<stDPCMSampleWindow> &Windows);		// // //
 	int  GetBankCount() const;
 
 protected:
@@ -95,7 +97,6 @@ protected:
 
 protected:
 	unsigned int m_iStartAddr;
-	unsigned int m_iSampleAddr;
 };
 
 // NES render
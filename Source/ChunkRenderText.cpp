@@ -20,6 +20,7 @@
 ** must bear this legend.
 */
 
+
 #include "ChunkRenderText.h"
 #include "SimpleFile.h"		// // //
 #include "ft0cc/doc/dpcm_sample.hpp"		// // //
@@ -29,6 +30,7 @@
 #include "NumConv.h"		// // //
 #include "Instrument.h"		// // //
 #include "str_conv/str_conv.hpp"		// // //
+#include <array>		// // //
 
 /**
  * Text chunk render, these methods will always output single byte strings
@@ -39,76 +41,95 @@ namespace {
 
 const int DEFAULT_LINE_BREAK = 20;
 
+const std::size_t FLUSH_SIZE = 0x10000;		// // // Output is written in blocks of about this size
+
+// // // "$XX" for every byte value
+constexpr auto HEX_BYTES = [] {
+	constexpr char DIGITS[] = "0123456789ABCDEF";
+	std::array<std::array<char, 3>, 256> table = { };
+	for (unsigned i = 0; i < 256; ++i) {
+		table[i][0] = '$';
+		table[i][1] = DIGITS[i >> 4];
+		table[i][2] = DIGITS[i & 0x0F];
+	}
+	return table;
+}();
+
+void AppendHexByte(std::string &str, unsigned char x) {		// // //
+	str.append(HEX_BYTES[x].data(), HEX_BYTES[x].size());
+}
+
 } // namespace
 
 // // // TODO: remove
-std::string CChunkRenderText::GetLabelString(const stChunkLabel &label) {
-	const auto p1 = [&] { return conv::from_uint(label.Param1); };
-	const auto p2 = [&] { return conv::from_uint(label.Param2); };
-	const auto p3 = [&] { return conv::from_uint(label.Param3); };
+void CChunkRenderText::AppendLabelString(std::string &str, const stChunkLabel &label) {		// // //
+	const auto p = [&] (std::string_view prefix, unsigned param) {
+		str += prefix;
+		str += conv::sv_from_uint(param);
+	};
 
 	switch (label.Type) {
 	case CHUNK_NONE:            break;
 	case CHUNK_HEADER:          break;
 	case CHUNK_SEQUENCE:
 		switch (label.Param2) {
-		case INST_2A03: return "ft_seq_2a03_" + p1();
-		case INST_VRC6: return "ft_seq_vrc6_" + p1();
-		case INST_FDS:  return "ft_seq_fds_" + p1();
-		case INST_N163: return "ft_seq_n163_" + p1();
-		case INST_S5B:  return "ft_seq_s5b_" + p1();
+		case INST_2A03: p("ft_seq_2a03_", label.Param1); break;
+		case INST_VRC6: p("ft_seq_vrc6_", label.Param1); break;
+		case INST_FDS:  p("ft_seq_fds_", label.Param1); break;
+		case INST_N163: p("ft_seq_n163_", label.Param1); break;
+		case INST_S5B:  p("ft_seq_s5b_", label.Param1); break;
 		}
 		break;
-	case CHUNK_INSTRUMENT_LIST: return "ft_instrument_list";
-	case CHUNK_INSTRUMENT:      return "ft_inst_" + p1();
-	case CHUNK_SAMPLE_LIST:     return "ft_sample_list";
-	case CHUNK_SAMPLE_POINTERS: return "ft_sample_" + p1();
-//	case CHUNK_SAMPLE:          return "ft_sample_" + p1();
-	case CHUNK_GROOVE_LIST:     return "ft_groove_list";
-	case CHUNK_GROOVE:          return "ft_groove_" + p1();
-	case CHUNK_SONG_LIST:       return "ft_song_list";
-	case CHUNK_SONG:            return "ft_song_" + p1();
-	case CHUNK_FRAME_LIST:      return "ft_s" + p1() + "_frames";
-	case CHUNK_FRAME:           return "ft_s" + p1() + "f" + p2();
-	case CHUNK_PATTERN:         return "ft_s" + p1() + "p" + p2() + "c" + p3();
-	case CHUNK_WAVETABLE:       return "ft_wave_table";
-	case CHUNK_WAVES:           return "ft_waves_" + p1();
+	case CHUNK_INSTRUMENT_LIST: str += "ft_instrument_list"; break;
+	case CHUNK_INSTRUMENT:      p("ft_inst_", label.Param1); break;
+	case CHUNK_SAMPLE_LIST:     str += "ft_sample_list"; break;
+	case CHUNK_SAMPLE_POINTERS: p("ft_sample_", label.Param1); break;
+//	case CHUNK_SAMPLE:          p("ft_sample_", label.Param1); break;
+	case CHUNK_GROOVE_LIST:     str += "ft_groove_list"; break;
+	case CHUNK_GROOVE:          p("ft_groove_", label.Param1); break;
+	case CHUNK_SONG_LIST:       str += "ft_song_list"; break;
+	case CHUNK_SONG:            p("ft_song_", label.Param1); break;
+	case CHUNK_FRAME_LIST:      p("ft_s", label.Param1); str += "_frames"; break;
+	case CHUNK_FRAME:           p("ft_s", label.Param1); p("f", label.Param2); break;
+	case CHUNK_PATTERN:         p("ft_s", label.Param1); p("p", label.Param2); p("c", label.Param3); break;
+	case CHUNK_WAVETABLE:       str += "ft_wave_table"; break;
+	case CHUNK_WAVES:           p("ft_waves_", label.Param1); break;
 	case CHUNK_CHANNEL_MAP:     break;
 	case CHUNK_CHANNEL_TYPES:   break;
 	}
-	return "";
 }
 
 // String render functions
 const CChunkRenderText::stChunkRenderFunc CChunkRenderText::RENDER_FUNCTIONS[] = {
-	{CHUNK_HEADER,			&CChunkRenderText::StoreHeaderChunk},
-	{CHUNK_SEQUENCE,		&CChunkRenderText::StoreSequenceChunk},
-	{CHUNK_INSTRUMENT_LIST,	&CChunkRenderText::StoreInstrumentListChunk},
-	{CHUNK_INSTRUMENT,		&CChunkRenderText::StoreInstrumentChunk},
-	{CHUNK_SAMPLE_LIST,		&CChunkRenderText::StoreSampleListChunk},
-	{CHUNK_SAMPLE_POINTERS,	&CChunkRenderText::StoreSamplePointersChunk},
-	{CHUNK_GROOVE_LIST,		&CChunkRenderText::StoreGrooveListChunk},		// // //
-	{CHUNK_GROOVE,			&CChunkRenderText::StoreGrooveChunk},		// // //
-	{CHUNK_SONG_LIST,		&CChunkRenderText::StoreSongListChunk},
-	{CHUNK_SONG,			&CChunkRenderText::StoreSongChunk},
-	{CHUNK_FRAME_LIST,		&CChunkRenderText::StoreFrameListChunk},
-	{CHUNK_FRAME,			&CChunkRenderText::StoreFrameChunk},
-	{CHUNK_PATTERN,			&CChunkRenderText::StorePatternChunk},
-	{CHUNK_WAVETABLE,		&CChunkRenderText::StoreWavetableChunk},
-	{CHUNK_WAVES,			&CChunkRenderText::StoreWavesChunk},
+	{CHUNK_HEADER,			&CChunkRenderText::StoreHeaderChunk,			&CChunkRenderText::m_headerText},
+	{CHUNK_SEQUENCE,		&CChunkRenderText::StoreSequenceChunk,			&CChunkRenderText::m_sequenceText},
+	{CHUNK_INSTRUMENT_LIST,	&CChunkRenderText::StoreInstrumentListChunk,	&CChunkRenderText::m_instrumentListText},
+	{CHUNK_INSTRUMENT,		&CChunkRenderText::StoreInstrumentChunk,		&CChunkRenderText::m_instrumentText},
+	{CHUNK_SAMPLE_LIST,		&CChunkRenderText::StoreSampleListChunk,		&CChunkRenderText::m_sampleListText},
+	{CHUNK_SAMPLE_POINTERS,	&CChunkRenderText::StoreSamplePointersChunk,	&CChunkRenderText::m_samplePointersText},
+	{CHUNK_GROOVE_LIST,		&CChunkRenderText::StoreGrooveListChunk,		&CChunkRenderText::m_grooveListText},		// // //
+	{CHUNK_GROOVE,			&CChunkRenderText::StoreGrooveChunk,			&CChunkRenderText::m_grooveText},		// // //
+	{CHUNK_SONG_LIST,		&CChunkRenderText::StoreSongListChunk,			&CChunkRenderText::m_songListText},
+	{CHUNK_SONG,			&CChunkRenderText::StoreSongChunk,				&CChunkRenderText::m_songText},
+	{CHUNK_FRAME_LIST,		&CChunkRenderText::StoreFrameListChunk,			nullptr},
+	{CHUNK_FRAME,			&CChunkRenderText::StoreFrameChunk,				nullptr},
+	{CHUNK_PATTERN,			&CChunkRenderText::StorePatternChunk,			nullptr},
+	{CHUNK_WAVETABLE,		&CChunkRenderText::StoreWavetableChunk,			&CChunkRenderText::m_wavetableText},
+	{CHUNK_WAVES,			&CChunkRenderText::StoreWavesChunk,				&CChunkRenderText::m_wavesText},
 };
 
 CChunkRenderText::CChunkRenderText(CSimpleFile &File) : m_File(File)
 {
+	m_Buffer.reserve(FLUSH_SIZE * 2);		// // //
 }
 
 void CChunkRenderText::StoreChunks(const std::vector<std::shared_ptr<CChunk>> &Chunks)		// // //
 {
-	// Generate strings
+	// Generate strings for the module sections, song data is rendered later
 	for (auto &pChunk : Chunks)
 		for (const auto &f : RENDER_FUNCTIONS)
-			if (pChunk->GetType() == f.type)
-				(this->*(f.function))(pChunk.get());
+			if (pChunk->GetType() == f.type && f.section)		// // //
+				(this->*(f.function))(pChunk.get(), this->*(f.section));
 
 	// Write strings to file
 	WriteFileString("; VT02CC-FamiTracker exported music data: ");
@@ -116,36 +137,45 @@ void CChunkRenderText::StoreChunks(const std::vector<std::shared_ptr<CChunk>> &C
 	WriteFileString("\n;\n\n");
 
 	// Module header
-	DumpStrings("; Module header\n", "\n", m_headerStrings);
+	DumpSection("; Module header\n", "\n", m_headerText);
 
 	// Instrument list
-	DumpStrings("; Instrument pointer list\n", "\n", m_instrumentListStrings);
-	DumpStrings("; Instruments\n", "", m_instrumentStrings);
+	DumpSection("; Instrument pointer list\n", "\n", m_instrumentListText);
+	DumpSection("; Instruments\n", "", m_instrumentText);
 
 	// Sequences
-	DumpStrings("; Sequences\n", "\n", m_sequenceStrings);
+	DumpSection("; Sequences\n", "\n", m_sequenceText);
 
 	// Waves (FDS & N163)
-	if (!m_wavetableStrings.empty())
-		DumpStrings("; FDS waves\n", "\n", m_wavetableStrings);
+	if (!m_wavetableText.empty())
+		DumpSection("; FDS waves\n", "\n", m_wavetableText);
 
-	if (!m_wavesStrings.empty())
-		DumpStrings("; N163 waves\n", "\n", m_wavesStrings);
+	if (!m_wavesText.empty())
+		DumpSection("; N163 waves\n", "\n", m_wavesText);
 
 	// Samples
-	DumpStrings("; DPCM instrument list (pitch, sample index)\n", "\n", m_sampleListStrings);
-	DumpStrings("; DPCM samples list (location, size, bank)\n", "\n", m_samplePointersStrings);
+	DumpSection("; DPCM instrument list (pitch, sample index)\n", "\n", m_sampleListText);
+	DumpSection("; DPCM samples list (location, size, bank)\n", "\n", m_samplePointersText);
 
 	// // // Grooves
-	DumpStrings("; Groove list\n", "", m_grooveListStrings);
-	DumpStrings("; Grooves (size, terms)\n", "\n", m_grooveStrings);
+	DumpSection("; Groove list\n", "", m_grooveListText);
+	DumpSection("; Grooves (size, terms)\n", "\n", m_grooveText);
 
 	// Songs
-	DumpStrings("; Song pointer list\n", "\n", m_songListStrings);
-	DumpStrings("; Song info\n", "\n", m_songStrings);
+	DumpSection("; Song pointer list\n", "\n", m_songListText);
+	DumpSection("; Song info\n", "\n", m_songText);
 
-	// Song data
-	DumpStrings(";\n; Pattern and frame data for all songs below\n;\n\n", "", m_songDataStrings);
+	// Song data, rendered directly into the output buffer
+	WriteFileString(";\n; Pattern and frame data for all songs below\n;\n\n");
+	for (auto &pChunk : Chunks)		// // //
+		for (const auto &f : RENDER_FUNCTIONS)
+			if (pChunk->GetType() == f.type && !f.section) {
+				(this->*(f.function))(pChunk.get(), m_Buffer);
+				if (m_Buffer.size() >= FLUSH_SIZE)
+					FlushBuffer();
+			}
+
+	FlushBuffer();
 
 	// Actual DPCM samples are stored later
 }
@@ -162,9 +192,13 @@ void CChunkRenderText::StoreSamples(const std::vector<std::shared_ptr<const ft0c
 	for (size_t i = 0; i < Samples.size(); ++i) if (const auto &pDSample = Samples[i]) {		// // //
 		const unsigned int SampleSize = pDSample->size();
 
-		std::string label = "ft_sample_" + conv::from_uint(i);		// // //
-		std::string str = label + ": ; " + std::string {pDSample->name()} + "\n";
-		str += GetByteString(*pDSample, DEFAULT_LINE_BREAK);
+		std::string &str = m_Buffer;		// // //
+		str += "ft_sample_";
+		str += conv::sv_from_uint(i);
+		str += ": ; ";
+		str += pDSample->name();
+		str += '\n';
+		AppendByteString(str, *pDSample, DEFAULT_LINE_BREAK);
 		Address += SampleSize;
 
 		// Adjust if necessary
@@ -175,105 +209,119 @@ void CChunkRenderText::StoreSamples(const std::vector<std::shared_ptr<const ft0c
 		}
 
 		str.push_back('\n');
-		WriteFileString(str);
+		if (m_Buffer.size() >= FLUSH_SIZE)
+			FlushBuffer();
 	}
+
+	FlushBuffer();
 }
 
-void CChunkRenderText::DumpStrings(std::string_view preStr, std::string_view postStr, const std::vector<std::string> &stringArray) const		// // //
+void CChunkRenderText::DumpSection(std::string_view preStr, std::string_view postStr, const std::string &section)		// // //
 {
 	WriteFileString(preStr);
-
-	for (auto &str : stringArray)
-		WriteFileString(str);
-
+	WriteFileString(section);
 	WriteFileString(postStr);
 }
 
-void CChunkRenderText::StoreHeaderChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreHeaderChunk(const CChunk *pChunk, std::string &str)
 {
-	std::string str;
 	int i = 0;
 
-	str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i++)) + "\n";		// // //
-	str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i++)) + "\n";
-	str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i++)) + "\n";
-	str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i++)) + "\n";
-	str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i++)) + "\n";		// // //		groove
-	str += "\t.byte %i ; flags\n", pChunk->GetData(i++);
-	if (pChunk->IsDataPointer(i))
-		str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i++)) + "\n";	// FDS waves
-	str += "\t.word %i ; NTSC speed\n", pChunk->GetData(i++);
-	str += "\t.word %i ; PAL speed\n", pChunk->GetData(i++);
+	for (int j = 0; j < 5; ++j) {		// // // groove
+		str += "\t.word ";
+		AppendLabelString(str, pChunk->GetDataPointerTarget(i++));
+		str += '\n';
+	}
+	str += "\t.byte " + conv::from_uint(pChunk->GetData(i++)) + " ; flags\n";		// // //
+	if (pChunk->IsDataPointer(i)) {
+		str += "\t.word ";
+		AppendLabelString(str, pChunk->GetDataPointerTarget(i++));		// FDS waves
+		str += '\n';
+	}
+	str += "\t.word " + conv::from_uint(pChunk->GetData(i++)) + " ; NTSC speed\n";
+	str += "\t.word " + conv::from_uint(pChunk->GetData(i++)) + " ; PAL speed\n";
 	if (i < pChunk->GetLength())
-		str += "\t.word %i ; N163 channels\n", pChunk->GetData(i++);	// N163 channels
-
-	m_headerStrings.push_back(std::move(str));
+		str += "\t.byte " + conv::from_uint(pChunk->GetData(i++)) + " ; N163 channels\n";	// N163 channels
 }
 
-void CChunkRenderText::StoreInstrumentListChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreInstrumentListChunk(const CChunk *pChunk, std::string &str)
 {
 	// Store instrument pointers
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
 
-	for (int i = 0; i < pChunk->GetLength(); ++i)
-		str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i)) + "\n";
-
-	m_instrumentListStrings.push_back(std::move(str));
+	for (int i = 0; i < pChunk->GetLength(); ++i) {
+		str += "\t.word ";
+		AppendLabelString(str, pChunk->GetDataPointerTarget(i));
+		str += '\n';
+	}
 }
 
-void CChunkRenderText::StoreInstrumentChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreInstrumentChunk(const CChunk *pChunk, std::string &str)
 {
 	int len = pChunk->GetLength();
 
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n\t.byte " + conv::from_uint(pChunk->GetData(0)) + "\n";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n\t.byte ";
+	str += conv::sv_from_uint(pChunk->GetData(0));
+	str += '\n';
 
 	for (int i = 1; i < len; ++i) {
-		if (pChunk->IsDataPointer(i))
-			str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i)) + "\n";
-		else if (pChunk->GetDataSize(i) == 1)
-			str += "\t.byte $" + conv::from_uint_hex(pChunk->GetData(i), 2) + "\n";
-		else
-			str += "\t.word $" + conv::from_uint_hex(pChunk->GetData(i), 4) + "\n";
+		if (pChunk->IsDataPointer(i)) {
+			str += "\t.word ";
+			AppendLabelString(str, pChunk->GetDataPointerTarget(i));
+		}
+		else if (pChunk->GetDataSize(i) == 1) {
+			str += "\t.byte ";
+			AppendHexByte(str, pChunk->GetData(i));
+		}
+		else {
+			str += "\t.word $";
+			str += conv::sv_from_uint_hex(pChunk->GetData(i), 4);
+		}
+		str += '\n';
 	}
 
 	str.push_back('\n');
-
-	m_instrumentStrings.push_back(std::move(str));
 }
 
-void CChunkRenderText::StoreSequenceChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreSequenceChunk(const CChunk *pChunk, std::string &str)
 {
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
-	str += GetByteString(pChunk, DEFAULT_LINE_BREAK);		// // //
-
-	m_sequenceStrings.push_back(std::move(str));
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
+	AppendByteString(str, pChunk, DEFAULT_LINE_BREAK);		// // //
 }
 
-void CChunkRenderText::StoreSampleListChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreSampleListChunk(const CChunk *pChunk, std::string &str)
 {
 	// Store sample list
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
-
-	for (int i = 0; i < pChunk->GetLength(); i += 3)
-		str += "\t.byte " + conv::from_uint(pChunk->GetData(i + 0)) + ", " +
-			conv::from_uint(pChunk->GetData(i + 1)) + ", " +
-			conv::from_uint(pChunk->GetData(i + 2)) + "\n";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
 
-	m_sampleListStrings.push_back(std::move(str));
+	for (int i = 0; i < pChunk->GetLength(); i += 3) {
+		str += "\t.byte ";
+		str += conv::sv_from_uint(pChunk->GetData(i + 0));
+		str += ", ";
+		str += conv::sv_from_uint(pChunk->GetData(i + 1));
+		str += ", ";
+		str += conv::sv_from_uint(pChunk->GetData(i + 2));
+		str += '\n';
+	}
 }
 
-void CChunkRenderText::StoreSamplePointersChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreSamplePointersChunk(const CChunk *pChunk, std::string &str)
 {
 	int len = pChunk->GetLength();
 
 	// Store sample pointer
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
 
 	if (len > 0) {
 		str += "\t.byte ";
 
 		for (int i = 0; i < len; ++i) {
-			str += conv::from_uint(pChunk->GetData(i));
+			str += conv::sv_from_uint(pChunk->GetData(i));
 			if ((i < len - 1) && (i % 3 != 2))
 				str += ", ";
 			if (i % 3 == 2 && i < (len - 1))
@@ -282,85 +330,95 @@ void CChunkRenderText::StoreSamplePointersChunk(const CChunk *pChunk)
 	}
 
 	str.push_back('\n');
-
-	m_samplePointersStrings.push_back(std::move(str));
 }
 
-void CChunkRenderText::StoreGrooveListChunk(const CChunk *pChunk)		// // //
+void CChunkRenderText::StoreGrooveListChunk(const CChunk *pChunk, std::string &str)		// // //
 {
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
-
-	for (int i = 0; i < pChunk->GetLength(); ++i)
-		str += "\t.byte $" + conv::from_uint_hex(pChunk->GetData(i), 2) + "\n";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
 
-	m_grooveListStrings.push_back(std::move(str));
+	for (int i = 0; i < pChunk->GetLength(); ++i) {
+		str += "\t.byte ";
+		AppendHexByte(str, pChunk->GetData(i));
+		str += '\n';
+	}
 }
 
-void CChunkRenderText::StoreGrooveChunk(const CChunk *pChunk)		// // //
+void CChunkRenderText::StoreGrooveChunk(const CChunk *pChunk, std::string &str)		// // //
 {
-	std::string str;
-
-	// std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
-	str += GetByteString(pChunk, DEFAULT_LINE_BREAK);
-
-	m_grooveStrings.push_back(std::move(str));
+	// AppendLabelString(str, pChunk->GetLabel());
+	AppendByteString(str, pChunk, DEFAULT_LINE_BREAK);
 }
 
-void CChunkRenderText::StoreSongListChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreSongListChunk(const CChunk *pChunk, std::string &str)
 {
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
 
 	for (int i = 0; i < pChunk->GetLength(); ++i) {
-		str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i)) + "\n";
+		str += "\t.word ";
+		AppendLabelString(str, pChunk->GetDataPointerTarget(i));
+		str += '\n';
 	}
-
-	m_songListStrings.push_back(std::move(str));
 }
 
-void CChunkRenderText::StoreSongChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreSongChunk(const CChunk *pChunk, std::string &str)
 {
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
+
+	const std::string_view COMMENTS[] = {		// // //
+		"\t; frame count\n",
+		"\t; pattern length\n",
+		"\t; speed\n",
+		"\t; tempo\n",
+		"\t; groove position\n",
+		"\t; initial bank\n",
+	};
 
 	for (int i = 0; i < pChunk->GetLength();) {
-		str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i++)) + "\n";
-		str += "\t.byte " + conv::from_uint(pChunk->GetData(i++)) + "\t; frame count\n";
-		str += "\t.byte " + conv::from_uint(pChunk->GetData(i++)) + "\t; pattern length\n";
-		str += "\t.byte " + conv::from_uint(pChunk->GetData(i++)) + "\t; speed\n";
-		str += "\t.byte " + conv::from_uint(pChunk->GetData(i++)) + "\t; tempo\n";
-		str += "\t.byte " + conv::from_uint(pChunk->GetData(i++)) + "\t; groove position\n";		// // //
-		str += "\t.byte " + conv::from_uint(pChunk->GetData(i++)) + "\t; initial bank\n";
+		str += "\t.word ";
+		AppendLabelString(str, pChunk->GetDataPointerTarget(i++));
+		str += '\n';
+		for (auto comment : COMMENTS) {
+			str += "\t.byte ";
+			str += conv::sv_from_uint(pChunk->GetData(i++));
+			str += comment;
+		}
 	}
 
 	str.push_back('\n');
-
-	m_songStrings.push_back(std::move(str));
 }
 
-void CChunkRenderText::StoreFrameListChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreFrameListChunk(const CChunk *pChunk, std::string &str)
 {
 	// Pointers to frames
-	std::string str = "; Bank " + conv::from_uint(pChunk->GetBank()) + "\n";
-	str += GetLabelString(pChunk->GetLabel()) + ":\n";
+	str += "; Bank ";
+	str += conv::sv_from_uint(pChunk->GetBank());
+	str += '\n';
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
 
 	for (int i = 0; i < pChunk->GetLength(); ++i) {
-		str += "\t.word " + GetLabelString(pChunk->GetDataPointerTarget(i)) + "\n";
+		str += "\t.word ";
+		AppendLabelString(str, pChunk->GetDataPointerTarget(i));
+		str += '\n';
 	}
-
-	m_songDataStrings.push_back(std::move(str));
 }
 
-void CChunkRenderText::StoreFrameChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreFrameChunk(const CChunk *pChunk, std::string &str)
 {
 	int len = pChunk->GetLength();
 
 	// Frame list
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n\t.word ";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n\t.word ";
 
 	for (int i = 0, j = 0; i < len; ++i) {
 		if (pChunk->IsDataPointer(i)) {
 			if (j++ > 0)
 				str += ", ";
-			str += GetLabelString(pChunk->GetDataPointerTarget(i));
+			AppendLabelString(str, pChunk->GetDataPointerTarget(i));
 		}
 	}
 
@@ -371,127 +429,85 @@ void CChunkRenderText::StoreFrameChunk(const CChunk *pChunk)
 				str += "\n\t.byte ";
 			if (j++ > 0)
 				str += ", ";
-			str += "$" + conv::from_uint_hex(pChunk->GetData(i), 2);
+			AppendHexByte(str, pChunk->GetData(i));
 		}
 	}
 
 	str.push_back('\n');
-
-	m_songDataStrings.push_back(std::move(str));
 }
 
-void CChunkRenderText::StorePatternChunk(const CChunk *pChunk)
+void CChunkRenderText::StorePatternChunk(const CChunk *pChunk, std::string &str)
 {
 	// Patterns
-	std::string str = "; Bank " + conv::from_uint(pChunk->GetBank()) + "\n";
-	str += GetLabelString(pChunk->GetLabel()) + ":\n";
+	str += "; Bank ";
+	str += conv::sv_from_uint(pChunk->GetBank());
+	str += '\n';
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
 
-	const std::vector<unsigned char> &vec = pChunk->GetStringData(0);		// // //
-	str += GetByteString(vec, DEFAULT_LINE_BREAK).data();
-/*
-	len = vec.size();
-	for (int i = 0; i < len; ++i) {
-		str += "$%02X", (unsigned char)vec[i]);
-		if ((i % 20 == 19) && (i < len - 1))
-			str += "\n\t.byte ";
-		else {
-			if (i < len - 1)
-				str += ", ";
-		}
-	}
-*/
+	AppendByteString(str, pChunk->GetStringData(0), DEFAULT_LINE_BREAK);		// // //
 	str.push_back('\n');
-
-	m_songDataStrings.push_back(std::move(str));
 }
 
-void CChunkRenderText::StoreWavetableChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreWavetableChunk(const CChunk *pChunk, std::string &str)
 {
-	int len = pChunk->GetLength();
-
 	// FDS waves
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
-	str += "\t.byte ";
-
-	for (int i = 0; i < len; ++i) {
-		str += "$" + conv::from_uint_hex(pChunk->GetData(i), 2);
-		if ((i % 64 == 63) && (i < len - 1))
-			str += "\n\t.byte ";
-		else {
-			if (i < len - 1)
-				str += ", ";
-		}
-	}
-
-	str.push_back('\n');
-
-	m_wavetableStrings.push_back(std::move(str));
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
+	AppendByteString(str, pChunk, 64);		// // //
 }
 
-void CChunkRenderText::StoreWavesChunk(const CChunk *pChunk)
+void CChunkRenderText::StoreWavesChunk(const CChunk *pChunk, std::string &str)
 {
-	int len = pChunk->GetLength();
-
 //				int waves = pChunk->GetData(0);
 	int wave_len = 16;//(len - 1) / waves;
 
 	// Namco waves
-	std::string str = GetLabelString(pChunk->GetLabel()) + ":\n";
+	AppendLabelString(str, pChunk->GetLabel());
+	str += ":\n";
 //				str += "\t.byte %i\n", waves);
 
-	str += "\t.byte ";
-
-	for (int i = 0; i < len; ++i) {
-		str += "$" + conv::from_uint_hex(pChunk->GetData(i), 2);
-		if ((i % wave_len == (wave_len - 1)) && (i < len - 1))
-			str += "\n\t.byte ";
-		else {
-			if (i < len - 1)
-				str += ", ";
-		}
-	}
-
-	str.push_back('\n');
-
-	m_wavesStrings.push_back(std::move(str));
+	AppendByteString(str, pChunk, wave_len);		// // //
 }
 
-void CChunkRenderText::WriteFileString(std::string_view sv) const		// // //
+void CChunkRenderText::WriteFileString(std::string_view sv)		// // //
 {
-	m_File.WriteBytes(sv);		// // //
+	m_Buffer += sv;
+	if (m_Buffer.size() >= FLUSH_SIZE)
+		FlushBuffer();
 }
 
-std::string CChunkRenderText::GetByteString(array_view<unsigned char> Data, int LineBreak) {		// // //
-	std::string str = "\t.byte ";
+void CChunkRenderText::FlushBuffer()		// // //
+{
+	if (!m_Buffer.empty()) {
+		m_File.WriteBytes(m_Buffer);
+		m_Buffer.clear();
+	}
+}
 
-	int i = 0;
-	while (!Data.empty()) {
-		str += '$';
-		str += conv::sv_from_uint_hex(Data.front(), 2);
-		Data.pop_front();
+void CChunkRenderText::AppendByteString(std::string &str, array_view<unsigned char> Data, int LineBreak) {		// // //
+	str += "\t.byte ";
 
-		if (!Data.empty()) {
+	for (std::size_t i = 0, n = Data.size(); i < n; ++i) {
+		AppendHexByte(str, Data[i]);
+		if (i < n - 1) {
 			if ((i % LineBreak == (LineBreak - 1)))
 				str += "\n\t.byte ";
 			else
 				str += ", ";
 		}
-
-		++i;
 	}
 
 	str += '\n';
-	return str;
 }
 
-std::string CChunkRenderText::GetByteString(const CChunk *pChunk, int LineBreak) {		// // //
+void CChunkRenderText::AppendByteString(std::string &str, const CChunk *pChunk, int LineBreak) {		// // //
 	int len = pChunk->GetLength();
 
-	std::string str = "\t.byte ";
+	str += "\t.byte ";
 
 	for (int i = 0; i < len; ++i) {
-		str += '$';
-		str += conv::sv_from_uint_hex(pChunk->GetData(i), 2);
+		AppendHexByte(str, pChunk->GetData(i));
 
 		if ((i % LineBreak == (LineBreak - 1)) && (i < len - 1))
 			str += "\n\t.byte ";
@@ -500,5 +516,4 @@ std::string CChunkRenderText::GetByteString(const CChunk *pChunk, int LineBreak)
 	}
 
 	str += '\n';
-	return str;
 }
@@ -44,10 +44,11 @@ struct stChunkLabel;		// // //
 
 class CChunkRenderText
 {
-	using renderFunc_t = void (CChunkRenderText::*)(const CChunk *);
+	using renderFunc_t = void (CChunkRenderText::*)(const CChunk *, std::string &);		// // //
 	struct stChunkRenderFunc {
 		chunk_type_t type;
 		renderFunc_t function;
+		std::string CChunkRenderText::*section;		// // // nullptr for song data, which is streamed to the file
 	};
 
 public:
@@ -58,45 +59,47 @@ public:
 
 private:
 	static const stChunkRenderFunc RENDER_FUNCTIONS[];
-	static std::string GetLabelString(const stChunkLabel &label);		// // //
-	static std::string GetByteString(array_view<unsigned char> Data, int LineBreak);		// // //
-	static std::string GetByteString(const CChunk *pChunk, int LineBreak);		// // //
+	static void AppendLabelString(std::string &str, const stChunkLabel &label);		// // //
+	static void AppendByteString(std::string &str, array_view<unsigned char> Data, int LineBreak);		// // //
+	static void AppendByteString(std::string &str, const CChunk *pChunk, int LineBreak);		// // //
 
 private:
-	void DumpStrings(std::string_view preStr, std::string_view postStr, const std::vector<std::string> &stringArray) const;		// // //
-	void WriteFileString(std::string_view sv) const;		// // //
+	void DumpSection(std::string_view preStr, std::string_view postStr, const std::string &section);		// // //
+	void WriteFileString(std::string_view sv);		// // //
+	void FlushBuffer();		// // //
 
 private:
-	void StoreHeaderChunk(const CChunk *pChunk);
-	void StoreInstrumentListChunk(const CChunk *pChunk);
-	void StoreInstrumentChunk(const CChunk *pChunk);
-	void StoreSequenceChunk(const CChunk *pChunk);
-	void StoreSampleListChunk(const CChunk *pChunk);
-	void StoreSamplePointersChunk(const CChunk *pChunk);
-	void StoreGrooveListChunk(const CChunk *pChunk);		// // //
-	void StoreGrooveChunk(const CChunk *pChunk);		// // //
-	void StoreSongListChunk(const CChunk *pChunk);
-	void StoreSongChunk(const CChunk *pChunk);
-	void StoreFrameListChunk(const CChunk *pChunk);
-	void StoreFrameChunk(const CChunk *pChunk);
-	void StorePatternChunk(const CChunk *pChunk);
-	void StoreWavetableChunk(const CChunk *pChunk);
-	void StoreWavesChunk(const CChunk *pChunk);
+	void StoreHeaderChunk(const CChunk *pChunk, std::string &str);
+	void StoreInstrumentListChunk(const CChunk *pChunk, std::string &str);
+	void StoreInstrumentChunk(const CChunk *pChunk, std::string &str);
+	void StoreSequenceChunk(const CChunk *pChunk, std::string &str);
+	void StoreSampleListChunk(const CChunk *pChunk, std::string &str);
+	void StoreSamplePointersChunk(const CChunk *pChunk, std::string &str);
+	void StoreGrooveListChunk(const CChunk *pChunk, std::string &str);		// // //
+	void StoreGrooveChunk(const CChunk *pChunk, std::string &str);		// // //
+	void StoreSongListChunk(const CChunk *pChunk, std::string &str);
+	void StoreSongChunk(const CChunk *pChunk, std::string &str);
+	void StoreFrameListChunk(const CChunk *pChunk, std::string &str);
+	void StoreFrameChunk(const CChunk *pChunk, std::string &str);
+	void StorePatternChunk(const CChunk *pChunk, std::string &str);
+	void StoreWavetableChunk(const CChunk *pChunk, std::string &str);
+	void StoreWavesChunk(const CChunk *pChunk, std::string &str);
 
 private:
-	std::vector<std::string> m_headerStrings;		// // //
-	std::vector<std::string> m_instrumentListStrings;
-	std::vector<std::string> m_instrumentStrings;
-	std::vector<std::string> m_sequenceStrings;
-	std::vector<std::string> m_sampleListStrings;
-	std::vector<std::string> m_samplePointersStrings;
-	std::vector<std::string> m_grooveListStrings;		// // //
-	std::vector<std::string> m_grooveStrings;		// // //
-	std::vector<std::string> m_songListStrings;
-	std::vector<std::string> m_songStrings;
-	std::vector<std::string> m_songDataStrings;
-	std::vector<std::string> m_wavetableStrings;
-	std::vector<std::string> m_wavesStrings;
+	std::string m_headerText;		// // //
+	std::string m_instrumentListText;
+	std::string m_instrumentText;
+	std::string m_sequenceText;
+	std::string m_sampleListText;
+	std::string m_samplePointersText;
+	std::string m_grooveListText;
+	std::string m_grooveText;
+	std::string m_songListText;
+	std::string m_songText;
+	std::string m_wavetableText;
+	std::string m_wavesText;
+
+	std::string m_Buffer;		// // // Pending file output
 
 	CSimpleFile &m_File;
 };
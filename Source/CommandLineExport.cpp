@@ -24,7 +24,9 @@
 #include "FamiTrackerDoc.h"
 #include "FamiTrackerModule.h"		// // //
 #include "Compiler.h"
+#include "CompilerCache.h"		// // //
 #include "SoundGen.h"
+#include "FamiTrackerEnv.h"		// // //
 #include "TextExporter.h"
 #include "SimpleFile.h"		// // //
 #include "str_conv/str_conv.hpp"		// // //
@@ -43,7 +45,7 @@ private:
 };
 
 // Command line export function
-void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CStringW &fileOut, const CStringW &fileLog, const CStringW &fileDPCM) {
+void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CStringW &fileOut, const CStringW &fileLog, const CStringW &fileDPCM, const CStringW &fileCache) {		// // //
 	// open log
 	bool bLog = false;
 	CStdioFile fLog;
@@ -99,10 +101,23 @@ void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CString
 
 	const CFamiTrackerModule *pModule = pExportDoc->GetModule();		// // //
 
+	// // // reuse compiled data from previous exports
+	std::shared_ptr<CCompilerCache> pCache;
+	if (fileCache.GetLength() > 0) {
+		pCache = std::make_shared<CCompilerCache>(static_cast<LPCWSTR>(fileCache));
+		pCache->Load();
+	}
+	const auto SaveCache = [&] {
+		if (pCache && !pCache->Save() && bLog)
+			fLog.WriteString(L"Warning: unable to write export cache\n");
+	};
+
 	// export
 	if (0 == ext.CompareNoCase(L".nsf")) {
 		CCompiler compiler(*pModule, bLog ? std::make_shared<CCommandLineLog>(fLog) : nullptr);		// // //
+		compiler.SetCache(pCache);		// // //
 		compiler.ExportNSF(OutputFile, value_cast(pModule->GetMachine()));
+		SaveCache();
 		if (bLog) {
 			fLog.WriteString(L"\nNSF export complete.\n");
 		}
@@ -110,7 +125,9 @@ void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CString
 	}
 	else if (0 == ext.CompareNoCase(L".nes")) {
 		CCompiler compiler(*pModule, bLog ? std::make_shared<CCommandLineLog>(fLog) : nullptr);		// // //
+		compiler.SetCache(pCache);		// // //
 		compiler.ExportNES(OutputFile, pModule->GetMachine() == machine_t::PAL);
+		SaveCache();
 		if (bLog) {
 			fLog.WriteString(L"\nNES export complete.\n");
 		}
@@ -127,7 +144,9 @@ void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CString
 		}
 
 		CCompiler compiler(*pModule, bLog ? std::make_shared<CCommandLineLog>(fLog) : nullptr);		// // //
+		compiler.SetCache(pCache);		// // //
 		compiler.ExportBIN(OutputFile, DPCMFile);
+		SaveCache();
 		if (bLog) {
 			fLog.WriteString(L"\nBIN export complete.\n");
 		}
@@ -135,7 +154,9 @@ void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CString
 	}
 	else if (0 == ext.CompareNoCase(L".prg")) {
 		CCompiler compiler(*pModule, bLog ? std::make_shared<CCommandLineLog>(fLog) : nullptr);		// // //
+		compiler.SetCache(pCache);		// // //
 		compiler.ExportPRG(OutputFile, pModule->GetMachine() == machine_t::PAL);
+		SaveCache();
 		if (bLog) {
 			fLog.WriteString(L"\nPRG export complete.\n");
 		}
@@ -143,7 +164,9 @@ void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CString
 	}
 	else if (0 == ext.CompareNoCase(L".asm")) {
 		CCompiler compiler(*pModule, bLog ? std::make_shared<CCommandLineLog>(fLog) : nullptr);		// // //
+		compiler.SetCache(pCache);		// // //
 		compiler.ExportASM(OutputFile);
+		SaveCache();
 		if (bLog) {
 			fLog.WriteString(L"\nASM export complete.\n");
 		}
@@ -152,7 +175,9 @@ void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CString
 	else if (0 == ext.CompareNoCase(L".nsfe"))		// // //
 	{
 		CCompiler compiler(*pModule, bLog ? std::make_shared<CCommandLineLog>(fLog) : nullptr);		// // //
+		compiler.SetCache(pCache);		// // //
 		compiler.ExportNSFE(OutputFile, value_cast(pModule->GetMachine()));
+		SaveCache();
 		if (bLog) {
 			fLog.WriteString(L"\nNSFe export complete.\n");
 		}
@@ -160,8 +185,9 @@ void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CString
 	}
 	else if (0 == ext.CompareNoCase(L".txt")) {
 		CTextExport textExport;
-		CStringA result = textExport.ExportFile((LPCWSTR)fileOut, *pExportDoc);		// // //
-		if (result.GetLength() > 0) {
+		std::string result = textExport.ExportFile((LPCWSTR)fileOut, *pExportDoc->GetModule());		// // //
+		FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
+		if (!result.empty()) {
 			if (bLog) {
 				fLog.WriteString(L"Error: ");
 				fLog.WriteString(conv::to_wide(result).data());
@@ -28,5 +28,5 @@
 class CCommandLineExport
 {
 public:
-	void CommandLineExport(const CStringW& fileIn, const CStringW& fileOut, const CStringW& fileLog,  const CStringW& fileDPCM);
+	void CommandLineExport(const CStringW& fileIn, const CStringW& fileOut, const CStringW& fileLog,  const CStringW& fileDPCM, const CStringW& fileCache);		// // //
 };
@@ -37,9 +37,8 @@ struct stDPCMState {
 	int DeltaCntr;
 };
 
-// Used to play the audio when the buffer is full
+// Receives the audio of each emulated frame
 class IAudioCallback {
 public:
-	virtual void FlushBuffer(array_view<int16_t> Buffer) = 0;		// // //
-	virtual bool PlayBuffer() = 0;		// // // return true if succeeded
+	virtual void FlushBuffer(array_view<float> Buffer) = 0;		// // // samples are normalized to +/-1.0 and not clipped
 };
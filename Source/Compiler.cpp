@@ -49,6 +49,12 @@
 #include "SoundChipService.h"		// // //
 #include "SimpleFile.h"		// // //
 #include "Assertion.h"		// // //
+#include "CompilerCache.h"		// // //
+#include "ContentHash.h"		// // //
+#include <algorithm>		// // //
+#include <numeric>		// // //
+#include <set>		// // //
+#include <tuple>		// // //
 
 //
 // This is the new NSF data compiler, music is compiled to an object list instead of a binary chunk
@@ -273,7 +279,7 @@ void CCompiler::ExportNSF_NSFE(CSimpleFile &file, int MachineType, bool isNSFE)
 	if (m_bBankSwitched) {
 		Render.StoreDriver(Driver);
 		Render.StoreChunksBankswitched(m_vChunks);
-		Render.StoreSamplesBankswitched(m_vSamples);
+		Render.StoreSamplesBankswitched(m_vSamples, m_vSampleWindows);		// // //
 	}
 	else {
 		if (bCompressedMode) {
@@ -450,6 +456,14 @@ void CCompiler::SetMetadata(std::string_view title, std::string_view artist, std
 	copyright_ = conv::utf8_trim(copyright.substr(0, CFamiTrackerModule::METADATA_FIELD_LENGTH - 1));
 }
 
+void CCompiler::SetCache(std::shared_ptr<CCompilerCache> pCache) {		// // //
+	m_pCache = std::move(pCache);
+}
+
+bool CCompiler::HasErrors() const {		// // //
+	return m_bErrors;
+}
+
 std::vector<unsigned char> CCompiler::LoadDriver(const driver_t &Driver, unsigned short Origin) const {		// // //
 	// Copy embedded driver
 	std::vector<unsigned char> Data(Driver.driver.begin(), Driver.driver.end());
@@ -615,53 +629,95 @@ stNSFeHeader CCompiler::CreateNSFeHeader(int MachineType)		// // //
 }
 
 
+void CCompiler::PackSamplesBankswitched()		// // //
+{
+	// Distribute samples over DPCM windows with first-fit decreasing, each
+	// window then occupies only as many NSF banks as it actually uses
+
+	const unsigned int Capacity = DPCM_SWITCH_ADDRESS - PAGE_SAMPLES;
+
+	std::vector<std::size_t> Order(m_vSamples.size());
+	std::iota(Order.begin(), Order.end(), 0u);
+	std::stable_sort(Order.begin(), Order.end(), [&] (std::size_t l, std::size_t r) {
+		return m_vSamples[l]->size() > m_vSamples[r]->size();
+	});
+
+	m_vSampleWindows.clear();
+	for (std::size_t i : Order) {
+		unsigned int Size = m_vSamples[i]->size();
+		auto it = std::find_if(m_vSampleWindows.begin(), m_vSampleWindows.end(), [&] (const stDPCMSampleWindow &w) {
+			return w.Size + Size < Capacity;
+		});
+		auto &Window = it != m_vSampleWindows.end() ? *it : m_vSampleWindows.emplace_back();
+		Window.Samples.push_back(i);
+		Window.Size += Size + AdjustSampleAddress(Window.Size + Size);
+	}
+
+	unsigned int Bank = m_iFirstSampleBank;
+	for (auto &Window : m_vSampleWindows) {
+		unsigned int Pages = (Window.Size + PAGE_SIZE - 1) / PAGE_SIZE;
+		Window.Bank = Bank;
+		Bank += Pages;
+		Print(" * DPCM bank " + conv::from_uint(Window.Bank) + (Pages > 1 ? "-" + conv::from_uint(Bank - 1) : "") +
+			": " + conv::from_uint(Window.Samples.size()) + " sample(s), " + conv::from_uint(Window.Size) + " / " +
+			conv::from_uint(Pages * PAGE_SIZE) + " bytes (" + conv::from_uint(100 * Window.Size / (Pages * PAGE_SIZE)) + "%)\n");
+	}
+	Print(" * DPCM sample banks: " + conv::from_uint(Bank - m_iFirstSampleBank) + "\n");
+}
+
 void CCompiler::UpdateSamplePointers(unsigned int Origin)
 {
 	// Rewrite sample pointer list with valid addresses
-	//
-	// TODO: rewrite this to utilize the CChunkDataBank to resolve bank numbers automatically
-	//
 
 	Assert(m_pSamplePointersChunk != NULL);
 
-	unsigned int Address = Origin;
-	unsigned int Bank = m_iFirstSampleBank;
+	std::vector<unsigned int> Address(m_vSamples.size());		// // //
+	std::vector<unsigned int> Bank(m_vSamples.size(), 0u);		// Disable DPCM bank switching by default
 
-	if (!m_bBankSwitched)
-		Bank = 0;			// Disable DPCM bank switching
+	if (m_bBankSwitched) {
+		PackSamplesBankswitched();		// // //
+		for (const auto &Window : m_vSampleWindows) {
+			unsigned int Pos = PAGE_SAMPLES;
+			for (std::size_t i : Window.Samples) {
+				Address[i] = Pos;
+				Bank[i] = Window.Bank;
+				Pos += m_vSamples[i]->size();
+				Pos += AdjustSampleAddress(Pos);
+			}
+		}
+	}
+	else {
+		unsigned int Pos = Origin;
+		for (std::size_t i = 0; i < m_vSamples.size(); ++i) {
+			Address[i] = Pos;
+			Pos += m_vSamples[i]->size();
+			Pos += AdjustSampleAddress(Pos);
+		}
+	}
 
 	m_pSamplePointersChunk->Clear();
 
 	// The list is stored in the same order as the samples vector
 
-	for (auto pDSample : m_vSamples) {
-		unsigned int Size = pDSample->size();
-
-		if (m_bBankSwitched) {
-			if ((Address + Size) >= DPCM_SWITCH_ADDRESS) {
-				Address = PAGE_SAMPLES;
-				Bank += DPCM_PAGE_WINDOW;
-			}
-		}
+	for (std::size_t i = 0; i < m_vSamples.size(); ++i) {
+		unsigned int Size = m_vSamples[i]->size();
 
 		// Store
-		m_pSamplePointersChunk->StoreByte(Address >> 6);
+		m_pSamplePointersChunk->StoreByte(Address[i] >> 6);
 		m_pSamplePointersChunk->StoreByte(Size >> 4);
-		m_pSamplePointersChunk->StoreByte(Bank);
+		m_pSamplePointersChunk->StoreByte(Bank[i]);
 
 #ifdef _DEBUG
-		Print(" * DPCM sample " + std::string {pDSample->name()} + ": $" + conv::from_uint_hex(Address, 4) +
-			", bank " + conv::from_uint(Bank) + " (" + conv::from_uint(Size) + " bytes)\n");
+		Print(" * DPCM sample " + std::string {m_vSamples[i]->name()} + ": $" + conv::from_uint_hex(Address[i], 4) +
+			", bank " + conv::from_uint(Bank[i]) + " (" + conv::from_uint(Size) + " bytes)\n");
 #endif
-		Address += Size;
-		Address += AdjustSampleAddress(Address);
 	}
-#ifdef _DEBUG
-	Print(" * DPCM sample banks: " + conv::from_uint(Bank - m_iFirstSampleBank + DPCM_PAGE_WINDOW) + "\n");
-#endif
 
 	// Save last bank number for NSF header
-	m_iLastBank = Bank + 1;
+	if (m_bBankSwitched)		// // //
+		m_iLastBank = (m_vSampleWindows.empty() ? m_iFirstSampleBank : m_vSampleWindows.back().Bank) + 1;
+	else
+		m_iLastBank = 1;
 }
 
 void CCompiler::UpdateFrameBanks()
@@ -819,59 +875,56 @@ void CCompiler::AssignLabels(std::map<stChunkLabel, int> &labelMap)		// // //
 		pChunk->AssignLabels(labelMap);
 }
 
-bool CCompiler::CompileData()
+std::string_view CCompiler::SelectDriver()		// // //
 {
-	// Compile music data to an object tree
-	//
-
-	// // // Full chip export
-
 	// Select driver and channel order
 	CSoundChipSet Chip = m_pModule->GetSoundChipSet();
-	if (!Chip.IsMultiChip())
-		switch (Chip.WithoutChip(sound_chip_t::APU).GetSoundChip()) {
-		case sound_chip_t::none:
-			m_pDriverData = &DRIVER_PACK_2A03;
-			m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_2A03;
-			Print(" * No expansion chip\n");
-			break;
-		case sound_chip_t::VRC6:
-			m_pDriverData = &DRIVER_PACK_VRC6;
-			m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_VRC6;
-			Print(" * VRC6 expansion enabled\n");
-			break;
-		case sound_chip_t::MMC5:
-			m_pDriverData = &DRIVER_PACK_MMC5;
-			m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_MMC5;
-			Print(" * MMC5 expansion enabled\n");
-			break;
-		case sound_chip_t::VRC7:
-			m_pDriverData = &DRIVER_PACK_VRC7;
-			m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_VRC7;
-			Print(" * VRC7 expansion enabled\n");
-			break;
-		case sound_chip_t::FDS:
-			m_pDriverData = &DRIVER_PACK_FDS;
-			m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_FDS;
-			Print(" * FDS expansion enabled\n");
-			break;
-		case sound_chip_t::N163:
-			m_pDriverData = &DRIVER_PACK_N163;
-			m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_N163;
-			Print(" * N163 expansion enabled\n");
-			break;
-		case sound_chip_t::S5B:
-			m_pDriverData = &DRIVER_PACK_S5B;
-			m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_S5B;
-			Print(" * S5B expansion enabled\n");
-			break;
-		}
-	else {		// // //
+	if (Chip.IsMultiChip()) {
 		m_pDriverData = &DRIVER_PACK_ALL;
 		m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_ALL;
-		Print(" * Multiple expansion chips enabled\n");
+		return " * Multiple expansion chips enabled\n";
 	}
 
+	switch (Chip.WithoutChip(sound_chip_t::APU).GetSoundChip()) {
+	case sound_chip_t::VRC6:
+		m_pDriverData = &DRIVER_PACK_VRC6;
+		m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_VRC6;
+		return " * VRC6 expansion enabled\n";
+	case sound_chip_t::MMC5:
+		m_pDriverData = &DRIVER_PACK_MMC5;
+		m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_MMC5;
+		return " * MMC5 expansion enabled\n";
+	case sound_chip_t::VRC7:
+		m_pDriverData = &DRIVER_PACK_VRC7;
+		m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_VRC7;
+		return " * VRC7 expansion enabled\n";
+	case sound_chip_t::FDS:
+		m_pDriverData = &DRIVER_PACK_FDS;
+		m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_FDS;
+		return " * FDS expansion enabled\n";
+	case sound_chip_t::N163:
+		m_pDriverData = &DRIVER_PACK_N163;
+		m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_N163;
+		return " * N163 expansion enabled\n";
+	case sound_chip_t::S5B:
+		m_pDriverData = &DRIVER_PACK_S5B;
+		m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_S5B;
+		return " * S5B expansion enabled\n";
+	default:
+		m_pDriverData = &DRIVER_PACK_2A03;
+		m_iVibratoTableLocation = VIBRATO_TABLE_LOCATION_2A03;
+		return " * No expansion chip\n";
+	}
+}
+
+bool CCompiler::CompileData()
+{
+	// Compile music data to an object tree
+	//
+
+	// // // Full chip export
+	Print(SelectDriver());
+
 	// Driver size
 	m_iDriverSize = m_pDriverData->driver.size();		// // //
 
@@ -923,6 +976,145 @@ bool CCompiler::CompileData()
 	return true;
 }
 
+unsigned stExportSizeInfo::GetMusicDataSize() const		// // //
+{
+	unsigned Size = HeaderSize + SequenceSize + InstrumentSize + SampleListSize + GrooveSize;
+	for (const auto &Song : Songs)
+		Size += Song.FrameSize + Song.PatternSize;
+	return Size;
+}
+
+stExportSizeInfo CCompiler::EstimateSize() const		// // //
+{
+	// Computes the sizes CompileData would produce for the unbankswitched layout by
+	// mirroring each of its steps without creating chunks. Driver selection, song scan
+	// and sample assignment run on a scratch compiler so this one is left untouched;
+	// the export cache is only peeked at. Patterns are still compiled since their sizes
+	// depend on the data
+
+	CCompiler Scratch {*m_pModule, nullptr};
+	Scratch.m_pCache = m_pCache;
+	Scratch.m_bPeekCache = true;
+	Scratch.SelectDriver();
+	Scratch.ScanSong();
+	const auto SampleItems = Scratch.AssignSamples();
+	if (m_pCache)
+		Scratch.HashCacheContext();
+
+	const CSoundChipSet Chip = m_pModule->GetSoundChipSet();
+	const bool HasWavetable = m_pModule->HasExpansionChip(sound_chip_t::FDS) || Chip.IsMultiChip();
+	const auto &Im = *m_pModule->GetInstrumentManager();
+	const auto &Dm = *m_pModule->GetDSampleManager();
+	const auto &Assigned = Scratch.m_iAssignedInstruments;
+
+	stExportSizeInfo Info;
+	Info.DriverSize = Scratch.m_pDriverData->driver.size();
+
+	// Main header, see CreateMainHeader
+	Info.HeaderSize = 5 * 2 + 1 + (Chip.ContainsChip(sound_chip_t::FDS) || Chip.IsMultiChip() ? 2 : 0) + 2 * 2 +
+		(Chip.ContainsChip(sound_chip_t::N163) || Chip.IsMultiChip() ? 1 : 0);
+
+	// Instruments, see CreateSequenceList and CreateInstrumentList; shared sequences
+	// belong to the first instrument using them, shared N163 waves to the instrument
+	// whose waves are stored
+	const inst_type_t INST[] = {INST_2A03, INST_VRC6, INST_N163, INST_S5B};
+	std::set<std::tuple<inst_type_t, unsigned, sequence_t>> SeqStored;
+	std::vector<std::shared_ptr<const CInstrumentN163>> WaveOwners;
+	const CInstCompilerN163 n163_c;
+
+	for (unsigned Index : Assigned) {
+		const auto pInstrument = Im.GetInstrument(Index);
+		const inst_type_t Type = pInstrument->GetType();
+		unsigned SeqSize = 0;
+		unsigned InstSize = 2 + FTEnv.GetInstrumentService()->GetChunkCompiler(Type).GetChunkSize(*pInstrument);
+
+		if (std::find(std::begin(INST), std::end(INST), Type) != std::end(INST)) {
+			auto pSeqInst = std::static_pointer_cast<const CSeqInstrument>(pInstrument);
+			for (auto j : enum_values<sequence_t>())
+				if (pSeqInst->GetSeqEnable(j)) {
+					const unsigned SeqIndex = pSeqInst->GetSeqIndex(j);
+					const auto pSeq = Im.GetSequence(Type, j, SeqIndex);
+					if (pSeq->GetItemCount() > 0 && SeqStored.emplace(Type, SeqIndex, j).second)
+						SeqSize += pSeq->GetItemCount() + 4;
+				}
+		}
+
+		if (Type == INST_FDS && HasWavetable)
+			InstSize += 1 + 64;		// Wave table index and wave
+
+		if (Type == INST_N163) {
+			auto pN163 = std::static_pointer_cast<const CInstrumentN163>(pInstrument);
+			if (std::none_of(WaveOwners.begin(), WaveOwners.end(), [&] (const auto &pOwner) { return pOwner->IsWaveEqual(*pN163); })) {
+				WaveOwners.push_back(pN163);
+				InstSize += n163_c.GetWavesSize(*pN163);
+			}
+		}
+
+		Info.SequenceSize += SeqSize;
+		Info.InstrumentSize += InstSize;
+		Info.Instruments.emplace_back(Index, SeqSize + InstSize);
+	}
+
+	// FDS sequences are stored for every FDS instrument, used or not
+	for (unsigned i = 0; i < MAX_INSTRUMENTS; ++i)
+		if (auto pInstrument = std::dynamic_pointer_cast<const CInstrumentFDS>(Im.GetInstrument(i)))
+			for (auto j : enum_values<sequence_t>())
+				if (const auto pSeq = pInstrument->GetSequence(j); pSeq && pSeq->GetItemCount() > 0) {
+					const unsigned Size = pSeq->GetItemCount() + 4;
+					Info.SequenceSize += Size;
+					for (auto &[Index, InstSize] : Info.Instruments)
+						if (Index == i)
+							InstSize += Size;
+				}
+
+	// DPCM instrument list, sample pointers and sample data, see StoreSamples
+	Info.SampleListSize = SampleItems.size() * 3;
+	for (unsigned i = 0; i < Scratch.m_iSamplesUsed; ++i)
+		if (unsigned Size = Dm.GetDSample(Scratch.m_iSampleBank[i])->size(); Size > 0) {
+			Info.SampleListSize += 3;
+			Info.SampleSize += Size + AdjustSampleAddress(Info.SampleSize + Size);
+		}
+
+	// Grooves, see StoreGrooves
+	Info.GrooveSize = 1;
+	for (unsigned i = 0; i < MAX_GROOVE; ++i)
+		if (const auto pGroove = m_pModule->GetGroove(i))
+			Info.GrooveSize += pGroove->compiled_size();
+
+	// Songs, with duplicate patterns removed across the whole module as in StorePatterns
+	CPatternCompiler PatternCompiler(*m_pModule, Assigned, (const DPCM_List_t *)Scratch.m_iSamplesLookUp.data(), nullptr);
+	std::set<std::vector<unsigned char>> PatternsStored;
+
+	m_pModule->VisitSongs([&] (const CSongData &song, unsigned Track) {
+		Info.HeaderSize += 2 + 8;		// Song list pointer and song header
+
+		auto &Song = Info.Songs.emplace_back();
+		Song.FrameSize = song.GetFrameCount() * (2 + 2 * m_ChannelOrder.GetChannelCount());
+		m_ChannelOrder.ForeachChannel([&] (stChannelID Chan) {
+			Song.ChannelSize.emplace_back(Chan, 0u);
+		});
+
+		for (unsigned i = 0; i < MAX_PATTERN; ++i) {
+			auto ChannelSize = Song.ChannelSize.begin();
+			m_ChannelOrder.ForeachChannel([&] (stChannelID j) {
+				auto &Size = (ChannelSize++)->second;
+				if (!IsPatternAddressed(Track, i, j))
+					return;
+
+				const std::vector<unsigned char> &Data = Scratch.GetPatternData(PatternCompiler, Track, i, j);
+#ifdef REMOVE_DUPLICATE_PATTERNS
+				if (!PatternsStored.insert(Data).second)
+					return;
+#endif /* REMOVE_DUPLICATE_PATTERNS */
+				Size += Data.size();
+				Song.PatternSize += Data.size();
+			});
+		}
+	});
+
+	return Info;
+}
+
 void CCompiler::AddBankswitching()
 {
 	// Add bankswitching data
@@ -1224,6 +1416,17 @@ void CCompiler::CreateSampleList()
 	 *
 	 */
 
+	CChunk &Chunk = CreateChunk({CHUNK_SAMPLE_LIST});		// // //
+
+	for (const auto &Item : AssignSamples())		// // //
+		for (unsigned char x : Item)
+			Chunk.StoreByte(x);
+}
+
+std::vector<std::array<unsigned char, 3>> CCompiler::AssignSamples()		// // //
+{
+	// Assign sample list items to the accessed DPCM notes, and sample bank positions to their samples
+
 	const int SAMPLE_ITEM_WIDTH = 3;	// 3 bytes / sample item
 
 	// Clear the sample list
@@ -1232,7 +1435,7 @@ void CCompiler::CreateSampleList()
 	auto &Im = *m_pModule->GetInstrumentManager();		// // //
 	auto &Dm = *m_pModule->GetDSampleManager();		// // //
 
-	CChunk &Chunk = CreateChunk({CHUNK_SAMPLE_LIST});		// // //
+	std::vector<std::array<unsigned char, 3>> Items;
 
 	// Store sample instruments
 	unsigned int Item = 0;
@@ -1252,9 +1455,7 @@ void CCompiler::CreateSampleList()
 					// Save a reference to this item
 					m_iSamplesLookUp[i][n] = ++Item;
 
-					Chunk.StoreByte(SamplePitch);
-					Chunk.StoreByte(SampleDelta);
-					Chunk.StoreByte(SampleIndex * SAMPLE_ITEM_WIDTH);
+					Items.push_back({SamplePitch, (unsigned char)SampleDelta, (unsigned char)(SampleIndex * SAMPLE_ITEM_WIDTH)});
 				}
 				else
 					// No instrument here
@@ -1262,6 +1463,8 @@ void CCompiler::CreateSampleList()
 			}
 		}
 	}
+
+	return Items;
 }
 
 void CCompiler::StoreSamples()
@@ -1377,6 +1580,13 @@ void CCompiler::StoreSongs()
 
 	m_iDuplicatePatterns = 0;
 
+	unsigned int CacheHits = 0, CacheMisses = 0;		// // //
+	if (m_pCache) {
+		HashCacheContext();
+		CacheHits = m_pCache->GetHitCount();
+		CacheMisses = m_pCache->GetMissCount();
+	}
+
 	// Store song info
 	m_pModule->VisitSongs([&] (const CSongData &song, unsigned index) {
 		// Create song
@@ -1423,9 +1633,9 @@ void CCompiler::StoreSongs()
 	if (m_iDuplicatePatterns > 0)
 		Print(" * " + conv::from_int(m_iDuplicatePatterns) + " duplicated pattern(s) removed\n");
 
-#ifdef _DEBUG
-	Print("Hash collisions: " + conv::from_uint(m_iHashCollisions) + " (of " + conv::from_uint(m_PatternMap.size()) + " items)\r\n");		// // //
-#endif
+	if (m_pCache)		// // //
+		Print(" * Export cache: " + conv::from_uint(m_pCache->GetHitCount() - CacheHits) + " pattern(s) reused, " +
+			conv::from_uint(m_pCache->GetMissCount() - CacheMisses) + " compiled\n");
 }
 
 // Frames
@@ -1499,26 +1709,19 @@ void CCompiler::StorePatterns(unsigned int Track)
 			// And store only used ones
 			if (IsPatternAddressed(Track, i, j)) {
 
-				// Compile pattern data
-				PatternCompiler.CompileData(Track, i, j);
+				const std::vector<unsigned char> &Data = GetPatternData(PatternCompiler, Track, i, j);		// // //
 
 				auto label = stChunkLabel {CHUNK_PATTERN, Track, i, j.ToInteger()};		// // //
 
 				bool StoreNew = true;
 
 #ifdef REMOVE_DUPLICATE_PATTERNS
-				unsigned int Hash = PatternCompiler.GetHash();
-
-				// Check for duplicate patterns
-				if (auto it = m_PatternMap.find(Hash); it != m_PatternMap.end()) {
-					const CChunk *pDuplicate = it->second;
-					// Hash only indicates that patterns may be equal, check exact data
-					if (PatternCompiler.CompareData(pDuplicate->GetStringData(PATTERN_CHUNK_INDEX))) {
-						// Duplicate was found, store a reference to existing pattern
-						m_DuplicateMap.try_emplace(label, pDuplicate->GetLabel());		// // //
-						++m_iDuplicatePatterns;
-						StoreNew = false;
-					}
+				// Check for duplicate patterns, keyed by the pattern data itself		// // //
+				if (auto it = m_PatternMap.find(Data); it != m_PatternMap.end()) {
+					// Duplicate was found, store a reference to existing pattern
+					m_DuplicateMap.try_emplace(label, it->second->GetLabel());		// // //
+					++m_iDuplicatePatterns;
+					StoreNew = false;
 				}
 #endif /* REMOVE_DUPLICATE_PATTERNS */
 
@@ -1527,15 +1730,13 @@ void CCompiler::StorePatterns(unsigned int Track)
 					CChunk &Chunk = CreateChunk(label);		// // //
 
 #ifdef REMOVE_DUPLICATE_PATTERNS
-					if (m_PatternMap.count(Hash))
-						++m_iHashCollisions;
-					m_PatternMap[Hash] = &Chunk;
+					m_PatternMap.try_emplace(Data, &Chunk);		// // //
 #endif /* REMOVE_DUPLICATE_PATTERNS */
 
 					// Store pattern data as string
-					Chunk.StoreString(PatternCompiler.GetData());
+					Chunk.StoreString(Data);
 
-					PatternSize += PatternCompiler.GetDataSize();
+					PatternSize += Data.size();
 					++PatternCount;
 				}
 			}
@@ -1559,6 +1760,74 @@ void CCompiler::StorePatterns(unsigned int Track)
 	Print(conv::from_int(PatternCount) + " patterns (" + conv::from_int(PatternSize) + " bytes)\r\n");
 }
 
+const std::vector<unsigned char> &CCompiler::GetPatternData(CPatternCompiler &Compiler, unsigned int Track, unsigned int Pattern, stChannelID Channel)		// // //
+{
+	// Compile pattern data, or reuse it from the export cache
+	const bool bUseCache = m_pCache && m_bCacheContextValid;
+	std::uint64_t Key = 0u;
+	std::vector<std::uint8_t> Input;
+	if (bUseCache) {
+		Key = GetPatternKey(Track, Pattern, Channel, Input);
+		if (const auto *pData = m_bPeekCache ? m_pCache->Peek(Key, m_iCacheContext, Input) : m_pCache->Find(Key, m_iCacheContext, Input))
+			return *pData;
+	}
+
+	Compiler.CompileData(Track, Pattern, Channel);
+	if (Compiler.GetErrorCount() > 0)
+		m_bErrors = true;
+	// Patterns with errors are never cached, so every export reports them again
+	else if (bUseCache && !m_bPeekCache)
+		m_pCache->Store(Key, m_iCacheContext, Input, Compiler.GetData());
+	return Compiler.GetData();
+}
+
+void CCompiler::HashCacheContext()		// // //
+{
+	// Module-wide inputs of the pattern compiler
+	std::vector<std::uint8_t> Input;
+	CContentHash hash {Input};
+	hash.Add(Get0CCFTVersionString()).Add(m_pModule->GetSoundChipSet().GetFlag())
+		.Add(m_pModule->GetLinearPitch()).Add(m_pModule->GetSpeedSplitPoint());
+
+	hash.Add(m_iAssignedInstruments.size());
+	for (unsigned Inst : m_iAssignedInstruments)
+		hash.Add(Inst);
+	// Instrument types decide which notes are reported as errors
+	for (unsigned i = 0; i < MAX_INSTRUMENTS; ++i)
+		hash.Add(m_pModule->GetInstrumentManager()->GetInstrumentType(i));
+	for (const auto &Lookup : m_iSamplesLookUp)
+		hash.Add(Lookup);
+
+	for (unsigned i = 0; i < MAX_GROOVE; ++i) {
+		const auto pGroove = m_pModule->GetGroove(i);
+		hash.Add(pGroove ? pGroove->compiled_size() : 0u);
+	}
+
+	m_iCacheContext = hash.Get();
+	m_bCacheContextValid = m_bPeekCache ? m_pCache->CheckContext(m_iCacheContext, Input) : m_pCache->AddContext(m_iCacheContext, Input);
+}
+
+std::uint64_t CCompiler::GetPatternKey(unsigned int Track, unsigned int Pattern, stChannelID Channel, std::vector<std::uint8_t> &Input) const		// // //
+{
+	// Covers everything CPatternCompiler::CompileData reads from the song, Input receives the hashed bytes
+	const auto *pSong = m_pModule->GetSong(Track);
+	const unsigned Rows = pSong->GetPatternLength();
+	const unsigned EffColumns = pSong->GetEffectColumnCount(Channel);
+
+	CContentHash hash {Input};
+	hash.Add(m_iCacheContext).Add(Channel.ToInteger()).Add(pSong->GetSongTempo()).Add(Rows).Add(EffColumns);
+
+	const auto &PatternData = pSong->GetPattern(Channel, Pattern);
+	for (unsigned i = 0; i < Rows; ++i) {
+		const auto &Note = PatternData.GetNoteOn(i);
+		hash.Add(Note.Note).Add(Note.Octave).Add(Note.Vol).Add(Note.Instrument);
+		for (unsigned j = 0; j < EffColumns; ++j)
+			hash.Add(Note.Effects[j].fx).Add(Note.Effects[j].param);
+	}
+
+	return hash.Get();
+}
+
 bool CCompiler::IsPatternAddressed(unsigned int Track, int Pattern, stChannelID Channel) const
 {
 	// Scan the frame list to see if a pattern is accessed for that frame
@@ -29,6 +29,7 @@
 #include <string>		// // //
 #include <map>		// // //
 #include <cstdint>		// // //
+#include <utility>		// // //
 #include "SoundChipSet.h"		// // //
 #include "ChannelOrder.h"		// // //
 #include "Sequence.h"		// // // TODO: remove
@@ -70,6 +71,34 @@ struct stNSFeHeader {		// // //
 	uint8_t		BankValues[8] = { };
 };
 
+// // // Contiguous DPCM sample area of a bankswitched export, mapped to $C000 - $EFFF
+struct stDPCMSampleWindow {
+	unsigned Bank = 0;					// First NSF bank of the window
+	unsigned Size = 0;					// Bytes used, including alignment padding
+	std::vector<std::size_t> Samples;	// Sample list indices, in storage order
+};
+
+// // // Music data size of an export, computed without building chunks
+struct stExportSizeInfo {
+	struct stSongSize {
+		unsigned FrameSize = 0;		// Frame list and frame entries
+		unsigned PatternSize = 0;	// Pattern data after duplicate removal
+		std::vector<std::pair<stChannelID, unsigned>> ChannelSize;	// Pattern data per channel
+	};
+
+	unsigned DriverSize = 0;
+	unsigned HeaderSize = 0;		// Main header, song list and song headers
+	unsigned SequenceSize = 0;
+	unsigned InstrumentSize = 0;	// Instrument list and chunks, FDS wave tables, N163 waves
+	unsigned SampleListSize = 0;	// DPCM instrument list and sample pointers
+	unsigned SampleSize = 0;		// DPCM sample data, including alignment padding
+	unsigned GrooveSize = 0;
+	std::vector<stSongSize> Songs;
+	std::vector<std::pair<unsigned, unsigned>> Instruments;	// Instrument index, bytes including owned sequences and waves
+
+	unsigned GetMusicDataSize() const;
+};
+
 struct driver_t;
 class CChunk;
 enum chunk_type_t : int;
@@ -82,6 +111,8 @@ class CSequence;		// // //
 class CInstrumentFDS;		// // //
 class CConstSongView;		// // //
 class CSimpleFile;		// // //
+class CCompilerCache;		// // //
+class CPatternCompiler;		// // //
 
 /*
  * Logger class
@@ -111,6 +142,13 @@ public:
 	void	ExportASM(CSimpleFile &file);
 
 	void	SetMetadata(std::string_view title, std::string_view artist, std::string_view copyright);		// // //
+	void	SetCache(std::shared_ptr<CCompilerCache> pCache);		// // //
+
+	// // // True if any export on this compiler reported an error, including
+	// non-fatal pattern errors; the output file may still have been written
+	bool	HasErrors() const;
+
+	stExportSizeInfo EstimateSize() const;		// // //
 
 private:
 	void	ExportNSF_NSFE(CSimpleFile &file, int MachineType, bool isNSFE);		// // //
@@ -124,6 +162,7 @@ private:
 	std::vector<unsigned char> LoadDriver(const driver_t &Driver, unsigned short Origin) const;		// // //
 
 	// Compiler
+	std::string_view SelectDriver();		// // //
 	bool	CompileData();
 	void	ResolveLabels();
 	bool	ResolveLabelsBankswitched();
@@ -134,6 +173,7 @@ private:
 
 	void	ScanSong();
 	int		GetSampleIndex(int SampleNumber);
+	std::vector<std::array<unsigned char, 3>> AssignSamples();		// // //
 	bool	IsPatternAddressed(unsigned int Track, int Pattern, stChannelID Channel) const;
 
 	void	CreateMainHeader();
@@ -147,8 +187,14 @@ private:
 	void	StoreGrooves();		// // //
 	void	StoreSongs();
 	void	StorePatterns(unsigned int Track);
+	const std::vector<unsigned char> &GetPatternData(CPatternCompiler &Compiler, unsigned int Track, unsigned int Pattern, stChannelID Channel);		// // //
+
+	// Export cache
+	void	HashCacheContext();		// // //
+	std::uint64_t GetPatternKey(unsigned int Track, unsigned int Pattern, stChannelID Channel, std::vector<std::uint8_t> &Input) const;		// // //
 
 	// Bankswitching functions
+	void	PackSamplesBankswitched();		// // //
 	void	UpdateSamplePointers(unsigned int Origin);
 	void	UpdateFrameBanks();
 	void	UpdateSongBanks();
@@ -209,9 +255,11 @@ private:
 
 	// Samples
 	std::vector<std::shared_ptr<const ft0cc::doc::dpcm_sample>> m_vSamples;		// // //
+	std::vector<stDPCMSampleWindow> m_vSampleWindows;		// // //
 
 	// Flags
 	bool			m_bBankSwitched = false;
+	bool			m_bErrors = false;		// // //
 
 	// Driver
 	const driver_t	*m_pDriverData = nullptr;
@@ -260,12 +308,15 @@ private:
 	unsigned int	m_iWaveTables = 0;
 
 	// Optimization
-	std::map<unsigned, const CChunk *> m_PatternMap;		// // //
+	std::map<std::vector<unsigned char>, const CChunk *> m_PatternMap;		// // // Pattern data -> first chunk storing it
 	std::map<stChunkLabel, stChunkLabel> m_DuplicateMap;		// // //
 
+	// Export cache
+	std::shared_ptr<CCompilerCache> m_pCache;		// // //
+	bool			m_bPeekCache = false;		// // // Read the cache without storing or counting
+	std::uint64_t	m_iCacheContext = 0u;		// // // Hash of the module-wide inputs to pattern data
+	bool			m_bCacheContextValid = false;		// // // False if the cache knows different inputs with that hash
+
 	// Debugging
 	std::shared_ptr<CCompilerLog> m_pLogger;		// // //
-
-	// Diagnostics
-	unsigned int	m_iHashCollisions = 0u;
 };
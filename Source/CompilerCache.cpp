@@ -0,0 +1,206 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#include "CompilerCache.h"
+#include "SimpleFile.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+
+const char CACHE_IDENT[] = "FT0CC-EXPORT-CACHE";
+const std::uint32_t CACHE_VERSION = 2u;
+const std::uint32_t MAX_DATA_SIZE = 0x10000u;
+
+void WriteUint64(CSimpleFile &file, std::uint64_t x) {
+	file.WriteInt32(static_cast<std::int32_t>(x & 0xFFFFFFFFu));
+	file.WriteInt32(static_cast<std::int32_t>(x >> 32));
+}
+
+std::uint64_t ReadUint64(CSimpleFile &file) {
+	std::uint64_t lo = file.ReadUint32();
+	std::uint64_t hi = file.ReadUint32();
+	return lo | (hi << 32);
+}
+
+void WriteBlob(CSimpleFile &file, const std::vector<unsigned char> &data) {
+	file.WriteInt32(data.size());
+	file.WriteBytes(data);
+}
+
+bool ReadBlob(CSimpleFile &file, std::vector<unsigned char> &data) {
+	std::uint32_t size = file.ReadUint32();
+	if (!file || size > MAX_DATA_SIZE)
+		return false;
+	data.resize(size);
+	return file.ReadBytes(data.data(), data.size()) == data.size();
+}
+
+} // namespace
+
+const std::size_t CCompilerCache::MAX_ENTRIES = 0x10000;
+
+CCompilerCache::CCompilerCache(const fs::path &fname) : fname_(fname) {
+}
+
+bool CCompilerCache::Load() {
+	// A missing or unreadable cache file simply behaves as an empty cache
+	contexts_.clear();
+	entries_.clear();
+
+	std::error_code ec;
+	if (!fs::exists(fname_, ec))
+		return false;
+
+	try {
+		CSimpleFile file(fname_, std::ios::in | std::ios::binary);
+		if (!file)
+			return false;
+		if (file.ReadStringN(std::size(CACHE_IDENT) - 1) != CACHE_IDENT || file.ReadUint32() != CACHE_VERSION)
+			return false;
+
+		std::uint32_t count = file.ReadUint32();
+		for (std::uint32_t i = 0; i < count && file; ++i) {
+			std::uint64_t context = ReadUint64(file);
+			std::vector<std::uint8_t> input;
+			if (!ReadBlob(file, input))
+				break;
+			contexts_[context] = std::move(input);
+		}
+
+		count = file.ReadUint32();
+		for (std::uint32_t i = 0; i < count && file; ++i) {
+			std::uint64_t key = ReadUint64(file);
+			stCacheEntry entry;
+			entry.Context = ReadUint64(file);
+			if (!ReadBlob(file, entry.Input) || !ReadBlob(file, entry.Data))
+				break;
+			if (contexts_.count(entry.Context))
+				entries_[key] = std::move(entry);
+		}
+	}
+	catch (std::exception &) {
+		contexts_.clear();
+		entries_.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool CCompilerCache::Save() const {
+	// Entries used by this session are written first, stale ones fill the remaining slots
+	std::vector<std::pair<std::uint64_t, const stCacheEntry *>> list;
+	list.reserve(entries_.size());
+	for (const auto &[key, entry] : entries_)
+		if (contexts_.count(entry.Context))
+			list.emplace_back(key, &entry);
+	std::stable_partition(list.begin(), list.end(), [] (const auto &x) { return x.second->Used; });
+	if (list.size() > MAX_ENTRIES)
+		list.resize(MAX_ENTRIES);
+
+	// Contexts no longer referenced by any entry are dropped
+	std::unordered_set<std::uint64_t> contexts;
+	for (const auto &x : list)
+		contexts.insert(x.second->Context);
+
+	try {
+		CSimpleFile file(fname_, std::ios::out | std::ios::binary);
+		if (!file)
+			return false;
+
+		file.WriteBytes({CACHE_IDENT, std::size(CACHE_IDENT) - 1});
+		file.WriteInt32(CACHE_VERSION);
+		file.WriteInt32(contexts.size());
+		for (std::uint64_t context : contexts) {
+			WriteUint64(file, context);
+			WriteBlob(file, contexts_.at(context));
+		}
+		file.WriteInt32(list.size());
+		for (const auto &[key, pEntry] : list) {
+			WriteUint64(file, key);
+			WriteUint64(file, pEntry->Context);
+			WriteBlob(file, pEntry->Input);
+			WriteBlob(file, pEntry->Data);
+		}
+		file.Close();
+	}
+	catch (std::exception &) {
+		return false;
+	}
+
+	return true;
+}
+
+bool CCompilerCache::AddContext(std::uint64_t context, const std::vector<std::uint8_t> &input) {
+	auto [it, inserted] = contexts_.try_emplace(context, input);
+	return inserted || it->second == input;
+}
+
+bool CCompilerCache::CheckContext(std::uint64_t context, const std::vector<std::uint8_t> &input) const {
+	auto it = contexts_.find(context);
+	return it == contexts_.end() || it->second == input;
+}
+
+bool CCompilerCache::stCacheEntry::IsFrom(std::uint64_t context, const std::vector<std::uint8_t> &input) const {
+	// A hash collision is treated as a miss
+	return Context == context && Input == input;
+}
+
+const std::vector<unsigned char> *CCompilerCache::Find(std::uint64_t key, std::uint64_t context, const std::vector<std::uint8_t> &input) {
+	if (auto it = entries_.find(key); it != entries_.end() && it->second.IsFrom(context, input)) {
+		it->second.Used = true;
+		++hits_;
+		return &it->second.Data;
+	}
+
+	++misses_;
+	return nullptr;
+}
+
+const std::vector<unsigned char> *CCompilerCache::Peek(std::uint64_t key, std::uint64_t context, const std::vector<std::uint8_t> &input) const {
+	// Same as Find, but leaves the counters and usage marks alone
+	auto it = entries_.find(key);
+	return it != entries_.end() && it->second.IsFrom(context, input) ? &it->second.Data : nullptr;
+}
+
+void CCompilerCache::Store(std::uint64_t key, std::uint64_t context, const std::vector<std::uint8_t> &input, const std::vector<unsigned char> &data) {
+	// Replaces any entry colliding with this one
+	auto &entry = entries_[key];
+	entry.Context = context;
+	entry.Input = input;
+	entry.Data = data;
+	entry.Used = true;
+}
+
+unsigned int CCompilerCache::GetHitCount() const {
+	return hits_;
+}
+
+unsigned int CCompilerCache::GetMissCount() const {
+	return misses_;
+}
+
+void CCompilerCache::ResetCounters() {
+	hits_ = misses_ = 0u;
+}
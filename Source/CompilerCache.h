@@ -0,0 +1,78 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "ft0cc/fs.h"
+
+// // // On-disk store of compiled music data keyed by the content hash of its inputs
+// Entries keep the inputs they were compiled from, so that a hash hit is only
+// used if the inputs are byte-identical. Inputs shared by many entries, such as
+// module-wide settings, are stored once as a context that entries refer to by
+// its hash.
+class CCompilerCache
+{
+public:
+	explicit CCompilerCache(const fs::path &fname);
+
+	bool	Load();
+	bool	Save() const;
+
+	// Returns false if a context with the same hash but different inputs is
+	// already known, in which case it must not be used for lookups or stores
+	bool	AddContext(std::uint64_t context, const std::vector<std::uint8_t> &input);
+	// Same as AddContext, but does not record the context
+	bool	CheckContext(std::uint64_t context, const std::vector<std::uint8_t> &input) const;
+
+	// Lookups miss unless the entry was stored with the same context and input;
+	// entries are only saved if their context was added
+	const std::vector<unsigned char> *Find(std::uint64_t key, std::uint64_t context, const std::vector<std::uint8_t> &input);
+	const std::vector<unsigned char> *Peek(std::uint64_t key, std::uint64_t context, const std::vector<std::uint8_t> &input) const;
+	void	Store(std::uint64_t key, std::uint64_t context, const std::vector<std::uint8_t> &input, const std::vector<unsigned char> &data);
+
+	unsigned int GetHitCount() const;
+	unsigned int GetMissCount() const;
+	void	ResetCounters();
+
+	static const std::size_t MAX_ENTRIES;
+
+private:
+	struct stCacheEntry {
+		std::uint64_t Context = 0u;
+		std::vector<std::uint8_t> Input;
+		std::vector<unsigned char> Data;
+		bool Used = false;
+
+		bool IsFrom(std::uint64_t context, const std::vector<std::uint8_t> &input) const;
+	};
+
+	fs::path fname_;
+	std::unordered_map<std::uint64_t, std::vector<std::uint8_t>> contexts_;
+	std::unordered_map<std::uint64_t, stCacheEntry> entries_;
+	unsigned int hits_ = 0u;
+	unsigned int misses_ = 0u;
+};
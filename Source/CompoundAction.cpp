@@ -87,6 +87,13 @@ void CCompoundAction::UpdateViews(CMainFrame &MainFrm) const {
 	m_pActionList.back()->UpdateViews(MainFrm); // temp
 }
 
+std::size_t CCompoundAction::GetFootprint() const {		// // //
+	std::size_t Size = sizeof(CCompoundAction) + m_pActionList.capacity() * sizeof(std::unique_ptr<CAction>);
+	for (const auto &x : m_pActionList)
+		Size += x->GetFootprint();
+	return Size;
+}
+
 void CCompoundAction::JoinAction(std::unique_ptr<CAction> pAction)
 {
 	m_pActionList.push_back(std::move(pAction));
@@ -52,5 +52,7 @@ private:
 
 	void UpdateViews(CMainFrame &MainFrm) const override;
 
+	std::size_t GetFootprint() const override;		// // //
+
 	std::vector<std::unique_ptr<CAction>> m_pActionList;
 };
@@ -51,6 +51,7 @@ BEGIN_MESSAGE_MAP(CConfigSound, CPropertyPage)
 	ON_CBN_SELCHANGE(IDC_SAMPLE_RATE, OnCbnSelchangeSampleRate)
 	ON_CBN_SELCHANGE(IDC_SAMPLE_SIZE, OnCbnSelchangeSampleSize)
 	ON_CBN_SELCHANGE(IDC_DEVICES, OnCbnSelchangeDevices)
+	ON_BN_CLICKED(IDC_VRC7_NATIVE_RATE, OnBnClickedVRC7NativeRate)		// // //
 END_MESSAGE_MAP()
 
 const int MAX_BUFFER_LEN = 500;	// 500 ms
@@ -87,11 +88,13 @@ BOOL CConfigSound::OnInitDialog()
 		case 44100: pSampleRate->SelectString(0, L"44 100 Hz"); break;
 		case 48000: pSampleRate->SelectString(0, L"48 000 Hz"); break;
 		case 96000: pSampleRate->SelectString(0, L"96 000 Hz"); break;
+		case 192000: pSampleRate->SelectString(0, L"192 000 Hz"); break;		// // //
 	}
 
 	switch (pSettings->Sound.iSampleSize) {
 		case 16: pSampleSize->SelectString(0, L"16 bit"); break;
 		case 8:	 pSampleSize->SelectString(0, L"8 bit"); break;
+		case 32: pSampleSize->SelectString(0, L"32 bit float"); break;		// // //
 	}
 
 	pBufSlider->SetPos(pSettings->Sound.iBufferLength);
@@ -99,6 +102,7 @@ BOOL CConfigSound::OnInitDialog()
 	pTrebleSliderFreq->SetPos(pSettings->Sound.iTrebleFilter);
 	pTrebleSliderDamping->SetPos(pSettings->Sound.iTrebleDamping);
 	pVolumeSlider->SetPos(pSettings->Sound.iMixVolume);
+	CheckDlgButton(IDC_VRC7_NATIVE_RATE, pSettings->Sound.bNativeVRC7 ? 1 : 0);		// // //
 
 	UpdateTexts();
 
@@ -136,11 +140,13 @@ BOOL CConfigSound::OnApply()
 		case 2: pSettings->Sound.iSampleRate = 44100; break;
 		case 3: pSettings->Sound.iSampleRate = 48000; break;
 		case 4: pSettings->Sound.iSampleRate = 96000; break;
+		case 5: pSettings->Sound.iSampleRate = 192000; break;		// // //
 	}
 
 	switch (pSampleSize->GetCurSel()) {
 		case 0: pSettings->Sound.iSampleSize = 16; break;
 		case 1: pSettings->Sound.iSampleSize = 8; break;
+		case 2: pSettings->Sound.iSampleSize = 32; break;		// // //
 	}
 
 	pSettings->Sound.iBufferLength = pBufSlider->GetPos();
@@ -149,6 +155,7 @@ BOOL CConfigSound::OnApply()
 	pSettings->Sound.iTrebleFilter	= static_cast<CSliderCtrl*>(GetDlgItem(IDC_TREBLE_FREQ))->GetPos();
 	pSettings->Sound.iTrebleDamping	= static_cast<CSliderCtrl*>(GetDlgItem(IDC_TREBLE_DAMP))->GetPos();
 	pSettings->Sound.iMixVolume		= static_cast<CSliderCtrl*>(GetDlgItem(IDC_VOLUME))->GetPos();
+	pSettings->Sound.bNativeVRC7	= IsDlgButtonChecked(IDC_VRC7_NATIVE_RATE) != 0;		// // //
 
 	pSettings->Sound.iDevice	= pDevices->GetCurSel();
 
@@ -172,6 +179,11 @@ void CConfigSound::OnCbnSelchangeDevices()
 	SetModified();
 }
 
+void CConfigSound::OnBnClickedVRC7NativeRate()		// // //
+{
+	SetModified();
+}
+
 void CConfigSound::UpdateTexts()
 {
 	SetDlgItemTextW(IDC_BUF_LEN, FormattedW(L"%i ms", static_cast<CSliderCtrl*>(GetDlgItem(IDC_BUF_LENGTH))->GetPos()));
@@ -52,4 +52,5 @@ public:
 	afx_msg void OnCbnSelchangeSampleRate();
 	afx_msg void OnCbnSelchangeSampleSize();
 	afx_msg void OnCbnSelchangeDevices();
+	afx_msg void OnBnClickedVRC7NativeRate();		// // //
 };
@@ -0,0 +1,78 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "array_view.h"
+
+// 64-bit FNV-1a hash used to key content-addressed caches
+class CContentHash
+{
+public:
+	CContentHash() = default;
+	// Also appends every hashed byte to bytes, so that hash hits can be verified
+	explicit CContentHash(std::vector<std::uint8_t> &bytes) noexcept : bytes_(&bytes) {
+	}
+
+	CContentHash &Add(array_view<std::uint8_t> data) noexcept {
+		for (std::uint8_t x : data)
+			AddByte(x);
+		return *this;
+	}
+
+	CContentHash &Add(std::string_view sv) noexcept {
+		Add(sv.size());
+		for (char c : sv)
+			AddByte(static_cast<std::uint8_t>(c));
+		return *this;
+	}
+
+	template <typename T>
+	std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>, CContentHash &>
+	Add(T x) noexcept {
+		// hash little-endian bytes so that keys are portable
+		auto val = static_cast<std::uint64_t>(x);
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+			AddByte(static_cast<std::uint8_t>(val >> (i * 8)));
+		return *this;
+	}
+
+	std::uint64_t Get() const noexcept {
+		return hash_;
+	}
+
+private:
+	void AddByte(std::uint8_t x) noexcept {
+		hash_ = (hash_ ^ x) * 0x100000001B3ull;
+		if (bytes_)
+			bytes_->push_back(x);
+	}
+
+	std::uint64_t hash_ = 0xCBF29CE484222325ull;
+	std::vector<std::uint8_t> *bytes_ = nullptr;
+};
@@ -0,0 +1,374 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#include "DPCMConverter.h"
+#include "MappedFile.h"
+#include "APU/Types.h"
+#include "APU/DPCM.h"
+#include "resampler/sinc.hpp"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define DPCM_CONVERTER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+const int DMC_BIAS = 32;
+const int LEVELS = 64;			// Delta counter values
+
+// when resampling we must clip because of possible ringing.
+const float MAX_AMP =  (1 << 16) - 1;
+const float MIN_AMP = -(1 << 16) + 1; // just being symetric
+
+const float CUTOFF = .9f;
+const std::size_t PHASES = 256;		// Fractional positions of the polyphase filter
+const unsigned LOOKAHEAD = 6;		// Steps searched by the lookahead encoder
+
+// Tap counts are multiples of this
+const std::size_t TAP_ALIGN = 8;
+
+float DotProduct(const float *a, const float *b, std::size_t n) {
+#ifdef DPCM_CONVERTER_SSE
+	__m128 acc0 = _mm_setzero_ps();
+	__m128 acc1 = _mm_setzero_ps();
+	for (std::size_t i = 0; i < n; i += TAP_ALIGN) {
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	float part[4];
+	_mm_storeu_ps(part, _mm_add_ps(acc0, acc1));
+	return (part[0] + part[1]) + (part[2] + part[3]);
+#else
+	float acc[TAP_ALIGN] = { };
+	for (std::size_t i = 0; i < n; i += TAP_ALIGN)
+		for (std::size_t j = 0; j < TAP_ALIGN; ++j)
+			acc[j] += a[i + j] * b[i + j];
+	float sum = 0.f;
+	for (float x : acc)
+		sum += x;
+	return sum;
+#endif
+}
+
+float ToLevel(float Sample, float Volume) {
+	return std::clamp(Sample, MIN_AMP, MAX_AMP) * Volume / 1024.f + DMC_BIAS;
+}
+
+// Delta counter levels of the samples, extended by the last sample
+std::vector<float> GetLevels(array_view<float> Samples, std::size_t Count, float Volume) {
+	std::vector<float> Levels(Count);
+	for (std::size_t i = 0; i < Count; ++i)
+		Levels[i] = ToLevel(Samples[std::min(i, Samples.size() - 1)], Volume);
+	return Levels;
+}
+
+void EncodeGreedy(array_view<float> Samples, std::vector<std::uint8_t> &Out, float Volume) {
+	int Delta = DMC_BIAS;		// Delta counter
+	for (std::size_t b = 0; b < Out.size(); ++b) {
+		const float *pSample = Samples.data() + b * 8;
+		unsigned DeltaAcc = 0;	// DPCM sample accumulator
+		for (unsigned i = 0; i < 8; ++i) {
+			// Volume done this way so it acts as before
+			const int Sample = static_cast<int>((std::clamp(pSample[i], MIN_AMP, MAX_AMP) * Volume) / 1024.f) + DMC_BIAS;
+			if (Sample >= Delta) {
+				Delta = std::min(Delta + 1, 63);
+				DeltaAcc |= 1u << i;
+			}
+			else
+				Delta = std::max(Delta - 1, 0);
+		}
+		Out[b] = static_cast<std::uint8_t>(DeltaAcc);
+	}
+}
+
+void EncodeLookahead(const std::vector<float> &Target, std::vector<std::uint8_t> &Out) {
+	// Every step sequence of the search, bit k of the index is the direction of step k
+	const std::size_t PATHS = 1u << LOOKAHEAD;
+	float Err[PATHS];
+	int Level[PATHS];
+	int Delta = DMC_BIAS;
+
+	for (std::size_t n = 0; n < Out.size() * 8; ++n) {
+		// extend all sequences one step at a time, keep the first step of the one closest to the samples
+		Err[0] = 0.f;
+		Level[0] = Delta;
+		for (std::size_t k = 0, Count = 1; k < LOOKAHEAD; ++k, Count *= 2) {
+			const float t = Target[n + k];
+			for (std::size_t j = 0; j < Count; ++j) {
+				const int Up = std::min(Level[j] + 1, 63);
+				const int Down = std::max(Level[j] - 1, 0);
+				Err[j + Count] = Err[j] + (Up - t) * (Up - t);
+				Err[j] += (Down - t) * (Down - t);
+				Level[j + Count] = Up;
+				Level[j] = Down;
+			}
+		}
+		const bool Up = (std::min_element(std::begin(Err), std::end(Err)) - std::begin(Err)) & 1;
+		Delta = Up ? std::min(Delta + 1, 63) : std::max(Delta - 1, 0);
+		if (Up)
+			Out[n / 8] |= 1u << (n % 8);
+	}
+}
+
+void EncodeTrellis(const std::vector<float> &Target, std::vector<std::uint8_t> &Out) {
+	// Viterbi search over the delta counter levels. Cost holds the least squared error of all
+	// paths ending at each level, between copies of the edge levels, so that the levels one step
+	// below and above are at fixed offsets; the edge levels may also be reached from themselves.
+	float Cost[LEVELS + 2];
+	float Next[LEVELS];
+	std::fill(std::begin(Cost), std::end(Cost), std::numeric_limits<float>::infinity());
+	Cost[DMC_BIAS + 1] = 0.f;
+
+	// Bit k is set if level k was reached by stepping down
+	std::vector<std::uint64_t> Choice(Target.size());
+
+	for (std::size_t n = 0; n < Target.size(); ++n) {
+		const float t = Target[n];
+		std::uint64_t Mask = 0;
+#ifdef DPCM_CONVERTER_SSE
+		const __m128 Target4 = _mm_set1_ps(t);
+		__m128 Min4 = _mm_set1_ps(std::numeric_limits<float>::infinity());
+		for (unsigned i = 0; i < LEVELS; i += 4) {
+			const __m128 Below = _mm_loadu_ps(Cost + i);
+			const __m128 Above = _mm_loadu_ps(Cost + i + 2);
+			const __m128 Err = _mm_sub_ps(_mm_set_ps(i + 3.f, i + 2.f, i + 1.f, i + 0.f), Target4);
+			const __m128 x = _mm_add_ps(_mm_min_ps(Below, Above), _mm_mul_ps(Err, Err));
+			Mask |= static_cast<std::uint64_t>(_mm_movemask_ps(_mm_cmplt_ps(Above, Below))) << i;
+			Min4 = _mm_min_ps(Min4, x);
+			_mm_storeu_ps(Next + i, x);
+		}
+		Min4 = _mm_min_ps(Min4, _mm_movehl_ps(Min4, Min4));
+		Min4 = _mm_min_ss(Min4, _mm_shuffle_ps(Min4, Min4, 1));
+		const float Min = _mm_cvtss_f32(Min4);
+#else
+		float Min = std::numeric_limits<float>::infinity();
+		for (unsigned i = 0; i < LEVELS; ++i) {
+			const float Below = Cost[i];
+			const float Above = Cost[i + 2];
+			const float Err = i - t;
+			Next[i] = (Above < Below ? Above : Below) + Err * Err;
+			if (Above < Below)
+				Mask |= std::uint64_t {1} << i;
+			Min = std::min(Min, Next[i]);
+		}
+#endif
+		// keep the costs small so that differences between paths are not lost
+		for (unsigned i = 0; i < LEVELS; ++i)
+			Cost[i + 1] = Next[i] - Min;
+		Cost[0] = Cost[1];
+		Cost[LEVELS + 1] = Cost[LEVELS];
+		Choice[n] = Mask;
+	}
+
+	// Trace the best path back from its last level
+	int Level = static_cast<int>(std::min_element(Cost + 1, Cost + LEVELS + 1) - (Cost + 1));
+	for (std::size_t n = Target.size(); n-- > 0; ) {
+		const bool Down = (Choice[n] >> Level) & 1u;
+		if (Level == LEVELS - 1 || (Level != 0 && !Down))
+			Out[n / 8] |= 1u << (n % 8);
+		Level = Down ? std::min(Level + 1, LEVELS - 1) : std::max(Level - 1, 0);
+	}
+}
+
+template <std::size_t Size>
+int ReadChannel(const unsigned char *p) {
+	if constexpr (Size == 1)
+		return (p[0] - 128) << 8;
+	else if constexpr (Size == 2)
+		return static_cast<std::int16_t>(p[0] | p[1] << 8);
+	else if constexpr (Size == 3)		// upper 16 bits
+		return static_cast<std::int16_t>(p[1] | p[2] << 8);
+	else
+		return static_cast<std::int16_t>(p[2] | p[3] << 8);
+}
+
+template <std::size_t Size>
+void ReadFrames(std::vector<float> &Out, const unsigned char *p, std::size_t Frames, unsigned Channels, unsigned BlockAlign) {
+	Out.resize(Frames);
+	for (std::size_t i = 0; i < Frames; ++i, p += BlockAlign) {
+		int v = 0;
+		for (unsigned c = 0; c < Channels; ++c)
+			v += ReadChannel<Size>(p + c * Size);
+		Out[i] = static_cast<float>(v / static_cast<int>(Channels));
+	}
+}
+
+} // namespace
+
+CDPCMConverter::CDPCMConverter(unsigned Quality, int VolumeDB, dpcm_encoder_t Encoder) :
+	quality_(std::min(Quality, MAX_QUALITY)),
+	volume_(std::pow(10.f, static_cast<float>(VolumeDB) / 20.f)),		// Convert dB to linear
+	encoder_(Encoder)
+{
+}
+
+stPCMWave CDPCMConverter::ReadWaveFile(const fs::path &fname) {
+	const CMappedFile File {fname};
+	const std::string_view Data = File.GetText();
+	const auto *p = reinterpret_cast<const unsigned char *>(Data.data());
+	const auto u16 = [p] (std::size_t pos) { return static_cast<unsigned>(p[pos] | p[pos + 1] << 8); };
+	const auto u32 = [p] (std::size_t pos) { return static_cast<std::size_t>(p[pos] | p[pos + 1] << 8 | p[pos + 2] << 16) | static_cast<std::size_t>(p[pos + 3]) << 24; };
+
+	if (Data.size() < 12 || Data.substr(0, 4) != "RIFF" || Data.substr(8, 4) != "WAVE")
+		throw std::runtime_error("Unsupported or invalid wave file");
+
+	unsigned Format = 0, Channels = 0, SampleRate = 0, BlockAlign = 0;
+	std::string_view Audio;
+	for (std::size_t pos = 12; pos + 8 <= Data.size(); ) {
+		const std::string_view ID = Data.substr(pos, 4);
+		const std::size_t Size = std::min(u32(pos + 4), Data.size() - pos - 8);
+		pos += 8;
+		if (ID == "fmt " && Size >= 16) {
+			Format = u16(pos);
+			Channels = u16(pos + 2);
+			SampleRate = static_cast<unsigned>(u32(pos + 4));
+			BlockAlign = u16(pos + 12);
+			if (Format == 0xFFFEu && Size >= 26)		// WAVE_FORMAT_EXTENSIBLE, read the sub-format
+				Format = u16(pos + 24);
+		}
+		else if (ID == "data")
+			Audio = Data.substr(pos, Size);
+		pos += Size + (Size & 1u);		// chunks are word-aligned
+	}
+
+	const unsigned SampleSize = Channels ? BlockAlign / Channels : 0;
+	if (Format != 1u || !SampleRate || !SampleSize || SampleSize > 4 || BlockAlign != SampleSize * Channels || Audio.empty())
+		throw std::runtime_error("Unsupported or invalid wave file");
+
+	stPCMWave Wave;
+	Wave.SampleRate = SampleRate;
+	Wave.Channels = Channels;
+	Wave.SampleSize = SampleSize;
+
+	const auto *pAudio = reinterpret_cast<const unsigned char *>(Audio.data());
+	const std::size_t Frames = Audio.size() / BlockAlign;
+	switch (SampleSize) {
+	case 1: ReadFrames<1>(Wave.Samples, pAudio, Frames, Channels, BlockAlign); break;
+	case 2: ReadFrames<2>(Wave.Samples, pAudio, Frames, Channels, BlockAlign); break;
+	case 3: ReadFrames<3>(Wave.Samples, pAudio, Frames, Channels, BlockAlign); break;
+	case 4: ReadFrames<4>(Wave.Samples, pAudio, Frames, Channels, BlockAlign); break;
+	}
+
+	return Wave;
+}
+
+std::vector<float> CDPCMConverter::Resample(array_view<float> Samples, unsigned SampleRate) const {
+	const double BaseFreq = static_cast<double>(MASTER_CLOCK_NTSC) / CDPCM::DMC_PERIODS_NTSC[quality_];
+	const double Ratio = BaseFreq / SampleRate;
+	const std::size_t Count = static_cast<std::size_t>(std::ceil(Samples.size() * Ratio));
+	if (Samples.empty())
+		return { };
+
+	// Windowed sinc of the old resampler, evaluated once per tap and phase
+	const jarh::sinc Sinc {512, 32};
+	const float SincStep = std::min(1.f, static_cast<float>(Ratio)) * CUTOFF;
+	const std::size_t Half = static_cast<std::size_t>(std::ceil(Sinc.range() / SincStep));
+	const std::size_t Taps = (Half * 2 + TAP_ALIGN - 1) / TAP_ALIGN * TAP_ALIGN;
+
+	std::vector<float> Bank(PHASES * Taps);
+	for (std::size_t p = 0; p < PHASES; ++p) {
+		float *Coef = Bank.data() + p * Taps;
+		const float Frac = static_cast<float>(p) / PHASES;
+		float Sum = 0.f;
+		for (std::size_t k = 0; k < Taps; ++k) {
+			// tap k reads the input at the integer position - Half + 1 + k
+			const float x = static_cast<float>(k + 1) - static_cast<float>(Half) - Frac;
+			Sum += Coef[k] = Sinc(x * SincStep);
+		}
+		for (std::size_t k = 0; k < Taps; ++k)
+			Coef[k] /= Sum;
+	}
+
+	// Zero padding on both sides removes all bounds checks
+	std::vector<float> Padded(Half + Samples.size() + Taps + 1);
+	std::copy(Samples.begin(), Samples.end(), Padded.begin() + Half);
+
+	std::vector<float> Out(Count);
+	const double Step = 1. / Ratio;
+	for (std::size_t n = 0; n < Count; ++n) {
+		const double t = n * Step;
+		std::size_t i = static_cast<std::size_t>(t);
+		std::size_t p = static_cast<std::size_t>((t - i) * PHASES + .5);
+		if (p == PHASES) {
+			++i;
+			p = 0;
+		}
+		Out[n] = DotProduct(Padded.data() + i + 1, Bank.data() + p * Taps, Taps);
+	}
+
+	return Out;
+}
+
+std::vector<std::uint8_t> CDPCMConverter::Encode(array_view<float> Samples) const {
+	const std::size_t Bytes = std::min(Samples.size() / 8, ft0cc::doc::dpcm_sample::max_size);
+	std::vector<std::uint8_t> Out(Bytes);
+	if (!Bytes)
+		return Out;
+
+	switch (encoder_) {
+	case dpcm_encoder_t::greedy:
+		EncodeGreedy(Samples, Out, volume_);
+		break;
+	case dpcm_encoder_t::lookahead:
+		EncodeLookahead(GetLevels(Samples, Bytes * 8 + LOOKAHEAD, volume_), Out);
+		break;
+	case dpcm_encoder_t::trellis:
+		EncodeTrellis(GetLevels(Samples, Bytes * 8, volume_), Out);
+		break;
+	}
+
+	return Out;
+}
+
+double CDPCMConverter::GetSNR(array_view<float> Samples, array_view<std::uint8_t> Bytes) const {
+	// Compare the delta counter after each bit with the sample levels, around the bias
+	double Signal = 0., Noise = 0.;
+	int Delta = DMC_BIAS;
+	for (std::size_t n = 0, Count = std::min(Samples.size(), Bytes.size() * 8); n < Count; ++n) {
+		Delta = (Bytes[n / 8] >> (n % 8)) & 1u ? std::min(Delta + 1, 63) : std::max(Delta - 1, 0);
+		const double Level = ToLevel(Samples[n], volume_);
+		Signal += (Level - DMC_BIAS) * (Level - DMC_BIAS);
+		Noise += (Delta - Level) * (Delta - Level);
+	}
+
+	return Noise > 0. ? 10. * std::log10(Signal / Noise) : std::numeric_limits<double>::infinity();
+}
+
+std::shared_ptr<ft0cc::doc::dpcm_sample> CDPCMConverter::Convert(const stPCMWave &Wave) const {
+	return MakeSample(Encode(Resample(Wave.Samples, Wave.SampleRate)));
+}
+
+std::shared_ptr<ft0cc::doc::dpcm_sample> CDPCMConverter::MakeSample(std::vector<std::uint8_t> Bytes) {
+	// Adjust sample until size is x * $10 + 1 bytes
+	while (Bytes.size() < ft0cc::doc::dpcm_sample::max_size && (Bytes.size() & 0x0Fu) != 1u)
+		Bytes.push_back(ft0cc::doc::dpcm_sample::pad_value);
+
+	return std::make_shared<ft0cc::doc::dpcm_sample>(std::move(Bytes), "");
+}
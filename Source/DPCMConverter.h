@@ -0,0 +1,80 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "array_view.h"
+#include "ft0cc/fs.h"
+
+namespace ft0cc::doc {
+class dpcm_sample;
+} // namespace ft0cc::doc
+
+// // // Portable PCM to DPCM converter, used by the DPCM import dialog and batch tools
+
+// Audio data of a PCM wave file, mixed down to one channel
+struct stPCMWave {
+	unsigned SampleRate = 0;
+	unsigned Channels = 0;
+	unsigned SampleSize = 0;		// Bytes per sample of one channel
+	std::vector<float> Samples;		// 16-bit range
+};
+
+enum class dpcm_encoder_t : std::uint8_t {
+	greedy,			// Steps toward the current sample
+	lookahead,		// Picks the step that minimises the error over the next samples
+	trellis,		// Picks the steps that minimise the error over the whole sample
+};
+
+class CDPCMConverter
+{
+public:
+	static constexpr unsigned MAX_QUALITY = 15;
+	static constexpr int MAX_VOLUME = 12;		// +/- dB
+
+	// Quality is the DPCM pitch
+	CDPCMConverter(unsigned Quality, int VolumeDB, dpcm_encoder_t Encoder = dpcm_encoder_t::greedy);
+
+	// Throws std::runtime_error if the file is not an uncompressed PCM wave file
+	static stPCMWave ReadWaveFile(const fs::path &fname);
+
+	std::shared_ptr<ft0cc::doc::dpcm_sample> Convert(const stPCMWave &Wave) const;
+	// Pads encoded samples to a valid sample length
+	static std::shared_ptr<ft0cc::doc::dpcm_sample> MakeSample(std::vector<std::uint8_t> Bytes);
+
+	// Samples at the DPCM rate, in 16-bit range
+	std::vector<float> Resample(array_view<float> Samples, unsigned SampleRate) const;
+	std::vector<std::uint8_t> Encode(array_view<float> Samples) const;
+
+	// Signal-to-noise ratio in dB of encoded samples played back against the resampled samples
+	double GetSNR(array_view<float> Samples, array_view<std::uint8_t> Bytes) const;
+
+private:
+	unsigned quality_;
+	float volume_;
+	dpcm_encoder_t encoder_;
+};
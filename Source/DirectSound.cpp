@@ -25,9 +25,11 @@
 //
 
 #include "DirectSound.h"
+#include <mmreg.h>		// // //
 #include "Common.h"
 #include "../resource.h"
 #include "str_conv/str_conv.hpp"		// // //
+#include "WaveStream.h"		// // //
 
 // Class members
 
@@ -168,7 +170,7 @@ std::unique_ptr<CDSoundChannel> CDSound::OpenChannel(int SampleRate, int SampleS
 	wfx.wBitsPerSample		= SampleSize;
 	wfx.nBlockAlign			= wfx.nChannels * (wfx.wBitsPerSample / 8);
 	wfx.nAvgBytesPerSec		= wfx.nSamplesPerSec * wfx.nBlockAlign;
-	wfx.wFormatTag			= WAVE_FORMAT_PCM;
+	wfx.wFormatTag			= SampleSize == 32 ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;		// // //
 
 	DSBUFFERDESC dsbd = {sizeof(DSBUFFERDESC)};		// // //
 	dsbd.dwBufferBytes	= SoundBufferSize;
@@ -338,3 +340,82 @@ void CDSoundChannel::AdvanceWritePointer()
 {
 	m_iCurrentWriteBlock = (m_iCurrentWriteBlock + 1) % m_iBlocks;
 }
+
+// // // CDSoundAudioSink
+
+CDSoundAudioSink::CDSoundAudioSink(std::unique_ptr<CDSoundChannel> pChannel) :
+	m_pChannel(std::move(pChannel)),
+	m_Samples(m_pChannel->GetBlockSize() / (m_pChannel->GetSampleSize() / 8)),
+	m_Block(m_pChannel->GetBlockSize())
+{
+}
+
+CDSoundAudioSink::~CDSoundAudioSink() noexcept {
+	m_pChannel->Stop();
+}
+
+bool CDSoundAudioSink::Pump(IAudioSource &Source) {
+	const int AUDIO_TIMEOUT = 2000;		// 2s buffer timeout
+
+	// Wait for a buffer event
+	buffer_event_t dwEvent;
+	while ((dwEvent = m_pChannel->WaitForSyncEvent(AUDIO_TIMEOUT)) != BUFFER_IN_SYNC) {
+		switch (dwEvent) {
+			case BUFFER_TIMEOUT:
+				// Buffer timeout
+				SetSoundTimeout(true);
+			case BUFFER_CUSTOM_EVENT:
+				// Custom event, quit
+				return false;
+			case BUFFER_OUT_OF_SYNC:
+				// Buffer underrun detected
+				AddUnderrun();
+				break;
+		}
+	}
+
+	// Render exactly one block
+	if (!Source.RenderAudio(m_Samples.data(), m_Samples.size()))
+		return false;
+
+	switch (m_pChannel->GetSampleSize()) {
+	case 8:  ConvertBlock<std::uint8_t>(); break;
+	case 32: ConvertBlock<float>(); break;
+	default: ConvertBlock<std::int16_t>(); break;
+	}
+
+	// Write audio to buffer
+	m_pChannel->WriteBuffer({m_Block.data(), m_Block.size()});
+
+	SetSoundTimeout(false);
+
+	return true;
+}
+
+void CDSoundAudioSink::Reset() {
+	m_pChannel->ClearBuffer();
+}
+
+unsigned CDSoundAudioSink::GetSampleRate() const {
+	return m_pChannel->GetSampleRate();
+}
+
+unsigned CDSoundAudioSink::GetSampleSize() const {
+	return m_pChannel->GetSampleSize();
+}
+
+unsigned CDSoundAudioSink::GetPeriodFrames() const {
+	return static_cast<unsigned>(m_Samples.size());
+}
+
+unsigned CDSoundAudioSink::GetLatencyFrames() const {
+	return m_pChannel->GetBlocks() * GetPeriodFrames();
+}
+
+template <typename T>
+void CDSoundAudioSink::ConvertBlock() {
+	// same conversion as wave files, 8-bit samples are unsigned
+	auto *pBlock = reinterpret_cast<T *>(m_Block.data());
+	for (float Sample : m_Samples)
+		*pBlock++ = details::convert_sample<T>(Sample, sizeof(T) * 8);
+}
@@ -30,6 +30,7 @@
 #include <vector>		// // //
 #include <string>		// // //
 #include "array_view.h"		// // //
+#include "AudioSink.h"		// // //
 
 // Return values from WaitForDirectSoundEvent()
 enum buffer_event_t {
@@ -91,6 +92,31 @@ private:
 	unsigned int	m_iCurrentWriteBlock;
 };
 
+// // // Audio sink playing through a DirectSound channel, one block per period
+class CDSoundAudioSink final : public CAudioSink
+{
+public:
+	explicit CDSoundAudioSink(std::unique_ptr<CDSoundChannel> pChannel);
+	~CDSoundAudioSink() noexcept;
+
+	bool Pump(IAudioSource &Source) override;
+	void Reset() override;
+
+	unsigned GetSampleRate() const override;
+	unsigned GetSampleSize() const override;
+	unsigned GetPeriodFrames() const override;
+	unsigned GetLatencyFrames() const override;
+
+private:
+	template <typename T>
+	void ConvertBlock();
+
+private:
+	std::unique_ptr<CDSoundChannel> m_pChannel;
+	std::vector<float> m_Samples;
+	std::vector<char> m_Block;
+};
+
 // DirectSound
 class CDSound
 {
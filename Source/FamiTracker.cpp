@@ -261,7 +261,7 @@ BOOL CFamiTrackerApp::InitInstance()
 	// Handle command line export
 	if (cmdInfo.m_bExport) {
 		CCommandLineExport exporter;
-		exporter.CommandLineExport(cmdInfo.m_strFileName, cmdInfo.m_strExportFile, cmdInfo.m_strExportLogFile, cmdInfo.m_strExportDPCMFile);
+		exporter.CommandLineExport(cmdInfo.m_strFileName, cmdInfo.m_strExportFile, cmdInfo.m_strExportLogFile, cmdInfo.m_strExportDPCMFile, cmdInfo.m_strExportCacheFile);		// // //
 		ExitProcess(0);
 	}
 
@@ -707,6 +707,11 @@ void CFTCommandLineInfo::ParseParam(const WCHAR* pszParam, BOOL bFlag, BOOL bLas
 			m_bExport = true;
 			return;
 		}
+		// // // Export cache file (/cache <file>)
+		else if (!_wcsicmp(pszParam, L"cache")) {
+			m_bExpectCacheFile = true;
+			return;
+		}
 		// Auto play (/play or /p)
 		else if (!_wcsicmp(pszParam, L"play") || !_wcsicmp(pszParam, L"p")) {
 			m_bPlay = true;
@@ -743,6 +748,11 @@ void CFTCommandLineInfo::ParseParam(const WCHAR* pszParam, BOOL bFlag, BOOL bLas
 		}
 	}
 	else {
+		if (m_bExpectCacheFile) {		// // //
+			m_strExportCacheFile = CStringW(pszParam);
+			m_bExpectCacheFile = false;
+			return;
+		}
 		// Store NSF name, then log filename
 		if (m_bExport) {
 			if (m_strExportFile.IsEmpty()) {
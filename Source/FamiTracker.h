@@ -53,6 +53,8 @@ public:
 	CStringW m_strExportFile;
 	CStringW m_strExportLogFile;
 	CStringW m_strExportDPCMFile;
+	CStringW m_strExportCacheFile;		// // //
+	bool m_bExpectCacheFile = false;		// // //
 	unsigned track_;
 	unsigned render_param_ = 1;		// // //
 	render_type_t render_type_;		// // //
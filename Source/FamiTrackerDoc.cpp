@@ -213,6 +213,11 @@ void CFamiTrackerDoc::SetModifiedFlag(BOOL bModified)
 	BOOL bWasModified = IsModified();
 	CDocument::SetModifiedFlag(bModified);
 
+	// // // Hand the edited module to the player
+	if (bModified)
+		if (CSoundGen *pSoundGen = FTEnv.GetSoundGenerator())
+			pSoundGen->PublishModule();
+
 	if (auto *pFrameWnd = dynamic_cast<CFrameWnd *>(FTEnv.GetMainApp()->m_pMainWnd))		// // //
 		if (pFrameWnd->GetActiveDocument() == this && bWasModified != bModified)
 			pFrameWnd->OnUpdateFrameTitle(TRUE);
@@ -1750,7 +1750,7 @@ stChanNote CFamiTrackerView::GetInputNote(note_t Note, int Octave, std::size_t I
 	const int Frame = GetSelectedFrame();
 	const int Row = GetSelectedRow();
 
-	stChanNote Cell = GetSongView()->GetPatternOnFrame(Index, Frame).GetNoteOn(Row);		// // //
+	stChanNote Cell = std::as_const(*GetSongView()).GetPatternOnFrame(Index, Frame).GetNoteOn(Row);		// // //
 
 	Cell.Note = Note;
 
@@ -2598,7 +2598,7 @@ void CFamiTrackerView::HandleKeyboardInput(unsigned char nChar)		// // //
 		return;
 
 	// Get the note data
-	stChanNote Note = GetSongView()->GetPatternOnFrame(GetSelectedChannel(), Frame).GetNoteOn(Row);		// // //
+	stChanNote Note = std::as_const(*GetSongView()).GetPatternOnFrame(GetSelectedChannel(), Frame).GetNoteOn(Row);		// // //
 
 	// Make all effect columns look the same, save an index instead
 	switch (Column) {
@@ -2813,7 +2813,7 @@ int CFamiTrackerView::TranslateKeyModplug(unsigned char Key) const
 	int KeyOctave = 0;
 	int Octave = static_cast<CMainFrame*>(GetParentFrame())->GetSelectedOctave();		// // // 050B
 
-	const auto &NoteData = GetSongView()->GetPatternOnFrame(GetSelectedChannel(), GetSelectedFrame()).GetNoteOn(GetSelectedRow());
+	const auto &NoteData = std::as_const(*GetSongView()).GetPatternOnFrame(GetSelectedChannel(), GetSelectedFrame()).GetNoteOn(GetSelectedRow());		// // //
 
 	if (m_bEditEnable && Key >= '0' && Key <= '9') {		// // //
 		KeyOctave = Key - '1';
@@ -3286,7 +3286,7 @@ void CFamiTrackerView::OnPickupRow()
 	int Frame = GetSelectedFrame();
 	int Row = GetSelectedRow();
 
-	const auto &Note = GetSongView()->GetPatternOnFrame(GetSelectedChannel(), Frame).GetNoteOn(Row);		// // //
+	const auto &Note = std::as_const(*GetSongView()).GetPatternOnFrame(GetSelectedChannel(), Frame).GetNoteOn(Row);		// // //
 
 	m_LastNote.Note = Note.Note;		// // //
 	m_LastNote.Octave = Note.Octave;
@@ -37,32 +37,6 @@
 #include "NoteName.h"
 #include "str_conv/str_conv.hpp"
 
-namespace {
-
-enum {
-	WC_NOTE = 0,
-	WC_OCT,
-	WC_INST,
-	WC_VOL,
-	WC_EFF,
-	WC_PARAM,
-};
-
-} // namespace
-
-searchTerm::searchTerm() :
-	Note(std::make_unique<NoteRange>()),
-	Oct(std::make_unique<CharRange>()),
-	Inst(std::make_unique<CharRange>(0, MAX_INSTRUMENTS)),
-	Vol(std::make_unique<CharRange>(0, MAX_VOLUME)),
-	EffParam(std::make_unique<CharRange>()),
-	Definite(),
-	EffNumber()
-{
-}
-
-
-
 CFindCursor::CFindCursor(CSongView &view, const CCursorPos &Pos, const CSelection &Scope) :
 	CPatternIterator(view, Pos),
 	m_Scope(Scope.GetNormalized()),
@@ -900,64 +874,6 @@ replaceTerm CFindDlg::toReplace(const searchTerm &x) const
 	return Term;
 }
 
-bool CFindDlg::CompareFields(const stChanNote &Target, bool Noise, int EffCount)
-{
-	int EffColumn = m_cEffectColumn.GetCurSel();
-	if (EffColumn > EffCount && EffColumn != 4) EffColumn = EffCount;
-	bool Negate = IsDlgButtonChecked(IDC_CHECK_FIND_NEGATE) == BST_CHECKED;
-	bool EffectMatch = false;
-
-	bool Melodic = is_note(m_searchTerm.Note->Min) && // ||
-				   is_note(m_searchTerm.Note->Max) &&
-				   m_searchTerm.Definite[WC_OCT];
-
-	if (m_searchTerm.Definite[WC_NOTE]) {
-		if (m_searchTerm.NoiseChan) {
-			if (!Noise && Melodic) return false;
-			if (!is_note(m_searchTerm.Note->Min) || !is_note(m_searchTerm.Note->Max)) {
-				if (!m_searchTerm.Note->IsMatch(Target.Note)) return Negate;
-			}
-			else {
-				int NoiseNote = Target.ToMidiNote() % 16;
-				int Low = ft0cc::doc::midi_note(m_searchTerm.Oct->Min, m_searchTerm.Note->Min) % 16;
-				int High = ft0cc::doc::midi_note(m_searchTerm.Oct->Max, m_searchTerm.Note->Max) % 16;
-				if ((NoiseNote < Low && NoiseNote < High) || (NoiseNote > Low && NoiseNote > High))
-					return Negate;
-			}
-		}
-		else {
-			if (Noise && Melodic) return false;
-			if (Melodic) {
-				if (!is_note(Target.Note))
-					return Negate;
-				int NoteValue = Target.ToMidiNote();
-				int Low = ft0cc::doc::midi_note(m_searchTerm.Oct->Min, m_searchTerm.Note->Min);
-				int High = ft0cc::doc::midi_note(m_searchTerm.Oct->Max, m_searchTerm.Note->Max);
-				if ((NoteValue < Low && NoteValue < High) || (NoteValue > Low && NoteValue > High))
-					return Negate;
-			}
-			else {
-				if (!m_searchTerm.Note->IsMatch(Target.Note)) return Negate;
-				if (m_searchTerm.Definite[WC_OCT] && !m_searchTerm.Oct->IsMatch(Target.Octave))
-					return Negate;
-			}
-		}
-	}
-	if (m_searchTerm.Definite[WC_INST] && !m_searchTerm.Inst->IsMatch(Target.Instrument)) return Negate;
-	if (m_searchTerm.Definite[WC_VOL] && !m_searchTerm.Vol->IsMatch(Target.Vol)) return Negate;
-	int Limit = MAX_EFFECT_COLUMNS - 1;
-	if (EffCount < Limit) Limit = EffCount;
-	if (EffColumn < Limit) Limit = EffColumn;
-	for (int i = EffColumn % MAX_EFFECT_COLUMNS; i <= Limit; ++i) {
-		if ((!m_searchTerm.Definite[WC_EFF] || m_searchTerm.EffNumber[value_cast(Target.Effects[i].fx)])
-		&& (!m_searchTerm.Definite[WC_PARAM] || m_searchTerm.EffParam->IsMatch(Target.Effects[i].param)))
-			EffectMatch = true;
-	}
-	if (!EffectMatch) return Negate;
-
-	return !Negate;
-}
-
 template <typename... T>
 void CFindDlg::RaiseIf(bool Check, LPCWSTR Str, T&&... args)
 {
@@ -987,7 +903,7 @@ bool CFindDlg::Find(bool ShowEnd)
 			m_pFindCursor->Move(m_iSearchDirection);
 		}
 		const auto &Target = m_pFindCursor->Get();
-		if (CompareFields(Target, IsAPUNoise(Order.TranslateChannel(m_pFindCursor->m_iChannel)),
+		if (m_pMatcher->IsMatch(Target, IsAPUNoise(Order.TranslateChannel(m_pFindCursor->m_iChannel)),		// // //
 			pSongView->GetEffectColumnCount(m_pFindCursor->m_iChannel))) {
 			auto pCursor = std::move(m_pFindCursor);
 			m_pView->SelectFrame(pCursor->m_iFrame % Frames);
@@ -1036,8 +952,7 @@ bool CFindDlg::Replace(CCompoundAction *pAction)
 			else {
 				const int c = pSongView->GetEffectColumnCount(m_pFindCursor->m_iChannel);
 				for (int i = 0; i <= c; ++i)
-					if ((!m_searchTerm.Definite[WC_EFF] || m_searchTerm.EffNumber[value_cast(Target.Effects[i].fx)]) &&
-						(!m_searchTerm.Definite[WC_PARAM] || m_searchTerm.EffParam->IsMatch(Target.Effects[i].param)))
+					if (m_pMatcher->IsEffectMatch(Target.Effects[i]))		// // //
 						MatchedColumns.push_back(i);
 			}
 
@@ -1084,6 +999,8 @@ bool CFindDlg::PrepareFind()
 		return false;
 	}
 
+	m_pMatcher = std::make_unique<CPatternMatcher>(m_searchTerm, m_cEffectColumn.GetCurSel(),		// // //
+		IsDlgButtonChecked(IDC_CHECK_FIND_NEGATE) == BST_CHECKED);
 	return true;
 }
 
@@ -1210,13 +1127,18 @@ void CFindDlg::OnBnClickedButtonFindAll()
 	m_iSearchDirection = IsDlgButtonChecked(IDC_CHECK_VERTICAL_SEARCH) ?
 		CFindCursor::direction_t::DOWN : CFindCursor::direction_t::RIGHT;
 
+	// // // look up channel properties once instead of on every cell
+	std::vector<std::pair<bool, unsigned>> Tracks;
+	for (std::size_t i = 0, n = Order.GetChannelCount(); i < n; ++i)
+		Tracks.emplace_back(IsAPUNoise(Order.TranslateChannel(i)), pSongView->GetEffectColumnCount(i));
+
 	PrepareCursor(true);
 	m_cResultsBox.SetRedraw(FALSE);
 	m_cResultsBox.ClearResults();
 	do {
 		const auto &Target = m_pFindCursor->Get();
-		bool isNoise = IsAPUNoise(Order.TranslateChannel(m_pFindCursor->m_iChannel));
-		if (CompareFields(Target, isNoise, pSongView->GetEffectColumnCount(m_pFindCursor->m_iChannel)))
+		const auto [isNoise, EffCount] = Tracks[m_pFindCursor->m_iChannel];		// // //
+		if (m_pMatcher->IsMatch(Target, isNoise, EffCount))
 			m_cResultsBox.AddResult(Target, *m_pFindCursor, isNoise);
 		m_pFindCursor->Move(m_iSearchDirection);
 	} while (!m_pFindCursor->AtStart());
@@ -1238,12 +1160,16 @@ void CFindDlg::OnBnClickedButtonReplaceall()
 	m_iSearchDirection = IsDlgButtonChecked(IDC_CHECK_VERTICAL_SEARCH) ?
 		CFindCursor::direction_t::DOWN : CFindCursor::direction_t::RIGHT;
 
+	std::vector<std::pair<bool, unsigned>> Tracks;		// // //
+	for (std::size_t i = 0, n = Order.GetChannelCount(); i < n; ++i)
+		Tracks.emplace_back(IsAPUNoise(Order.TranslateChannel(i)), pSongView->GetEffectColumnCount(i));
+
 	auto pAction = std::make_unique<CCompoundAction>();
 	PrepareCursor(true);
 	do {
 		const auto &Target = m_pFindCursor->Get();
-		bool isNoise = IsAPUNoise(Order.TranslateChannel(m_pFindCursor->m_iChannel));
-		if (CompareFields(Target, isNoise, pSongView->GetEffectColumnCount(m_pFindCursor->m_iChannel))) {
+		const auto [isNoise, EffCount] = Tracks[m_pFindCursor->m_iChannel];		// // //
+		if (m_pMatcher->IsMatch(Target, isNoise, EffCount)) {
 			m_bFound = true;
 			Replace(static_cast<CCompoundAction *>(pAction.get()));
 			++Count;
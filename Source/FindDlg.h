@@ -28,65 +28,13 @@
 
 #include <memory>
 #include <string>
-#include <limits>
 
 #include "PatternNote.h"
+#include "PatternSearch.h"		// // //
 #include "PatternEditorTypes.h"
 #include "SelectionRange.h"
 #include "APU/Types_fwd.h"
 
-namespace details {
-
-template <typename T, bool>
-struct underlying_type {
-	using type = T;
-};
-template <typename T>
-struct underlying_type<T, true> {
-	using type = std::underlying_type_t<T>;
-};
-template <typename T>
-using underlying_type_t = typename underlying_type<T, std::is_enum_v<T>>::type;
-
-} // namespace details
-
-template <typename T>
-struct FindRange {
-	constexpr FindRange() noexcept = default;
-	constexpr FindRange(T a, T b) noexcept : Min(a), Max(b) { }
-
-	constexpr void Set(T x, bool Half = false) noexcept {
-		if (!Half)
-			Min = x;
-		Max = x;
-	}
-	constexpr bool IsMatch(T x) const noexcept {
-		return (x >= Min && x <= Max) || (x >= Max && x <= Min);
-	}
-	constexpr bool IsSingle() const noexcept {
-		return Min == Max;
-	}
-
-	T Min = static_cast<T>(std::numeric_limits<details::underlying_type_t<T>>::min());
-	T Max = static_cast<T>(std::numeric_limits<details::underlying_type_t<T>>::max());
-};
-
-using CharRange = FindRange<unsigned char>;
-using NoteRange = FindRange<note_t>;
-
-class searchTerm
-{
-public:
-	searchTerm();
-
-	std::unique_ptr<NoteRange> Note;
-	std::unique_ptr<CharRange> Oct, Inst, Vol;
-	bool EffNumber[enum_count<effect_t>() + 1] = { };
-	std::unique_ptr<CharRange> EffParam;
-	bool Definite[6] = { };
-	bool NoiseChan = false;
-};
-
 struct replaceTerm
 {
 	stChanNote Note;
@@ -232,8 +180,6 @@ protected:
 	void GetFindTerm();
 	void GetReplaceTerm();
 
-	bool CompareFields(const stChanNote &Target, bool Noise, int EffCount);
-
 	template <typename... T>
 	void RaiseIf(bool Check, LPCWSTR Str, T&&... args);
 	unsigned GetHex(LPCWSTR str);
@@ -256,6 +202,7 @@ protected:
 
 	searchTerm m_searchTerm = { };
 	replaceTerm m_replaceTerm = { };
+	std::unique_ptr<CPatternMatcher> m_pMatcher;		// // //
 	bool m_bFound, m_bSkipFirst, m_bReplacing;
 
 	std::unique_ptr<CFindCursor> m_pFindCursor;
@@ -128,6 +128,16 @@ void CFrameAction::SaveRedoState(const CMainFrame &MainFrm)		// // //
 	m_pRedoState = std::make_unique<CFrameEditorState>(*GET_VIEW());		// // //
 }
 
+std::size_t CFrameAction::GetFootprint() const		// // //
+{
+	std::size_t Size = sizeof(CFrameAction);
+	if (m_pUndoState)
+		Size += sizeof(CFrameEditorState);
+	if (m_pRedoState)
+		Size += sizeof(CFrameEditorState);
+	return Size;
+}
+
 void CFrameAction::RestoreUndoState(CMainFrame &MainFrm) const		// // //
 {
 	m_pUndoState->ApplyState(*GET_VIEW());
@@ -188,6 +198,11 @@ void CFActionRemoveFrame::Redo(CMainFrame &MainFrm)
 	GET_SONG().DeleteFrames(m_pUndoState->Cursor.m_iFrame, 1);
 }
 
+std::size_t CFActionRemoveFrame::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_RowClipData.GetFootprint();
+}
+
 
 
 bool CFActionDuplicateFrame::SaveState(const CMainFrame &MainFrm)
@@ -293,6 +308,11 @@ void CFActionSetPattern::Redo(CMainFrame &MainFrm)
 			pSongView->SetFramePattern(c, f, m_iNewPattern);
 }
 
+std::size_t CFActionSetPattern::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_ClipData.GetFootprint();
+}
+
 bool CFActionSetPattern::Merge(const CAction &Other)		// // //
 {
 	auto pAction = dynamic_cast<const CFActionSetPattern *>(&Other);
@@ -334,6 +354,11 @@ void CFActionSetPatternAll::Redo(CMainFrame &MainFrm)
 	});
 }
 
+std::size_t CFActionSetPatternAll::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_RowClipData.GetFootprint();
+}
+
 bool CFActionSetPatternAll::Merge(const CAction &Other)		// // //
 {
 	auto pAction = dynamic_cast<const CFActionSetPatternAll *>(&Other);
@@ -385,6 +410,11 @@ void CFActionChangePattern::Redo(CMainFrame &MainFrm)
 		}
 }
 
+std::size_t CFActionChangePattern::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_ClipData.GetFootprint();
+}
+
 bool CFActionChangePattern::Merge(const CAction &Other)		// // //
 {
 	auto pAction = dynamic_cast<const CFActionChangePattern *>(&Other);
@@ -438,6 +468,11 @@ void CFActionChangePatternAll::Redo(CMainFrame &MainFrm)
 	});
 }
 
+std::size_t CFActionChangePatternAll::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_RowClipData.GetFootprint();
+}
+
 bool CFActionChangePatternAll::Merge(const CAction &Other)		// // //
 {
 	auto pAction = dynamic_cast<const CFActionChangePatternAll *>(&Other);
@@ -530,6 +565,11 @@ void CFActionPaste::Redo(CMainFrame &MainFrm)
 	pFrameEditor->SetSelection(sel);
 }
 
+std::size_t CFActionPaste::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_ClipData.GetFootprint();
+}
+
 void CFActionPaste::UpdateViews(CMainFrame &MainFrm) const {
 	CFrameAction::UpdateViews(MainFrm);
 	MainFrm.UpdateControls();
@@ -574,6 +614,11 @@ void CFActionPasteOverwrite::Redo(CMainFrame &MainFrm)		// // //
 	pEditor->SetSelection(m_TargetSelection);
 }
 
+std::size_t CFActionPasteOverwrite::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_ClipData.GetFootprint() + m_OldClipData.GetFootprint();
+}
+
 
 
 CFActionDropMove::CFActionDropMove(CFrameClipData Data, int Frame) :
@@ -601,6 +646,11 @@ void CFActionDropMove::Redo(CMainFrame &MainFrm)
 		 {m_iTargetFrame, m_pUndoState->Cursor.m_iChannel});
 }
 
+std::size_t CFActionDropMove::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_ClipData.GetFootprint();
+}
+
 
 
 CFActionClonePatterns::~CFActionClonePatterns() {
@@ -647,6 +697,11 @@ void CFActionClonePatterns::Redo(CMainFrame &MainFrm)		// // //
 	}
 }
 
+std::size_t CFActionClonePatterns::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_ClipData.GetFootprint();
+}
+
 
 
 CFActionDeleteSel::~CFActionDeleteSel() {
@@ -681,6 +736,11 @@ void CFActionDeleteSel::Redo(CMainFrame &MainFrm)
 	GET_FRAME_EDITOR()->CancelSelection();
 }
 
+std::size_t CFActionDeleteSel::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_ClipData.GetFootprint();
+}
+
 void CFActionDeleteSel::UpdateViews(CMainFrame &MainFrm) const {
 	CFrameAction::UpdateViews(MainFrm);
 	MainFrm.UpdateControls();
@@ -745,3 +805,8 @@ void CFActionMergeDuplicated::Redo(CMainFrame &MainFrm)
 	CFrameEditor *pFrameEditor = GET_FRAME_EDITOR();
 	pFrameEditor->PasteAt(*&m_ClipData, {0, 0});
 }
+
+std::size_t CFActionMergeDuplicated::GetFootprint() const		// // //
+{
+	return CFrameAction::GetFootprint() + m_ClipData.GetFootprint() + m_OldClipData.GetFootprint();
+}
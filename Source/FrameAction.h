@@ -88,6 +88,7 @@ protected:
 	void RestoreUndoState(CMainFrame &MainFrm) const override;		// // //
 	void RestoreRedoState(CMainFrame &MainFrm) const override;		// // //
 	void UpdateViews(CMainFrame &MainFrm) const override;		// // //
+	std::size_t GetFootprint() const override;		// // //
 
 protected:
 	static int ClipPattern(int Pattern);
@@ -119,6 +120,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 private:
 	CFrameClipData m_RowClipData;
 };
@@ -166,6 +168,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 	bool Merge(const CAction &Other) override;		// // //
 private:
 	int m_iNewPattern;
@@ -181,6 +184,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 	bool Merge(const CAction &Other) override;		// // //
 private:
 	int m_iNewPattern;
@@ -196,6 +200,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 	bool Merge(const CAction &Other) override;		// // //
 private:
 	int m_iPatternOffset;
@@ -212,6 +217,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 	bool Merge(const CAction &Other) override;		// // //
 private:
 	int m_iPatternOffset;
@@ -248,6 +254,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 private:
 	int m_iOldPattern, m_iNewPattern;
 	CFrameClipData m_ClipData;
@@ -262,6 +269,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 	void UpdateViews(CMainFrame &MainFrm) const override;
 private:
 	CFrameClipData m_ClipData;
@@ -278,6 +286,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 private:
 	CFrameClipData m_ClipData, m_OldClipData;
 	CFrameSelection m_TargetSelection;
@@ -292,6 +301,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 private:
 	CFrameClipData m_ClipData;
 	int m_iTargetFrame;
@@ -306,6 +316,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 	void UpdateViews(CMainFrame &MainFrm) const override;
 private:
 	CFrameClipData m_ClipData;
@@ -320,6 +331,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 private:
 	CFrameClipData m_ClipData, m_OldClipData;
 };
@@ -48,6 +48,10 @@ bool CFrameClipData::ContainsData() const {		// // //
 	return pFrames != nullptr;
 }
 
+std::size_t CFrameClipData::GetFootprint() const {		// // //
+	return pFrames ? sizeof(int) * iSize : 0u;
+}
+
 bool CFrameClipData::ToBytes(std::byte *pBuf, std::size_t buflen) const		// // //
 {
 	if (buflen >= GetAllocSize()) {
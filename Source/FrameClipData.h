@@ -39,6 +39,7 @@ public:
 	void SetFrame(int Frame, int Channel, int Pattern);
 
 	bool ContainsData() const override;		// // //
+	std::size_t GetFootprint() const;		// // // heap memory only, in bytes
 
 private:
 	std::size_t GetAllocSize() const override;
@@ -32,6 +32,10 @@ int CInstCompilerNull::CompileChunk(const CInstrument &, CChunk &, unsigned) con
 	return 0;
 }
 
+unsigned CInstCompilerNull::GetChunkSize(const CInstrument &) const {		// // //
+	return 0;
+}
+
 int CInstCompilerSeq::CompileChunk(const CInstrument &inst_, CChunk &chunk, unsigned instIndex) const {
 	auto &inst = dynamic_cast<const CSeqInstrument &>(inst_);
 
@@ -61,6 +65,16 @@ int CInstCompilerSeq::CompileChunk(const CInstrument &inst_, CChunk &chunk, unsi
 	return StoredBytes;
 }
 
+unsigned CInstCompilerSeq::GetChunkSize(const CInstrument &inst_) const {		// // //
+	auto &inst = dynamic_cast<const CSeqInstrument &>(inst_);
+
+	unsigned Size = 2; // type, sequence switch
+	for (auto i : enum_values<sequence_t>())
+		if (inst.GetSeqEnable(i))
+			Size += 2;
+	return Size;
+}
+
 int CInstCompilerVRC7::CompileChunk(const CInstrument &inst_, CChunk &chunk, unsigned instIndex) const {
 	auto &inst = dynamic_cast<const CInstrumentVRC7 &>(inst_);
 
@@ -77,6 +91,11 @@ int CInstCompilerVRC7::CompileChunk(const CInstrument &inst_, CChunk &chunk, uns
 	return (Patch == 0) ? 10 : 2;		// // //
 }
 
+unsigned CInstCompilerVRC7::GetChunkSize(const CInstrument &inst_) const {		// // //
+	auto &inst = dynamic_cast<const CInstrumentVRC7 &>(inst_);
+	return inst.GetPatch() == 0 ? 10 : 2;
+}
+
 int CInstCompilerFDS::CompileChunk(const CInstrument &inst_, CChunk &chunk, unsigned instIndex) const {
 	auto &inst = dynamic_cast<const CInstrumentFDS &>(inst_);
 
@@ -116,6 +135,16 @@ int CInstCompilerFDS::CompileChunk(const CInstrument &inst_, CChunk &chunk, unsi
 	return size;
 }
 
+unsigned CInstCompilerFDS::GetChunkSize(const CInstrument &inst_) const {		// // //
+	auto &inst = dynamic_cast<const CInstrumentFDS &>(inst_);
+
+	unsigned Size = 2 + 16 + 4; // type, sequence switch, modulation table, delay, depth, speed
+	for (auto i : enum_values<sequence_t>())
+		if (const auto pSequence = inst.GetSequence(i); inst.GetSeqEnable(i) && pSequence && pSequence->GetItemCount() > 0)
+			Size += 2;
+	return Size;
+}
+
 int CInstCompilerN163::CompileChunk(const CInstrument &inst_, CChunk &chunk, unsigned instIndex) const {
 	auto &inst = dynamic_cast<const CInstrumentN163 &>(inst_);
 
@@ -133,6 +162,10 @@ int CInstCompilerN163::CompileChunk(const CInstrument &inst_, CChunk &chunk, uns
 	return StoredBytes;
 }
 
+unsigned CInstCompilerN163::GetChunkSize(const CInstrument &inst) const {		// // //
+	return CInstCompilerSeq::GetChunkSize(inst) + 4; // wave size, position, wave pointer
+}
+
 int CInstCompilerN163::StoreWaves(const CInstrumentN163 &inst, CChunk &chunk) const {
 	int Count = inst.GetWaveCount();
 	int Size = inst.GetWaveSize();
@@ -147,3 +180,7 @@ int CInstCompilerN163::StoreWaves(const CInstrumentN163 &inst, CChunk &chunk) co
 
 	return Count * Size / 2;
 }
+
+unsigned CInstCompilerN163::GetWavesSize(const CInstrumentN163 &inst) const {		// // //
+	return inst.GetWaveCount() * ((inst.GetWaveSize() + 1) / 2);
+}
@@ -30,25 +30,31 @@ class CInstCompiler {
 public:
 	virtual ~CInstCompiler() noexcept = default;
 	virtual int CompileChunk(const CInstrument &inst, CChunk &chunk, unsigned instIndex) const = 0;
+	// // // exact number of bytes CompileChunk stores into the chunk
+	virtual unsigned GetChunkSize(const CInstrument &inst) const = 0;
 };
 
 class CInstCompilerNull final : public CInstCompiler {
 	int CompileChunk(const CInstrument &inst, CChunk &chunk, unsigned instIndex) const override;
+	unsigned GetChunkSize(const CInstrument &inst) const override;		// // //
 };
 
 class CInstCompilerSeq : public CInstCompiler {
 protected:
 	int CompileChunk(const CInstrument &inst, CChunk &chunk, unsigned instIndex) const override;
+	unsigned GetChunkSize(const CInstrument &inst) const override;		// // //
 };
 
 class CInstCompilerVRC7 : public CInstCompiler {
 protected:
 	int CompileChunk(const CInstrument &inst, CChunk &chunk, unsigned instIndex) const override;
+	unsigned GetChunkSize(const CInstrument &inst) const override;		// // //
 };
 
 class CInstCompilerFDS : public CInstCompiler {
 protected:
 	int CompileChunk(const CInstrument &inst, CChunk &chunk, unsigned instIndex) const override;
+	unsigned GetChunkSize(const CInstrument &inst) const override;		// // //
 };
 
 class CInstrumentN163;
@@ -56,7 +62,9 @@ class CInstrumentN163;
 class CInstCompilerN163 : public CInstCompilerSeq {
 public:
 	int StoreWaves(const CInstrumentN163 &inst, CChunk &chunk) const;
+	unsigned GetWavesSize(const CInstrumentN163 &inst) const;		// // //
 
 protected:
 	int CompileChunk(const CInstrument &inst, CChunk &chunk, unsigned instIndex) const override;
+	unsigned GetChunkSize(const CInstrument &inst) const override;		// // //
 };
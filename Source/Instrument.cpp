@@ -22,6 +22,8 @@
 
 #include "Instrument.h"
 #include "InstrumentManagerInterface.h"		// // //
+#include "ContentHash.h"		// // //
+#include <vector>		// // //
 
 namespace {
 
@@ -75,3 +77,24 @@ inst_type_t CInstrument::GetType() const		// // //
 {
 	return m_iType;
 }
+
+void CInstrument::HashContent(CContentHash &hash) const		// // //
+{
+	hash.Add(m_iType).Add(name_);
+}
+
+std::uint64_t CInstrument::GetContentHash() const		// // //
+{
+	CContentHash hash;
+	HashContent(hash);
+	return hash.Get();
+}
+
+bool CInstrument::HasSameContent(const CInstrument &other) const		// // //
+{
+	std::vector<std::uint8_t> lhs, rhs;
+	CContentHash h1 {lhs}, h2 {rhs};
+	HashContent(h1);
+	other.HashContent(h2);
+	return lhs == rhs;
+}
@@ -25,6 +25,7 @@
 
 #include <string>
 #include <memory>
+#include <cstdint>		// // //
 
 // Instrument types
 enum inst_type_t : unsigned {
@@ -40,6 +41,7 @@ enum inst_type_t : unsigned {
 // External classes
 class CChunk;
 class CInstrumentManagerInterface;		// // // break cyclic dependencies
+class CContentHash;		// // //
 
 // Instrument base class
 class CInstrument {
@@ -60,6 +62,12 @@ public:
 	inst_type_t GetType() const;										// // // Returns instrument type
 	virtual bool CanRelease() const = 0;
 
+	// // // Hashes everything that defines the instrument, with sequences and samples by content
+	virtual void HashContent(CContentHash &hash) const;
+	std::uint64_t GetContentHash() const;
+	// // // Compares everything HashContent sees, for telling hash collisions apart
+	bool HasSameContent(const CInstrument &other) const;
+
 protected:
 	virtual void CloneFrom(const CInstrument *pInst);					// // // virtual copying
 
@@ -23,6 +23,8 @@
 #include "Instrument2A03.h"
 #include "InstrumentManagerInterface.h"		// // //
 #include "ft0cc/doc/dpcm_sample.hpp"		// // //
+#include "ContentHash.h"		// // //
+#include <unordered_map>		// // //
 
 // 2A03 instruments
 
@@ -128,3 +130,22 @@ std::shared_ptr<ft0cc::doc::dpcm_sample> CInstrument2A03::GetDSample(int MidiNot
 	unsigned Index = GetSampleIndex(MidiNote);
 	return Index != NO_DPCM ? m_pInstManager->GetDSample(Index) : nullptr;
 }
+
+void CInstrument2A03::HashContent(CContentHash &hash) const		// // //
+{
+	CSeqInstrument::HashContent(hash);
+
+	// each sample is hashed once by content, later uses refer to the order of first use
+	std::unordered_map<unsigned, unsigned> Used;
+	for (int i = 0; i < NOTE_COUNT; ++i) {
+		const auto &x = m_Assignments[i];
+		auto pSample = GetDSample(i);
+		hash.Add(pSample != nullptr).Add(x.Pitch).Add(x.LoopOffset).Add(x.Delta);
+		if (!pSample)
+			continue;
+		auto [it, inserted] = Used.try_emplace(x.Index, Used.size());
+		hash.Add(it->second);
+		if (inserted)
+			hash.Add(pSample->size()).Add(array_view<std::uint8_t> {pSample->data(), pSample->size()});
+	}
+}
@@ -52,6 +52,8 @@ public:
 	bool	AssignedSamples() const;
 	std::shared_ptr<ft0cc::doc::dpcm_sample> GetDSample(int MidiNote) const;		// // //
 
+	void	HashContent(CContentHash &hash) const override;		// // //
+
 protected:
 	void	CloneFrom(const CInstrument *pInst) override;		// // //
 
@@ -23,6 +23,7 @@
 #include "InstrumentFDS.h"		// // //
 #include "Sequence.h"		// // //
 #include "Assertion.h"		// // //
+#include "ContentHash.h"		// // //
 
 namespace {
 
@@ -197,3 +198,10 @@ void CInstrumentFDS::SetSequence(sequence_t SeqType, std::shared_ptr<CSequence>
 	if (GetSeqEnable(SeqType))
 		m_pSequence[SeqType] = std::move(pSeq);
 }
+
+void CInstrumentFDS::HashContent(CContentHash &hash) const		// // //
+{
+	CSeqInstrument::HashContent(hash);
+	hash.Add(m_iSamples).Add(m_iModulation).Add(m_iModulationSpeed).Add(m_iModulationDepth)
+		.Add(m_iModulationDelay).Add(m_bModulationEnable);
+}
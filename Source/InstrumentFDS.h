@@ -55,6 +55,8 @@ public:
 	bool	GetModulationEnable() const;
 	void	SetModulationEnable(bool Enable);
 
+	void	HashContent(CContentHash &hash) const override;		// // //
+
 protected:
 	void	CloneFrom(const CInstrument *pInst) override;		// // //
 
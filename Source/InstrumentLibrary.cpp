@@ -0,0 +1,343 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#include "InstrumentLibrary.h"
+#include "FamiTrackerEnv.h"
+#include "InstrumentService.h"
+#include "InstrumentManager.h"
+#include "InstrumentIO.h"
+#include "Instrument2A03.h"
+#include "SeqInstrument.h"
+#include "ModuleException.h"
+#include "SimpleFile.h"
+#include "ContentHash.h"
+#include "NumConv.h"
+#include "RunParallel.h"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+
+namespace {
+
+// FTI instruments files
+const std::string_view INST_HEADER = "FTI";
+const unsigned I_CURRENT_VER_MAJ = 2;
+const unsigned I_CURRENT_VER_MIN = 5;
+
+const std::string_view CACHE_HEADER = "FTILIB";
+const int CACHE_VERSION = 1;
+
+bool IsInstrumentFile(const fs::path &fname) {
+	std::string ext = fname.extension().u8string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), [] (unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return ext == ".fti";
+}
+
+// Lists the instrument files below Root, each directory is read by one of the worker threads
+std::vector<stInstrumentLibraryEntry> ListFiles(const fs::path &Root, unsigned Threads) {
+	std::mutex Lock;
+	std::condition_variable Cond;
+	std::vector<fs::path> Pending {Root};
+	unsigned Busy = 0;
+	std::vector<stInstrumentLibraryEntry> Files;
+
+	const auto Worker = [&] {
+		std::unique_lock<std::mutex> lk {Lock};
+		while (true) {
+			Cond.wait(lk, [&] { return !Pending.empty() || !Busy; });
+			if (Pending.empty())
+				return;
+			fs::path Dir = std::move(Pending.back());
+			Pending.pop_back();
+			++Busy;
+			lk.unlock();
+
+			std::vector<fs::path> SubDirs;
+			std::vector<stInstrumentLibraryEntry> Found;
+			std::error_code ec;
+			for (fs::directory_iterator it {Dir, fs::directory_options::skip_permission_denied, ec}, end; !ec && it != end; it.increment(ec)) {
+				const fs::directory_entry &x = *it;
+				std::error_code ec2;
+				if (x.is_symlink(ec2) || x.path().filename().u8string().front() == '.')
+					continue;		// hidden folders and links that may form cycles
+				if (x.is_directory(ec2))
+					SubDirs.push_back(x.path());
+				else if (x.is_regular_file(ec2) && IsInstrumentFile(x.path())) {
+					auto &Entry = Found.emplace_back();
+					Entry.Path = x.path();
+					Entry.FileSize = x.file_size(ec2);
+					Entry.ModifiedTime = x.last_write_time(ec2).time_since_epoch().count();
+				}
+			}
+
+			lk.lock();
+			--Busy;
+			std::move(SubDirs.begin(), SubDirs.end(), std::back_inserter(Pending));
+			std::move(Found.begin(), Found.end(), std::back_inserter(Files));
+			Cond.notify_all();
+		}
+	};
+
+	Threads = std::max(Threads, 1u);
+	std::vector<std::thread> Pool;
+	for (unsigned i = 1; i < Threads; ++i)
+		Pool.emplace_back(Worker);
+	Worker();
+	for (auto &t : Pool)
+		t.join();
+
+	std::sort(Files.begin(), Files.end(), [] (const auto &a, const auto &b) { return a.Path < b.Path; });
+	return Files;
+}
+
+void WriteInt64(CSimpleFile &file, std::uint64_t x) {
+	file.WriteInt32(static_cast<std::int32_t>(x));
+	file.WriteInt32(static_cast<std::int32_t>(x >> 32));
+}
+
+std::uint64_t ReadInt64(CSimpleFile &file) {
+	std::uint64_t lo = file.ReadUint32();
+	return lo | static_cast<std::uint64_t>(file.ReadUint32()) << 32;
+}
+
+} // namespace
+
+std::uint64_t CInstrumentLibrary::GetSequenceHash(const CSequence &seq) {
+	CContentHash hash;
+	seq.HashContent(hash);
+	return hash.Get();
+}
+
+stInstrumentLibraryEntry CInstrumentLibrary::ReadEntry(const fs::path &fname) {
+	stInstrumentLibraryEntry Entry;
+	Entry.Path = fname;
+
+	try {
+		CSimpleFile file {fname, std::ios::in | std::ios::binary};
+
+		// Signature
+		if (file.ReadStringN(INST_HEADER.size()) != INST_HEADER)
+			return Entry;
+
+		// Version
+		unsigned iInstMaj = conv::from_digit(file.ReadInt8());
+		if (file.ReadInt8() != '.')
+			return Entry;
+		unsigned iInstMin = conv::from_digit(file.ReadInt8());
+		if (std::tie(iInstMaj, iInstMin) > std::tie(I_CURRENT_VER_MAJ, I_CURRENT_VER_MIN))
+			return Entry;
+
+		auto InstType = static_cast<inst_type_t>(file.ReadUint8());
+		if (InstType == INST_NONE)
+			InstType = INST_2A03;
+		if (InstType > INST_S5B)
+			return Entry;
+
+		// A scratch manager holds the sequences and samples of the instrument
+		CInstrumentManager Manager;
+		auto pInstrument = Manager.CreateNew(InstType);
+		pInstrument->OnBlankInstrument();
+		FTEnv.GetInstrumentService()->GetInstrumentIO(InstType, MODULE_ERROR_DEFAULT)->
+			ReadFromFTI(*pInstrument, file, iInstMaj * 10 + iInstMin);
+		if (!file)
+			return Entry;		// truncated
+
+		Entry.Type = InstType;
+		Entry.Name = pInstrument->GetName();
+		if (auto *pSeqInst = dynamic_cast<const CSeqInstrument *>(pInstrument.get()))
+			foreachSeq([&] (sequence_t SeqType) {
+				if (pSeqInst->GetSeqEnable(SeqType))
+					if (auto pSeq = pSeqInst->GetSequence(SeqType))
+						Entry.SequenceHashes[value_cast(SeqType)] = GetSequenceHash(*pSeq);
+			});
+		if (auto *p2A03 = dynamic_cast<const CInstrument2A03 *>(pInstrument.get())) {
+			std::unordered_set<unsigned> Samples;
+			for (int i = 0; i < NOTE_COUNT; ++i)
+				if (p2A03->GetDSample(i))
+					Samples.insert(p2A03->GetSampleIndex(i));
+			Entry.SampleCount = Samples.size();
+		}
+		Entry.ContentHash = pInstrument->GetContentHash();
+		Entry.Valid = true;
+	}
+	catch (CModuleException &) {
+	}
+	catch (std::exception &) {
+	}
+
+	return Entry;
+}
+
+std::size_t CInstrumentLibrary::Scan(const fs::path &Root, unsigned Threads) {
+	std::vector<stInstrumentLibraryEntry> Files = ListFiles(Root, Threads);
+
+	// Both lists are sorted by path
+	std::vector<std::size_t> Stale;
+	auto it = m_Entries.begin();
+	for (std::size_t i = 0; i < Files.size(); ++i) {
+		auto &File = Files[i];
+		it = std::lower_bound(it, m_Entries.end(), File, [] (const auto &a, const auto &b) { return a.Path < b.Path; });
+		if (it != m_Entries.end() && it->Path == File.Path && it->FileSize == File.FileSize && it->ModifiedTime == File.ModifiedTime)
+			File = std::move(*it);
+		else
+			Stale.push_back(i);
+	}
+
+	(void)FTEnv.GetInstrumentService();		// construct the service before the workers use it
+	RunParallel(Stale.size(), Threads, [&] (std::size_t i) {
+		auto &File = Files[Stale[i]];
+		stInstrumentLibraryEntry Entry = ReadEntry(File.Path);
+		Entry.FileSize = File.FileSize;
+		Entry.ModifiedTime = File.ModifiedTime;
+		File = std::move(Entry);
+	});
+
+	m_Entries = std::move(Files);
+	BuildIndex();
+	return Stale.size();
+}
+
+bool CInstrumentLibrary::LoadCache(const fs::path &fname) {
+	m_Entries.clear();
+	BuildIndex();
+	std::vector<stInstrumentLibraryEntry> Entries;
+
+	try {
+		CSimpleFile file {fname, std::ios::in | std::ios::binary};
+		if (file.ReadStringN(CACHE_HEADER.size()) != CACHE_HEADER || file.ReadInt32() != CACHE_VERSION)
+			return false;
+
+		const std::size_t Count = file.ReadUint32();
+		for (std::size_t i = 0; i < Count && file; ++i) {
+			auto &Entry = Entries.emplace_back();
+			Entry.Path = fs::u8path(file.ReadString());
+			Entry.FileSize = ReadInt64(file);
+			Entry.ModifiedTime = static_cast<std::int64_t>(ReadInt64(file));
+			Entry.Valid = file.ReadUint8() != 0;
+			Entry.Type = static_cast<inst_type_t>(file.ReadUint8());
+			Entry.Name = file.ReadString();
+			for (auto &x : Entry.SequenceHashes)
+				x = ReadInt64(file);
+			Entry.SampleCount = file.ReadUint32();
+			Entry.ContentHash = ReadInt64(file);
+		}
+		if (!file)
+			return false;
+	}
+	catch (std::exception &) {
+		return false;
+	}
+
+	std::sort(Entries.begin(), Entries.end(), [] (const auto &a, const auto &b) { return a.Path < b.Path; });
+	m_Entries = std::move(Entries);
+	BuildIndex();
+	return true;
+}
+
+void CInstrumentLibrary::SaveCache(const fs::path &fname) const {
+	CSimpleFile file {fname, std::ios::out | std::ios::binary};
+
+	file.WriteBytes(CACHE_HEADER);
+	file.WriteInt32(CACHE_VERSION);
+	file.WriteInt32(static_cast<std::int32_t>(m_Entries.size()));
+	for (const auto &Entry : m_Entries) {
+		file.WriteString(Entry.Path.u8string());
+		WriteInt64(file, Entry.FileSize);
+		WriteInt64(file, static_cast<std::uint64_t>(Entry.ModifiedTime));
+		file.WriteInt8(Entry.Valid ? 1 : 0);
+		file.WriteInt8(static_cast<std::int8_t>(Entry.Type));
+		file.WriteString(Entry.Name);
+		for (auto x : Entry.SequenceHashes)
+			WriteInt64(file, x);
+		file.WriteInt32(Entry.SampleCount);
+		WriteInt64(file, Entry.ContentHash);
+	}
+
+	if (!file)
+		throw std::runtime_error("Could not write instrument library cache " + fname.u8string());
+	file.Close();
+}
+
+const std::vector<stInstrumentLibraryEntry> &CInstrumentLibrary::GetEntries() const {
+	return m_Entries;
+}
+
+CInstrumentLibrary::entry_list_t CInstrumentLibrary::FindByType(inst_type_t Type) const {
+	entry_list_t List;
+	for (const auto &Entry : m_Entries)
+		if (Entry.Valid && Entry.Type == Type)
+			List.push_back(&Entry);
+	return List;
+}
+
+CInstrumentLibrary::entry_list_t CInstrumentLibrary::FindByName(std::string_view Name) const {
+	const auto eq = [] (unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); };
+	entry_list_t List;
+	for (const auto &Entry : m_Entries)
+		if (Entry.Valid && std::search(Entry.Name.begin(), Entry.Name.end(), Name.begin(), Name.end(), eq) != Entry.Name.end())
+			List.push_back(&Entry);
+	return List;
+}
+
+CInstrumentLibrary::entry_list_t CInstrumentLibrary::FindBySequence(std::uint64_t Hash) const {
+	std::vector<std::size_t> Index;
+	for (auto [b, e] = m_SequenceIndex.equal_range(Hash); b != e; ++b)
+		Index.push_back(b->second);
+	std::sort(Index.begin(), Index.end());
+	Index.erase(std::unique(Index.begin(), Index.end()), Index.end());
+
+	entry_list_t List;
+	for (std::size_t i : Index)
+		List.push_back(&m_Entries[i]);
+	return List;
+}
+
+CInstrumentLibrary::entry_list_t CInstrumentLibrary::FindByContent(std::uint64_t Hash) const {
+	std::vector<std::size_t> Index;
+	for (auto [b, e] = m_ContentIndex.equal_range(Hash); b != e; ++b)
+		Index.push_back(b->second);
+	std::sort(Index.begin(), Index.end());
+
+	entry_list_t List;
+	for (std::size_t i : Index)
+		List.push_back(&m_Entries[i]);
+	return List;
+}
+
+void CInstrumentLibrary::BuildIndex() {
+	m_SequenceIndex.clear();
+	m_ContentIndex.clear();
+	for (std::size_t i = 0; i < m_Entries.size(); ++i) {
+		const auto &Entry = m_Entries[i];
+		if (!Entry.Valid)
+			continue;
+		for (auto x : Entry.SequenceHashes)
+			if (x)
+				m_SequenceIndex.emplace(x, i);
+		m_ContentIndex.emplace(Entry.ContentHash, i);
+	}
+}
@@ -0,0 +1,83 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Instrument.h"
+#include "Sequence.h"
+#include "ft0cc/fs.h"
+
+// // // Portable index of a folder tree of FTI instrument files
+
+struct stInstrumentLibraryEntry {
+	fs::path Path;
+	std::uint64_t FileSize = 0;
+	std::int64_t ModifiedTime = 0;	// Ticks of the file clock, only compared for equality
+	bool Valid = false;				// False if the file could not be read as an instrument
+	inst_type_t Type = INST_NONE;
+	std::string Name;
+	std::array<std::uint64_t, SEQ_COUNT> SequenceHashes = { };	// CSequence::HashContent, 0 if disabled
+	unsigned SampleCount = 0;		// Distinct DPCM samples
+	std::uint64_t ContentHash = 0;	// CInstrument::GetContentHash
+};
+
+class CInstrumentLibrary
+{
+public:
+	using entry_list_t = std::vector<const stInstrumentLibraryEntry *>;
+
+	// Rescans a folder tree on a pool of worker threads; files whose size and
+	// modification time match an existing entry are not read again. Returns
+	// the number of files read
+	std::size_t Scan(const fs::path &Root, unsigned Threads = 1);
+
+	// The on-disk cache holds all entries; loading a cache made by another
+	// version of the index leaves the library empty and returns false
+	bool LoadCache(const fs::path &fname);
+	void SaveCache(const fs::path &fname) const;
+
+	// Entries sorted by path
+	const std::vector<stInstrumentLibraryEntry> &GetEntries() const;
+
+	entry_list_t FindByType(inst_type_t Type) const;
+	entry_list_t FindByName(std::string_view Name) const;	// Case-insensitive substring
+	entry_list_t FindBySequence(std::uint64_t Hash) const;
+	entry_list_t FindByContent(std::uint64_t Hash) const;
+
+	static std::uint64_t GetSequenceHash(const CSequence &seq);
+	static stInstrumentLibraryEntry ReadEntry(const fs::path &fname);
+
+private:
+	void BuildIndex();
+
+	std::vector<stInstrumentLibraryEntry> m_Entries;
+	std::unordered_multimap<std::uint64_t, std::size_t> m_SequenceIndex;
+	std::unordered_multimap<std::uint64_t, std::size_t> m_ContentIndex;
+};
@@ -22,6 +22,7 @@
 
 #include "InstrumentN163.h"		// // //
 #include "Assertion.h"		// // //
+#include "ContentHash.h"		// // //
 
 // // // Default wave
 
@@ -172,3 +173,12 @@ int CInstrumentN163::GetWaveCount() const
 {
 	return m_iWaveCount;
 }
+
+void CInstrumentN163::HashContent(CContentHash &hash) const		// // //
+{
+	CSeqInstrument::HashContent(hash);
+	hash.Add(m_iWaveSize).Add(m_iWavePos).Add(m_iWaveCount);
+	for (int i = 0; i < m_iWaveCount; ++i)
+		for (unsigned j = 0; j < m_iWaveSize; ++j)
+			hash.Add(m_iSamples[i][j]);
+}
@@ -50,6 +50,8 @@ public:
 
 	bool	IsWaveEqual(const CInstrumentN163 &Instrument) const;		// // //
 
+	void	HashContent(CContentHash &hash) const override;		// // //
+
 	bool	InsertNewWave(int Index);		// // //
 	bool	RemoveWave(int Index);		// // //
 
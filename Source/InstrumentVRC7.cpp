@@ -21,6 +21,7 @@
 */
 
 #include "InstrumentVRC7.h"		// // //
+#include "ContentHash.h"		// // //
 #include <cstring>
 
 /*
@@ -80,3 +81,9 @@ unsigned char CInstrumentVRC7::GetCustomReg(int Reg) const		// // //
 {
 	return m_iRegs[Reg];
 }
+
+void CInstrumentVRC7::HashContent(CContentHash &hash) const		// // //
+{
+	CInstrument::HashContent(hash);
+	hash.Add(m_iPatch).Add(m_iRegs);
+}
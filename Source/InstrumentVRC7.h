@@ -38,6 +38,8 @@ public:
 	void		 SetCustomReg(int Reg, unsigned char Value);		// // //
 	unsigned char GetCustomReg(int Reg) const;		// // //
 
+	void	HashContent(CContentHash &hash) const override;		// // //
+
 protected:
 	void	CloneFrom(const CInstrument *pInst) override;		// // //
 
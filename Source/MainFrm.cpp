@@ -85,7 +85,8 @@
 
 namespace {
 
-const unsigned MAX_UNDO_LEVELS = 64;		// // // moved
+const unsigned MAX_UNDO_LEVELS = 1024;		// // // moved
+const std::size_t MAX_UNDO_MEMORY = 64u << 20;		// // // bytes
 const int INST_DIGITS = 2;		// // //
 
 const UINT indicators[] =
@@ -1959,7 +1960,12 @@ void CMainFrame::OnFileImportText()
 
 	if (auto path = GetLoadPath("", "", IDS_FILTER_TXT, L"*.txt")) {
 		try {
-			CTextExport { }.ImportFile(*path, Doc);
+			// begin a new document
+			if (!Doc.OnNewDocument())
+				throw std::runtime_error {"Unable to create new Famitracker document."};
+			CTextExport { }.ImportFile(*path, *Doc.GetModule());		// // //
+			FTEnv.GetSoundGenerator()->AssignModule(*Doc.GetModule());
+			FTEnv.GetSoundGenerator()->ModuleChipChanged();
 		}
 		catch (std::runtime_error err) {
 			AfxMessageBox(conv::to_wide(err.what()).data(), MB_OK | MB_ICONEXCLAMATION);
@@ -1988,8 +1994,9 @@ void CMainFrame::OnFileExportText()
 	auto initPath = FTEnv.GetSettings()->GetPath(PATH_NSF);		// // //
 	if (auto path = GetSavePath(Doc.GetFileTitle(), initPath.c_str(), IDS_FILTER_TXT, L"*.txt")) {
 		CTextExport Exporter;
-		CStringA sResult = Exporter.ExportFile(*path, Doc);
-		if (!sResult.IsEmpty())
+		std::string sResult = Exporter.ExportFile(*path, *Doc.GetModule());		// // //
+		FTEnv.GetSoundGenerator()->ModuleChipChanged();
+		if (!sResult.empty())
 			AfxMessageBox(conv::to_wide(sResult).data(), MB_OK | MB_ICONERROR);
 		Doc.UpdateAllViews(NULL, UPDATE_PROPERTIES);
 	}
@@ -2007,8 +2014,8 @@ void CMainFrame::OnFileExportRows()		// // //
 	auto initPath = FTEnv.GetSettings()->GetPath(PATH_NSF);		// // //
 	if (auto path = GetSavePath(Doc.GetFileTitle(), initPath.c_str(), IDS_FILTER_CSV, L"*.csv")) {
 		CTextExport Exporter;
-		CStringA sResult = Exporter.ExportRows(*path, *Doc.GetModule());
-		if (!sResult.IsEmpty())
+		std::string sResult = Exporter.ExportRows(*path, *Doc.GetModule());		// // //
+		if (!sResult.empty())
 			AfxMessageBox(conv::to_wide(sResult).data(), MB_OK | MB_ICONERROR);
 	}
 }
@@ -2699,7 +2706,7 @@ bool CMainFrame::AddAction(std::unique_ptr<CAction> pAction)		// // //
 
 void CMainFrame::ResetUndo()
 {
-	m_pActionHandler = std::make_unique<CActionHandler>(MAX_UNDO_LEVELS);		// // //
+	m_pActionHandler = std::make_unique<CActionHandler>(MAX_UNDO_LEVELS, MAX_UNDO_MEMORY);		// // //
 }
 
 void CMainFrame::OnEditUndo()
@@ -0,0 +1,169 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#include "MappedFile.h"
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <cerrno>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+[[noreturn]] void ThrowOpenError(std::error_code ec) {
+	throw std::runtime_error {"Unable to open file:\n" + ec.message()};
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+CMappedFile::CMappedFile(const fs::path &fname) {
+	HANDLE hFile = ::CreateFileW(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		ThrowOpenError({static_cast<int>(::GetLastError()), std::system_category()});
+
+	LARGE_INTEGER sz = { };
+	if (!::GetFileSizeEx(hFile, &sz)) {
+		std::error_code ec {static_cast<int>(::GetLastError()), std::system_category()};
+		::CloseHandle(hFile);
+		ThrowOpenError(ec);
+	}
+	if (sz.QuadPart == 0) {		// empty files cannot be mapped
+		::CloseHandle(hFile);
+		return;
+	}
+
+	HANDLE hMapping = ::CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	std::error_code ec {static_cast<int>(::GetLastError()), std::system_category()};
+	::CloseHandle(hFile);
+	if (!hMapping)
+		ThrowOpenError(ec);
+
+	const void *pView = ::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!pView) {
+		ec.assign(static_cast<int>(::GetLastError()), std::system_category());
+		::CloseHandle(hMapping);
+		ThrowOpenError(ec);
+	}
+
+	mapping_ = hMapping;
+	data_ = static_cast<const char *>(pView);
+	size_ = static_cast<std::size_t>(sz.QuadPart);
+}
+
+void CMappedFile::Close() noexcept {
+	if (data_)
+		::UnmapViewOfFile(data_);
+	if (mapping_)
+		::CloseHandle(mapping_);
+	data_ = nullptr;
+	mapping_ = nullptr;
+	size_ = 0;
+}
+
+#else
+
+CMappedFile::CMappedFile(const fs::path &fname) {
+	int fd = ::open(fname.c_str(), O_RDONLY);
+	if (fd == -1)
+		ThrowOpenError({errno, std::generic_category()});
+
+	struct stat st = { };
+	if (::fstat(fd, &st) == -1) {
+		std::error_code ec {errno, std::generic_category()};
+		::close(fd);
+		ThrowOpenError(ec);
+	}
+	if (st.st_size == 0) {		// empty files cannot be mapped
+		::close(fd);
+		return;
+	}
+
+	void *pView = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	std::error_code ec {errno, std::generic_category()};
+	::close(fd);
+	if (pView == MAP_FAILED)
+		ThrowOpenError(ec);
+	::madvise(pView, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+
+	data_ = static_cast<const char *>(pView);
+	size_ = static_cast<std::size_t>(st.st_size);
+}
+
+void CMappedFile::Close() noexcept {
+	if (data_)
+		::munmap(const_cast<char *>(data_), size_);
+	data_ = nullptr;
+	size_ = 0;
+}
+
+#endif
+
+CMappedFile::~CMappedFile() noexcept {
+	Close();
+}
+
+CMappedFile::CMappedFile(CMappedFile &&other) noexcept :
+	data_(std::exchange(other.data_, nullptr)),
+	size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+	, mapping_(std::exchange(other.mapping_, nullptr))
+#endif
+{
+}
+
+CMappedFile &CMappedFile::operator=(CMappedFile &&other) noexcept {
+	if (this != &other) {
+		Close();
+		data_ = std::exchange(other.data_, nullptr);
+		size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+		mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+	}
+	return *this;
+}
+
+std::string_view CMappedFile::GetText() const noexcept {
+	return {data_, size_};
+}
+
+std::size_t CMappedFile::GetSize() const noexcept {
+	return size_;
+}
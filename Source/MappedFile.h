@@ -0,0 +1,54 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include "ft0cc/fs.h"
+
+// // // Read-only view of a whole file mapped into memory
+
+class CMappedFile
+{
+public:
+	CMappedFile() = default;
+	explicit CMappedFile(const fs::path &fname);		// throws std::runtime_error
+	~CMappedFile() noexcept;
+
+	CMappedFile(CMappedFile &&other) noexcept;
+	CMappedFile &operator=(CMappedFile &&other) noexcept;
+
+	std::string_view GetText() const noexcept;
+	std::size_t GetSize() const noexcept;
+
+private:
+	void Close() noexcept;
+
+	const char *data_ = nullptr;
+	std::size_t size_ = 0;
+#ifdef _WIN32
+	void *mapping_ = nullptr;
+#endif
+};
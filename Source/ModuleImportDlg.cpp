@@ -24,14 +24,14 @@
 #include "FamiTrackerDoc.h"
 #include "FamiTrackerModule.h"		// // //
 #include "SongData.h"		// // //
-#include "SoundChipSet.h"		// // //
 #include "FamiTrackerViewMessage.h"		// // //
 #include "FamiTrackerEnv.h"		// // //
-#include "SoundChipService.h"		// // //
 #include "SoundGen.h"		// // //
-#include "ChannelMap.h"		// // //
 #include "ModuleImporter.h"		// // //
 #include "str_conv/str_conv.hpp"		// // //
+#include <thread>		// // //
+#include <future>		// // //
+#include <chrono>		// // //
 
 // CModuleImportDlg dialog
 
@@ -83,21 +83,15 @@ BOOL CModuleImportDlg::OnInitDialog()
 
 void CModuleImportDlg::OnBnClickedOk()
 {
+	if (m_bImporting)		// // //
+		return;
+
 	auto &oldModule = *m_pDocument->GetModule();
 	auto &newModule = *m_pImportedDoc->GetModule();
 
 	// // // union of sound chip configurations
-	CSoundChipSet c1 = newModule.GetSoundChipSet();
-	CSoundChipSet c2 = oldModule.GetSoundChipSet();
-	unsigned n1 = newModule.GetNamcoChannels();
-	unsigned n2 = oldModule.GetNamcoChannels();
-	if (n1 != n2 || c1 != c2) {
-		CSoundChipSet merged = c1.MergedWith(c2);
-		unsigned n163chs = std::max(n1, n2);
-		oldModule.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(merged, n163chs));
-		newModule.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(merged, n163chs));
+	if (CModuleImporter::MergeSoundChips(oldModule, newModule))
 		FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
-	}
 
 	// // // remove non-imported songs in advance
 	unsigned track = 0;
@@ -110,10 +104,22 @@ void CModuleImportDlg::OnBnClickedOk()
 
 	auto instMode = enum_cast<import_mode_t>(static_cast<CComboBox *>(GetDlgItem(IDC_COMBO_IMPORT_INST))->GetCurSel());
 	auto grooveMode = enum_cast<import_mode_t>(static_cast<CComboBox *>(GetDlgItem(IDC_COMBO_IMPORT_GROOVE))->GetCurSel());
-	CModuleImporter importer {*m_pDocument->GetModule(), newModule, instMode, grooveMode};
-	if (importer.Validate()) {
-		importer.DoImport(IsDlgButtonChecked(IDC_IMPORT_DETUNE) == BST_CHECKED);
-
+	CModuleImporter importer {*m_pDocument->GetModule(), newModule, instMode, grooveMode, std::thread::hardware_concurrency(), &m_bCancelImport};		// // //
+	if (import_error_t err = importer.Validate(); err != import_error_t::none) {
+		switch (err) {
+		case import_error_t::track_count:
+			AfxMessageBox(IDS_IMPORT_FAILED, MB_ICONEXCLAMATION); break;
+		case import_error_t::instrument_slots:
+			AfxMessageBox(IDS_IMPORT_INSTRUMENT_COUNT, MB_ICONERROR); break;
+		case import_error_t::groove_slots:
+			AfxMessageBox(IDS_IMPORT_GROOVE_SLOTS, MB_ICONEXCLAMATION); break;
+		case import_error_t::sample_slots:
+			AfxMessageBox(IDS_IMPORT_SAMPLE_SLOTS, MB_ICONEXCLAMATION); break;
+		case import_error_t::sequence_slots:
+			AfxMessageBox(IDS_IMPORT_SEQUENCE_COUNT, MB_ICONERROR); break;
+		}
+	}
+	else if (TranslateSongs(importer) && importer.DoImport(IsDlgButtonChecked(IDC_IMPORT_DETUNE) == BST_CHECKED)) {		// // //
 		// TODO another way to do this?
 		m_pDocument->ModifyIrreversible();		// // //
 		m_pDocument->UpdateAllViews(NULL, UPDATE_TRACK);		// // //
@@ -126,6 +132,35 @@ void CModuleImportDlg::OnBnClickedOk()
 	OnOK();
 }
 
+void CModuleImportDlg::OnCancel() {		// // //
+	if (m_bImporting)
+		m_bCancelImport = true;
+	else
+		CDialog::OnCancel();
+}
+
+bool CModuleImportDlg::TranslateSongs(CModuleImporter &importer) {		// // //
+	// the songs are translated on a worker thread so that the Cancel button stays responsive;
+	// only the imported module changes until this returns
+	GetDlgItem(IDOK)->EnableWindow(FALSE);
+	m_bImporting = true;
+	auto Translated = std::async(std::launch::async, [&] { return importer.TranslateSongs(); });
+	while (Translated.wait_for(std::chrono::milliseconds {10}) != std::future_status::ready)
+		for (MSG msg; ::PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE); ) {
+			if (msg.message == WM_QUIT) {
+				m_bCancelImport = true;
+				::PostQuitMessage(static_cast<int>(msg.wParam));
+				break;
+			}
+			if (!IsDialogMessage(&msg)) {
+				::TranslateMessage(&msg);
+				::DispatchMessageW(&msg);
+			}
+		}
+	m_bImporting = false;
+	return Translated.get();
+}
+
 bool CModuleImportDlg::LoadFile(const fs::path &fname) {		// // //
 	m_pImportedDoc = CFamiTrackerDoc::LoadImportFile(fname.c_str());
 	return m_pImportedDoc != nullptr;
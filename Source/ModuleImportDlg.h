@@ -26,9 +26,11 @@
 #include "stdafx.h"		// // //
 #include "../resource.h"		// // //
 #include <memory>		// // //
+#include <atomic>		// // //
 #include "ft0cc/fs.h"		// // //
 
 class CFamiTrackerDoc;
+class CModuleImporter;		// // //
 
 // CModuleImportDlg dialog
 
@@ -46,9 +48,14 @@ public:
 public:
 	bool LoadFile(const fs::path &fname);		// // //
 
+private:
+	bool TranslateSongs(CModuleImporter &importer);		// // //
+
 private:
 	CFamiTrackerDoc *m_pDocument;
 	std::unique_ptr<CFamiTrackerDoc> m_pImportedDoc;		// // //
+	bool m_bImporting = false;		// // //
+	std::atomic_bool m_bCancelImport {false};		// // // set by the Cancel button while importing
 
 protected:
 	virtual void DoDataExchange(CDataExchange* pDX);    // DDX/DDV support
@@ -60,6 +67,7 @@ protected:
 public:
 	afx_msg void OnBnClickedOk();
 	virtual BOOL OnInitDialog();
+	virtual void OnCancel();		// // //
 	afx_msg void OnBnClickedButtonImportAll();
 	afx_msg void OnBnClickedButtonImportNone();
 };
@@ -22,21 +22,48 @@
 
 #include "ModuleImporter.h"
 #include "FamiTrackerModule.h"
-#include "stdafx.h" // error messages
-#include "../resource.h" // error string IDs
+#include "FamiTrackerEnv.h"		// // //
+#include "SoundChipService.h"		// // //
+#include "SoundChipSet.h"		// // //
+#include "ChannelMap.h"		// // //
+#include "ContentHash.h"		// // //
 #include "Instrument2A03.h"
 #include "InstrumentManager.h"
 #include "DSampleManager.h"
 #include "Sequence.h"
 #include "SongData.h"
 #include "ft0cc/doc/groove.hpp"
+#include "RunParallel.h"		// // //
+#include <algorithm>		// // //
+#include <array>		// // //
+#include <numeric>		// // //
+
+namespace {
+
+std::uint64_t GetGrooveHash(const ft0cc::doc::groove &groove) {
+	CContentHash hash;
+	hash.Add(groove.size());
+	for (auto x : groove)
+		hash.Add(x);
+	return hash.Get();
+}
+
+} // namespace
 
 CModuleImporter::CModuleImporter(CFamiTrackerModule &modfile, CFamiTrackerModule &imported,
-	import_mode_t instMode, import_mode_t grooveMode) :
-	modfile_(modfile), imported_(imported), inst_mode_(instMode), groove_mode_(grooveMode)
+	import_mode_t instMode, import_mode_t grooveMode, unsigned threads, const std::atomic_bool *pCancel) :
+	modfile_(modfile), imported_(imported), inst_mode_(instMode), groove_mode_(grooveMode), threads_(threads), cancel_(pCancel)
 {
 	auto *pInst = modfile_.GetInstrumentManager();
 	auto *pImportedInst = imported_.GetInstrumentManager();
+
+	// // // content hash -> first instrument with these contents and its index, imported ones included
+	std::unordered_map<std::uint64_t, std::pair<unsigned, const CInstrument *>> instHashes;
+	if (inst_mode_ == import_mode_t::import_missing)
+		std::as_const(*pInst).VisitInstruments([&] (const CInstrument &inst, std::size_t i) {
+			instHashes.try_emplace(inst.GetContentHash(), i, &inst);
+		});
+
 	unsigned ii = 0;
 	while (pInst->HasInstrument(ii))
 		++ii;
@@ -51,14 +78,27 @@ CModuleImporter::CModuleImporter(CFamiTrackerModule &modfile, CFamiTrackerModule
 			case import_mode_t::overwrite_all:
 				inst_index_.try_emplace(i, i);
 				break;
-			case import_mode_t::import_missing:
-				if (!pInst->HasInstrument(i))
+			case import_mode_t::import_missing: {		// // //
+				const CInstrument &inst = *pImportedInst->GetInstrument(i);
+				auto [it, inserted] = instHashes.try_emplace(inst.GetContentHash(), i, &inst);
+				if (!inserted && it->second.second->HasSameContent(inst))		// 64-bit hashes may collide
+					inst_index_.try_emplace(i, it->second.first);
+				else if (!pInst->HasInstrument(i))
 					inst_index_.try_emplace(i, i);
+				else if (inserted)
+					instHashes.erase(it);
 				break;
+			}
 			case import_mode_t::none: default:
 				break;
 			}
 
+	std::unordered_map<std::uint64_t, std::pair<unsigned, const ft0cc::doc::groove *>> grooveHashes;		// // //
+	if (groove_mode_ == import_mode_t::import_missing)
+		for (unsigned i = 0; i < MAX_GROOVE; ++i)
+			if (auto pGroove = std::as_const(modfile_).GetGroove(i))
+				grooveHashes.try_emplace(GetGrooveHash(*pGroove), i, pGroove.get());
+
 	unsigned gi = 0;
 	while (modfile_.HasGroove(gi))
 		++gi;
@@ -73,42 +113,73 @@ CModuleImporter::CModuleImporter(CFamiTrackerModule &modfile, CFamiTrackerModule
 			case import_mode_t::overwrite_all:
 				groove_index_.try_emplace(i, i);
 				break;
-			case import_mode_t::import_missing:
-				if (!modfile_.HasGroove(i))
+			case import_mode_t::import_missing: {		// // //
+				const auto &groove = *std::as_const(imported_).GetGroove(i);
+				auto [it, inserted] = grooveHashes.try_emplace(GetGrooveHash(groove), i, &groove);
+				if (!inserted && *it->second.second == groove)		// 64-bit hashes may collide
+					groove_index_.try_emplace(i, it->second.first);
+				else if (!modfile_.HasGroove(i))
 					groove_index_.try_emplace(i, i);
+				else if (inserted)
+					grooveHashes.erase(it);
 				break;
+			}
 			case import_mode_t::none: default:
 				break;
 			}
 }
 
-bool CModuleImporter::Validate() const {
-	if (modfile_.GetSongCount() + imported_.GetSongCount() > MAX_TRACKS) {
-		AfxMessageBox(IDS_IMPORT_FAILED, MB_ICONEXCLAMATION);
+bool CModuleImporter::MergeSoundChips(CFamiTrackerModule &modfile, CFamiTrackerModule &imported) {		// // //
+	CSoundChipSet c1 = imported.GetSoundChipSet();
+	CSoundChipSet c2 = modfile.GetSoundChipSet();
+	unsigned n1 = imported.GetNamcoChannels();
+	unsigned n2 = modfile.GetNamcoChannels();
+	if (n1 == n2 && c1 == c2)
 		return false;
+
+	CSoundChipSet merged = c1.MergedWith(c2);
+	unsigned n163chs = std::max(n1, n2);
+	modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(merged, n163chs));
+	imported.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(merged, n163chs));
+	return true;
+}
+
+std::string_view CModuleImporter::GetErrorMessage(import_error_t err) {		// // //
+	switch (err) {
+	case import_error_t::track_count:
+		return "Import module failed";
+	case import_error_t::instrument_slots:
+		return "Could not import all instruments, out of instrument slots!";
+	case import_error_t::groove_slots:
+		return "Could not import all grooves, out of groove slots!";
+	case import_error_t::sample_slots:
+		return "Could not import all samples, out of sample slots!";
+	case import_error_t::sequence_slots:
+		return "Could not import all sequences, out of sequence slots!";
+	case import_error_t::none: default:
+		return "";
 	}
+}
+
+import_error_t CModuleImporter::Validate() const {
+	if (modfile_.GetSongCount() + imported_.GetSongCount() > MAX_TRACKS)
+		return import_error_t::track_count;
 
 	for (const auto &it : inst_index_)
-		if (it.second >= MAX_INSTRUMENTS) {
-			AfxMessageBox(IDS_IMPORT_INSTRUMENT_COUNT, MB_ICONERROR);
-			return false;
-		}
+		if (it.second >= MAX_INSTRUMENTS)
+			return import_error_t::instrument_slots;
 
 	for (const auto &it : groove_index_)
-		if (it.second >= MAX_GROOVE) {
-			AfxMessageBox(IDS_IMPORT_GROOVE_SLOTS, MB_ICONEXCLAMATION);
-			return false;
-		}
+		if (it.second >= MAX_GROOVE)
+			return import_error_t::groove_slots;
 
 	if (inst_mode_ != import_mode_t::none) {
 		// // // Check DPCM sample count
 		// TODO: allow importing only used samples
 		auto *pSamps = modfile_.GetDSampleManager();
 		auto *pImportedSamps = imported_.GetDSampleManager();		// // //
-		if (pSamps->GetDSampleCount() + pImportedSamps->GetDSampleCount() > MAX_DSAMPLES) {
-			AfxMessageBox(IDS_IMPORT_SAMPLE_SLOTS, MB_ICONEXCLAMATION);
-			return false;
-		}
+		if (pSamps->GetDSampleCount() + pImportedSamps->GetDSampleCount() > MAX_DSAMPLES)
+			return import_error_t::sample_slots;
 
 		const inst_type_t INST[] = {INST_2A03, INST_VRC6, INST_N163, INST_S5B};		// // //
 
@@ -120,22 +191,29 @@ bool CModuleImporter::Validate() const {
 			for (auto t : enum_values<sequence_t>()) {
 				int seqCount = pInsts->GetSequenceCount(i, t);
 				seqCount += pImportedInsts->GetSequenceCount(i, t);
-				if (seqCount > MAX_SEQUENCES) {		// // //
-					AfxMessageBox(IDS_IMPORT_SEQUENCE_COUNT, MB_ICONERROR);
-					return false;
-				}
+				if (seqCount > MAX_SEQUENCES)		// // //
+					return import_error_t::sequence_slots;
 			}
 	}
 
-	return true;
+	return import_error_t::none;
 }
 
-void CModuleImporter::DoImport(bool doDetune) {
+bool CModuleImporter::TranslateSongs() {		// // //
+	if (!translated_)
+		translated_ = TranslateSongsImpl();
+	return translated_;
+}
+
+bool CModuleImporter::DoImport(bool doDetune) {
+	if (!TranslateSongs())		// // // the target module is untouched until here
+		return false;
 	ImportInstruments();
 	ImportGrooves();
 	if (doDetune)
 		ImportDetune();
 	ImportSongs();
+	return true;
 }
 
 void CModuleImporter::ImportInstruments() {
@@ -181,6 +259,9 @@ void CModuleImporter::ImportInstruments() {
 	// Copy instruments
 	pImportedInsts->VisitInstruments([&] (const CInstrument &inst, std::size_t i) {
 		if (auto it = inst_index_.find(i); it != inst_index_.end()) {
+			// // // already present in the module
+			if (inst_mode_ == import_mode_t::import_missing && pInsts->HasInstrument(it->second))
+				return;
 			auto pNewInst = inst.Clone();		// // //
 
 			// Update references
@@ -208,7 +289,8 @@ void CModuleImporter::ImportInstruments() {
 void CModuleImporter::ImportGrooves() {
 	if (groove_mode_ != import_mode_t::none)
 		for (auto [i, gi] : groove_index_)
-			modfile_.SetGroove(gi, imported_.GetGroove(i));
+			if (groove_mode_ != import_mode_t::import_missing || !modfile_.HasGroove(gi))		// // //
+				modfile_.SetGroove(gi, imported_.GetGroove(i));
 }
 
 void CModuleImporter::ImportDetune() {
@@ -217,28 +299,42 @@ void CModuleImporter::ImportDetune() {
 			modfile_.SetDetuneOffset(i, j, imported_.GetDetuneOffset(i, j));
 }
 
-void CModuleImporter::ImportSongs() {
-	imported_.VisitSongs([&] (const CSongData &, unsigned i) {
-		auto pSong = imported_.ReleaseSong(i);		// // //
-		auto &song = *pSong;
-		modfile_.InsertSong(modfile_.GetSongCount(), std::move(pSong));
+bool CModuleImporter::TranslateSongsImpl() {		// // //
+	// flat translation tables, read by all workers
+	std::array<std::uint8_t, MAX_INSTRUMENTS> instTable;
+	std::array<std::uint8_t, MAX_GROOVE> grooveTable;
+	std::iota(instTable.begin(), instTable.end(), 0u);
+	std::iota(grooveTable.begin(), grooveTable.end(), 0u);
+	for (auto [i, ii] : inst_index_)
+		instTable[i] = static_cast<std::uint8_t>(ii);
+	for (auto [i, gi] : groove_index_)
+		grooveTable[i] = static_cast<std::uint8_t>(gi);
+	const bool translate = std::any_of(inst_index_.begin(), inst_index_.end(), [] (auto x) { return x.first != x.second; }) ||
+		std::any_of(groove_index_.begin(), groove_index_.end(), [] (auto x) { return x.first != x.second; });
 
-		// // // translate instruments and grooves outside modules
-		if (song.GetSongGroove())
-			if (auto it = groove_index_.find(song.GetSongSpeed()); it != groove_index_.end())
-				song.SetSongSpeed(it->second);
-		song.VisitPatterns([this] (CPatternData &pat) {
-			pat.VisitRows([this] (stChanNote &note) {
+	if (!translate)
+		return true;
+
+	// songs share no patterns, so each worker can translate its own song in place
+	return RunParallel(imported_.GetSongCount(), threads_, [&] (std::size_t i) {
+		CSongData &song = *imported_.GetSong(i);
+		if (song.GetSongGroove() && song.GetSongSpeed() < MAX_GROOVE)
+			song.SetSongSpeed(grooveTable[song.GetSongSpeed()]);
+		song.VisitPatterns([&] (CPatternData &pat) {
+			pat.VisitRows([&] (stChanNote &note) {
 				// Translate instrument number
 				if (note.Instrument < MAX_INSTRUMENTS)
-					if (auto it = inst_index_.find(note.Instrument); it != inst_index_.end())
-						note.Instrument = it->second;
+					note.Instrument = instTable[note.Instrument];
 				// // // Translate groove commands
 				for (auto &[fx, param] : note.Effects)
 					if (fx == effect_t::GROOVE && param < MAX_GROOVE)
-						if (auto it = groove_index_.find(param); it != groove_index_.end())
-							param = it->second;
+						param = grooveTable[param];
 			});
 		});
-	});
+	}, cancel_);
+}
+
+void CModuleImporter::ImportSongs() {
+	while (auto pSong = imported_.ReleaseSong(0))		// // //
+		modfile_.InsertSong(modfile_.GetSongCount(), std::move(pSong));
 }
@@ -25,7 +25,9 @@
 
 #include <memory>
 #include <unordered_map>
+#include <atomic>		// // //
 #include <cstdint>
+#include <string_view>		// // //
 #include "ft0cc/enum_traits.h"
 
 class CFamiTrackerModule;
@@ -35,15 +37,36 @@ ENUM_CLASS_STANDARD(import_mode_t, std::uint8_t) {
 	min = duplicate_all, max = import_missing,
 };
 
+// // // Reasons an import cannot be done
+enum class import_error_t : std::uint8_t {
+	none, track_count, instrument_slots, groove_slots, sample_slots, sequence_slots,
+};
+
+// // // Portable module importer, shared by the import dialog and command-line tools
+// With import_missing, instruments and grooves whose contents already exist in the
+// module are mapped onto the existing copies instead of being imported.
+// Setting *pCancel stops the song translation; the target module is then left unchanged,
+// but the imported module is partially translated and must be discarded.
 class CModuleImporter {
 public:
 	CModuleImporter(CFamiTrackerModule &modfile, CFamiTrackerModule &imported,
-		import_mode_t instMode, import_mode_t grooveMode);
+		import_mode_t instMode, import_mode_t grooveMode, unsigned threads = 1, const std::atomic_bool *pCancel = nullptr);
+
+	// Gives both modules the union of their sound chips, returns whether the
+	// channel map of the target module has changed; call before constructing an importer
+	static bool MergeSoundChips(CFamiTrackerModule &modfile, CFamiTrackerModule &imported);
+	static std::string_view GetErrorMessage(import_error_t err);
 
-	bool Validate() const;
-	void DoImport(bool doDetune);
+	import_error_t Validate() const;
+	// Translates instrument and groove numbers in the imported songs; touches only the
+	// imported module, so it may run on a worker thread; returns false if cancelled
+	bool TranslateSongs();
+	// Calls TranslateSongs if needed, then moves everything into the target module;
+	// returns false if cancelled
+	bool DoImport(bool doDetune);
 
 private:
+	bool TranslateSongsImpl();
 	void ImportInstruments();
 	void ImportGrooves();
 	void ImportDetune();
@@ -58,4 +81,7 @@ private:
 
 	import_mode_t inst_mode_ = import_mode_t::none;
 	import_mode_t groove_mode_ = import_mode_t::none;
+	unsigned threads_ = 1;		// // //
+	const std::atomic_bool *cancel_ = nullptr;		// // //
+	bool translated_ = false;		// // //
 };
@@ -0,0 +1,195 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "ModulePlayer.h"
+#include "FamiTrackerModule.h"
+#include "SoundDriver.h"
+#include "TempoCounter.h"
+#include "PlayerCursor.h"
+#include "APU/APU.h"
+#include "APU/Types.h"
+#include "AudioDriver.h"
+#include "AudioSink.h"
+#include "WaveRenderer.h"
+#include "SongData.h"
+#include "ChannelOrder.h"
+
+namespace {
+
+// Default mixer settings of the sound configuration page
+const int BASS_FILTER = 30;
+const int TREBLE_FILTER = 12000;
+const int TREBLE_DAMPING = 24;
+const int MIX_VOLUME = 100;
+
+} // namespace
+
+CModulePlayer::CModulePlayer(const CFamiTrackerModule &modfile, unsigned SampleRate) :
+	modfile_(modfile),
+	apu_(std::make_unique<CAPU>()),
+	driver_(std::make_unique<CSoundDriver>(this)),
+	tempo_(std::make_shared<CTempoCounter>(modfile))
+{
+	const machine_t Machine = modfile_.GetMachine();
+	const unsigned Rate = modfile_.GetFrameRate();
+	update_cycles_ = (Machine == machine_t::NTSC ? MASTER_CLOCK_NTSC : MASTER_CLOCK_PAL) / Rate;
+
+	apu_->SetupSound(SampleRate, 1, Machine);
+	apu_->SetupMixer(BASS_FILTER, TREBLE_FILTER, TREBLE_DAMPING, MIX_VOLUME);
+	apu_->ChangeMachineRate(Machine, Rate);
+	apu_->SetExternalSound(modfile_.GetSoundChipSet());
+
+	driver_->SetupTracks();
+	driver_->AssignModule(modfile_);
+	driver_->LoadAPU(*apu_);
+	driver_->SetTempoCounter(tempo_);
+	driver_->ConfigureDocument();
+	driver_->ResetTracks();		// the driver runs before the renderer starts the player
+}
+
+CModulePlayer::~CModulePlayer() {
+}
+
+bool CModulePlayer::Render(unsigned Track, CWaveRenderer &Renderer, std::unique_ptr<CAudioSink> pSink, const std::atomic_bool *pCancel) {
+	// Same sequence as the sound generator: the renderer starts the player after a few
+	// silent frames and lets the song fade out for a few frames after it stops
+	CAudioDriver Driver {[this] { return RenderFrame(); }, std::move(pSink)};
+	if (!Driver.IsAudioDeviceOpen())
+		return false;
+	apu_->SetCallback(Driver);
+
+	renderer_ = &Renderer;
+	track_ = Track;
+	done_ = false;
+
+	apu_->Reset();
+	Renderer.Start();
+
+	bool Success = true;
+	while (!done_) {
+		if ((pCancel && *pCancel) || !Driver.Pump()) {
+			Success = false;
+			break;
+		}
+	}
+
+	driver_->StopPlayer();
+	renderer_ = nullptr;
+	return Success;
+}
+
+bool CModulePlayer::RenderFrame() {
+	// Runs the player for one frame, see CSoundGen::RenderFrame
+	if (renderer_ && !done_) {
+		if (renderer_->ShouldStopRender())
+			done_ = true;
+		else if (renderer_->ShouldStartPlayer())
+			BeginPlayer();
+	}
+
+	driver_->Tick();
+	UpdateAPU();
+
+	if (driver_->ShouldHalt()) {
+		MakeSilent();
+		driver_->StopPlayer();
+	}
+
+	return true;
+}
+
+void CModulePlayer::BeginPlayer() {
+	// See CSoundGen::BeginPlayer
+	const CSongData &Song = *modfile_.GetSong(track_);
+	driver_->StartPlayer(std::make_unique<CPlayerCursor>(Song, track_));
+	tempo_->LoadTempo(Song);
+	ResetAPU();
+	MakeSilent();
+}
+
+void CModulePlayer::UpdateAPU() {
+	// Spreads the register writes of each channel over the frame, see CSoundGen::UpdateAPU
+	int Cycles = update_cycles_;
+	sound_chip_t LastChip = sound_chip_t::none;
+
+	driver_->ForeachTrack([&] (CChannelHandler &, CTrackerChannel &, stChannelID ID) {
+		if (modfile_.GetChannelOrder().HasChannel(ID)) {
+			int Delay = (ID.Chip == LastChip) ? 150 : 250;
+			if (Delay < Cycles) {
+				Cycles -= Delay;
+				apu_->AddTime(Delay);
+			}
+			LastChip = ID.Chip;
+		}
+		apu_->Process();
+	});
+
+	apu_->AddTime(Cycles);
+	apu_->Process();
+	apu_->EndFrame();
+}
+
+void CModulePlayer::ResetAPU() {
+	// Enables all channels, see CSoundGen::ResetAPU
+	apu_->Reset();
+	apu_->Write(0x4015, 0x0F);
+	apu_->Write(0x4017, 0x00);
+	apu_->Write(0x4023, 0x02);
+	apu_->Write(0x5015, 0x03);
+}
+
+void CModulePlayer::MakeSilent() {
+	apu_->Reset();
+	driver_->ResetTracks();
+}
+
+CInstrumentManager *CModulePlayer::GetInstrumentManager() const {
+	return modfile_.GetInstrumentManager();
+}
+
+void CModulePlayer::OnTick() {
+	if (renderer_)
+		renderer_->Tick();
+}
+
+void CModulePlayer::OnStepRow() {
+	if (renderer_)
+		renderer_->StepRow();
+}
+
+void CModulePlayer::OnPlayNote(stChannelID, const stChanNote &) {
+}
+
+void CModulePlayer::OnUpdateRow(int, int) {
+}
+
+bool CModulePlayer::IsChannelMuted(stChannelID) const {
+	return false;
+}
+
+bool CModulePlayer::ShouldStopPlayer() const {
+	return renderer_ && renderer_->ShouldStopPlayer();
+}
+
+int CModulePlayer::GetArpNote(stChannelID) const {
+	return -1;
+}
@@ -0,0 +1,89 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include "SoundGenBase.h"
+
+class CFamiTrackerModule;
+class CSoundDriver;
+class CTempoCounter;
+class CAPU;
+class CAudioSink;
+class CWaveRenderer;
+
+// // // Plays a module without a window or audio device, for batch rendering
+
+/*!
+	\brief A headless counterpart of the sound generator, running the sound driver and the APU
+	emulation on the calling thread.
+	\details Each player frame is timed like the tracker's own player, so a rendered song is
+	identical to the output of the wave export dialog with the same sound settings.
+*/
+class CModulePlayer final : public CSoundGenBase {
+public:
+	/*!	\brief Constructor of the player, using the default sound settings of the tracker.
+		\param modfile The module to play. It must outlive the player and must not change while
+		a song is rendered.
+		\param SampleRate The output sample rate. */
+	CModulePlayer(const CFamiTrackerModule &modfile, unsigned SampleRate);
+	~CModulePlayer();
+
+	/*!	\brief Plays a song into an audio sink until the renderer stops it.
+		\param Track The song index.
+		\param Renderer Decides the length of the output, its output stream is not used.
+		\param pSink The audio output, whose sample rate must match that of the player.
+		\param pCancel If not null, rendering stops as soon as this flag is set.
+		\return False if the sink failed or rendering was cancelled. */
+	bool Render(unsigned Track, CWaveRenderer &Renderer, std::unique_ptr<CAudioSink> pSink, const std::atomic_bool *pCancel = nullptr);
+
+private:
+	CInstrumentManager *GetInstrumentManager() const override;
+	void OnTick() override;
+	void OnStepRow() override;
+	void OnPlayNote(stChannelID chan, const stChanNote &note) override;
+	void OnUpdateRow(int frame, int row) override;
+	bool IsChannelMuted(stChannelID chan) const override;
+	bool ShouldStopPlayer() const override;
+	int GetArpNote(stChannelID chan) const override;
+
+	bool RenderFrame();
+	void BeginPlayer();
+	void UpdateAPU();
+	void ResetAPU();
+	void MakeSilent();
+
+private:
+	const CFamiTrackerModule &modfile_;
+	std::unique_ptr<CAPU> apu_;
+	std::unique_ptr<CSoundDriver> driver_;
+	std::shared_ptr<CTempoCounter> tempo_;
+
+	CWaveRenderer *renderer_ = nullptr;
+	unsigned track_ = 0;
+	bool done_ = false;
+	int update_cycles_ = 0;
+};
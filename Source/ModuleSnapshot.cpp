@@ -0,0 +1,131 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#include "ModuleSnapshot.h"
+#include "FamiTrackerModule.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SoundChipSet.h"
+#include "SongData.h"
+#include "SongDirtyRows.h"
+#include "ft0cc/doc/groove.hpp"
+#include <utility>
+
+CModuleSnapshot::CModuleSnapshot(const CFamiTrackerModule &modfile, std::uint64_t Version,
+	const CModuleSnapshot *pPrevious, bool PreviousUnseen) :
+	modfile_(std::make_unique<CFamiTrackerModule>()), version_(Version)
+{
+	auto pMap = std::make_unique<CChannelMap>(modfile.GetSoundChipSet(), modfile.GetNamcoChannels());
+	pMap->GetChannelOrder() = modfile.GetChannelOrder();
+	modfile_->SetChannelMap(std::move(pMap));
+
+	modfile_->SetMachine(modfile.GetMachine());
+	modfile_->SetEngineSpeed(modfile.GetEngineSpeed());
+	modfile_->SetVibratoStyle(modfile.GetVibratoStyle());
+	modfile_->SetLinearPitch(modfile.GetLinearPitch());
+	modfile_->SetSpeedSplitPoint(modfile.GetSpeedSplitPoint());
+	for (int chip = 0; chip < 6; ++chip)
+		for (int note = 0; note < NOTE_COUNT; ++note)
+			modfile_->SetDetuneOffset(chip, note, modfile.GetDetuneOffset(chip, note));
+	modfile_->SetTuning(modfile.GetTuningSemitone(), modfile.GetTuningCent());
+
+	modfile.VisitSongs([&] (const CSongData &song, unsigned index) {
+		if (index == 0)
+			modfile_->ReplaceSong(0, std::make_unique<CSongData>(song));
+		else
+			modfile_->InsertSong(index, std::make_unique<CSongData>(song));
+	});
+
+	// grooves are replaced rather than modified by the editor
+	for (unsigned i = 0; i < MAX_GROOVE; ++i)
+		modfile_->SetGroove(i, std::const_pointer_cast<ft0cc::doc::groove>(modfile.GetGroove(i)));
+
+	// rows changed since the snapshot the player holds, including those of a skipped snapshot
+	const CFamiTrackerModule *pOldModule = pPrevious ? pPrevious->modfile_.get() : nullptr;
+	const auto IsSameOrder = [] (const CChannelOrder &x, const CChannelOrder &y) {
+		if (x.GetChannelCount() != y.GetChannelCount())
+			return false;
+		for (std::size_t i = 0, n = x.GetChannelCount(); i < n; ++i)
+			if (x.TranslateChannel(i) != y.TranslateChannel(i))
+				return false;
+		return true;
+	};
+	const bool SameOrder = pOldModule && IsSameOrder(pOldModule->GetChannelOrder(), modfile_->GetChannelOrder());
+	modfile_->VisitSongs([&] (CSongData &song, unsigned index) {
+		CSongDirtyRows &Dirty = song.GetDirtyRows();
+		const CSongData *pOld = pOldModule ? pOldModule->GetSong(index) : nullptr;
+		if (!pOld || !SameOrder)
+			Dirty.MarkAll();
+		else {
+			Dirty = CSongDirtyRows::Compare(*pOld, song);
+			if (PreviousUnseen)
+				Dirty.Merge(pOld->GetDirtyRows());
+		}
+	});
+}
+
+CModuleSnapshot::~CModuleSnapshot() noexcept {
+}
+
+const CFamiTrackerModule &CModuleSnapshot::GetModule() const noexcept {
+	return *modfile_;
+}
+
+std::uint64_t CModuleSnapshot::GetVersion() const noexcept {
+	return version_;
+}
+
+
+
+CModuleSnapshotPublisher::~CModuleSnapshotPublisher() noexcept {
+	DestroyRetired();
+	delete pending_.load();
+	delete current_;
+}
+
+void CModuleSnapshotPublisher::Publish(const CFamiTrackerModule &modfile) {
+	DestroyRetired();
+	// the last snapshot is either pending or held by the player, so it is still alive here
+	const bool Unseen = last_ && pending_.load(std::memory_order_acquire) == last_;
+	auto *pSnapshot = new CModuleSnapshot {modfile, ++version_, last_, Unseen};
+	last_ = pSnapshot;
+	delete pending_.exchange(pSnapshot, std::memory_order_acq_rel);
+}
+
+const CModuleSnapshot *CModuleSnapshotPublisher::Acquire() noexcept {
+	if (CModuleSnapshot *pSnapshot = pending_.exchange(nullptr, std::memory_order_acq_rel)) {
+		if (current_) {
+			current_->next_ = retired_.load(std::memory_order_relaxed);
+			while (!retired_.compare_exchange_weak(current_->next_, current_, std::memory_order_release, std::memory_order_relaxed))
+				;
+		}
+		current_ = pSnapshot;
+	}
+	return current_;
+}
+
+void CModuleSnapshotPublisher::DestroyRetired() noexcept {
+	CModuleSnapshot *pSnapshot = retired_.exchange(nullptr, std::memory_order_acquire);
+	while (pSnapshot)
+		delete std::exchange(pSnapshot, pSnapshot->next_);
+}
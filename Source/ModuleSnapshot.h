@@ -0,0 +1,92 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+class CFamiTrackerModule;
+
+// // // Module snapshots handed from the editor to the sound player
+
+/*!
+	\brief A read-only copy of the module data used by the sound player.
+	\details Songs share their pattern rows with the module they are copied from until the module
+	modifies them, so taking a snapshot only copies frame lists and settings. Instruments, sequences
+	and samples are not part of the snapshot. Each song records the rows changed since the snapshot
+	last seen by the player.
+*/
+class CModuleSnapshot {
+public:
+	/*!	\brief Constructor of the module snapshot.
+		\param modfile The module.
+		\param Version The snapshot version, increasing with every snapshot published.
+		\param pPrevious The previously published snapshot, or nullptr.
+		\param PreviousUnseen Whether the player may not have picked up the previous snapshot. */
+	CModuleSnapshot(const CFamiTrackerModule &modfile, std::uint64_t Version,
+		const CModuleSnapshot *pPrevious = nullptr, bool PreviousUnseen = false);
+	~CModuleSnapshot() noexcept;
+
+	const CFamiTrackerModule &GetModule() const noexcept;
+	std::uint64_t GetVersion() const noexcept;
+
+private:
+	std::unique_ptr<CFamiTrackerModule> modfile_;
+	std::uint64_t version_;
+
+	friend class CModuleSnapshotPublisher;
+	CModuleSnapshot *next_ = nullptr;		// Retired snapshots waiting to be destroyed
+};
+
+/*!
+	\brief Hands module snapshots from the editor thread to the player thread without locking.
+	\details Snapshots are always destroyed on the editor thread, since destroying a snapshot
+	releases pattern rows that the editor may otherwise copy on write.
+*/
+class CModuleSnapshotPublisher {
+public:
+	CModuleSnapshotPublisher() = default;
+	CModuleSnapshotPublisher(const CModuleSnapshotPublisher &) = delete;
+	~CModuleSnapshotPublisher() noexcept;
+
+	/*!	\brief Publishes a snapshot of the module, replacing one not yet picked up by the player.
+		\details Called from the editor thread only. Snapshots retired by the player are destroyed.
+		\param modfile The module. */
+	void Publish(const CFamiTrackerModule &modfile);
+
+	/*!	\brief Picks up the latest published snapshot. Called from the player thread only.
+		\return The snapshot, which remains valid until a later call returns a different one, or
+		nullptr if nothing has been published yet. */
+	const CModuleSnapshot *Acquire() noexcept;
+
+private:
+	void DestroyRetired() noexcept;
+
+	std::atomic<CModuleSnapshot *> pending_ {nullptr};
+	std::atomic<CModuleSnapshot *> retired_ {nullptr};		// Linked through CModuleSnapshot::next_
+	CModuleSnapshot *current_ = nullptr;		// Owned by the player thread
+	const CModuleSnapshot *last_ = nullptr;		// Pending or current, used by the editor thread
+	std::uint64_t version_ = 0u;
+};
@@ -57,12 +57,13 @@ std::string GetNoteString(note_t note, int octave) {
 	case note_t::echo:
 		return "^-"s + std::to_string(octave);
 	default:
-		if (is_note(note))
+		if (is_note(note)) {		// // //
 #ifndef AFL_FUZZ_ENABLED
-			return std::string((FTEnv.GetSettings()->Appearance.bDisplayFlats ? NOTE_NAME_FLAT : NOTE_NAME)[value_cast(note) - 1]) + std::to_string(octave);
-#else
-			return std::string((NOTE_NAME)[value_cast(note) - 1]) + std::to_string(octave);
+			if (const CSettings *pSettings = FTEnv.GetSettings(); pSettings && pSettings->Appearance.bDisplayFlats)		// // // no settings in portable builds
+				return std::string(NOTE_NAME_FLAT[value_cast(note) - 1]) + std::to_string(octave);
 #endif
+			return std::string((NOTE_NAME)[value_cast(note) - 1]) + std::to_string(octave);
+		}
 		return "..."s;
 	}
 }
@@ -28,8 +28,6 @@
 #include "SoundGen.h"
 #include "APU/DPCM.h"
 #include "FileDialogs.h"		// // //
-#include "resampler/resample.hpp"
-#include "resampler/resample.inl"
 #include <algorithm>		// // //
 #include "str_conv/str_conv.hpp"		// // //
 #include <MMSystem.h>		// // //
@@ -37,103 +35,6 @@
 const int CPCMImport::QUALITY_RANGE = 16;
 const int CPCMImport::VOLUME_RANGE = 12;		// +/- dB
 
-// Implement a resampler using CRTP idiom
-class resampler : public jarh::resample<resampler>
-{
-	typedef jarh::resample<resampler> base;
-public:
-	resampler(const jarh::sinc &sinc, float ratio, int channels, int smpsize,
-			  size_t nbsamples, CFile &cfile)
-	// TODO: cutoff is currently fixed to a value (.9f), make it modifiable.
-	 : base(sinc), channels_(channels), smpsize_(smpsize),
-	   nbsamples_(nbsamples), remain_(nbsamples), cfile_(cfile)
-	{
-		init(ratio, .9f);
-	}
-
-	bool initstream()
-	{
-		// Don't seek to the begin of wave chunk, as it is already done.
-		// This stream will not be reinitialized, then.
-		remain_ = nbsamples_;
-		return true;
-	}
-
-	float *fill(float *first, float *end)
-	{
-		int val;
-		for(;first != end && remain_ && ReadSample(val); ++first, --remain_)
-		{
-			*first = (float)val;
-		}
-		return first;
-	}
-
-private:
-	bool ReadSample(int &v)
-	{
-		int ret = 0, nbytes = 0;
-		if (smpsize_ == 2) {
-			// 16 bit samples
-			short sample_word[2];
-			if (channels_ == 2) {
-				ret = cfile_.Read(sample_word, nbytes = 2*sizeof(short));
-				v = (sample_word[0] + sample_word[1]) / 2;
-			}
-			else {
-				ret = cfile_.Read(sample_word, nbytes = sizeof(short));
-				v = *sample_word;
-			}
-		}
-		else if (smpsize_ == 1) {
-			// 8 bit samples
-			unsigned char sample_byte[2];
-			if (channels_ == 2) {
-				ret = cfile_.Read(sample_byte, nbytes = 2);
-				// convert to a proper signed representation
-				// shift left only by 7; because we want a mean
-				v = ((int)sample_byte[0] + (int)sample_byte[1] - 256) << 7;
-			}
-			else {
-				ret = cfile_.Read(sample_byte, nbytes = 1);
-				v = ((int)(*sample_byte) - 128) << 8;
-			}
-		}
-		else if (smpsize_ == 3) {
-			// 24 bit samples
-	        unsigned char sample_byte[6];
-			if (channels_ == 2) {
-				ret = cfile_.Read(sample_byte, nbytes = 6);
-				v = (*((signed short*)(sample_byte + 1)) + *((signed short*)(sample_byte + 4))) / 2;
-			}
-			else {
-				ret = cfile_.Read(sample_byte, nbytes = 3);
-				v = *((signed short*)(sample_byte + 1));
-			}
-		}
-		else if (smpsize_ == 4) {
-			// 32 bit samples
-	        int sample_word[2];
-			if (channels_ == 2) {
-				ret = cfile_.Read(sample_word, nbytes = 8);
-				v = ((sample_word[0] >> 16) + (sample_word[1] >> 16)) / 2;
-			}
-			else {
-				ret = cfile_.Read(sample_word, nbytes = 4);
-				v = sample_word[0] >> 16;
-			}
-		}
-
-		return ret == nbytes;
-	}
-
-	CFile &cfile_;
-	int    channels_;
-	int    smpsize_;
-	size_t nbsamples_;
-	size_t remain_;
-};
-
 // Derive a new class from CFileDialog with implemented preview of audio files
 
 class CFileSoundDialog : public CFileDialog
@@ -171,8 +72,7 @@ CPCMImport::CPCMImport(CWnd* pParent /*=NULL*/)
 	: CDialog(CPCMImport::IDD, pParent),
 	m_pCachedSample(NULL),
 	m_iCachedQuality(0),
-	m_iCachedVolume(0),
-	m_psinc(std::make_unique<jarh::sinc>(512, 32)) // sinc object. TODO: parametrise
+	m_iCachedVolume(0)
 {
 }
 
@@ -218,8 +118,7 @@ std::shared_ptr<ft0cc::doc::dpcm_sample> CPCMImport::ShowDialog() {		// // //
 
 	CDialog::DoModal();
 
-	// Close file
-	m_fSampleFile.Close();
+	m_Wave = stPCMWave { };		// // //
 
 	return m_pImported;
 }
@@ -316,9 +215,9 @@ void CPCMImport::OnBnClickedPreview()
 void CPCMImport::UpdateFileInfo()
 {
 	SetDlgItemTextW(IDC_SAMPLE_RATE, AfxFormattedW(IDS_DPCM_IMPORT_WAVE_FORMAT,
-		FormattedW(L"%i", m_iSamplesPerSec),
-		FormattedW(L"%i", m_iSampleSize * 8),
-		(m_iChannels == 2) ? L"Stereo" : L"Mono"));		// // //
+		FormattedW(L"%u", m_Wave.SampleRate),		// // //
+		FormattedW(L"%u", m_Wave.SampleSize * 8),
+		(m_Wave.Channels == 2) ? L"Stereo" : L"Mono"));		// // //
 
 	float base_freq = (float)MASTER_CLOCK_NTSC / (float)CDPCM::DMC_PERIODS_NTSC[m_iQuality];
 
@@ -341,190 +240,25 @@ std::shared_ptr<ft0cc::doc::dpcm_sample> CPCMImport::GetSample() {		// // //
 
 std::shared_ptr<ft0cc::doc::dpcm_sample> CPCMImport::ConvertFile() {		// // //
 	// Converts a WAV file to a DPCM sample
-	const int DMC_BIAS = 32;
-
-	unsigned char DeltaAcc = 0;	// DPCM sample accumulator
-	int Delta = DMC_BIAS;		// Delta counter
-	int AccReady = 8;
-
-	float volume = powf(10, float(m_iVolume) / 20.0f);		// Convert dB to linear
-
-	// Seek to start of samples
-	m_fSampleFile.Seek(m_ullSampleStart, CFile::begin);
-
-	// Allocate space
-	std::vector<uint8_t> pSamples(ft0cc::doc::dpcm_sample::max_size);		// // //
-
-	// Determine resampling factor
-	float base_freq = (float)MASTER_CLOCK_NTSC / (float)CDPCM::DMC_PERIODS_NTSC[m_iQuality];
-	float resample_factor = base_freq / (float)m_iSamplesPerSec;
-
-	resampler resmpler(*m_psinc, resample_factor, m_iChannels, m_iSampleSize, m_iWaveSize, m_fSampleFile);
-	float val;
-	// Conversion
-	while (resmpler.get(val) && (pSamples.size() < ft0cc::doc::dpcm_sample::max_size)) {		// // //
-
-		// when resampling we must clip because of possible ringing.
-		const float MAX_AMP =  (1 << 16) - 1;
-		const float MIN_AMP = -(1 << 16) + 1; // just being symetric
-		val = std::clamp(val, MIN_AMP, MAX_AMP);
-
-		// Volume done this way so it acts as before
-		int Sample = (int)((val * volume) / 1024.f) + DMC_BIAS;
-
-		DeltaAcc >>= 1;
-
-		// PCM -> DPCM
-		if (Sample >= Delta) {
-			++Delta;
-			if (Delta > 63)
-				Delta = 63;
-			DeltaAcc |= 0x80;
-		}
-		else if (Sample < Delta) {
-			--Delta;
-			if (Delta < 0)
-				Delta = 0;
-		}
-
-		if (--AccReady == 0) {
-			// Store sample
-			pSamples.push_back(DeltaAcc);
-			AccReady = 8;
-		}
-	}
-
-	// TODO: error handling with th efile
-	// if (!resmpler.eof())
-	//      throw ?? or something else.
-
-	// Adjust sample until size is x * $10 + 1 bytes
-	while (pSamples.size() < ft0cc::doc::dpcm_sample::max_size && ((pSamples.size() & 0x0F) - 1) != 0)		// // //
-		pSamples.push_back(0xAA);
-
-	// Center end of sample (not yet working)
-#if 0
-	int CenterPos = (iSamples << 3) - 1;
-	while (Delta != DMC_BIAS && CenterPos > 0) {
-		if (Delta > DMC_BIAS) {
-			int BitPos = CenterPos & 0x07;
-			if ((pSamples[CenterPos >> 3] & (1 << BitPos)))
-				--Delta;
-			pSamples[CenterPos >> 3] = pSamples[CenterPos >> 3] & ~(1 << BitPos);
-		}
-		else if (Delta < DMC_BIAS) {
-			int BitPos = CenterPos & 0x07;
-			if ((pSamples[CenterPos >> 3] & (1 << BitPos)) == 0)
-				++Delta;
-			pSamples[CenterPos >> 3] = pSamples[CenterPos >> 3] | (1 << BitPos);
-		}
-		--CenterPos;
-	}
-#endif
-
-	// Return a sample object
-	return std::make_shared<ft0cc::doc::dpcm_sample>(std::move(pSamples), "");		// // //
+	return CDPCMConverter {static_cast<unsigned>(m_iQuality), m_iVolume}.Convert(m_Wave);
 }
 
 bool CPCMImport::OpenWaveFile()
 {
-	// Open and read wave file header
-	PCMWAVEFORMAT WaveFormat = { };		// // //
-	char Header[4] = { };
-	bool Scanning = true;
-	bool WaveFormatFound = false;
-	bool ValidWave = false;
-	unsigned int BlockSize;
-	unsigned int FileSize;
-	CFileException ex;
-
-	m_iWaveSize = 0;
-	m_ullSampleStart = 0;
-
+	// // // Read and mix down the whole wave file
 	TRACE(L"DPCM import: Loading wave file %s...\n", (LPCWSTR)m_strPath);
 
-	if (!m_fSampleFile.Open(m_strPath, CFile::modeRead, &ex)) {
-		WCHAR szCause[255] = { };
-		ex.GetErrorMessage(szCause, std::size(szCause));
-		AfxMessageBox(FormattedW(L"Could not open file: %s", szCause));		// // //
-		return false;
-	}
-
-	m_fSampleFile.Read(Header, 4);
-
-	if (memcmp(Header, "RIFF", 4) != 0) {
-		// Invalid format
-		Scanning = false;
-		ValidWave = false;
-	}
-	else {
-		// Read file size
-		m_fSampleFile.Read(&FileSize, 4);
-	}
-
-	// Now improved, should handle most files
-	while (Scanning) {
-		if (m_fSampleFile.Read(Header, 4) < 4) {
-			Scanning = false;
-			TRACE(L"DPCM import: End of file reached\n");
-		}
-
-		if (!memcmp(Header, "WAVE", 4)) {
-			ValidWave = true;
-		}
-		else if (Scanning) {
-			m_fSampleFile.Read(&BlockSize, 4);
-
-			if (!memcmp(Header, "fmt ", 4)) {
-				// Read the wave-format
-				TRACE(L"DPCM import: Found fmt block\n");
-				int ReadSize = BlockSize;
-				if (ReadSize > sizeof(PCMWAVEFORMAT))
-					ReadSize = sizeof(PCMWAVEFORMAT);
-
-				m_fSampleFile.Read(&WaveFormat, ReadSize);
-				m_fSampleFile.Seek(BlockSize - ReadSize, CFile::current);
-				WaveFormatFound = true;
-
-				if (WaveFormat.wf.wFormatTag != WAVE_FORMAT_PCM) {
-					// Invalid audio format
-					Scanning = false;
-					ValidWave = false;
-					TRACE(L"DPCM import: Unrecognized wave format (%i)\n", WaveFormat.wf.wFormatTag);
-				}
-
-			}
-			else if (!memcmp(Header, "data", 4)) {
-				// Actual wave-data, store the position
-				TRACE(L"DPCM import: Found data block\n");
-				m_iWaveSize = BlockSize;
-				m_ullSampleStart = m_fSampleFile.GetPosition();
-				m_fSampleFile.Seek(BlockSize, CFile::current);
-			}
-			else {
-				// Unrecognized block
-				TRACE(L"DPCM import: Unrecognized block %c%c%c%c\n", Header[0], Header[1], Header[2], Header[3]);
-				m_fSampleFile.Seek(BlockSize, CFile::current);
-			}
-		}
+	try {
+		m_Wave = CDPCMConverter::ReadWaveFile((LPCWSTR)m_strPath);
 	}
-
-	if (!ValidWave || !WaveFormatFound || m_iWaveSize == 0) {
+	catch (std::runtime_error &e) {
 		// Failed to load file properly, display error message and quit
-		TRACE(L"DPCM import: Unsupported or invalid wave file\n");
-		m_fSampleFile.Close();
+		TRACE(L"DPCM import: %S\n", e.what());
 		AfxMessageBox(IDS_DPCM_IMPORT_INVALID_WAVEFILE, MB_ICONEXCLAMATION);
 		return false;
 	}
 
-	// Save file info
-	m_iChannels		  = WaveFormat.wf.nChannels;
-	m_iSampleSize	  = WaveFormat.wf.nBlockAlign / WaveFormat.wf.nChannels;
-	m_iBlockAlign	  = WaveFormat.wf.nBlockAlign;
-	m_iAvgBytesPerSec = WaveFormat.wf.nAvgBytesPerSec;
-	m_iSamplesPerSec  = WaveFormat.wf.nSamplesPerSec;
-
-	TRACE(L"DPCM import: Scan done (%i Hz, %i bits, %i channels)\n", m_iSamplesPerSec, m_iSampleSize, m_iChannels);
+	TRACE(L"DPCM import: Scan done (%u Hz, %u bits, %u channels)\n", m_Wave.SampleRate, m_Wave.SampleSize * 8, m_Wave.Channels);
 
 	return true;
 }
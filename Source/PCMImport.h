@@ -25,15 +25,12 @@
 #include "stdafx.h"		// // //
 #include "../resource.h"		// // //
 #include <memory>		// // //
+#include "DPCMConverter.h"		// // //
 
 namespace ft0cc::doc {
 class dpcm_sample;
 } // namespace ft0cc::doc
 
-namespace jarh {
-	class sinc;
-}
-
 class CPCMImport : public CDialog
 {
 	DECLARE_DYNAMIC(CPCMImport)
@@ -52,21 +49,12 @@ protected:
 	std::shared_ptr<ft0cc::doc::dpcm_sample> m_pCachedSample;
 
 	CStringW		m_strPath, m_strFileName;
-	CFile		m_fSampleFile;
-	ULONGLONG	m_ullSampleStart;
+	stPCMWave	m_Wave;		// // //
 
 	int m_iQuality;
 	int m_iVolume;
-	int m_iSampleSize;
-	int m_iChannels;
-	int m_iBlockAlign;
-	int m_iAvgBytesPerSec;
-	int m_iSamplesPerSec;
 	int m_iCachedQuality;
 	int m_iCachedVolume;
-	unsigned int m_iWaveSize;
-
-	std::unique_ptr<jarh::sinc> m_psinc;		// // //
 
 protected:
 	static const int QUALITY_RANGE;
@@ -223,6 +223,41 @@ std::pair<CPatternIterator, CPatternIterator> CPatternAction::GetIterators(CSong
 		CPatternIterator::FromCursor(m_pUndoState->Cursor, view);
 }
 
+void CPatternAction::SaveRegion(const CMainFrame &MainFrm, const CSelection &Sel)		// // //
+{
+	m_UndoClipData = GET_PATTERN_EDITOR()->CopyRaw(Sel);
+	m_region = Sel;
+	m_bRegion = true;
+}
+
+bool CPatternAction::UndoRegion(CMainFrame &MainFrm) const		// // //
+{
+	if (!m_pDelta)
+		return false;
+	m_pDelta->Undo(*GET_SONG_VIEW());
+	return true;
+}
+
+bool CPatternAction::RedoRegion(CMainFrame &MainFrm) const		// // //
+{
+	if (!m_pDelta)
+		return false;
+	m_pDelta->Redo(*GET_SONG_VIEW());
+	return true;
+}
+
+std::size_t CPatternAction::GetFootprint() const		// // //
+{
+	std::size_t Size = sizeof(CPatternAction) + m_ClipData.GetFootprint() + m_UndoClipData.GetFootprint();
+	if (m_pUndoState)
+		Size += sizeof(CPatternEditorState);
+	if (m_pRedoState)
+		Size += sizeof(CPatternEditorState);
+	if (m_pDelta)
+		Size += sizeof(CPatternDelta) + m_pDelta->GetFootprint();
+	return Size;
+}
+
 // Undo / Redo base methods
 
 void CPatternAction::SaveUndoState(const CMainFrame &MainFrm)		// // //
@@ -238,6 +273,13 @@ void CPatternAction::SaveUndoState(const CMainFrame &MainFrm)		// // //
 void CPatternAction::SaveRedoState(const CMainFrame &MainFrm)		// // //
 {
 	m_pRedoState = std::make_unique<CPatternEditorState>(*GET_PATTERN_EDITOR());
+
+	if (m_bRegion && !m_pDelta) {		// // // the full copy is no longer needed
+		CSongView *pSongView = GET_SONG_VIEW();
+		const CCursorPos Origin = CPatternIterator::FromSelection(m_region, *pSongView).first.GetCursor();
+		m_pDelta = std::make_unique<CPatternDelta>(m_UndoClipData, *pSongView, Origin);
+		m_UndoClipData = CPatternClipData { };
+	}
 }
 
 void CPatternAction::RestoreUndoState(CMainFrame &MainFrm) const		// // //
@@ -259,13 +301,14 @@ CPSelectionAction::~CPSelectionAction() {
 
 bool CPSelectionAction::SaveState(const CMainFrame &MainFrm)
 {
-	const CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
-	m_UndoClipData = pPatternEditor->CopyRaw(m_pUndoState->Selection);
+	SaveRegion(MainFrm, m_pUndoState->Selection);		// // //
 	return true;
 }
 
 void CPSelectionAction::Undo(CMainFrame &MainFrm)
 {
+	if (UndoRegion(MainFrm))		// // //
+		return;
 	CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
 	pPatternEditor->PasteRaw(m_UndoClipData, m_pUndoState->Selection.m_cpStart);
 }
@@ -514,17 +557,21 @@ CPActionPaste::CPActionPaste(CPatternClipData ClipData, paste_mode_t Mode, paste
 bool CPActionPaste::SaveState(const CMainFrame &MainFrm) {
 	if (!SetTargetSelection(MainFrm, m_newSelection))		// // //
 		return false;
-	m_UndoClipData = GET_PATTERN_EDITOR()->CopyRaw();
+	SaveRegion(MainFrm, m_newSelection);		// // //
 	return true;
 }
 
 void CPActionPaste::Undo(CMainFrame &MainFrm) {
+	if (UndoRegion(MainFrm))		// // //
+		return;
 	CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
 	pPatternEditor->SetSelection(m_newSelection);		// // //
 	pPatternEditor->PasteRaw(m_UndoClipData);
 }
 
 void CPActionPaste::Redo(CMainFrame &MainFrm) {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
 	pPatternEditor->Paste(m_ClipData, m_iPasteMode, m_iPastePos);		// // //
 }
@@ -533,6 +580,8 @@ void CPActionPaste::Redo(CMainFrame &MainFrm) {
 
 void CPActionClearSel::Redo(CMainFrame &MainFrm)
 {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	DeleteSelection(*GET_SONG_VIEW(), m_pUndoState->Selection);
 }
 
@@ -562,11 +611,17 @@ bool CPActionDeleteAtSel::SaveState(const CMainFrame &MainFrm)
 			m_pUndoState->Selection.m_cpEnd.Xpos.Column,
 			m_cpTailPos.Ypos.Frame
 		}});
+
+	CSelection Region(m_pUndoState->Selection);		// // //
+	Region.m_cpEnd.Ypos.Row = Length;
+	SaveRegion(MainFrm, Region);
 	return true;
 }
 
 void CPActionDeleteAtSel::Undo(CMainFrame &MainFrm)
 {
+	if (UndoRegion(MainFrm))		// // //
+		return;
 	CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
 	pPatternEditor->PasteRaw(m_UndoHead, m_pUndoState->Selection.m_cpStart);
 	if (m_UndoTail.ContainsData())
@@ -577,14 +632,30 @@ void CPActionDeleteAtSel::Redo(CMainFrame &MainFrm)
 {
 	CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
 
-	CSelection Sel(m_pUndoState->Selection);
-	Sel.m_cpEnd.Ypos.Row = pPatternEditor->GetCurrentPatternLength(Sel.m_cpEnd.Ypos.Frame) - 1;
-	DeleteSelection(*GET_SONG_VIEW(), Sel);
-	if (m_UndoTail.ContainsData())
-		pPatternEditor->PasteRaw(m_UndoTail, m_pUndoState->Selection.m_cpStart);
+	if (!RedoRegion(MainFrm)) {		// // //
+		CSelection Sel(m_pUndoState->Selection);
+		Sel.m_cpEnd.Ypos.Row = pPatternEditor->GetCurrentPatternLength(Sel.m_cpEnd.Ypos.Frame) - 1;
+		DeleteSelection(*GET_SONG_VIEW(), Sel);
+		if (m_UndoTail.ContainsData())
+			pPatternEditor->PasteRaw(m_UndoTail, m_pUndoState->Selection.m_cpStart);
+	}
 	pPatternEditor->CancelSelection();
 }
 
+void CPActionDeleteAtSel::SaveRedoState(const CMainFrame &MainFrm)		// // //
+{
+	CPatternAction::SaveRedoState(MainFrm);
+	if (m_pDelta) {
+		m_UndoHead = CPatternClipData { };
+		m_UndoTail = CPatternClipData { };
+	}
+}
+
+std::size_t CPActionDeleteAtSel::GetFootprint() const		// // //
+{
+	return CPatternAction::GetFootprint() + m_UndoHead.GetFootprint() + m_UndoTail.GetFootprint();
+}
+
 
 
 CPActionInsertAtSel::~CPActionInsertAtSel()
@@ -621,11 +692,16 @@ bool CPActionInsertAtSel::SaveState(const CMainFrame &MainFrm)
 		}
 	}
 
+	CSelection Region(m_pUndoState->Selection);		// // //
+	Region.m_cpEnd.Ypos.Row = m_cpTailPos.Ypos.Row;
+	SaveRegion(MainFrm, Region);
 	return true;
 }
 
 void CPActionInsertAtSel::Undo(CMainFrame &MainFrm)
 {
+	if (UndoRegion(MainFrm))		// // //
+		return;
 	CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
 	pPatternEditor->PasteRaw(m_UndoTail, m_cpTailPos);
 	if (m_UndoHead.ContainsData())
@@ -634,6 +710,8 @@ void CPActionInsertAtSel::Undo(CMainFrame &MainFrm)
 
 void CPActionInsertAtSel::Redo(CMainFrame &MainFrm)
 {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
 
 	CSelection Sel(m_pUndoState->Selection);
@@ -643,6 +721,20 @@ void CPActionInsertAtSel::Redo(CMainFrame &MainFrm)
 		pPatternEditor->PasteRaw(m_UndoHead, m_cpHeadPos);
 }
 
+void CPActionInsertAtSel::SaveRedoState(const CMainFrame &MainFrm)		// // //
+{
+	CPatternAction::SaveRedoState(MainFrm);
+	if (m_pDelta) {
+		m_UndoHead = CPatternClipData { };
+		m_UndoTail = CPatternClipData { };
+	}
+}
+
+std::size_t CPActionInsertAtSel::GetFootprint() const		// // //
+{
+	return CPatternAction::GetFootprint() + m_UndoHead.GetFootprint() + m_UndoTail.GetFootprint();
+}
+
 
 
 CPActionTranspose::CPActionTranspose(int Amount) : m_iTransposeAmount(Amount)
@@ -651,6 +743,8 @@ CPActionTranspose::CPActionTranspose(int Amount) : m_iTransposeAmount(Amount)
 
 void CPActionTranspose::Redo(CMainFrame &MainFrm)
 {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	CSongView *pSongView = GET_SONG_VIEW();
 	auto [b, e] = GetIterators(*pSongView);
 
@@ -705,6 +799,8 @@ CPActionScrollValues::CPActionScrollValues(int Amount) : m_iAmount(Amount)
 
 void CPActionScrollValues::Redo(CMainFrame &MainFrm)
 {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	CPatternEditor *pPatternEditor = GET_PATTERN_EDITOR();
 	CSongView *pSongView = GET_SONG_VIEW();
 	auto [b, e] = GetIterators(*pSongView);
@@ -791,6 +887,8 @@ bool CPActionInterpolate::SaveState(const CMainFrame &MainFrm)
 
 void CPActionInterpolate::Redo(CMainFrame &MainFrm)
 {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	CSongView *pSongView = GET_SONG_VIEW();
 	auto [b, e] = GetIterators(*pSongView);
 	const CSelection &Sel = m_pUndoState->Selection;
@@ -892,6 +990,8 @@ bool CPActionReverse::SaveState(const CMainFrame &MainFrm)
 
 void CPActionReverse::Redo(CMainFrame &MainFrm)
 {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	CSongView *pSongView = GET_SONG_VIEW();
 	auto [b, e] = GetIterators(*pSongView);
 	const CSelection &Sel = m_pUndoState->Selection;
@@ -937,6 +1037,8 @@ bool CPActionReplaceInst::SaveState(const CMainFrame &MainFrm)
 
 void CPActionReplaceInst::Redo(CMainFrame &MainFrm)
 {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	auto [b, e] = GetIterators(*GET_SONG_VIEW());
 	const CSelection &Sel = m_pUndoState->Selection;
 
@@ -989,6 +1091,11 @@ void CPActionDragDrop::Redo(CMainFrame &MainFrm)
 	GET_PATTERN_EDITOR()->DragPaste(m_ClipData, m_dragTarget, m_bDragMix);
 }
 
+std::size_t CPActionDragDrop::GetFootprint() const		// // //
+{
+	return CPatternAction::GetFootprint() + m_AuxiliaryClipData.GetFootprint();
+}
+
 
 
 bool CPActionPatternLen::SaveState(const CMainFrame &MainFrm)
@@ -1038,6 +1145,8 @@ bool CPActionStretch::SaveState(const CMainFrame &MainFrm)
 
 void CPActionStretch::Redo(CMainFrame &MainFrm)
 {
+	if (RedoRegion(MainFrm))		// // //
+		return;
 	CSongView *pSongView = GET_SONG_VIEW();
 	auto [b, e] = GetIterators(*pSongView);
 	const CSelection &Sel = m_pUndoState->Selection;
@@ -1072,6 +1181,11 @@ void CPActionStretch::Redo(CMainFrame &MainFrm)
 	} while (++b <= e);
 }
 
+std::size_t CPActionStretch::GetFootprint() const		// // //
+{
+	return CPatternAction::GetFootprint() + m_iStretchMap.capacity() * sizeof(int);
+}
+
 
 
 CPActionEffColumn::CPActionEffColumn(int Channel, int Count) :		// // //
@@ -1169,6 +1283,14 @@ void CPActionUniquePatterns::UpdateViews(CMainFrame &MainFrm) const {
 	MainFrm.GetActiveDocument()->UpdateAllViews(NULL, UPDATE_FRAME);
 }
 
+std::size_t CPActionUniquePatterns::GetFootprint() const {		// // //
+	std::size_t Size = CPatternAction::GetFootprint();
+	for (const auto &pSong : {song_.get(), songNew_.get()})
+		if (pSong)
+			Size += sizeof(CSongData) + pSong->GetFootprint();
+	return Size;
+}
+
 
 
 bool CPActionClearAll::SaveState(const CMainFrame &MainFrm) {
@@ -1195,3 +1317,11 @@ void CPActionClearAll::UpdateViews(CMainFrame &MainFrm) const {
 	MainFrm.GetActiveDocument()->UpdateAllViews(NULL, UPDATE_TRACK);
 	MainFrm.GetActiveDocument()->UpdateAllViews(NULL, UPDATE_FRAME);
 }
+
+std::size_t CPActionClearAll::GetFootprint() const {		// // //
+	std::size_t Size = CPatternAction::GetFootprint();
+	for (const auto &pSong : {song_.get(), songNew_.get()})
+		if (pSong)
+			Size += sizeof(CSongData) + pSong->GetFootprint();
+	return Size;
+}
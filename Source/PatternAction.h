@@ -77,6 +77,8 @@ public:
 	void RestoreUndoState(CMainFrame &MainFrm) const override;		// // //
 	void RestoreRedoState(CMainFrame &MainFrm) const override;		// // //
 
+	std::size_t GetFootprint() const override;		// // //
+
 private:
 	void UpdateViews(CMainFrame &MainFrm) const override;		// // //
 
@@ -86,9 +88,16 @@ protected:
 	bool ValidateSelection(const CPatternEditor &Editor) const;		// // //
 	std::pair<CPatternIterator, CPatternIterator> GetIterators(CSongView &view) const;		// // //
 
+	// // // For actions that only modify cells inside one selection: the selection is copied into
+	// m_UndoClipData before the action, then reduced to the changed cells once it is performed
+	void SaveRegion(const CMainFrame &MainFrm, const CSelection &Sel);
+	bool UndoRegion(CMainFrame &MainFrm) const;
+	bool RedoRegion(CMainFrame &MainFrm) const;
+
 protected:
 	std::unique_ptr<CPatternEditorState> m_pUndoState;		// // //
 	std::unique_ptr<CPatternEditorState> m_pRedoState;
+	std::unique_ptr<CPatternDelta> m_pDelta;		// // //
 
 protected:
 	CPatternClipData m_ClipData;
@@ -100,6 +109,10 @@ protected:
 	CSelection m_selection, m_newSelection;		// // //
 
 	CSelection m_dragTarget;
+
+private:
+	CSelection m_region;		// // //
+	bool m_bRegion = false;		// // //
 };
 
 /*!
@@ -113,8 +126,6 @@ protected:
 protected:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
-protected:
-	CPatternClipData m_UndoClipData;
 };
 
 // // // built-in pattern action subtypes
@@ -202,6 +213,8 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	void SaveRedoState(const CMainFrame &MainFrm) override;		// // //
+	std::size_t GetFootprint() const override;		// // //
 
 	CCursorPos m_cpTailPos;
 	CPatternClipData m_UndoHead;
@@ -216,6 +229,8 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	void SaveRedoState(const CMainFrame &MainFrm) override;		// // //
+	std::size_t GetFootprint() const override;		// // //
 
 	CCursorPos m_cpHeadPos, m_cpTailPos;
 	CPatternClipData m_UndoHead;
@@ -275,6 +290,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 private:
 //	const CPatternClipData *m_pClipData;
 	CPatternClipData m_AuxiliaryClipData; // TODO: remove
@@ -304,6 +320,7 @@ public:
 private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	std::size_t GetFootprint() const override;		// // //
 
 	std::vector<int> m_iStretchMap;
 };
@@ -343,6 +360,7 @@ private:
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
 	void UpdateViews(CMainFrame &MainFrm) const override;
+	std::size_t GetFootprint() const override;		// // //
 
 	std::unique_ptr<CSongData> song_;
 	std::unique_ptr<CSongData> songNew_;
@@ -357,6 +375,7 @@ private:
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
 	void UpdateViews(CMainFrame &MainFrm) const override;
+	std::size_t GetFootprint() const override;		// // //
 
 	std::unique_ptr<CSongData> song_;
 	std::unique_ptr<CSongData> songNew_;
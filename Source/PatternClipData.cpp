@@ -23,7 +23,10 @@
 #include "PatternClipData.h"
 #include "PatternNote.h"
 #include "Assertion.h"		// // //
+#include "SongView.h"		// // //
+#include "SongData.h"		// // //
 #include <cstring>		// // //
+#include <cstdlib>		// // //
 
 CPatternClipData::CPatternClipData(int Channels, int Rows) :
 	ClipInfo({Channels, Rows}),		// // //
@@ -41,6 +44,10 @@ bool CPatternClipData::ContainsData() const {		// // //
 	return pPattern != nullptr;
 }
 
+std::size_t CPatternClipData::GetFootprint() const {		// // //
+	return pPattern ? Size * sizeof(stChanNote) : 0u;
+}
+
 bool CPatternClipData::ToBytes(std::byte *pBuf, std::size_t buflen) const		// // //
 {
 	if (buflen >= GetAllocSize()) {
@@ -78,3 +85,53 @@ const stChanNote *CPatternClipData::GetPattern(int Channel, int Row) const
 
 	return &pPattern[Channel * ClipInfo.Rows + Row];
 }
+
+
+
+// // // CPatternDelta
+
+static_assert(MAX_FRAMES <= 0x100 && MAX_PATTERN_LENGTH <= 0x100, "Cell positions no longer fit in a byte");
+
+CPatternDelta::CPatternDelta(const CPatternClipData &Before, const CConstSongView &view, const CCursorPos &Origin)
+{
+	// same traversal as CPatternEditor::CopyRaw
+	const int Frames = view.GetSong().GetFrameCount();
+	const int Length = view.GetSong().GetPatternLength();
+	const int PackedPos = (Origin.Ypos.Frame + Frames) * Length + Origin.Ypos.Row;
+
+	for (int i = 0; i < Before.ClipInfo.Channels; ++i)
+		for (int r = 0; r < Before.ClipInfo.Rows; ++r) {
+			auto pos = std::div(PackedPos + r, Length);
+			const int Track = i + Origin.Xpos.Track;
+			const int Frame = pos.quot % Frames;
+			const stChanNote &Old = *Before.GetPattern(i, r);
+			const stChanNote &New = view.GetPatternOnFrame(Track, Frame).GetNoteOn(pos.rem);
+			if (Old != New)
+				cells_.push_back({
+					static_cast<std::uint8_t>(Track),
+					static_cast<std::uint8_t>(Frame),
+					static_cast<std::uint8_t>(pos.rem),
+					Old, New,
+				});
+		}
+
+	cells_.shrink_to_fit();
+}
+
+void CPatternDelta::Undo(CSongView &view) const {
+	for (auto it = cells_.crbegin(), end = cells_.crend(); it != end; ++it)
+		view.GetPatternOnFrame(it->Track, it->Frame).SetNoteOn(it->Row, it->Before);
+}
+
+void CPatternDelta::Redo(CSongView &view) const {
+	for (const auto &x : cells_)
+		view.GetPatternOnFrame(x.Track, x.Frame).SetNoteOn(x.Row, x.After);
+}
+
+std::size_t CPatternDelta::GetCellCount() const {
+	return cells_.size();
+}
+
+std::size_t CPatternDelta::GetFootprint() const {
+	return cells_.capacity() * sizeof(stCell);
+}
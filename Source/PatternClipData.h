@@ -24,10 +24,14 @@
 #pragma once
 
 #include <memory>
+#include <vector>		// // //
+#include <cstdint>		// // //
 #include "BinarySerializable.h"		// // //
 #include "PatternEditorTypes.h"
+#include "PatternNote.h"		// // //
 
-class stChanNote;
+class CConstSongView;		// // //
+class CSongView;		// // //
 
 // Class used by clipboard
 class CPatternClipData : public CBinarySerializableInterface {		// // //
@@ -39,6 +43,7 @@ public:
 	const stChanNote *GetPattern(int Channel, int Row) const;
 
 	bool ContainsData() const override;		// // //
+	std::size_t GetFootprint() const;		// // // heap memory only, in bytes
 
 private:
 	std::size_t GetAllocSize() const override;
@@ -61,3 +66,38 @@ public:
 	int Size = 0;					// Pattern data size, in rows * columns
 };
 
+/*!
+	\brief The cells changed by an edit confined to a pattern selection, storing both their old and
+	new contents so that the edit can be undone and redone in time proportional to its size.
+*/
+class CPatternDelta		// // //
+{
+public:
+	/*!	\brief Constructor of the pattern delta.
+		\param Before The selection before the edit, as returned by CPatternEditor::CopyRaw.
+		\param view The song view, already holding the selection after the edit.
+		\param Origin The first cell of the selection after normalization and warping. */
+	CPatternDelta(const CPatternClipData &Before, const CConstSongView &view, const CCursorPos &Origin);
+
+	/*!	\brief Writes the old contents of all changed cells. */
+	void Undo(CSongView &view) const;
+	/*!	\brief Writes the new contents of all changed cells. */
+	void Redo(CSongView &view) const;
+
+	/*!	\brief Returns the number of changed cells. */
+	std::size_t GetCellCount() const;
+	/*!	\brief Returns the heap memory held by the delta, in bytes. */
+	std::size_t GetFootprint() const;
+
+private:
+	struct stCell {
+		std::uint8_t Track;
+		std::uint8_t Frame;
+		std::uint8_t Row;
+		stChanNote Before;
+		stChanNote After;
+	};
+
+	std::vector<stCell> cells_;
+};
+
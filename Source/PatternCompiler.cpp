@@ -148,6 +148,7 @@ void CPatternCompiler::CompileData(int Track, int Pattern, stChannelID Channel)
 
 	// Global init
 	m_iHash = 0;
+	m_iErrorCount = 0;		// // //
 	m_iDuration = 0;
 	m_iCurrentDefaultDuration = 0xFF;
 
@@ -170,9 +171,11 @@ void CPatternCompiler::CompileData(int Track, int Pattern, stChannelID Channel)
 		bool Action = false;
 
 		if (ChanNote.Instrument != MAX_INSTRUMENTS && ChanNote.Instrument != HOLD_INSTRUMENT && (is_note(Note) || Note == note_t::echo))		// // //
-			if (!IsInstrumentCompatible(Channel.Chip, pInstManager->GetInstrumentType(ChanNote.Instrument)))		// // //
+			if (!IsInstrumentCompatible(Channel.Chip, pInstManager->GetInstrumentType(ChanNote.Instrument))) {		// // //
+				++m_iErrorCount;
 				Print("Error: Missing or incompatible instrument (on row " + conv::from_uint(i) +
 					", channel " + std::string {FTEnv.GetSoundChipService()->GetChannelFullName(Channel)} + ", pattern " + conv::from_uint(Pattern) + ")\n");
+			}
 
 		// Check for delays, must come first
 		for (int j = 0; j < EffColumns; ++j) {
@@ -284,6 +287,7 @@ void CPatternCompiler::CompileData(int Track, int Pattern, stChannelID Channel)
 					// 2A03 DPCM
 					int LookUp = FindSample(DPCMInst, NESNote);
 					if (LookUp <= 0) { // Invalid sample, skip
+						++m_iErrorCount;		// // //
 						Print("Error: Missing DPCM sample (on row " + conv::from_uint(i) +
 							", channel " + std::string {FTEnv.GetSoundChipService()->GetChannelFullName(Channel)} + ", pattern " + conv::from_uint(Pattern) + ")\n");
 						return 0xFF;
@@ -902,6 +906,11 @@ unsigned int CPatternCompiler::GetHash() const
 	return m_iHash;
 }
 
+unsigned int CPatternCompiler::GetErrorCount() const		// // //
+{
+	return m_iErrorCount;
+}
+
 void CPatternCompiler::Print(std::string_view text) const		// // //
 {
 	if (m_pLogger)
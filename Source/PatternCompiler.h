@@ -51,6 +51,8 @@ public:
 	unsigned int	GetDataSize() const;
 	unsigned int	GetCompressedDataSize() const;
 
+	unsigned int	GetErrorCount() const;		// // // Errors reported by the last CompileData call
+
 private:
 	struct stSpacingInfo {
 		int SpaceCount = 0;
@@ -81,6 +83,7 @@ private:
 	unsigned int	m_iCurrentDefaultDuration;
 	bool			m_bDSamplesAccessed[OCTAVE_RANGE * NOTE_RANGE] = { }; // <- check the range, its not optimal right now
 	unsigned int	m_iHash;
+	unsigned int	m_iErrorCount = 0;		// // //
 	const std::vector<unsigned> &m_iInstrumentList;		// // //
 
 	const DPCM_List_t *m_pDPCMList = nullptr;		// // //
@@ -22,30 +22,46 @@
 
 #include "PatternData.h"
 #include <type_traits>
+#include <utility>		// // //
+#include <atomic>		// // //
 
 namespace {
 
 const auto BLANK = stChanNote { };
 
+std::atomic<std::uint64_t> LAST_VERSION {0u};		// // // shared by all patterns
+
 } // namespace
 
-CPatternData::CPatternData(const CPatternData &other) : data_(std::make_unique<elem_t>(*other.data_)) {
+CPatternData::CPatternData(const CPatternData &other) :
+	data_(other.data_), version_(other.version_)		// // //
+{
+}
+
+CPatternData::CPatternData(CPatternData &&other) noexcept :		// // //
+	data_(std::move(other.data_)), version_(std::exchange(other.version_, 0u))
+{
 }
 
 CPatternData &CPatternData::operator=(const CPatternData &other) {
 	if (this != &other) {
-		if (other.data_) {
-			Allocate();
-			*data_ = *other.data_;
-		}
-		else
-			data_.reset();
+		data_ = other.data_;		// // //
+		version_ = other.version_;		// // //
+	}
+	return *this;
+}
+
+CPatternData &CPatternData::operator=(CPatternData &&other) noexcept {		// // //
+	if (this != &other) {
+		data_ = std::move(other.data_);
+		version_ = std::exchange(other.version_, 0u);
 	}
 	return *this;
 }
 
 stChanNote &CPatternData::GetNoteOn(unsigned row) {
 	Allocate();
+	Modify();		// // //
 	return (*data_)[row];
 }
 
@@ -55,11 +71,12 @@ const stChanNote &CPatternData::GetNoteOn(unsigned row) const {
 
 void CPatternData::SetNoteOn(unsigned row, const stChanNote &note) {
 	Allocate();
+	Modify();		// // //
 	(*data_)[row] = note;
 }
 
 bool CPatternData::operator==(const CPatternData &other) const noexcept {
-	if (!data_ && !other.data_)
+	if (data_ == other.data_)		// // //
 		return true;
 
 	const auto IsPatternBlank = [] (const elem_t &notes) {
@@ -107,7 +124,22 @@ bool CPatternData::IsEmpty() const {
 	return true;
 }
 
+std::uint64_t CPatternData::GetVersion() const noexcept {		// // //
+	return version_;
+}
+
+std::size_t CPatternData::GetFootprint() const noexcept {		// // //
+	return data_ ? sizeof(elem_t) : 0u;
+}
+
 void CPatternData::Allocate() {
+	// // // also called before modifying the rows, which are copied if any other pattern uses them
 	if (!data_)
-		data_ = std::make_unique<elem_t>();
+		data_ = std::make_shared<elem_t>();
+	else if (data_.use_count() > 1)
+		data_ = std::make_shared<elem_t>(*data_);
+}
+
+void CPatternData::Modify() noexcept {		// // //
+	version_ = ++LAST_VERSION;
 }
@@ -25,11 +25,12 @@
 
 #include <memory>
 #include <array>
+#include <cstdint>		// // //
 #include "PatternNote.h"
 
 class stChanNote;
 
-// // // the real pattern class
+// // // the real pattern class, copies share their rows until either of them is modified
 
 class CPatternData {
 	static constexpr unsigned max_size = MAX_PATTERN_LENGTH;
@@ -37,9 +38,9 @@ class CPatternData {
 public:
 	CPatternData() = default;
 	CPatternData(const CPatternData &other);
-	CPatternData(CPatternData &&other) noexcept = default;
+	CPatternData(CPatternData &&other) noexcept;		// // //
 	CPatternData &operator=(const CPatternData &other);
-	CPatternData &operator=(CPatternData &&other) noexcept = default;
+	CPatternData &operator=(CPatternData &&other) noexcept;		// // //
 	~CPatternData() noexcept = default;
 
 	stChanNote &GetNoteOn(unsigned row);
@@ -54,6 +55,11 @@ public:
 	unsigned GetNoteCount(int maxrows = max_size) const;
 	bool IsEmpty() const;
 
+	// // // Changes whenever the pattern may have been modified, equal versions imply equal contents
+	std::uint64_t GetVersion() const noexcept;
+	// // // Memory allocated for the rows, in bytes
+	std::size_t GetFootprint() const noexcept;
+
 	// void (*F)(stChanNote &note p [, unsigned row])
 	template <typename F>
 	void VisitRows(F f) {
@@ -69,6 +75,8 @@ public:
 	template <typename F>
 	void VisitRows(unsigned rows, F f) {
 		if (data_) {
+			Allocate();		// // //
+			Modify();		// // //
 			for (unsigned row = 0; row < rows; ++row)
 				if constexpr (std::is_invocable_v<F, stChanNote &>)
 					f((*data_)[row]);
@@ -90,8 +98,10 @@ public:
 
 private:
 	void Allocate();
+	void Modify() noexcept;		// // //
 
 private:
 	using elem_t = std::array<stChanNote, max_size>;
-	std::unique_ptr<elem_t> data_;
+	std::shared_ptr<elem_t> data_;		// // // never modified while shared
+	std::uint64_t version_ = 0u;		// // // 0 if the pattern was never modified
 };
@@ -1246,7 +1246,7 @@ void CPatternEditor::DrawRow(CDC &DC, int Row, int Line, int Frame, bool bPrevie
 				bInvert = true;
 			}
 
-			DrawCell(DC, PosX - m_iColumnSpacing / 2, j, i, bInvert, pSongView->GetPatternOnFrame(i, f).GetNoteOn(Row), colorInfo);		// // //
+			DrawCell(DC, PosX - m_iColumnSpacing / 2, j, i, bInvert, std::as_const(*pSongView).GetPatternOnFrame(i, f).GetNoteOn(Row), colorInfo);		// // //
 			PosX += GetColumnSpace(j);
 			if (!m_bCompactMode)		// // //
 				SelStart += GetSelectWidth(j);
@@ -2834,7 +2834,7 @@ CPatternClipData CPatternEditor::CopyEntire() const
 
 	for (int i = 0; i < ChannelCount; ++i)
 		for (int j = 0; j < Rows; ++j)
-			*ClipData.GetPattern(i, j) = pSongView->GetPatternOnFrame(i, Frame).GetNoteOn(j);		// // //
+			*ClipData.GetPattern(i, j) = std::as_const(*pSongView).GetPatternOnFrame(i, Frame).GetNoteOn(j);		// // //
 
 	return ClipData;
 }
@@ -2894,7 +2894,7 @@ CPatternClipData CPatternEditor::CopyRaw(const CSelection &Sel) const		// // //
 	for (int i = 0; i < Channels; ++i)
 		for (int r = 0; r < Rows; ++r) {
 			auto pos = std::div(PackedPos + r, Length);
-			*ClipData.GetPattern(i, r) = pSongView->GetPatternOnFrame(i + cBegin, pos.quot % Frames).GetNoteOn(pos.rem);
+			*ClipData.GetPattern(i, r) = std::as_const(*pSongView).GetPatternOnFrame(i + cBegin, pos.quot % Frames).GetNoteOn(pos.rem);		// // //
 		}
 
 	return ClipData;
@@ -3529,9 +3529,9 @@ CStringW CPatternEditor::GetSelectionAsText() const {		// // //
 			auto RowString = CTextExport::ExportCellText(NoteData, pSongView->GetEffectColumnCount(i),
 				IsAPUNoise(pSongView->GetChannelOrder().TranslateChannel(i)));
 			if (i == b.m_iChannel) for (unsigned c = 0; c < value_cast(BegCol); ++c)
-				for (int j = 0; j < COLUMN_CHAR_LEN[c]; ++j) RowString.SetAt(COLUMN_CHAR_POS[c] + j, ' ');
+				for (int j = 0; j < COLUMN_CHAR_LEN[c]; ++j) RowString[COLUMN_CHAR_POS[c] + j] = ' ';		// // //
 			if (i == e.m_iChannel && EndCol < column_t::Effect4)
-				RowString = RowString.Left(COLUMN_CHAR_POS[value_cast(EndCol) + 1] - 1);
+				RowString = RowString.substr(0, COLUMN_CHAR_POS[value_cast(EndCol) + 1] - 1);
 			AppendFormatW(line, L" : %s", conv::to_wide(RowString).data());
 		}
 		str.Append(line);
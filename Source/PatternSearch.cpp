@@ -0,0 +1,285 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2015 Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "PatternSearch.h"
+#include <algorithm>
+#include <tuple>
+#include "FamiTrackerModule.h"
+#include "SongData.h"
+#include "ChannelOrder.h"
+#include "RunParallel.h"
+
+namespace {
+
+// Sorts matches from channel-major order into frame and row order, keeping the channel order
+void SortMatches(std::vector<stPatternMatch> &Matches) {
+	std::stable_sort(Matches.begin(), Matches.end(), [] (const stPatternMatch &a, const stPatternMatch &b) {
+		return std::tie(a.Track, a.Frame, a.Row) < std::tie(b.Track, b.Frame, b.Row);
+	});
+}
+
+const unsigned EFFECT_KEY = 0x100u;
+
+} // namespace
+
+searchTerm::searchTerm() :
+	Note(std::make_unique<NoteRange>()),
+	Oct(std::make_unique<CharRange>()),
+	Inst(std::make_unique<CharRange>(0, MAX_INSTRUMENTS)),
+	Vol(std::make_unique<CharRange>(0, MAX_VOLUME)),
+	EffParam(std::make_unique<CharRange>())
+{
+}
+
+
+
+CPatternMatcher::CPatternMatcher(const searchTerm &Term, unsigned EffColumn, bool Negate) :
+	m_Note(*Term.Note),
+	m_Oct(*Term.Oct),
+	m_Inst(*Term.Inst),
+	m_Vol(*Term.Vol),
+	m_EffParam(*Term.EffParam),
+	m_bNoiseChan(Term.NoiseChan),
+	m_bNegate(Negate),
+	m_iEffColumn(EffColumn)
+{
+	std::copy(std::begin(Term.EffNumber), std::end(Term.EffNumber), std::begin(m_bEffNumber));
+	std::copy(std::begin(Term.Definite), std::end(Term.Definite), std::begin(m_bDefinite));
+
+	m_bMelodic = is_note(m_Note.Min) && is_note(m_Note.Max) && m_bDefinite[WC_OCT];
+	if (is_note(m_Note.Min) && is_note(m_Note.Max)) {
+		m_iMidiLow = ft0cc::doc::midi_note(m_Oct.Min, m_Note.Min);
+		m_iMidiHigh = ft0cc::doc::midi_note(m_Oct.Max, m_Note.Max);
+	}
+}
+
+bool CPatternMatcher::IsMatch(const stChanNote &Target, bool Noise, unsigned EffCount) const {
+	if (m_bDefinite[WC_NOTE]) {
+		if (m_bNoiseChan) {
+			if (!Noise && m_bMelodic)
+				return false;
+			if (!is_note(m_Note.Min) || !is_note(m_Note.Max)) {
+				if (!m_Note.IsMatch(Target.Note))
+					return m_bNegate;
+			}
+			else {
+				int NoiseNote = Target.ToMidiNote() % 16;
+				int Low = m_iMidiLow % 16;
+				int High = m_iMidiHigh % 16;
+				if ((NoiseNote < Low && NoiseNote < High) || (NoiseNote > Low && NoiseNote > High))
+					return m_bNegate;
+			}
+		}
+		else {
+			if (Noise && m_bMelodic)
+				return false;
+			if (m_bMelodic) {
+				if (!is_note(Target.Note))
+					return m_bNegate;
+				int NoteValue = Target.ToMidiNote();
+				if ((NoteValue < m_iMidiLow && NoteValue < m_iMidiHigh) || (NoteValue > m_iMidiLow && NoteValue > m_iMidiHigh))
+					return m_bNegate;
+			}
+			else {
+				if (!m_Note.IsMatch(Target.Note))
+					return m_bNegate;
+				if (m_bDefinite[WC_OCT] && !m_Oct.IsMatch(Target.Octave))
+					return m_bNegate;
+			}
+		}
+	}
+	if (m_bDefinite[WC_INST] && !m_Inst.IsMatch(Target.Instrument))
+		return m_bNegate;
+	if (m_bDefinite[WC_VOL] && !m_Vol.IsMatch(Target.Vol))
+		return m_bNegate;
+
+	int EffColumn = m_iEffColumn;
+	if (EffColumn > (int)EffCount && EffColumn != (int)ANY_COLUMN)
+		EffColumn = EffCount;
+	int Limit = std::min({MAX_EFFECT_COLUMNS - 1, (int)EffCount, EffColumn});
+	for (int i = EffColumn % MAX_EFFECT_COLUMNS; i <= Limit; ++i)
+		if (IsEffectMatch(Target.Effects[i]))
+			return !m_bNegate;
+
+	return m_bNegate;
+}
+
+bool CPatternMatcher::IsEffectMatch(const stEffectCommand &Cmd) const {
+	return (!m_bDefinite[WC_EFF] || m_bEffNumber[value_cast(Cmd.fx)]) &&
+		(!m_bDefinite[WC_PARAM] || m_EffParam.IsMatch(Cmd.param));
+}
+
+
+
+std::vector<stPatternMatch> CPatternUsageIndex::FindInstrument(const CSongData &song, const CChannelOrder &Order, unsigned Index) {
+	return Index < MAX_INSTRUMENTS ? Find(song, Order, Index) : std::vector<stPatternMatch> { };
+}
+
+std::vector<stPatternMatch> CPatternUsageIndex::FindEffect(const CSongData &song, const CChannelOrder &Order, effect_t fx) {
+	return fx != effect_t::none ? Find(song, Order, EFFECT_KEY + value_cast(fx)) : std::vector<stPatternMatch> { };
+}
+
+std::vector<stPatternMatch> CPatternUsageIndex::Find(const CSongData &song, const CChannelOrder &Order, unsigned Key) {
+	std::lock_guard<std::mutex> lock {m_Lock};
+
+	++m_iGeneration;
+	const unsigned Rows = song.GetPatternLength();
+	const unsigned Frames = song.GetFrameCount();
+	std::vector<stPatternMatch> Matches;
+
+	Order.ForeachChannel([&] (stChannelID Chan) {
+		const CTrackData *pTrack = song.GetTrack(Chan);
+		if (!pTrack)
+			return;
+		const unsigned EffCount = pTrack->GetEffectColumnCount();
+
+		for (unsigned Frame = 0; Frame < Frames; ++Frame) {
+			const unsigned Pattern = pTrack->GetFramePattern(Frame);
+			const CPatternData &pat = pTrack->GetPattern(Pattern);
+			const std::uint64_t Version = pat.GetVersion();
+			if (!Version)		// never modified, hence blank
+				continue;
+
+			auto it = m_Patterns.find(Version);
+			if (it == m_Patterns.end())
+				it = m_Patterns.try_emplace(Version, MakeUsage(pat)).first;
+			it->second.Generation = m_iGeneration;
+
+			const auto &Cells = it->second.Cells;
+			unsigned LastRow = (unsigned)-1;
+			for (auto c = std::lower_bound(Cells.begin(), Cells.end(), Key << 16),
+				e = std::lower_bound(c, Cells.end(), (Key + 1) << 16); c != e; ++c) {
+				const unsigned Row = (*c >> 8) & 0xFFu;
+				const unsigned Column = *c & 0xFFu;
+				if (Row >= Rows || Column >= EffCount || Row == LastRow)
+					continue;
+				LastRow = Row;
+				Matches.push_back({0u, Frame, Row, Chan, Pattern});
+			}
+		}
+	});
+
+	// Forget the patterns no longer used by the song
+	for (auto it = m_Patterns.begin(); it != m_Patterns.end(); )
+		if (it->second.Generation != m_iGeneration)
+			it = m_Patterns.erase(it);
+		else
+			++it;
+
+	SortMatches(Matches);
+	return Matches;
+}
+
+CPatternUsageIndex::stPatternUsage CPatternUsageIndex::MakeUsage(const CPatternData &Pattern) {
+	stPatternUsage Usage;
+	Pattern.VisitRows([&] (const stChanNote &Note, unsigned Row) {
+		if (Note.Instrument < MAX_INSTRUMENTS)
+			Usage.Cells.push_back(Note.Instrument << 16 | Row << 8);
+		for (unsigned i = 0; i < MAX_EFFECT_COLUMNS; ++i)
+			if (Note.Effects[i].fx != effect_t::none)
+				Usage.Cells.push_back((EFFECT_KEY + value_cast(Note.Effects[i].fx)) << 16 | Row << 8 | i);
+	});
+	std::sort(Usage.Cells.begin(), Usage.Cells.end());
+	return Usage;
+}
+
+
+
+CPatternSearch::CPatternSearch(const CFamiTrackerModule &modfile, unsigned Threads) :
+	modfile_(modfile), threads_(Threads)
+{
+}
+
+std::vector<stPatternMatch> CPatternSearch::Find(const CPatternMatcher &Matcher) const {
+	const CChannelOrder &Order = modfile_.GetChannelOrder();
+	std::vector<stChannelID> Channels;
+	Order.ForeachChannel([&] (stChannelID Chan) {
+		Channels.push_back(Chan);
+	});
+
+	const std::size_t Count = modfile_.GetSongCount() * Channels.size();
+	std::vector<std::vector<stPatternMatch>> Results(Count);
+
+	// Each task reads one track, testing every used pattern only once
+	RunParallel(Count, threads_, [&] (std::size_t i) {
+		const unsigned Track = i / Channels.size();
+		const stChannelID Chan = Channels[i % Channels.size()];
+		const CSongData &song = *modfile_.GetSong(Track);
+		const CTrackData *pTrack = song.GetTrack(Chan);
+		if (!pTrack)
+			return;
+
+		const bool Noise = IsAPUNoise(Chan);
+		const unsigned EffCount = pTrack->GetEffectColumnCount();
+		const unsigned Rows = song.GetPatternLength();
+		std::vector<std::vector<unsigned>> PatternRows(MAX_PATTERN);
+		std::vector<bool> Tested(MAX_PATTERN);
+
+		for (unsigned Frame = 0, Frames = song.GetFrameCount(); Frame < Frames; ++Frame) {
+			const unsigned Pattern = pTrack->GetFramePattern(Frame);
+			if (!Tested[Pattern]) {
+				Tested[Pattern] = true;
+				const CPatternData &pat = pTrack->GetPattern(Pattern);
+				for (unsigned Row = 0; Row < Rows; ++Row)
+					if (Matcher.IsMatch(pat.GetNoteOn(Row), Noise, EffCount))
+						PatternRows[Pattern].push_back(Row);
+			}
+			for (unsigned Row : PatternRows[Pattern])
+				Results[i].push_back({Track, Frame, Row, Chan, Pattern});
+		}
+	});
+
+	std::vector<stPatternMatch> Matches;
+	for (auto &x : Results)
+		Matches.insert(Matches.end(), x.begin(), x.end());
+	SortMatches(Matches);
+	return Matches;
+}
+
+std::vector<stPatternMatch> CPatternSearch::FindInstrument(unsigned Index) const {
+	return FindSongs([&] (const CSongData &song, const CChannelOrder &Order) {
+		return song.GetUsageIndex().FindInstrument(song, Order, Index);
+	});
+}
+
+std::vector<stPatternMatch> CPatternSearch::FindEffect(effect_t fx) const {
+	return FindSongs([&] (const CSongData &song, const CChannelOrder &Order) {
+		return song.GetUsageIndex().FindEffect(song, Order, fx);
+	});
+}
+
+template <typename F>
+std::vector<stPatternMatch> CPatternSearch::FindSongs(F f) const {
+	const CChannelOrder &Order = modfile_.GetChannelOrder();
+	std::vector<std::vector<stPatternMatch>> Results(modfile_.GetSongCount());
+
+	RunParallel(Results.size(), threads_, [&] (std::size_t i) {
+		Results[i] = f(*modfile_.GetSong(i), Order);
+		for (auto &x : Results[i])
+			x.Track = i;
+	});
+
+	std::vector<stPatternMatch> Matches;
+	for (auto &x : Results)
+		Matches.insert(Matches.end(), x.begin(), x.end());
+	return Matches;
+}
@@ -0,0 +1,226 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2015 Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <memory>
+#include <limits>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <type_traits>
+#include "PatternNote.h"
+#include "APU/Types.h"
+
+class CFamiTrackerModule;
+class CSongData;
+class CPatternData;
+class CChannelOrder;
+
+// // // Pattern search, shared by the find dialog and portable tools
+
+namespace details {
+
+template <typename T, bool>
+struct underlying_type {
+	using type = T;
+};
+template <typename T>
+struct underlying_type<T, true> {
+	using type = std::underlying_type_t<T>;
+};
+template <typename T>
+using underlying_type_t = typename underlying_type<T, std::is_enum_v<T>>::type;
+
+} // namespace details
+
+template <typename T>
+struct FindRange {
+	constexpr FindRange() noexcept = default;
+	constexpr FindRange(T a, T b) noexcept : Min(a), Max(b) { }
+
+	constexpr void Set(T x, bool Half = false) noexcept {
+		if (!Half)
+			Min = x;
+		Max = x;
+	}
+	constexpr bool IsMatch(T x) const noexcept {
+		return (x >= Min && x <= Max) || (x >= Max && x <= Min);
+	}
+	constexpr bool IsSingle() const noexcept {
+		return Min == Max;
+	}
+
+	T Min = static_cast<T>(std::numeric_limits<details::underlying_type_t<T>>::min());
+	T Max = static_cast<T>(std::numeric_limits<details::underlying_type_t<T>>::max());
+};
+
+using CharRange = FindRange<unsigned char>;
+using NoteRange = FindRange<note_t>;
+
+// Indices into searchTerm::Definite
+enum search_column_t : unsigned {
+	WC_NOTE = 0,
+	WC_OCT,
+	WC_INST,
+	WC_VOL,
+	WC_EFF,
+	WC_PARAM,
+};
+
+class searchTerm
+{
+public:
+	searchTerm();
+
+	std::unique_ptr<NoteRange> Note;
+	std::unique_ptr<CharRange> Oct, Inst, Vol;
+	bool EffNumber[enum_count<effect_t>() + 1] = { };
+	std::unique_ptr<CharRange> EffParam;
+	bool Definite[6] = { };
+	bool NoiseChan = false;
+};
+
+/*!
+	\brief A search term compiled into a predicate over pattern cells.
+	\details All derived quantities of the term are computed once, so that testing a cell only
+	compares it against plain values.
+*/
+class CPatternMatcher
+{
+public:
+	/*!	\brief The effect column value that matches effects in any column. */
+	static constexpr unsigned ANY_COLUMN = MAX_EFFECT_COLUMNS;
+
+	/*!	\brief Constructor of the pattern matcher.
+		\param Term The search term.
+		\param EffColumn The effect column to search, or ANY_COLUMN.
+		\param Negate Whether cells not matching the term are reported instead. */
+	CPatternMatcher(const searchTerm &Term, unsigned EffColumn = ANY_COLUMN, bool Negate = false);
+
+	/*!	\brief Tests a single cell.
+		\param Note The cell.
+		\param Noise Whether the cell belongs to the 2A03 noise channel.
+		\param EffCount The number of effect columns visible on the cell's track.
+		\return True if the cell matches. */
+	bool IsMatch(const stChanNote &Note, bool Noise, unsigned EffCount) const;
+
+	/*!	\brief Tests a single effect command against the effect fields of the term.
+		\param Cmd The effect command.
+		\return True if the effect matches, ignoring the effect column and negation. */
+	bool IsEffectMatch(const stEffectCommand &Cmd) const;
+
+private:
+	NoteRange m_Note;
+	CharRange m_Oct, m_Inst, m_Vol, m_EffParam;
+	bool m_bEffNumber[enum_count<effect_t>() + 1] = { };
+	bool m_bDefinite[6] = { };
+	bool m_bNoiseChan = false;
+	bool m_bMelodic = false;
+	bool m_bNegate = false;
+	unsigned m_iEffColumn = ANY_COLUMN;
+	int m_iMidiLow = 0;
+	int m_iMidiHigh = 0;
+};
+
+/*!	\brief The location of a cell returned by a pattern search. */
+struct stPatternMatch {
+	unsigned Track = 0;
+	unsigned Frame = 0;
+	unsigned Row = 0;
+	stChannelID Channel;
+	unsigned Pattern = 0;
+};
+
+// // // Per-song cache of instrument and effect usage, held by each song
+/*!	\brief Keeps, for every pattern used by the song, the list of cells sorted by the instrument
+	or effect they contain. Lists are validated against the pattern versions on each query, so only
+	patterns edited since the last query are read again.
+*/
+class CPatternUsageIndex
+{
+public:
+	/*!	\brief Finds all cells in a song using an instrument.
+		\param song The song.
+		\param Order The channels to search.
+		\param Index The instrument index.
+		\return The matching cells in frame, row and channel order, with the track index set to 0. */
+	std::vector<stPatternMatch> FindInstrument(const CSongData &song, const CChannelOrder &Order, unsigned Index);
+
+	/*!	\brief Finds all cells in a song using an effect in any visible effect column.
+		\param song The song.
+		\param Order The channels to search.
+		\param fx The effect type.
+		\return The matching cells in frame, row and channel order, with the track index set to 0. */
+	std::vector<stPatternMatch> FindEffect(const CSongData &song, const CChannelOrder &Order, effect_t fx);
+
+private:
+	struct stPatternUsage {
+		// Key << 16 | Row << 8 | Column, sorted; keys are instruments, or 0x100 plus effects
+		std::vector<std::uint32_t> Cells;
+		unsigned Generation = 0;
+	};
+
+	std::vector<stPatternMatch> Find(const CSongData &song, const CChannelOrder &Order, unsigned Key);
+	static stPatternUsage MakeUsage(const CPatternData &Pattern);
+
+	std::mutex m_Lock;
+	std::unordered_map<std::uint64_t, stPatternUsage> m_Patterns;		// Pattern version -> usage
+	unsigned m_iGeneration = 0;
+};
+
+/*!
+	\brief Searches the patterns of every song in a module.
+	\details The module must not be modified while a search is running.
+*/
+class CPatternSearch
+{
+public:
+	/*!	\brief Constructor of the pattern search.
+		\param modfile The module.
+		\param Threads The number of threads to search with. */
+	explicit CPatternSearch(const CFamiTrackerModule &modfile, unsigned Threads = 1);
+
+	/*!	\brief Finds all cells matching a search term, reading every cell of the module.
+		\param Matcher The compiled search term.
+		\return The matching cells in track, frame, row and channel order. */
+	std::vector<stPatternMatch> Find(const CPatternMatcher &Matcher) const;
+
+	/*!	\brief Finds all cells using an instrument through the songs' usage indices.
+		\param Index The instrument index.
+		\return The matching cells in track, frame, row and channel order. */
+	std::vector<stPatternMatch> FindInstrument(unsigned Index) const;
+
+	/*!	\brief Finds all cells using an effect through the songs' usage indices.
+		\param fx The effect type.
+		\return The matching cells in track, frame, row and channel order. */
+	std::vector<stPatternMatch> FindEffect(effect_t fx) const;
+
+private:
+	template <typename F>
+	std::vector<stPatternMatch> FindSongs(F f) const;
+
+	const CFamiTrackerModule &modfile_;
+	unsigned threads_;
+};
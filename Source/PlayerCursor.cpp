@@ -24,17 +24,22 @@
 #include "SongData.h"
 
 CPlayerCursor::CPlayerCursor(const CSongData &song, unsigned index) :
-	song_(song), track_(index)
+	song_(&song), track_(index)
 {
 }
 
 CPlayerCursor::CPlayerCursor(const CSongData &song, unsigned index, unsigned frame, unsigned row) :
-	song_(song), track_(index), frame_(frame), row_(row)
+	song_(&song), track_(index), frame_(frame), row_(row)
 {
 }
 
 const CSongData &CPlayerCursor::GetSong() const {
-	return song_;
+	return *song_;
+}
+
+void CPlayerCursor::SetSong(const CSongData &song) {		// // //
+	song_ = &song;
+	frame_ %= song_->GetFrameCount();
 }
 
 void CPlayerCursor::QueueFrame(unsigned frame) {
@@ -51,7 +56,7 @@ void CPlayerCursor::Tick() {
 }
 
 void CPlayerCursor::StepRow() {
-	if (++row_ >= song_.GetPatternLength()) {
+	if (++row_ >= song_->GetPatternLength()) {
 		row_ = 0;
 		MoveToCheckedFrame(frame_ + 1);
 	}
@@ -72,7 +77,7 @@ void CPlayerCursor::MoveToRow(unsigned Row) {
 }
 
 void CPlayerCursor::MoveToFrame(unsigned frame) {
-	frame_ = frame % song_.GetFrameCount();
+	frame_ = frame % song_->GetFrameCount();
 	++total_frames_;
 }
 
@@ -81,7 +86,7 @@ void CPlayerCursor::MoveToCheckedFrame(unsigned frame) {
 }
 
 void CPlayerCursor::DoBxx(unsigned frame) {
-	const unsigned Max = song_.GetFrameCount() - 1;
+	const unsigned Max = song_->GetFrameCount() - 1;
 	MoveToFrame(frame <= Max ? frame : Max);
 	MoveToRow(0);
 }
@@ -91,7 +96,7 @@ void CPlayerCursor::DoCxx() {
 }
 
 void CPlayerCursor::DoDxx(unsigned row) {
-	const unsigned Max = song_.GetPatternLength() - 1;
+	const unsigned Max = song_->GetPatternLength() - 1;
 	MoveToCheckedFrame(frame_ + 1);
 	MoveToRow(row <= Max ? row : Max);
 }
@@ -34,6 +34,7 @@ public:
 	CPlayerCursor(const CSongData &song, unsigned index, unsigned frame, unsigned row);
 
 	const CSongData &GetSong() const;
+	void SetSong(const CSongData &song);		// // // same song in a newer module snapshot
 
 	void QueueFrame(unsigned frame);
 	void EnableFrameLoop();
@@ -62,7 +63,7 @@ private:
 	void MoveToCheckedFrame(unsigned frame);
 	unsigned DequeueFrame();
 
-	const CSongData &song_;
+	const CSongData *song_;		// // //
 
 	unsigned track_ = 0;
 	unsigned frame_ = 0;
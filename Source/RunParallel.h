@@ -0,0 +1,53 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Calls f(i) for every i below Count on a pool of worker threads; the calling thread
+// is one of the workers, so Threads == 1 runs everything in order on the caller
+// Once *pCancel is set, workers finish their current call and take no new ones;
+// returns false if any call was skipped that way
+template <typename F>
+bool RunParallel(std::size_t Count, unsigned Threads, F f, const std::atomic_bool *pCancel = nullptr) {
+	std::atomic<std::size_t> Next {0u};
+	const auto Worker = [&] {
+		for (std::size_t i; !(pCancel && *pCancel) && (i = Next++) < Count; )
+			f(i);
+	};
+
+	Threads = std::clamp<unsigned>(Threads, 1u, std::max<unsigned>(Count, 1u));
+	std::vector<std::thread> Pool;
+	for (unsigned i = 1; i < Threads; ++i)
+		Pool.emplace_back(Worker);
+	Worker();
+	for (auto &t : Pool)
+		t.join();
+	return Next >= Count;
+}
@@ -0,0 +1,69 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed-size ring of slots passed from one producer thread to one consumer thread without
+// locking; neither side ever waits, a full ring makes the producer drop its item instead
+template <typename T, std::size_t N>
+class CSPSCRing
+{
+	static_assert(N >= 2 && !(N & (N - 1)), "Ring size must be a power of 2");
+
+public:
+	// Producer side: returns the slot to fill, or nullptr if the ring is full
+	T *BeginWrite() noexcept {
+		const std::size_t head = head_.load(std::memory_order_relaxed);
+		if (head - tail_.load(std::memory_order_acquire) == N)
+			return nullptr;
+		return &slots_[head % N];
+	}
+
+	// Producer side: publishes the slot returned by BeginWrite
+	void EndWrite() noexcept {
+		head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Consumer side: returns the oldest filled slot, or nullptr if the ring is empty
+	T *BeginRead() noexcept {
+		const std::size_t tail = tail_.load(std::memory_order_relaxed);
+		if (head_.load(std::memory_order_acquire) == tail)
+			return nullptr;
+		return &slots_[tail % N];
+	}
+
+	// Consumer side: hands the slot returned by BeginRead back to the producer
+	void EndRead() noexcept {
+		tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	alignas(64) std::atomic<std::size_t> head_ {0u};		// Next slot to write
+	alignas(64) std::atomic<std::size_t> tail_ {0u};		// Next slot to read
+	std::array<T, N> slots_ = { };
+};
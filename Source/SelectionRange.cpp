@@ -24,6 +24,7 @@
 #include "PatternEditorTypes.h"
 #include "SongView.h"
 #include "SongData.h"
+#include <utility>		// // //
 
 CPatternIterator::CPatternIterator(CSongView &view, const CCursorPos &Pos) :
 	m_iFrame(Pos.Ypos.Frame),
@@ -59,7 +60,7 @@ CCursorPos CPatternIterator::GetCursor() const {
 
 const stChanNote &CPatternIterator::Get(int Channel) const
 {
-	return song_view_.GetPatternOnFrame(Channel, TranslateFrame()).GetNoteOn(m_iRow);
+	return std::as_const(song_view_).GetPatternOnFrame(Channel, TranslateFrame()).GetNoteOn(m_iRow);		// // //
 }
 
 void CPatternIterator::Set(int Channel, const stChanNote &Note)
@@ -23,6 +23,7 @@
 #include "SeqInstrument.h"
 #include "InstrumentManagerInterface.h"
 #include "Sequence.h"
+#include "ContentHash.h"		// // //
 
 /*
  * Base class for instruments using sequences
@@ -108,6 +109,19 @@ void CSeqInstrument::SetSequence(sequence_t SeqType, std::shared_ptr<CSequence>
 		m_pInstManager->SetSequence(m_iType, SeqType, it->second.second, std::move(pSeq));
 }
 
+void CSeqInstrument::HashContent(CContentHash &hash) const		// // //
+{
+	CInstrument::HashContent(hash);
+
+	// sequence indices differ between modules, only the enabled contents count
+	foreachSeq([&] (sequence_t SeqType) {
+		auto pSeq = GetSeqEnable(SeqType) ? GetSequence(SeqType) : nullptr;
+		hash.Add(pSeq != nullptr);
+		if (pSeq)
+			pSeq->HashContent(hash);
+	});
+}
+
 bool CSeqInstrument::CanRelease() const
 {
 	return GetSeqEnable(sequence_t::Volume) && GetSequence(sequence_t::Volume)->GetReleasePoint() != -1;
@@ -46,6 +46,8 @@ public:
 	virtual std::shared_ptr<CSequence> GetSequence(sequence_t SeqType) const;		// // //
 	virtual void	SetSequence(sequence_t SeqType, std::shared_ptr<CSequence> pSeq);		// // // register sequence in document
 
+	void	HashContent(CContentHash &hash) const override;		// // //
+
 	// static const int SEQUENCE_TYPES[] = {sequence_t::Volume, sequence_t::Arpeggio, sequence_t::Pitch, sequence_t::HiPitch, sequence_t::DutyCycle};
 	virtual const char *GetSequenceName(int Index) const { return nullptr; }		// // //
 
@@ -21,6 +21,7 @@
 */
 
 #include "Sequence.h"
+#include "ContentHash.h"		// // //
 #include <stdexcept>		// // //
 #include <algorithm>		// // //
 
@@ -34,6 +35,12 @@ bool CSequence::operator==(const CSequence &other)		// // //
 			other.m_cValues.cbegin(), other.m_cValues.cbegin() + m_iItemCount);
 }
 
+void CSequence::HashContent(CContentHash &hash) const		// // //
+{
+	hash.Add(seq_type_).Add(m_iItemCount).Add(m_iLoopPoint).Add(m_iReleasePoint).Add(m_iSetting);
+	hash.Add(array_view<std::uint8_t> {reinterpret_cast<const std::uint8_t *>(m_cValues.data()), m_iItemCount});
+}
+
 void CSequence::Clear() {
 	SetItemCount(0);		// // //
 	m_cValues.fill(0);
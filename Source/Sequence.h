@@ -100,6 +100,8 @@ struct enum_traits<arp_scheme_mode_t> {
 const int ARPSCHEME_MAX = 36;		// // // highest note offset for arp schemes
 const int ARPSCHEME_MIN = ARPSCHEME_MAX - 0x3F;		// // //
 
+class CContentHash;		// // //
+
 /*
 ** This class is used to store instrument sequences
 */
@@ -108,6 +110,7 @@ public:
 	explicit constexpr CSequence(sequence_t SeqType) : seq_type_(SeqType) { }		// // //
 
 	bool         operator==(const CSequence &other);		// // //
+	void		 HashContent(CContentHash &hash) const;		// // // type and items
 
 	void		 Clear();
 
@@ -100,6 +100,7 @@ public:
 		int		iTrebleFilter;
 		int		iTrebleDamping;
 		int		iMixVolume;
+		bool	bNativeVRC7;		// // // Rate-independent VRC7 synthesis, for quality rather than speed
 	} Sound;
 
 	struct {
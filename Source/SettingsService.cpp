@@ -295,6 +295,7 @@ void CSettingsService::SetupSettings() {
 	NewSetting(L"Sound", L"Treble filter freq", 12000, s.Sound.iTrebleFilter);
 	NewSetting(L"Sound", L"Treble filter damping", 24, s.Sound.iTrebleDamping);
 	NewSetting(L"Sound", L"Volume", 100, s.Sound.iMixVolume);
+	NewSetting(L"Sound", L"VRC7 native rate", false, s.Sound.bNativeVRC7);		// // //
 
 	// Midi
 	NewSetting(L"MIDI", L"Device", 0, s.Midi.iMidiDevice);
@@ -25,6 +25,9 @@
 #include "ChannelOrder.h"		// // //
 #include "FamiTrackerEnv.h"		// // //
 #include "SoundChipService.h"		// // //
+#include "SongState.h"		// // //
+#include "SongLengthScanner.h"		// // //
+#include "PatternSearch.h"		// // //
 
 // Defaults when creating new modules
 const unsigned CSongData::DEFAULT_ROW_COUNT	= 64;
@@ -35,13 +38,32 @@ const stHighlight CSongData::DEFAULT_HIGHLIGHT = {4, 16, 0};		// // //
 
 CSongData::CSongData(unsigned int PatternLength) :		// // //
 	m_sTrackName("New song"),
-	m_iPatternLength(PatternLength)
+	m_iPatternLength(PatternLength),
+	state_index_(std::make_shared<CSongStateIndex>()),		// // //
+	length_index_(std::make_shared<CSongLengthIndex>()),		// // //
+	usage_index_(std::make_shared<CPatternUsageIndex>())		// // //
 {
 	FTEnv.GetSoundChipService()->ForeachTrack([&] (stChannelID track) {		// // //
 		tracks_.try_emplace(track);
 	});
 }
 
+CSongData::CSongData(const CSongData &other) :		// // //
+	m_sTrackName(other.m_sTrackName),
+	m_iPatternLength(other.m_iPatternLength),
+	m_iFrameCount(other.m_iFrameCount),
+	m_iSongSpeed(other.m_iSongSpeed),
+	m_iSongTempo(other.m_iSongTempo),
+	m_bUseGroove(other.m_bUseGroove),
+	m_vRowHighlight(other.m_vRowHighlight),
+	tracks_(other.tracks_),
+	state_index_(other.state_index_),		// the indices are locked and validated on use
+	length_index_(other.length_index_),
+	usage_index_(other.usage_index_)
+{
+	SetBookmarks(other.bookmarks_);
+}
+
 CSongData::~CSongData() {
 }
 
@@ -86,10 +108,10 @@ const stChanNote &CSongData::GetPatternData(stChannelID Channel, unsigned Patter
 }
 
 stChanNote CSongData::GetActiveNote(stChannelID Channel, unsigned Frame, unsigned Row) const {		// // //
-	stChanNote Note = GetPatternOnFrame(Channel, Frame).GetNoteOn(Row);
-	for (int i = GetEffectColumnCount(Channel); i < MAX_EFFECT_COLUMNS; ++i)
-		Note.Effects[i] = { };
-	return Note;
+	auto track = GetTrack(Channel);
+	if (!track)
+		throw std::out_of_range {"Bad stChannelID in CSongData::GetActiveNote(stChannelID, unsigned, unsigned)"};
+	return track->GetActiveNote(Frame, Row);
 }
 
 void CSongData::SetPatternData(stChannelID Channel, unsigned Pattern, unsigned Row, const stChanNote &Note)		// // //
@@ -388,3 +410,31 @@ void CSongData::SetBookmarks(const CBookmarkCollection &bookmarks) {
 void CSongData::SetBookmarks(CBookmarkCollection &&bookmarks) {
 	bookmarks_ = std::move(bookmarks);
 }
+
+CSongStateIndex &CSongData::GetStateIndex() const {		// // //
+	return *state_index_;
+}
+
+CSongLengthIndex &CSongData::GetLengthIndex() const {		// // //
+	return *length_index_;
+}
+
+CPatternUsageIndex &CSongData::GetUsageIndex() const {		// // //
+	return *usage_index_;
+}
+
+CSongDirtyRows &CSongData::GetDirtyRows() {		// // //
+	return dirty_rows_;
+}
+
+const CSongDirtyRows &CSongData::GetDirtyRows() const {		// // //
+	return dirty_rows_;
+}
+
+std::size_t CSongData::GetFootprint() const {		// // //
+	std::size_t Size = tracks_.size() * sizeof(decltype(tracks_)::value_type);
+	VisitPatterns([&] (const CPatternData &pattern) {
+		Size += pattern.GetFootprint();
+	});
+	return Size;
+}
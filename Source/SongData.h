@@ -24,19 +24,27 @@
 #pragma once
 
 #include <map>		// // //
+#include <memory>		// // //
 #include <string>		// // //
 #include "APU/Types.h"		// // //
 #include "TrackData.h"		// // //
 #include "Highlight.h"		// // //
 #include "BookmarkCollection.h"		// // //
+#include "SongDirtyRows.h"		// // //
 
 class stChanNote;		// // //
+class CSongStateIndex;		// // //
+class CSongLengthIndex;		// // //
+class CPatternUsageIndex;		// // //
 
 // CSongData holds all notes in the patterns
 class CSongData
 {
 public:
 	explicit CSongData(unsigned int PatternLength);		// // //
+	// // // Copies share the pattern rows and the cached indices with the original song
+	CSongData(const CSongData &other);
+	CSongData &operator=(const CSongData &other) = delete;
 	~CSongData();
 
 	CTrackData *GetTrack(stChannelID chan);		// // //
@@ -101,6 +109,17 @@ public:
 	void SetBookmarks(const CBookmarkCollection &bookmarks);
 	void SetBookmarks(CBookmarkCollection &&bookmarks);
 
+	CSongStateIndex &GetStateIndex() const;		// // //
+	CSongLengthIndex &GetLengthIndex() const;		// // //
+	CPatternUsageIndex &GetUsageIndex() const;		// // //
+
+	// // // Rows changed since the previous snapshot of the song, always clean in the document
+	CSongDirtyRows &GetDirtyRows();
+	const CSongDirtyRows &GetDirtyRows() const;
+
+	// // // Memory held by the tracks and patterns, excluding the song object itself, in bytes
+	std::size_t GetFootprint() const;
+
 	// void (*F)(CTrackData &track [, stChannelID ch])
 	template <typename F>
 	void VisitTracks(F f) {
@@ -186,4 +205,13 @@ private:
 	CBookmarkCollection bookmarks_;		// // //
 
 	std::map<stChannelID, CTrackData> tracks_;		// // //
+
+	// // // Keyframes for retrieving channel states, validated against the patterns on use
+	std::shared_ptr<CSongStateIndex> state_index_;
+	// // // Frame summaries and the last result for the song length
+	std::shared_ptr<CSongLengthIndex> length_index_;
+	// // // Instrument and effect usage of each pattern
+	std::shared_ptr<CPatternUsageIndex> usage_index_;
+	// // // Filled in by CModuleSnapshot only
+	CSongDirtyRows dirty_rows_;
 };
@@ -0,0 +1,128 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#include "SongDirtyRows.h"
+#include "SongData.h"
+#include <algorithm>
+#include <bitset>
+
+CSongDirtyRows CSongDirtyRows::Compare(const CSongData &Previous, const CSongData &Current) {
+	CSongDirtyRows Dirty;
+	const unsigned Frames = Current.GetFrameCount();
+	const unsigned Rows = Current.GetPatternLength();
+	if (Frames != Previous.GetFrameCount() || Rows != Previous.GetPatternLength()) {
+		Dirty.MarkAll();
+		return Dirty;
+	}
+
+	std::vector<std::pair<const CTrackData *, const CTrackData *>> Tracks;
+	bool Columns = false;
+	Current.VisitTracks([&] (const CTrackData &track, stChannelID ch) {
+		const CTrackData *pPrev = Previous.GetTrack(ch);
+		if (!pPrev || pPrev->GetEffectColumnCount() != track.GetEffectColumnCount())
+			Columns = true;
+		else
+			Tracks.emplace_back(pPrev, &track);
+	});
+	if (Columns) {
+		Dirty.MarkAll();
+		return Dirty;
+	}
+
+	for (unsigned f = 0; f < Frames; ++f) {
+		std::bitset<MAX_PATTERN_LENGTH> Changed;
+		for (auto [pPrev, pCurrent] : Tracks) {
+			const CPatternData &Old = pPrev->GetPatternOnFrame(f);
+			const CPatternData &New = pCurrent->GetPatternOnFrame(f);
+			if (Old != New)		// true without reading the rows if they are shared
+				for (unsigned r = 0; r < Rows; ++r)
+					if (Old.GetNoteOn(r) != New.GetNoteOn(r))
+						Changed.set(r);
+		}
+		for (unsigned r = 0; r < Rows; ) {
+			if (!Changed.test(r)) {
+				++r;
+				continue;
+			}
+			const unsigned First = r;
+			while (r < Rows && Changed.test(r))
+				++r;
+			Dirty.ranges_.push_back({f, First, r});
+		}
+	}
+
+	return Dirty;
+}
+
+void CSongDirtyRows::MarkRows(unsigned Frame, unsigned FirstRow, unsigned EndRow) {
+	if (all_ || FirstRow >= EndRow)
+		return;
+
+	const auto Before = [] (const stRange &x, const stRange &y) {
+		return x.Frame < y.Frame || (x.Frame == y.Frame && x.EndRow < y.FirstRow);
+	};
+	stRange Range {Frame, FirstRow, EndRow};
+	auto [b, e] = std::equal_range(ranges_.begin(), ranges_.end(), Range, Before);
+	if (b != e) {		// absorb the ranges overlapping or touching the new one
+		Range.FirstRow = std::min(Range.FirstRow, b->FirstRow);
+		Range.EndRow = std::max(Range.EndRow, std::prev(e)->EndRow);
+		*b = Range;
+		ranges_.erase(std::next(b), e);
+	}
+	else
+		ranges_.insert(b, Range);
+}
+
+void CSongDirtyRows::MarkAll() noexcept {
+	all_ = true;
+	ranges_.clear();
+}
+
+void CSongDirtyRows::Merge(const CSongDirtyRows &other) {
+	if (other.all_)
+		return MarkAll();
+	for (const auto &x : other.ranges_)
+		MarkRows(x.Frame, x.FirstRow, x.EndRow);
+}
+
+bool CSongDirtyRows::IsClean() const noexcept {
+	return !all_ && ranges_.empty();
+}
+
+bool CSongDirtyRows::IsAllDirty() const noexcept {
+	return all_;
+}
+
+bool CSongDirtyRows::IsDirty(unsigned Frame, unsigned FirstRow, unsigned EndRow) const {
+	if (all_)
+		return true;
+	auto it = std::lower_bound(ranges_.begin(), ranges_.end(), stRange {Frame, FirstRow, FirstRow},
+		[] (const stRange &x, const stRange &y) {
+			return x.Frame < y.Frame || (x.Frame == y.Frame && x.EndRow <= y.FirstRow);
+		});
+	return it != ranges_.end() && it->Frame == Frame && it->FirstRow < EndRow;
+}
+
+const std::vector<CSongDirtyRows::stRange> &CSongDirtyRows::GetRanges() const noexcept {
+	return ranges_;
+}
@@ -0,0 +1,77 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <vector>
+
+class CSongData;
+
+// // // Changed rows of a song
+
+/*!
+	\brief The rows of a song that differ from an earlier copy of the song.
+	\details Ranges are sorted by frame and row and never overlap or touch. Changes to the frame
+	count, the pattern length or the effect columns affect every row and mark the whole song.
+*/
+class CSongDirtyRows {
+public:
+	struct stRange {
+		unsigned Frame = 0;
+		unsigned FirstRow = 0;
+		unsigned EndRow = 0;		// One past the last changed row
+	};
+
+	/*!	\brief Finds the changed rows between two copies of a song.
+		\details Patterns sharing their rows are skipped without reading them.
+		\param Previous The earlier copy.
+		\param Current The later copy.
+		\return The rows of the later copy that differ from the earlier one. */
+	static CSongDirtyRows Compare(const CSongData &Previous, const CSongData &Current);
+
+	/*!	\brief Marks a range of rows in a frame as changed.
+		\param Frame The frame index.
+		\param FirstRow The first changed row.
+		\param EndRow One past the last changed row. */
+	void MarkRows(unsigned Frame, unsigned FirstRow, unsigned EndRow);
+	/*!	\brief Marks the whole song as changed. */
+	void MarkAll() noexcept;
+	/*!	\brief Adds the changed rows of another object.
+		\param other The changed rows. */
+	void Merge(const CSongDirtyRows &other);
+
+	bool IsClean() const noexcept;
+	bool IsAllDirty() const noexcept;
+	/*!	\brief Tests whether any row in a range has changed.
+		\param Frame The frame index.
+		\param FirstRow The first row.
+		\param EndRow One past the last row.
+		\return True if the whole song or any of the rows has changed. */
+	bool IsDirty(unsigned Frame, unsigned FirstRow, unsigned EndRow) const;
+	/*!	\brief Returns the changed row ranges, which are empty if the whole song has changed. */
+	const std::vector<stRange> &GetRanges() const noexcept;
+
+private:
+	std::vector<stRange> ranges_;
+	bool all_ = false;
+};
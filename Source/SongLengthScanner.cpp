@@ -26,83 +26,12 @@
 #include "SongData.h"
 #include "ft0cc/doc/groove.hpp"
 #include "ChannelOrder.h"
-#include <bitset>
-#include <type_traits>
+#include "PatternData.h"		// // //
+#include "ContentHash.h"		// // //
 #include <algorithm>
 
 
 
-class loop_visitor {
-public:
-	explicit loop_visitor(const CConstSongView &view) :
-		song_view_(view.GetChannelOrder().Canonicalize(), view.GetSong(), false) { }
-
-	template <typename F, typename G>
-	void Visit(F cb, G fx) {
-		unsigned FrameCount = song_view_.GetSong().GetFrameCount();
-		unsigned Rows = song_view_.GetSong().GetPatternLength();
-
-		std::bitset<MAX_PATTERN_LENGTH> RowVisited[MAX_FRAMES] = { };		// // //
-		while (!RowVisited[f_][r_]) {
-			RowVisited[f_][r_] = true;
-
-			int Bxx = -1;
-			int Dxx = -1;
-			bool Cxx = false;
-
-			song_view_.ForeachTrack([&] (const CTrackData &track /* , stChannelID id */) {
-				const auto &Note = track.GetPatternOnFrame(f_).GetNoteOn(r_);		// // //
-				for (unsigned l = 0, m = track.GetEffectColumnCount(); l < m; ++l) {
-					switch (Note.Effects[l].fx) {
-					case effect_t::JUMP:
-						Bxx = Note.Effects[l].param;
-						break;
-					case effect_t::SKIP:
-						Dxx = Note.Effects[l].param;
-						break;
-					case effect_t::HALT:
-						Cxx = true;
-						break;
-					default:
-						fx(/* id, */ Note.Effects[l]);
-					}
-				}
-			});
-
-			if (Cxx && !first_)
-				break;
-			cb();
-			if (Cxx)
-				break;
-
-			if (Bxx != -1) {
-				f_ = std::min(static_cast<unsigned int>(Bxx), FrameCount - 1);
-				r_ = 0;
-			}
-			else if (Dxx != -1) {
-				if (++f_ >= FrameCount)
-					f_ = 0;
-				r_ = std::min(static_cast<unsigned int>(Dxx), Rows - 1);
-			}
-			else if (++r_ >= Rows) {		// // //
-				r_ = 0;
-				if (++f_ >= FrameCount)
-					f_ = 0;
-			}
-		}
-
-		first_ = false;
-	}
-
-private:
-	CConstSongView song_view_;
-	unsigned f_ = 0;
-	unsigned r_ = 0;
-	bool first_ = true;
-};
-
-
-
 CSongLengthScanner::CSongLengthScanner(const CFamiTrackerModule &modfile, const CConstSongView &view) :
 	modfile_(modfile), song_view_(view)
 {
@@ -122,57 +51,239 @@ void CSongLengthScanner::Compute() {
 	if (std::exchange(scanned_, true))
 		return;
 
-	const auto &song = song_view_.GetSong();
+	const auto Length = song_view_.GetSong().GetLengthIndex().Get(modfile_, song_view_);		// // //
+	rows1_ = Length.IntroRows;
+	rows2_ = Length.LoopRows;
+	sec1_ = Length.IntroSeconds;
+	sec2_ = Length.LoopSeconds;
+}
+
+
+
+namespace {
+
+std::uint64_t GetFrameFingerprint(const CConstSongView &view, unsigned Frame) {
+	// pattern versions stand in for the pattern contents
+	CContentHash hash;
+	hash.Add(view.GetSong().GetPatternLength());
+	view.ForeachTrack([&] (const CTrackData &track) {
+		hash.Add(track.GetEffectColumnCount());
+		hash.Add(track.GetPatternOnFrame(Frame).GetVersion());
+	});
+	return hash.Get();
+}
+
+} // namespace
+
+CSongLengthIndex::stSongLength CSongLengthIndex::Get(const CFamiTrackerModule &modfile, const CConstSongView &view) {
+	std::lock_guard<std::mutex> lock {m_Lock};
+
+	const CConstSongView SongView {view.GetChannelOrder().Canonicalize(), view.GetSong(), false};
+	const auto &song = SongView.GetSong();
+
+	CContentHash hash;
+	hash.Add(song.GetFrameCount()).Add(song.GetSongSpeed()).Add(song.GetSongTempo()).Add(song.GetSongGroove());
+	hash.Add(modfile.GetFrameRate()).Add(modfile.GetSpeedSplitPoint());
+	for (unsigned i = 0; i < MAX_GROOVE; ++i)
+		if (auto pGroove = modfile.GetGroove(i)) {
+			hash.Add(i).Add(pGroove->size());
+			for (auto x : *pGroove)
+				hash.Add(x);
+		}
+	std::vector<std::uint64_t> Fingerprints(song.GetFrameCount());
+	for (unsigned i = 0; i < Fingerprints.size(); ++i)
+		hash.Add(Fingerprints[i] = GetFrameFingerprint(SongView, i));
+
+	if (!std::exchange(m_bHasResult, true) || m_iResultKey != hash.Get()) {
+		m_iResultKey = hash.Get();
+		m_Frames.resize(Fingerprints.size());
+		m_Result = Compute(modfile, SongView, Fingerprints);
+	}
+	return m_Result;
+}
+
+const CSongLengthIndex::stFrameSummary &CSongLengthIndex::GetSummary(const CConstSongView &view, unsigned Frame, std::uint64_t Fingerprint) {
+	auto &Summary = m_Frames[Frame];
+	if (Summary.Valid && Summary.Fingerprint == Fingerprint)
+		return Summary;
+	Summary.Fingerprint = Fingerprint;
+	Summary.Valid = true;
+	Summary.Events.clear();
+
+	// the last Bxx and Dxx commands of a row take effect; speed commands are kept in order
+	std::vector<stRowEvent> Rows(view.GetSong().GetPatternLength());
+	view.ForeachTrack([&] (const CTrackData &track) {
+		const unsigned EffColumns = track.GetEffectColumnCount();
+		track.GetPatternOnFrame(Frame).VisitRows(Rows.size(), [&] (const stChanNote &Note, unsigned Row) {
+			for (unsigned l = 0; l < EffColumns; ++l) {
+				const stEffectCommand &cmd = Note.Effects[l];
+				switch (cmd.fx) {
+				case effect_t::JUMP:
+					Rows[Row].Jump = cmd.param;
+					break;
+				case effect_t::SKIP:
+					Rows[Row].Skip = cmd.param;
+					break;
+				case effect_t::HALT:
+					Rows[Row].Halt = true;
+					break;
+				case effect_t::SPEED: case effect_t::GROOVE:
+					Rows[Row].Effects.push_back(cmd);
+					break;
+				}
+			}
+		});
+	});
+
+	for (unsigned Row = 0; Row < Rows.size(); ++Row)
+		if (auto &Event = Rows[Row]; Event.Jump != -1 || Event.Skip != -1 || Event.Halt || !Event.Effects.empty()) {
+			Event.Row = Row;
+			Summary.Events.push_back(std::move(Event));
+		}
+
+	return Summary;
+}
+
+CSongLengthIndex::stSongLength CSongLengthIndex::Compute(const CFamiTrackerModule &modfile, const CConstSongView &view,
+	const std::vector<std::uint64_t> &Fingerprints) {
+	const auto &song = view.GetSong();
+	const unsigned FrameCount = song.GetFrameCount();
+	const unsigned Rows = song.GetPatternLength();
 
 	double Tempo = song.GetSongTempo();
 	if (!Tempo)
-		Tempo = 2.5 * modfile_.GetFrameRate();
+		Tempo = 2.5 * modfile.GetFrameRate();
 	const bool AllowTempo = song.GetSongTempo() != 0;
-	const int Split = modfile_.GetSpeedSplitPoint();
+	const int Split = modfile.GetSpeedSplitPoint();
 	int Speed = song.GetSongSpeed();
 	int GrooveIndex = song.GetSongGroove() ? Speed : -1;
-	int GroovePointer = 0;
+	unsigned GroovePointer = 0;
 
-	if (GrooveIndex != -1 && !modfile_.HasGroove(Speed)) {
+	if (GrooveIndex != -1 && !modfile.HasGroove(Speed)) {
 		GrooveIndex = -1;
 		Speed = DEFAULT_SPEED;
 	}
 
-	const auto fxhandler = [&] (stEffectCommand cmd) {
-		switch (cmd.fx) {
-		case effect_t::SPEED:
-			if (AllowTempo && cmd.param >= Split)
-				Tempo = cmd.param;
-			else {
-				GrooveIndex = -1;
-				Speed = cmd.param;
+	// ticks are counted while the tempo stays the same
+	unsigned long long Ticks = 0;
+	double Seconds = 0.;
+	const auto Flush = [&] {
+		Seconds += Ticks / Tempo;
+		Ticks = 0;
+	};
+	const auto Advance = [&] (unsigned Count) {
+		if (auto pGroove = modfile.GetGroove(GrooveIndex)) {
+			if (const unsigned Size = pGroove->size()) {
+				unsigned long long Cycle = 0;
+				for (auto x : *pGroove)
+					Cycle += x;
+				Ticks += Count / Size * Cycle;
+				for (unsigned i = 0; i < Count % Size; ++i)
+					Ticks += pGroove->entry(GroovePointer + i);
+				GroovePointer = (GroovePointer + Count) % Size;
 			}
-			break;
-		case effect_t::GROOVE:
-			if (modfile_.HasGroove(cmd.param)) {
-				GrooveIndex = cmd.param;
-				GroovePointer = 0;
+			else
+				Ticks += Count * ft0cc::doc::groove::default_speed;
+		}
+		else
+			Ticks += static_cast<unsigned long long>(Count) * Speed;
+	};
+
+	unsigned f = 0;
+	unsigned r = 0;
+
+	// plays the song until a row repeats or a Cxx command is found, returns the number of rows
+	const auto Pass = [&] (bool First) {
+		std::vector<std::vector<std::pair<unsigned, unsigned>>> Visited(FrameCount);		// row ranges
+		unsigned RowCount = 0;
+		Seconds = 0.;
+
+		while (true) {
+			const auto &Events = GetSummary(view, f, Fingerprints[f]).Events;
+			const auto it = std::lower_bound(Events.begin(), Events.end(), r, [] (const stRowEvent &x, unsigned Row) { return x.Row < Row; });
+			const unsigned Last = it != Events.end() ? it->Row : Rows - 1;
+
+			unsigned Repeat = Last + 1;
+			for (auto [b, e] : Visited[f])
+				if (b <= Last && e >= r)
+					Repeat = std::min(Repeat, std::max(b, r));
+			if (Repeat <= Last) {
+				Advance(Repeat - r);
+				RowCount += Repeat - r;
+				r = Repeat;
+				break;
+			}
+			if (auto &Ranges = Visited[f]; !Ranges.empty() && Ranges.back().second + 1 == r)
+				Ranges.back().second = Last;
+			else
+				Ranges.emplace_back(r, Last);
+
+			Advance(Last - r);
+			RowCount += Last - r;
+			r = Last;
+			if (it == Events.end()) {
+				Advance(1);
+				++RowCount;
+				r = 0;
+				if (++f >= FrameCount)
+					f = 0;
+				continue;
+			}
+
+			Flush();
+			for (const auto &cmd : it->Effects)
+				switch (cmd.fx) {
+				case effect_t::SPEED:
+					if (AllowTempo && cmd.param >= Split)
+						Tempo = cmd.param;
+					else {
+						GrooveIndex = -1;
+						Speed = cmd.param;
+					}
+					break;
+				case effect_t::GROOVE:
+					if (modfile.HasGroove(cmd.param)) {
+						GrooveIndex = cmd.param;
+						GroovePointer = 0;
+					}
+					break;
+				}
+
+			if (it->Halt && !First)
+				break;
+			Advance(1);
+			++RowCount;
+			if (it->Halt)
+				break;
+
+			if (it->Jump != -1) {
+				f = std::min(static_cast<unsigned int>(it->Jump), FrameCount - 1);
+				r = 0;
+			}
+			else if (it->Skip != -1) {
+				if (++f >= FrameCount)
+					f = 0;
+				r = std::min(static_cast<unsigned int>(it->Skip), Rows - 1);
+			}
+			else if (++r >= Rows) {
+				r = 0;
+				if (++f >= FrameCount)
+					f = 0;
 			}
-			break;
 		}
+
+		Flush();
+		return RowCount;
 	};
 
-	loop_visitor visitor(song_view_);
-	visitor.Visit([&] {
-		if (auto pGroove = modfile_.GetGroove(GrooveIndex))
-			Speed = pGroove->entry(GroovePointer++);
-		sec1_ += Speed / Tempo;
-		++rows1_;
-	}, fxhandler);
-	visitor.Visit([&] {
-		if (auto pGroove = modfile_.GetGroove(GrooveIndex))
-			Speed = pGroove->entry(GroovePointer++);
-		sec2_ += Speed / Tempo;
-		++rows2_;
-	}, fxhandler);
-
-	rows1_ -= rows2_;
-	sec1_ -= sec2_;
-	sec1_ *= 2.5;
-	sec2_ *= 2.5;
+	stSongLength Length;
+	Length.IntroRows = Pass(true);
+	const double TotalSeconds = Seconds;
+	Length.LoopRows = Pass(false);
+	Length.LoopSeconds = Seconds;
+
+	Length.IntroRows -= Length.LoopRows;
+	Length.IntroSeconds = (TotalSeconds - Length.LoopSeconds) * 2.5;
+	Length.LoopSeconds *= 2.5;
+	return Length;
 }
@@ -24,6 +24,10 @@
 #pragma once
 
 #include <utility>
+#include <vector>		// // //
+#include <mutex>		// // //
+#include <cstdint>		// // //
+#include "PatternNote.h"		// // //
 
 class CFamiTrackerModule;
 class CConstSongView;
@@ -46,3 +50,51 @@ private:
 	double sec2_ = 0.;
 	bool scanned_ = false;
 };
+
+// // // Song length cache, held by each song
+/*!	\brief Keeps a summary of every frame that holds only the rows with control flow or speed
+	commands, so that the song length can be found without reading the other rows. Summaries
+	are validated against the pattern versions, and the last result is kept until the song or
+	the module settings it depends on change.
+*/
+class CSongLengthIndex {
+public:
+	struct stSongLength {
+		unsigned IntroRows = 0;
+		unsigned LoopRows = 0;
+		double IntroSeconds = 0.;
+		double LoopSeconds = 0.;
+	};
+
+	/*!	\brief Computes the length of a song, or returns the cached result.
+		\param modfile The module.
+		\param view The song view, only its channels are used.
+		\return The length of the song before and during the loop.
+	*/
+	stSongLength Get(const CFamiTrackerModule &modfile, const CConstSongView &view);
+
+private:
+	struct stRowEvent {
+		unsigned Row = 0;
+		int Jump = -1;
+		int Skip = -1;
+		bool Halt = false;
+		std::vector<stEffectCommand> Effects;		// Speed and groove commands in channel order
+	};
+
+	struct stFrameSummary {
+		std::uint64_t Fingerprint = 0;
+		bool Valid = false;
+		std::vector<stRowEvent> Events;
+	};
+
+	const stFrameSummary &GetSummary(const CConstSongView &view, unsigned Frame, std::uint64_t Fingerprint);
+	stSongLength Compute(const CFamiTrackerModule &modfile, const CConstSongView &view,
+		const std::vector<std::uint64_t> &Fingerprints);
+
+	std::mutex m_Lock;
+	std::vector<stFrameSummary> m_Frames;
+	std::uint64_t m_iResultKey = 0;
+	bool m_bHasResult = false;
+	stSongLength m_Result;
+};
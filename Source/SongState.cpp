@@ -30,6 +30,7 @@
 #include "NumConv.h"
 #include "FamiTrackerEnv.h"
 #include "SoundChipService.h"
+#include "ContentHash.h"		// // //
 
 
 
@@ -53,6 +54,117 @@ void UpdateEchoTranspose(const stChanNote &Note, int &Value, unsigned int EffCol
 	}
 }
 
+// // // Keyframe cell classes, see CSongState::HandleCell. Once the first cells of a class
+// are handled, later cells of the same class cannot change the state; the classes below
+// the effect commands are shared by all channels
+enum : unsigned {
+	CLASS_SLIDE = value_cast(effect_t::PORTAMENTO),
+	CLASS_EXX_LENGTH = enum_count<effect_t>() + 1,
+	CLASS_EXX_VOLUME,
+	CLASS_SXX_LOW,
+	CLASS_SXX_HIGH,
+	CLASS_FDS_AUTO_FM,
+	CLASS_FDS_SPEED_HI,
+	CLASS_INSTRUMENT,
+	CLASS_VOLUME,
+	CLASS_ECHO,
+	CLASS_FDS_MASK,
+	CLASS_SPEED,
+	CLASS_TEMPO,
+	CLASS_COUNT,
+	FIRST_GLOBAL_CLASS = CLASS_FDS_MASK,
+};
+
+unsigned GetClassLimit(unsigned Class) {
+	switch (Class) {
+	case CLASS_ECHO: return 16u;	// enough to resolve the echo buffer in most cases
+	case CLASS_TEMPO: return 2u;	// the first one might set the speed instead
+	}
+	return 1u;
+}
+
+// void (*F)(unsigned Class)
+template <typename F>
+void ForeachCellClass(const CFamiTrackerModule &modfile, stChannelID c, const stChanNote &Note, unsigned EffColumns, F f) {
+	if (Note.Note != note_t::none && Note.Note != note_t::release)
+		f(CLASS_ECHO);
+	if (Note.Instrument != MAX_INSTRUMENTS && Note.Instrument != HOLD_INSTRUMENT)
+		f(CLASS_INSTRUMENT);
+	if (Note.Vol != MAX_VOLUME)
+		f(CLASS_VOLUME);
+
+	for (unsigned k = 0; k < EffColumns; ++k) {
+		const stEffectCommand &cmd = Note.Effects[k];
+		if (!IsEffectCompatible(c, cmd))
+			continue;
+		switch (cmd.fx) {
+		case effect_t::SPEED:
+			f(cmd.param >= modfile.GetSpeedSplitPoint() ? CLASS_TEMPO : CLASS_SPEED);
+			break;
+		case effect_t::GROOVE:
+			if (cmd.param < MAX_GROOVE && modfile.HasGroove(cmd.param))
+				f(CLASS_SPEED);
+			break;
+		case effect_t::VOLUME:
+			if (cmd.param >= 0xE0 && cmd.param <= 0xE3)
+				f(CLASS_EXX_LENGTH);
+			else if (cmd.param <= 0x1F)
+				f(CLASS_EXX_VOLUME);
+			break;
+		case effect_t::NOTE_CUT:
+			f(cmd.param <= 0x7F ? CLASS_SXX_LOW : CLASS_SXX_HIGH);
+			break;
+		case effect_t::FDS_MOD_DEPTH:
+			if (cmd.param >= 0x80)
+				f(CLASS_FDS_AUTO_FM);
+			break;
+		case effect_t::FDS_MOD_SPEED_HI:
+			f(cmd.param <= 0x0F ? CLASS_FDS_MASK : CLASS_FDS_SPEED_HI);
+			break;
+		case effect_t::FDS_MOD_SPEED_LO:
+			f(CLASS_FDS_MASK);
+			break;
+		case effect_t::DUTY_CYCLE:
+			if (c.Chip == sound_chip_t::VRC7)
+				break;
+			[[fallthrough]];
+		case effect_t::SAMPLE_OFFSET:
+		case effect_t::FDS_VOLUME: case effect_t::FDS_MOD_BIAS:
+		case effect_t::SUNSOFT_ENV_LO: case effect_t::SUNSOFT_ENV_HI: case effect_t::SUNSOFT_ENV_TYPE:
+		case effect_t::N163_WAVE_BUFFER:
+		case effect_t::VRC7_PORT:
+		case effect_t::VIBRATO: case effect_t::TREMOLO: case effect_t::PITCH: case effect_t::VOLUME_SLIDE:
+			f(value_cast(cmd.fx));
+			break;
+		case effect_t::SWEEPUP: case effect_t::SWEEPDOWN: case effect_t::SLIDE_UP: case effect_t::SLIDE_DOWN:
+		case effect_t::PORTAMENTO: case effect_t::ARPEGGIO: case effect_t::PORTA_UP: case effect_t::PORTA_DOWN:
+			f(CLASS_SLIDE);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+bool HasHaltCommand(stChannelID c, const stChanNote &Note, unsigned EffColumns) {
+	for (unsigned k = 0; k < EffColumns; ++k)
+		if (Note.Effects[k].fx == effect_t::HALT && IsEffectCompatible(c, Note.Effects[k]))
+			return true;
+	return false;
+}
+
+std::uint64_t GetFrameFingerprint(const CConstSongView &SongView, unsigned Begin, unsigned End) {
+	// Covers everything CSongState::ScanRows reads from the frames, pattern versions stand in
+	// for the pattern contents
+	CContentHash hash;
+	SongView.ForeachTrack([&] (const CTrackData &track) {
+		hash.Add(track.GetEffectColumnCount());
+		for (unsigned f = Begin; f < End; ++f)
+			hash.Add(track.GetPatternOnFrame(f).GetVersion());
+	});
+	return hash.Get();
+}
+
 } // namespace
 
 
@@ -233,113 +345,156 @@ void stChannelState::HandleSxxCommand(unsigned char xy) {
 
 
 
+bool stChannelState::IsEchoSettled() const {		// // //
+	// no later notes can modify the echo buffer
+	if (BufferPos < (int)ECHO_BUFFER_LENGTH)
+		return false;
+	return std::none_of(Echo.begin(), Echo.end(), [] (int x) {
+		return x >= ECHO_BUFFER_ECHO && x < ECHO_BUFFER_ECHO + (int)ECHO_BUFFER_LENGTH;
+	});
+}
+
+
+
 void CSongState::Retrieve(const CFamiTrackerModule &modfile, unsigned Track, unsigned Frame, unsigned Row) {
 	CConstSongView SongView {modfile.GetChannelOrder().Canonicalize(), *modfile.GetSong(Track), false};
 	const auto &song = SongView.GetSong();
 
+	// // // scan back to the nearest keyframe, then continue from it
+	const unsigned KeyFrame = CSongStateIndex::GetKeyframeFrame(song, Frame);
+	stScanContext ctx;
+	Clear(SongView);
+	ScanRows(modfile, SongView, Frame, Row, KeyFrame, ctx);
+	if (!ctx.Halt && KeyFrame && !song.GetStateIndex().Apply(*this, modfile, SongView, KeyFrame, ctx)) {
+		ctx = stScanContext { };
+		Clear(SongView);
+		ScanRows(modfile, SongView, Frame, Row, 0, ctx);
+	}
+
+	ApplySongGroove(modfile, song, ctx);
+}
+
+void CSongState::RetrieveFullScan(const CFamiTrackerModule &modfile, unsigned Track, unsigned Frame, unsigned Row) {		// // //
+	CConstSongView SongView {modfile.GetChannelOrder().Canonicalize(), *modfile.GetSong(Track), false};
+	stScanContext ctx;
+	Clear(SongView);
+	ScanRows(modfile, SongView, Frame, Row, 0, ctx);
+	ApplySongGroove(modfile, SongView.GetSong(), ctx);
+}
+
+void CSongState::ApplySongGroove(const CFamiTrackerModule &modfile, const CSongData &song, const stScanContext &ctx) {		// // //
+	if (GroovePos == -1 && song.GetSongGroove()) {
+		unsigned Index = song.GetSongSpeed();
+		if (Index < MAX_GROOVE && modfile.HasGroove(Index)) {
+			GroovePos = ctx.TotalRows;
+			Speed = Index;
+		}
+	}
+}
+
+void CSongState::Clear(const CConstSongView &SongView) {		// // //
 	State.clear();
 	SongView.GetChannelOrder().ForeachChannel([&] (stChannelID id) {
 		State.try_emplace(id, stChannelState { });
 	});
+	Tempo = -1;
+	Speed = -1;
+	GroovePos = -1;
+}
 
-	int totalRows = 0;
-
-	bool maskFDS = false;
-	bool doHalt = false;
-
+void CSongState::ScanRows(const CFamiTrackerModule &modfile, const CConstSongView &SongView,
+	unsigned Frame, unsigned Row, unsigned StopFrame, stScanContext &ctx) {		// // //
+	// scans backward from the row before (Frame, Row) to the first row of StopFrame
 	while (true) {
 		if (Row)
 			--Row;
-		else if (Frame)
+		else if (Frame > StopFrame)
 			Row = SongView.GetFrameLength(--Frame) - 1;
 		else
 			break;
 
 		SongView.ForeachTrack([&] (const CTrackData &track, stChannelID c) {
-			stChannelState &chState = State.find(c)->second;
-			int EffColumns = track.GetEffectColumnCount();
 			const auto &Note = track.GetPatternOnFrame(Frame).GetNoteOn(Row);		// // //
-
-			chState.HandleNote(Note, EffColumns);
-
-			for (int k = EffColumns - 1; k >= 0; --k) {
-				const stEffectCommand &cmd = Note.Effects[k];
-				if (!IsEffectCompatible(c, cmd))
-					continue;
-				switch (cmd.fx) {
-				// ignore effects that cannot have memory
-				case effect_t::none: case effect_t::PORTAOFF:
-				case effect_t::DAC: case effect_t::DPCM_PITCH: case effect_t::RETRIGGER:
-				case effect_t::DELAY: case effect_t::DELAYED_VOLUME: case effect_t::NOTE_RELEASE: case effect_t::TRANSPOSE:
-				case effect_t::JUMP: case effect_t::SKIP: // no true backward iterator
-					break;
-				case effect_t::HALT:
-					doHalt = true;
-					break;
-				case effect_t::SPEED:
-					if (Speed == -1 && (cmd.param < modfile.GetSpeedSplitPoint() || song.GetSongTempo() == 0)) {
-						Speed = std::max((unsigned char)1u, cmd.param);
-						GroovePos = -2;
-					}
-					else if (Tempo == -1 && cmd.param >= modfile.GetSpeedSplitPoint())
-						Tempo = cmd.param;
-					break;
-				case effect_t::GROOVE:
-					if (GroovePos == -1 && cmd.param < MAX_GROOVE && modfile.HasGroove(cmd.param)) {
-						GroovePos = totalRows + 1;
-						Speed = cmd.param;
-					}
-					break;
-				case effect_t::VOLUME:
-					chState.HandleExxCommand2A03(cmd.param);
-					break;
-				case effect_t::NOTE_CUT:
-					chState.HandleSxxCommand(cmd.param);
-					break;
-				case effect_t::FDS_MOD_DEPTH:
-					if (chState.Effect_AutoFMMult == -1 && cmd.param >= 0x80)
-						chState.Effect_AutoFMMult = cmd.param;
-					break;
-				case effect_t::FDS_MOD_SPEED_HI:
-					if (cmd.param <= 0x0F)
-						maskFDS = true;
-					else if (!maskFDS && chState.Effect[value_cast(cmd.fx)] == -1) {
-						chState.Effect[value_cast(cmd.fx)] = cmd.param;
-						if (chState.Effect_AutoFMMult == -1)
-							chState.Effect_AutoFMMult = -2;
-					}
-					break;
-				case effect_t::FDS_MOD_SPEED_LO:
-					maskFDS = true;
-					break;
-				case effect_t::DUTY_CYCLE:
-					if (c.Chip == sound_chip_t::VRC7)		// // // 050B
-						break;
-					[[fallthrough]];
-				case effect_t::SAMPLE_OFFSET:
-				case effect_t::FDS_VOLUME: case effect_t::FDS_MOD_BIAS:
-				case effect_t::SUNSOFT_ENV_LO: case effect_t::SUNSOFT_ENV_HI: case effect_t::SUNSOFT_ENV_TYPE:
-				case effect_t::N163_WAVE_BUFFER:
-				case effect_t::VRC7_PORT:
-				case effect_t::VIBRATO: case effect_t::TREMOLO: case effect_t::PITCH: case effect_t::VOLUME_SLIDE:
-					chState.HandleNormalCommand(cmd);
-					break;
-				case effect_t::SWEEPUP: case effect_t::SWEEPDOWN: case effect_t::SLIDE_UP: case effect_t::SLIDE_DOWN:
-				case effect_t::PORTAMENTO: case effect_t::ARPEGGIO: case effect_t::PORTA_UP: case effect_t::PORTA_DOWN:
-					chState.HandleSlideCommand(cmd);
-					break;
-				}
-			}
+			HandleCell(modfile, SongView.GetSong(), c, Note, track.GetEffectColumnCount(), ctx);
 		});
-		if (doHalt)
+		if (ctx.Halt)
 			break;
-		++totalRows;
+		++ctx.TotalRows;
 	}
-	if (GroovePos == -1 && song.GetSongGroove()) {
-		unsigned Index = song.GetSongSpeed();
-		if (Index < MAX_GROOVE && modfile.HasGroove(Index)) {
-			GroovePos = totalRows;
-			Speed = Index;
+}
+
+void CSongState::HandleCell(const CFamiTrackerModule &modfile, const CSongData &song, stChannelID c,
+	const stChanNote &Note, unsigned EffColumns, stScanContext &ctx) {		// // //
+	stChannelState &chState = State.find(c)->second;
+
+	chState.HandleNote(Note, EffColumns);
+
+	for (int k = EffColumns - 1; k >= 0; --k) {
+		const stEffectCommand &cmd = Note.Effects[k];
+		if (!IsEffectCompatible(c, cmd))
+			continue;
+		switch (cmd.fx) {
+		// ignore effects that cannot have memory
+		case effect_t::none: case effect_t::PORTAOFF:
+		case effect_t::DAC: case effect_t::DPCM_PITCH: case effect_t::RETRIGGER:
+		case effect_t::DELAY: case effect_t::DELAYED_VOLUME: case effect_t::NOTE_RELEASE: case effect_t::TRANSPOSE:
+		case effect_t::JUMP: case effect_t::SKIP: // no true backward iterator
+			break;
+		case effect_t::HALT:
+			ctx.Halt = true;
+			break;
+		case effect_t::SPEED:
+			if (Speed == -1 && (cmd.param < modfile.GetSpeedSplitPoint() || song.GetSongTempo() == 0)) {
+				Speed = std::max((unsigned char)1u, cmd.param);
+				GroovePos = -2;
+			}
+			else if (Tempo == -1 && cmd.param >= modfile.GetSpeedSplitPoint())
+				Tempo = cmd.param;
+			break;
+		case effect_t::GROOVE:
+			if (GroovePos == -1 && cmd.param < MAX_GROOVE && modfile.HasGroove(cmd.param)) {
+				GroovePos = ctx.TotalRows + 1;
+				Speed = cmd.param;
+			}
+			break;
+		case effect_t::VOLUME:
+			chState.HandleExxCommand2A03(cmd.param);
+			break;
+		case effect_t::NOTE_CUT:
+			chState.HandleSxxCommand(cmd.param);
+			break;
+		case effect_t::FDS_MOD_DEPTH:
+			if (chState.Effect_AutoFMMult == -1 && cmd.param >= 0x80)
+				chState.Effect_AutoFMMult = cmd.param;
+			break;
+		case effect_t::FDS_MOD_SPEED_HI:
+			if (cmd.param <= 0x0F)
+				ctx.MaskFDS = true;
+			else if (!ctx.MaskFDS && chState.Effect[value_cast(cmd.fx)] == -1) {
+				chState.Effect[value_cast(cmd.fx)] = cmd.param;
+				if (chState.Effect_AutoFMMult == -1)
+					chState.Effect_AutoFMMult = -2;
+			}
+			break;
+		case effect_t::FDS_MOD_SPEED_LO:
+			ctx.MaskFDS = true;
+			break;
+		case effect_t::DUTY_CYCLE:
+			if (c.Chip == sound_chip_t::VRC7)		// // // 050B
+				break;
+			[[fallthrough]];
+		case effect_t::SAMPLE_OFFSET:
+		case effect_t::FDS_VOLUME: case effect_t::FDS_MOD_BIAS:
+		case effect_t::SUNSOFT_ENV_LO: case effect_t::SUNSOFT_ENV_HI: case effect_t::SUNSOFT_ENV_TYPE:
+		case effect_t::N163_WAVE_BUFFER:
+		case effect_t::VRC7_PORT:
+		case effect_t::VIBRATO: case effect_t::TREMOLO: case effect_t::PITCH: case effect_t::VOLUME_SLIDE:
+			chState.HandleNormalCommand(cmd);
+			break;
+		case effect_t::SWEEPUP: case effect_t::SWEEPDOWN: case effect_t::SLIDE_UP: case effect_t::SLIDE_DOWN:
+		case effect_t::PORTAMENTO: case effect_t::ARPEGGIO: case effect_t::PORTA_UP: case effect_t::PORTA_DOWN:
+			chState.HandleSlideCommand(cmd);
+			break;
 		}
 	}
 }
@@ -365,3 +520,177 @@ std::string CSongState::GetChannelStateString(const CFamiTrackerModule &modfile,
 
 	return str;
 }
+
+
+
+unsigned CSongStateIndex::GetKeyframeFrame(const CSongData &song, unsigned Frame) {
+	const unsigned Interval = std::max(1u, KEYFRAME_ROWS / song.GetPatternLength());
+	return Frame - Frame % Interval;
+}
+
+bool CSongStateIndex::Apply(CSongState &State, const CFamiTrackerModule &modfile, const CConstSongView &SongView,
+	unsigned Frame, CSongState::stScanContext &ctx) {
+	std::lock_guard<std::mutex> lock {m_Lock};
+
+	// the cells kept in keyframes also depend on the channels, the frame lengths and the speed commands
+	CContentHash hash;
+	SongView.GetChannelOrder().ForeachChannel([&] (stChannelID c) {
+		hash.Add(c.ToInteger());
+	});
+	hash.Add(SongView.GetSong().GetPatternLength()).Add(modfile.GetSpeedSplitPoint());
+	for (unsigned i = 0; i < MAX_GROOVE; ++i)
+		hash.Add(modfile.HasGroove(i));
+	if (hash.Get() != m_iContext || m_Keyframes.empty()) {
+		m_Keyframes.clear();
+		m_Segments.clear();
+		m_iContext = hash.Get();
+		auto &Start = m_Keyframes.emplace_back();
+		Start.Serial = ++m_iLastSerial;
+		Start.SelfContained = true;
+		Start.EchoTruncated.assign(SongView.GetChannelOrder().GetChannelCount(), false);
+		m_Segments.emplace_back();
+	}
+
+	const unsigned Interval = std::max(1u, KEYFRAME_ROWS / SongView.GetSong().GetPatternLength());
+	const unsigned Index = Frame / Interval;
+	if (m_Keyframes.size() <= Index) {
+		m_Keyframes.resize(Index + 1);
+		m_Segments.resize(Index + 1);
+	}
+	BuildKeyframe(modfile, SongView, Index, Interval);
+
+	const stKeyframe &Key = m_Keyframes[Index];
+	const int Rows = ctx.TotalRows;
+	for (const auto &Cell : Key.Cells) {
+		if (Cell.LateEcho && !State.State.find(Cell.Channel)->second.IsEchoSettled())
+			return false;
+		ctx.TotalRows = Rows + Cell.Row;
+		State.HandleCell(modfile, SongView.GetSong(), Cell.Channel, Cell.Note, Cell.EffColumns, ctx);
+	}
+
+	bool Settled = true;
+	std::size_t i = 0;
+	SongView.GetChannelOrder().ForeachChannel([&] (stChannelID c) {
+		if (Key.EchoTruncated[i++] && !State.State.find(c)->second.IsEchoSettled())
+			Settled = false;
+	});
+
+	ctx.TotalRows = Rows + Key.Rows;
+	ctx.Halt = Key.Halted;
+	return Settled;
+}
+
+class CSongStateIndex::CCellFilter {
+public:
+	CCellFilter(const CFamiTrackerModule &modfile, stKeyCells &Cells, std::size_t Channels) :
+		modfile_(modfile), cells_(Cells), channels_(Channels), count_((Channels + 1) * CLASS_COUNT)
+	{
+		cells_.EchoTruncated.assign(Channels, false);
+	}
+
+	// keeps a cell if it has a command of a class not seen enough times yet
+	void Add(stKeyCell Cell) {
+		bool Keep = false;
+		Cell.LateEcho = false;
+		ForeachCellClass(modfile_, Cell.Channel, Cell.Note, Cell.EffColumns, [&] (unsigned Class) {
+			unsigned &n = count_[(Class >= FIRST_GLOBAL_CLASS ? channels_ : Cell.ChannelIndex) * CLASS_COUNT + Class];
+			if (n < GetClassLimit(Class)) {
+				++n;
+				Keep = true;
+			}
+			else if (Class == CLASS_ECHO) {
+				Cell.LateEcho = true;
+				cells_.EchoTruncated[Cell.ChannelIndex] = true;
+			}
+		});
+		if (Keep)
+			cells_.Cells.push_back(Cell);
+	}
+
+private:
+	const CFamiTrackerModule &modfile_;
+	stKeyCells &cells_;
+	std::size_t channels_;
+	std::vector<unsigned> count_;
+};
+
+void CSongStateIndex::ScanSegment(const CFamiTrackerModule &modfile, const CConstSongView &SongView,
+	unsigned Index, unsigned Interval) {
+	// scans the frames since the previous keyframe like CSongState::ScanRows
+	stSegment &Segment = m_Segments[Index];
+	static_cast<stKeyCells &>(Segment) = stKeyCells { };
+	Segment.Serial = ++m_iLastSerial;
+	CCellFilter Filter {modfile, Segment, SongView.GetChannelOrder().GetChannelCount()};
+
+	for (unsigned Frame = Index * Interval; Frame-- > (Index - 1) * Interval && !Segment.Halted; )
+		for (unsigned Row = SongView.GetFrameLength(Frame); Row-- > 0; ) {
+			bool Halt = false;
+			std::uint8_t ChannelIndex = 0;
+			SongView.ForeachTrack([&] (const CTrackData &track, stChannelID c) {
+				const auto &Note = track.GetPatternOnFrame(Frame).GetNoteOn(Row);
+				const auto EffColumns = static_cast<std::uint8_t>(track.GetEffectColumnCount());
+				Filter.Add({Note, c, ChannelIndex++, EffColumns, false, Segment.Rows});
+				Halt = Halt || HasHaltCommand(c, Note, EffColumns);
+			});
+			if (Halt) {
+				Segment.Halted = true;
+				break;
+			}
+			++Segment.Rows;
+		}
+}
+
+void CSongStateIndex::BuildKeyframe(const CFamiTrackerModule &modfile, const CConstSongView &SongView,
+	unsigned Index, unsigned Interval) {
+	// rescans the frames since the previous keyframe only if they have been edited, then appends
+	// the previous keyframe, building it first if needed
+	stSegment &Segment = m_Segments[Index];
+	const std::uint64_t Fingerprint = GetFrameFingerprint(SongView, (Index - 1) * Interval, Index * Interval);
+	if (!Segment.Serial || Segment.Fingerprint != Fingerprint) {
+		ScanSegment(modfile, SongView, Index, Interval);
+		Segment.Fingerprint = Fingerprint;
+	}
+	if (!Segment.Halted && Index > 1)
+		BuildKeyframe(modfile, SongView, Index - 1, Interval);
+
+	stKeyframe &Key = m_Keyframes[Index];
+	const stKeyframe &Prev = m_Keyframes[Index - 1];
+	if (Key.Serial && Key.SegmentSerial == Segment.Serial && (Key.SelfContained || Key.PrevSerial == Prev.Serial))
+		return;
+
+	stKeyframe NewKey;
+	NewKey.SegmentSerial = Segment.Serial;
+	NewKey.SelfContained = Segment.Halted;
+	const std::size_t Channels = SongView.GetChannelOrder().GetChannelCount();
+	CCellFilter Filter {modfile, NewKey, Channels};
+	for (const auto &Cell : Segment.Cells)		// kept cells are kept again with the same counts
+		Filter.Add(Cell);
+	for (std::size_t i = 0; i < Channels; ++i)		// echo notes the segment scan left out stay unresolved
+		if (Segment.EchoTruncated[i])
+			NewKey.EchoTruncated[i] = true;
+	NewKey.Rows = Segment.Rows;
+	NewKey.Halted = Segment.Halted;
+	if (!NewKey.SelfContained) {
+		NewKey.PrevSerial = Prev.Serial;
+		for (stKeyCell Cell : Prev.Cells) {
+			Cell.Row += NewKey.Rows;
+			Filter.Add(Cell);
+		}
+		for (std::size_t i = 0; i < Channels; ++i)
+			if (Prev.EchoTruncated[i])
+				NewKey.EchoTruncated[i] = true;
+		NewKey.Rows += Prev.Rows;
+		NewKey.Halted = Prev.Halted;
+	}
+
+	// the keyframes after this one remain valid if the edit does not reach past it
+	const auto IsSameCell = [] (const stKeyCell &x, const stKeyCell &y) {
+		return x.Note == y.Note && x.Channel == y.Channel && x.EffColumns == y.EffColumns &&
+			x.LateEcho == y.LateEcho && x.Row == y.Row;
+	};
+	const bool Unchanged = Key.Serial && NewKey.Rows == Key.Rows && NewKey.Halted == Key.Halted &&
+		NewKey.EchoTruncated == Key.EchoTruncated &&
+		std::equal(NewKey.Cells.begin(), NewKey.Cells.end(), Key.Cells.begin(), Key.Cells.end(), IsSameCell);
+	NewKey.Serial = Unchanged ? Key.Serial : ++m_iLastSerial;
+	Key = std::move(NewKey);
+}
@@ -26,14 +26,17 @@
 #include "FamiTrackerDefines.h"
 #include "Effect.h"		// // //
 #include "APU/Types.h"
+#include "PatternNote.h"		// // //
 #include <memory>
 #include <string>
 #include <array>
 #include <map>
+#include <vector>		// // //
+#include <mutex>		// // //
 
 class CFamiTrackerModule;
-class stChanNote;
-struct stEffectCommand;
+class CSongData;		// // //
+class CConstSongView;		// // //
 
 std::string MakeCommandString(stEffectCommand cmd);		// // //
 
@@ -45,6 +48,7 @@ inline constexpr int ECHO_BUFFER_ECHO = 0x80;
 // // // Channel state information
 class stChannelState {
 	friend class CSongState;
+	friend class CSongStateIndex;		// // //
 
 public:
 	stChannelState();
@@ -72,18 +76,113 @@ private:
 	void HandleSlideCommand(stEffectCommand cmd);
 	void HandleExxCommand2A03(unsigned char param);
 	void HandleSxxCommand(unsigned char param);
+	bool IsEchoSettled() const;		// // //
 
 	int BufferPos = 0;
 	std::array<int, ECHO_BUFFER_LENGTH> Transpose = { };
 };
 
 class CSongState {
+	friend class CSongStateIndex;		// // //
+
 public:
 	void Retrieve(const CFamiTrackerModule &modfile, unsigned Track, unsigned Frame, unsigned Row);
+	// // // Same as Retrieve, but scans back to the first frame without keyframes; used as the reference for them
+	void RetrieveFullScan(const CFamiTrackerModule &modfile, unsigned Track, unsigned Frame, unsigned Row);
 	std::string GetChannelStateString(const CFamiTrackerModule &modfile, stChannelID chan) const;
 
 	std::map<stChannelID, stChannelState> State;
 	int Tempo = -1;
 	int Speed = -1;
 	int GroovePos = -1; // -1: disable groove
+
+private:
+	// // // Progress of a backward scan shared by all channels
+	struct stScanContext {
+		int TotalRows = 0;
+		bool MaskFDS = false;
+		bool Halt = false;
+	};
+
+	void Clear(const CConstSongView &SongView);		// // //
+	void ApplySongGroove(const CFamiTrackerModule &modfile, const CSongData &song, const stScanContext &ctx);		// // //
+	void ScanRows(const CFamiTrackerModule &modfile, const CConstSongView &SongView,
+		unsigned Frame, unsigned Row, unsigned StopFrame, stScanContext &ctx);		// // //
+	void HandleCell(const CFamiTrackerModule &modfile, const CSongData &song, stChannelID c,
+		const stChanNote &Note, unsigned EffColumns, stScanContext &ctx);		// // //
+};
+
+// // // Keyframes for CSongState::Retrieve, placed at frame starts about every KEYFRAME_ROWS rows
+/*!	\brief Each keyframe holds the pattern cells before it that may still affect a retrieved
+	state, in the order CSongState scans them; cells that can only repeat a command already
+	seen are left out. Retrieving a state scans the rows back to the nearest keyframe, then
+	replays that keyframe.
+
+	The cells of the frames between two keyframes are kept separately from the keyframes,
+	together with a fingerprint of those frames. A pattern edit only rescans the frames it
+	touches; the keyframes after it are merged again from the kept cells, and the edit stops
+	propagating at the first keyframe whose cells come out unchanged.
+*/
+class CSongStateIndex {
+public:
+	static constexpr unsigned KEYFRAME_ROWS = 256u;
+
+	/*!	\brief Obtains the frame of the nearest keyframe.
+		\param song The song.
+		\param Frame The frame index.
+		\return The index of the last frame at or before the given one that starts with a keyframe.
+	*/
+	static unsigned GetKeyframeFrame(const CSongData &song, unsigned Frame);
+
+	/*!	\brief Replays a keyframe onto a state.
+		\param State The song state, already containing the rows after the keyframe.
+		\param modfile The module.
+		\param SongView The song view used to retrieve the state.
+		\param Frame The frame index of the keyframe, as returned by GetKeyframeFrame.
+		\param ctx The scan progress.
+		\return Whether the replayed state is exact; if false, the state must be retrieved again
+		without the keyframe.
+	*/
+	bool Apply(CSongState &State, const CFamiTrackerModule &modfile, const CConstSongView &SongView,
+		unsigned Frame, CSongState::stScanContext &ctx);
+
+private:
+	struct stKeyCell {
+		stChanNote Note;
+		stChannelID Channel;
+		std::uint8_t ChannelIndex;
+		std::uint8_t EffColumns;
+		bool LateEcho;			// The note is beyond the echo notes kept for its channel
+		unsigned Row;			// Rows scanned before this cell
+	};
+
+	struct stKeyCells {
+		unsigned Rows = 0;
+		bool Halted = false;
+		std::vector<stKeyCell> Cells;
+		std::vector<bool> EchoTruncated;	// Echo notes not kept, indexed by channel
+	};
+
+	struct stSegment : stKeyCells {		// The frames since the previous keyframe
+		std::uint64_t Fingerprint = 0;		// Contents of the frames
+		unsigned Serial = 0;				// 0 if the frames are not scanned
+	};
+
+	struct stKeyframe : stKeyCells {
+		unsigned Serial = 0;				// 0 if the keyframe is not built
+		unsigned SegmentSerial = 0;			// Serial of the segment when this keyframe was built
+		unsigned PrevSerial = 0;			// Serial of the previous keyframe when this one was built
+		bool SelfContained = false;			// Does not include the previous keyframe
+	};
+
+	class CCellFilter;
+
+	void ScanSegment(const CFamiTrackerModule &modfile, const CConstSongView &SongView, unsigned Index, unsigned Interval);
+	void BuildKeyframe(const CFamiTrackerModule &modfile, const CConstSongView &SongView, unsigned Index, unsigned Interval);
+
+	std::mutex m_Lock;
+	std::uint64_t m_iContext = 0;
+	unsigned m_iLastSerial = 0;
+	std::vector<stSegment> m_Segments;		// Indexed as the keyframes, the first one is unused
+	std::vector<stKeyframe> m_Keyframes;
 };
@@ -33,6 +33,8 @@
 #include "PlayerCursor.h"
 #include "SongState.h"
 #include "ChannelMap.h"
+#include "TrackData.h"		// // //
+#include "ModuleSnapshot.h"		// // //
 #include "Assertion.h"
 
 
@@ -68,6 +70,16 @@ void CSoundDriver::SetupTracks() {
 
 void CSoundDriver::AssignModule(const CFamiTrackerModule &modfile) {
 	modfile_ = &modfile;
+	ModuleChipChanged();		// // //
+}
+
+void CSoundDriver::AssignSnapshots(CModuleSnapshotPublisher *pSnapshots) {		// // //
+	snapshots_ = pSnapshots;
+	snapshot_ = nullptr;
+}
+
+const CFamiTrackerModule *CSoundDriver::GetPlayingModule() const {		// // //
+	return snapshot_ ? &snapshot_->GetModule() : modfile_;
 }
 
 void CSoundDriver::LoadAPU(CAPUInterface &apu) {
@@ -86,6 +98,40 @@ void CSoundDriver::ConfigureDocument() {
 	ForeachTrack([&] (CChannelHandler &ch, CTrackerChannel &) {
 		ch.ConfigureDocument(*modfile_);
 	});
+
+	ModuleChipChanged();		// // //
+}
+
+void CSoundDriver::ModuleChipChanged() {		// // //
+	// The channel order may have changed, rebuild the track lists on the next tick
+	active_tracks_valid_ = false;
+}
+
+const std::vector<CSoundDriver::stActiveTrack> &CSoundDriver::GetActiveTracks() {		// // //
+	// Flattens the tracks of the channels in the current channel order so that the
+	// tick loop does not search any map
+	if (!active_tracks_valid_) {
+		active_tracks_.clear();
+		row_song_ = nullptr;
+		if (const CFamiTrackerModule *pModule = GetPlayingModule()) {		// // //
+			const CChannelOrder &order = pModule->GetChannelOrder();
+			ForeachTrack([&] (CChannelHandler &ch, CTrackerChannel &tr, stChannelID id) {
+				if (order.HasChannel(id))
+					active_tracks_.push_back({id, &ch, &tr});
+			});
+		}
+		active_tracks_valid_ = true;
+	}
+	return active_tracks_;
+}
+
+void CSoundDriver::UpdateRowTracks(const CSongData &song) {		// // //
+	row_tracks_.clear();
+	row_song_ = &song;
+	GetPlayingModule()->GetChannelOrder().ForeachChannel([&] (stChannelID i) {		// // //
+		if (const CTrackData *pTrack = song.GetTrack(i))
+			row_tracks_.emplace_back(i, pTrack);
+	});
 }
 
 CChannelHandler *CSoundDriver::GetChannelHandler(stChannelID chan) const {
@@ -108,12 +154,17 @@ const CTrackerChannel *CSoundDriver::GetTrackerChannel(stChannelID chan) const {
 
 void CSoundDriver::StartPlayer(std::unique_ptr<CPlayerCursor> cur) {
 	m_pPlayerCursor = std::move(cur);		// // //
+	row_song_ = nullptr;		// // //
 	m_bPlaying = true;
 	m_bHaltRequest = false;
 
 	m_iJumpToPattern = -1;
 	m_iSkipToRow = -1;
 	m_bDoHalt = false;		// // //
+
+	UpdateSnapshot();		// // //
+	if (snapshot_)
+		LoadSnapshotSong();
 }
 
 void CSoundDriver::StopPlayer() {
@@ -135,11 +186,9 @@ void CSoundDriver::ResetTracks() {
 void CSoundDriver::LoadSoundState(const CSongState &state) {
 	if (m_pTempoCounter)
 		m_pTempoCounter->LoadSoundState(state);
-	ForeachTrack([&] (CChannelHandler &ch, CTrackerChannel &tr, stChannelID id) {		// // //
-		if (modfile_->GetChannelOrder().HasChannel(id))
-			if (auto it = state.State.find(id); it != state.State.end())
-				ch.ApplyChannelState(it->second);
-	});
+	for (auto [id, ch, tr] : GetActiveTracks())		// // //
+		if (auto it = state.State.find(id); it != state.State.end())
+			ch->ApplyChannelState(it->second);
 }
 
 void CSoundDriver::SetTempoCounter(std::shared_ptr<CTempoCounter> tempo) {
@@ -147,15 +196,45 @@ void CSoundDriver::SetTempoCounter(std::shared_ptr<CTempoCounter> tempo) {
 		m_pTempoCounter->AssignModule(*modfile_);
 }
 
+void CSoundDriver::UpdateSnapshot() {		// // //
+	// Picks up the module most recently published by the editor, only between ticks so that
+	// the player never sees a partial edit
+	if (!snapshots_)
+		return;
+	if (const CModuleSnapshot *pSnapshot = snapshots_->Acquire(); pSnapshot && pSnapshot != snapshot_) {
+		// rows are read from the snapshot as they are reached, so an edit that only changes rows
+		// needs nothing besides pointing the cursor at the new song
+		const CSongData *pSong = m_pPlayerCursor ? pSnapshot->GetModule().GetSong(m_pPlayerCursor->GetCurrentSong()) : nullptr;
+		if (!snapshot_ || !pSong || pSong->GetDirtyRows().IsAllDirty())
+			ModuleChipChanged();
+		row_song_ = nullptr;		// the previous snapshot may be destroyed from now on
+		snapshot_ = pSnapshot;
+		if (m_pTempoCounter)
+			m_pTempoCounter->AssignModule(snapshot_->GetModule());
+		if (m_pPlayerCursor)
+			LoadSnapshotSong();
+	}
+}
+
+void CSoundDriver::LoadSnapshotSong() {		// // //
+	// The previous snapshot may be destroyed as soon as a newer one is acquired
+	if (const CSongData *pSong = snapshot_->GetModule().GetSong(m_pPlayerCursor->GetCurrentSong()))
+		m_pPlayerCursor->SetSong(*pSong);
+	else if (m_bPlaying) {
+		StopPlayer();
+		m_bHaltRequest = true;		// the song was removed
+	}
+}
+
 void CSoundDriver::Tick() {
+	UpdateSnapshot();		// // //
 	if (IsPlaying())
 		PlayerTick();
 	UpdateChannels();
 }
 
-void CSoundDriver::StepRow(stChannelID chan) {
-	stChanNote NoteData = m_pPlayerCursor->GetSong().GetActiveNote(
-		chan, m_pPlayerCursor->GetCurrentFrame(), m_pPlayerCursor->GetCurrentRow());		// // //
+void CSoundDriver::StepRow(stChannelID chan, const CTrackData &track) {		// // //
+	stChanNote NoteData = track.GetActiveNote(m_pPlayerCursor->GetCurrentFrame(), m_pPlayerCursor->GetCurrentRow());
 	for (auto &cmd : NoteData.Effects)
 		if (HandleGlobalEffect(cmd))
 			cmd = { };
@@ -184,9 +263,11 @@ void CSoundDriver::PlayerTick() {
 			++SteppedRows;
 		m_pTempoCounter->StepRow();		// // //
 
-		modfile_->GetChannelOrder().ForeachChannel([&] (stChannelID i) {
-			StepRow(i);
-		});
+		GetActiveTracks();		// // // drops row_tracks_ if the channel order has changed
+		if (const CSongData &song = m_pPlayerCursor->GetSong(); row_song_ != &song)
+			UpdateRowTracks(song);
+		for (auto [id, pTrack] : row_tracks_)
+			StepRow(id, *pTrack);
 
 		if (parent_)
 			parent_->OnStepRow();
@@ -220,9 +301,9 @@ void CSoundDriver::UpdateChannels() {
 	for (auto &chip : chips_)
 		chip->RefreshBefore(*apu_);
 
-	ForeachTrack([&] (CChannelHandler &Chan, CTrackerChannel &TrackerChan, stChannelID ID) {		// // //
-		if (!modfile_->GetChannelOrder().HasChannel(ID))
-			return;
+	for (auto [ID, pChan, pTrackerChan] : GetActiveTracks()) {		// // //
+		CChannelHandler &Chan = *pChan;
+		CTrackerChannel &TrackerChan = *pTrackerChan;
 
 		// Run auto-arpeggio, if enabled
 		if (int Arpeggio = parent_ ? parent_->GetArpNote(ID) : -1; Arpeggio > 0)		// // //
@@ -239,7 +320,7 @@ void CSoundDriver::UpdateChannels() {
 		m_bHaltRequest ? Chan.ResetChannel() : Chan.ProcessChannel();
 		Chan.RefreshChannel();
 		Chan.FinishTick();		// // //
-	});
+	}
 
 	for (auto &chip : chips_)
 		chip->RefreshAfter(*apu_);
@@ -42,6 +42,10 @@ class CSongState;
 class stChanNote;
 class CSoundGenBase;
 class CSoundChipSet;
+class CSongData;
+class CTrackData;
+class CModuleSnapshot;		// // //
+class CModuleSnapshotPublisher;		// // //
 enum note_prio_t : unsigned;
 struct stEffectCommand;
 
@@ -52,8 +56,11 @@ public:
 
 	void SetupTracks();
 	void AssignModule(const CFamiTrackerModule &modfile);
+	void AssignSnapshots(CModuleSnapshotPublisher *pSnapshots);		// // //
+	const CFamiTrackerModule *GetPlayingModule() const;		// // //
 	void LoadAPU(CAPUInterface &apu);
 	void ConfigureDocument();
+	void ModuleChipChanged();		// // //
 
 	CTrackerChannel *GetTrackerChannel(stChannelID chan);
 	const CTrackerChannel *GetTrackerChannel(stChannelID chan) const;
@@ -100,13 +107,24 @@ public:
 	}
 
 private:
+	struct stActiveTrack {		// // //
+		stChannelID ID;
+		CChannelHandler *Handler;
+		CTrackerChannel *Tracker;
+	};
+
 	CChannelHandler *GetChannelHandler(stChannelID chan) const;
 
+	const std::vector<stActiveTrack> &GetActiveTracks();		// // //
+	void UpdateRowTracks(const CSongData &song);		// // //
+	void UpdateSnapshot();		// // //
+	void LoadSnapshotSong();		// // //
+
 	void SetupVibrato();
 	void SetupPeriodTables();
 
 	void PlayerTick();
-	void StepRow(stChannelID chan);
+	void StepRow(stChannelID chan, const CTrackData &track);		// // //
 	void UpdateChannels();
 	bool HandleGlobalEffect(stEffectCommand cmd);		// // //
 
@@ -135,8 +153,14 @@ private:
 	};
 
 	std::map<stChannelID, std::pair<CChannelHandler *, std::unique_ptr<CTrackerChannel>>, stChannelID_ident_less> tracks_;
+	std::vector<stActiveTrack> active_tracks_;		// // // tracks in the module's channel order, sorted as in tracks_
+	bool active_tracks_valid_ = false;		// // //
+	std::vector<std::pair<stChannelID, const CTrackData *>> row_tracks_;		// // // tracks of row_song_ in channel order
+	const CSongData *row_song_ = nullptr;		// // //
 	std::vector<std::unique_ptr<CChipHandler>> chips_;		// // //
 	const CFamiTrackerModule *modfile_ = nullptr;		// // //
+	CModuleSnapshotPublisher *snapshots_ = nullptr;		// // //
+	const CModuleSnapshot *snapshot_ = nullptr;		// // // read instead of modfile_ during playback
 	CSoundGenBase *parent_ = nullptr;		// // //
 	CAPUInterface *apu_ = nullptr;		// // //
 
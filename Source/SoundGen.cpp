@@ -61,6 +61,7 @@ CSoundGen depends on CFamiTrackerView for:
 #include "AudioDriver.h"		// // //
 #include "WaveRenderer.h"		// // //
 #include "SoundDriver.h"		// // //
+#include "ModuleSnapshot.h"		// // //
 #include "PatternNote.h"		// // //
 #include "ChannelMap.h"		// // //
 #include "TrackerChannel.h"		// // //
@@ -103,6 +104,7 @@ END_MESSAGE_MAP()
 
 CSoundGen::CSoundGen() :
 	m_pTempoCounter(std::make_shared<CTempoCounter>()),		// // //
+	m_pModuleSnapshots(std::make_unique<CModuleSnapshotPublisher>()),		// // //
 	m_pSoundDriver(std::make_unique<CSoundDriver>(this)),		// // //
 	m_pAPU(std::make_unique<CAPU>()),		// // //
 	m_bHaltRequest(false),
@@ -120,6 +122,7 @@ CSoundGen::CSoundGen() :
 
 	// Create all kinds of channels
 	m_pSoundDriver->SetupTracks();		// // //
+	m_pSoundDriver->AssignSnapshots(m_pModuleSnapshots.get());		// // //
 }
 
 CSoundGen::~CSoundGen()
@@ -198,9 +201,7 @@ void CSoundGen::SetVisualizerWindow(CVisualizerWnd *pWnd)
 	// Called from main thread
 	ASSERT(GetCurrentThreadId() == FTEnv.GetMainApp()->m_nThreadID);
 
-	m_csVisualizerWndLock.Lock();
-	m_pVisualizerWnd = pWnd;
-	m_csVisualizerWndLock.Unlock();
+	m_pVisualizerWnd = pWnd;		// // //
 }
 
 void CSoundGen::ModuleChipChanged() {		// // //
@@ -233,6 +234,21 @@ void CSoundGen::DocumentPropertiesChanged(CFamiTrackerDoc *pDocument)
 		return;
 	AssignModule(*m_pDocument->GetModule());
 	m_pSoundDriver->ConfigureDocument();
+	PublishModule();		// // //
+}
+
+void CSoundGen::PublishModule() {		// // //
+	// The player picks up the new snapshot on its next tick, edits made in the meantime
+	// are never heard partially
+	ASSERT(GetCurrentThreadId() == FTEnv.GetMainApp()->m_nThreadID);
+
+	if (m_pModule)
+		m_pModuleSnapshots->Publish(*m_pModule);
+}
+
+const CFamiTrackerModule *CSoundGen::GetCurrentModule() const {		// // //
+	// The player thread reads the last published snapshot instead of the document
+	return GetCurrentThreadId() == m_nThreadID ? m_pSoundDriver->GetPlayingModule() : m_pModule;
 }
 
 //
@@ -427,8 +443,10 @@ bool CSoundGen::ResetAudioDevice()
 	if (BufferLen > 100)
 		iBlocks += (BufferLen / 66);
 
-	m_pAudioDriver = std::make_unique<CAudioDriver>(*this,
-		std::move(m_pDSound->OpenChannel(SampleRate, SampleSize, 1, BufferLen, iBlocks)), SampleSize);
+	// // // the device asks for samples, which the player renders frame by frame
+	auto pChannel = m_pDSound->OpenChannel(SampleRate, SampleSize, 1, BufferLen, iBlocks);
+	m_pAudioDriver = std::make_unique<CAudioDriver>([this] { return RenderFrame(); },
+		pChannel ? std::make_unique<CDSoundAudioSink>(std::move(pChannel)) : nullptr);
 
 	// Channel failed
 	if (!m_pAudioDriver || !m_pAudioDriver->IsAudioDeviceOpen()) {
@@ -437,12 +455,11 @@ bool CSoundGen::ResetAudioDevice()
 	}
 
 	// Sample graph rate
-	m_csVisualizerWndLock.Lock();
-	if (m_pVisualizerWnd)
-		m_pVisualizerWnd->SetSampleRate(SampleRate);
-	m_csVisualizerWndLock.Unlock();
+	if (CVisualizerWnd *pWnd = m_pVisualizerWnd)		// // //
+		pWnd->SetSampleRate(SampleRate);
 
-	m_pAPU->SetCallback(*m_pAudioDriver);
+	m_pAPU->SetCallback(*this);		// // //
+	m_pAPU->SetVRC7NativeRate(pSettings->Sound.bNativeVRC7);		// // //
 	if (!m_pAPU->SetupSound(SampleRate, 1, m_iMachineType))		// // //
 		return false;
 
@@ -498,14 +515,17 @@ void CSoundGen::ResetBuffer()
 	m_pAPU->Reset();
 }
 
-void CSoundGen::FlushBuffer(array_view<int16_t> Buffer)		// // //
+void CSoundGen::FlushBuffer(array_view<float> Buffer)		// // //
 {
 	// Callback method from emulation
 
 	// May only be called from sound player thread
 	ASSERT(GetCurrentThreadId() == m_nThreadID);
 
-	m_pAudioDriver->FlushBuffer(Buffer);		// // //
+	if (m_bRenderOffline)		// // //
+		m_pWaveRenderer->FlushBuffer(Buffer);
+	else
+		m_pAudioDriver->FlushBuffer(Buffer);		// // //
 }
 
 // // //
@@ -517,38 +537,46 @@ CAudioDriver *CSoundGen::GetAudioDriver() const {
 	return m_pAudioDriver.get();
 }
 
-bool CSoundGen::PlayBuffer()
+bool CSoundGen::RenderFrame()		// // //
 {
-	ASSERT(GetCurrentThreadId() == m_nThreadID);
+	// Runs the player for one frame, its samples are sent to FlushBuffer
+	if (!IsAudioReady())
+		return false;
 
-	if (m_pWaveRenderer) {		// // //
-		CSingleLock l(&m_csRenderer); l.Lock();
-		if (is_rendering_impl()) {
-			auto buf = m_pAudioDriver->ReleaseSoundBuffer();
-			switch (m_pAudioDriver->GetSampleSize()) {
-			case 8:
-				m_pWaveRenderer->FlushBuffer(array_view<std::uint8_t>(
-					reinterpret_cast<const std::uint8_t *>(buf.data()), buf.size() / sizeof(std::uint8_t)));		// // //
-				return true;
-			case 16:
-				m_pWaveRenderer->FlushBuffer(array_view<std::int16_t>(
-					reinterpret_cast<const std::int16_t *>(buf.data()), buf.size() / sizeof(std::int16_t)));		// // //
-				return true;
-			}
-			return false;
+	++m_iFrameCounter;
+
+	// Access the document object, skip if access wasn't granted to avoid gaps in audio playback
+	// // // rendering waits instead, since nothing is played back
+	m_pDocument->Locked([this] {
+		m_pSoundDriver->Tick();		// // //
+	}, m_bRenderOffline ? INFINITE : 0);
+
+	m_pSoundDriver->ForeachTrack([&] (CChannelHandler &, CTrackerChannel &TrackerChan, stChannelID ID) {		// // //
+		TrackerChan.SetVolumeMeter(m_pAPU->GetVol(ID));		// // //
+	});
+
+	if (FTEnv.GetSettings()->Midi.bMidiArpeggio && m_pArpeggiator)		// // //
+		m_pArpeggiator->Tick(m_pTrackerView->GetSelectedChannelID());
+
+	// Rendering
+	if (m_pWaveRenderer)		// // //
+		if (m_pWaveRenderer->ShouldStopRender())
+			StopRendering();
+		else if (m_pWaveRenderer->ShouldStartPlayer()) {
+			int track = m_pWaveRenderer->GetRenderTrack();
+			StartPlayer(std::make_unique<CPlayerCursor>(*m_pModule->GetSong(track), track));
 		}
-	}
 
-	if (!m_pAudioDriver->DoPlayBuffer())
-		return false;
+	// Update APU registers
+	UpdateAPU();
 
-	// // // Draw graph
-//	if (!IsBackgroundTask()) {
-	if (!is_rendering_impl()) {
-		m_csVisualizerWndLock.Lock();
-		if (m_pVisualizerWnd)
-			m_pVisualizerWnd->FlushSamples(m_pAudioDriver->ReleaseGraphBuffer());
-		m_csVisualizerWndLock.Unlock();
+	if (IsPlaying())		// // //
+		if (stChannelID Channel = m_pInstRecorder->GetRecordChannel(); Channel.Chip != sound_chip_t::none)		// // //
+			m_pInstRecorder->RecordInstrument(GetPlayerTicks(), m_pTrackerView);
+
+	if (m_pSoundDriver->ShouldHalt() || m_bHaltRequest) {		// // //
+		// Halt has been requested, abort playback here
+		HaltPlayer();
 	}
 
 	return true;
@@ -606,41 +634,40 @@ void CSoundGen::ApplyGlobalState()		// // //
 	CSingleLock l(&m_csAPULock, TRUE);		// // //
 	auto [Frame, Row] = IsPlaying() ? GetPlayerPos() : m_pTrackerView->GetSelectedPos();		// // //
 
+	const CFamiTrackerModule &modfile = *GetCurrentModule();		// // //
 	CSongState state;
-	state.Retrieve(*m_pModule, GetPlayerTrack(), Frame, Row);
+	state.Retrieve(modfile, GetPlayerTrack(), Frame, Row);
 
 	m_pSoundDriver->LoadSoundState(state);
 
-	m_iLastHighlight = m_pModule->GetSong(GetPlayerTrack())->GetHighlightAt(Frame, Row).First;
+	m_iLastHighlight = modfile.GetSong(GetPlayerTrack())->GetHighlightAt(Frame, Row).First;
 }
 
 // // //
 void CSoundGen::OnTick() {
 	if (m_pTempoDisplay)		// // // 050B
 		m_pTempoDisplay->Tick();
-	CSingleLock l(&m_csRenderer); l.Lock();
-	if (is_rendering_impl())
+	if (is_rendering_impl())		// // //
 		m_pWaveRenderer->Tick();
 }
 
 void CSoundGen::OnStepRow() {
 	if (m_pTempoDisplay)		// // // 050B
 		m_pTempoDisplay->StepRow();
-	CSingleLock l(&m_csRenderer); l.Lock();
-	if (is_rendering_impl())
-		m_pWaveRenderer->StepRow();		// // //
+	if (is_rendering_impl())		// // //
+		m_pWaveRenderer->StepRow();
 }
 
 void CSoundGen::OnPlayNote(stChannelID chan, const stChanNote &note) {
 	if (!IsChannelMuted(chan)) {
 		if (m_pTrackerView)
 			m_pTrackerView->PlayerPlayNote(chan, note);
-		FTEnv.GetMIDI()->WriteNote((uint8_t)m_pModule->GetChannelOrder().GetChannelIndex(chan), note.Note, note.Octave, note.Vol);
+		FTEnv.GetMIDI()->WriteNote((uint8_t)GetCurrentModule()->GetChannelOrder().GetChannelIndex(chan), note.Note, note.Octave, note.Vol);		// // //
 	}
 }
 
 void CSoundGen::OnUpdateRow(int frame, int row) {
-	auto *pMark = m_pModule->GetSong(m_iLastTrack)->GetBookmarks().FindAt(frame, row);
+	auto *pMark = m_pSoundDriver->GetPlayerCursor()->GetSong().GetBookmarks().FindAt(frame, row);		// // //
 	if (pMark && pMark->m_Highlight.First != -1)		// // //
 		m_iLastHighlight = pMark->m_Highlight.First;
 	if (!IsBackgroundTask() && m_pTrackerView)		// // //
@@ -659,7 +686,6 @@ bool CSoundGen::IsChannelMuted(stChannelID chan) const {		// // //
 }
 
 bool CSoundGen::ShouldStopPlayer() const {
-	CSingleLock l(&m_csRenderer); l.Lock();		// // //
 	return is_rendering_impl() && m_pWaveRenderer->ShouldStopPlayer();
 }
 
@@ -764,7 +790,7 @@ void CSoundGen::ResetTempo()
 	if (!m_pModule)
 		return;
 
-	const CSongData &song = *m_pModule->GetSong(m_iLastTrack);
+	const CSongData &song = *GetCurrentModule()->GetSong(m_iLastTrack);		// // //
 	m_pTempoCounter->LoadTempo(song);		// // //
 	m_iLastHighlight = song.GetRowHighlight().First;		// // //
 }
@@ -875,20 +901,22 @@ bool CSoundGen::RenderToFile(const fs::path &fname, std::shared_ptr<CWaveRendere
 		WaitForStop();
 	}
 
-	CSingleLock l(&m_csRenderer); l.Lock();
-	m_pWaveRenderer = std::move(pRender);		// // //
-
-	ASSERT(!m_pRenderFile);
-	m_pRenderFile = std::make_shared<CSimpleFile>(fname, std::ios::out | std::ios::binary);		// // //
-	if (m_pRenderFile) {
-		m_pWaveRenderer->SetOutputStream(std::make_unique<COutputWaveStream>(m_pRenderFile, CWaveFileFormat {
-			CWaveFileFormat::format_code::pcm,
+	auto pFile = std::make_shared<CSimpleFile>(fname, std::ios::out | std::ios::binary);		// // //
+	if (*pFile) {
+		const int SampleSize = FTEnv.GetSettings()->Sound.iSampleSize;		// // //
+		pRender->SetOutputStream(std::make_unique<COutputWaveStream>(std::move(pFile), CWaveFileFormat {
+			SampleSize == 32 ? CWaveFileFormat::format_code::ieee_float : CWaveFileFormat::format_code::pcm,
 			1,
 			static_cast<std::uint32_t>(FTEnv.GetSettings()->Sound.iSampleRate),
-			static_cast<std::uint16_t>(FTEnv.GetSettings()->Sound.iSampleSize),
+			static_cast<std::uint16_t>(SampleSize),
 		}));
-		PostThreadMessageW(WM_USER_START_RENDER, 0, 0);
-		return true;
+		// // // the renderer belongs to the player thread from here on, once the message is posted
+		auto pMessage = std::make_unique<std::shared_ptr<CWaveRenderer>>(std::move(pRender));
+		if (PostThreadMessageW(WM_USER_START_RENDER, reinterpret_cast<uintptr_t>(pMessage.get()), 0)) {
+			pMessage.release();
+			return true;
+		}
+		return false;
 	}
 
 	StopPlayer();
@@ -899,8 +927,8 @@ bool CSoundGen::RenderToFile(const fs::path &fname, std::shared_ptr<CWaveRendere
 // // //
 void CSoundGen::StartRendering() {
 	ResetBuffer();
-	CSingleLock l(&m_csRenderer); l.Lock();
 	m_pWaveRenderer->Start();
+	m_bRendering = true;		// // //
 }
 
 void CSoundGen::StopRendering()
@@ -908,21 +936,41 @@ void CSoundGen::StopRendering()
 	// Called from player thread
 	ASSERT(GetCurrentThreadId() == m_nThreadID);
 
-//	CSingleLock l(&m_csRenderer); l.Lock();
 	if (!is_rendering_impl())
 		return;
 
+	m_bRenderOffline = false;		// // //
+	m_bRendering = false;		// // //
 	m_pWaveRenderer.reset();		// // //
-	m_pRenderFile.reset();		// // //
 	ResetBuffer();
 	HaltPlayer();		// // //
 	ResetAPU();		// // //
 }
 
+void CSoundGen::RenderOffline() {		// // //
+	// Called from player thread
+	ASSERT(GetCurrentThreadId() == m_nThreadID);
+
+	// Runs the player without returning to the message loop until the renderer stops; the
+	// samples are written to the output stream without waiting for the audio device, and
+	// only stop requests are handled in the meantime
+	const unsigned RENDER_BATCH_FRAMES = 64;
+
+	m_bRenderOffline = true;
+	while (IsAudioReady() && IsRendering()) {
+		if (MSG msg; ::PeekMessageW(&msg, NULL, WM_USER_STOP_RENDER, WM_USER_STOP_RENDER, PM_REMOVE)) {
+			StopRendering();
+			break;
+		}
+		for (unsigned i = 0; i < RENDER_BATCH_FRAMES && IsRendering(); ++i)
+			IdleLoop();
+	}
+	m_bRenderOffline = false;
+}
+
 bool CSoundGen::IsRendering() const
 {
-	CSingleLock l(&m_csRenderer); l.Lock();		// // //
-	return is_rendering_impl();
+	return m_bRendering;		// // //
 }
 
 bool CSoundGen::is_rendering_impl() const {		// // //
@@ -997,8 +1045,8 @@ BOOL CSoundGen::InitInstance()
 
 	if (!ResetAudioDevice()) {
 		TRACE(L"SoundGen: Failed to reset audio device!\n");
-		if (m_pVisualizerWnd != NULL)
-			m_pVisualizerWnd->ReportAudioProblem();
+		if (CVisualizerWnd *pWnd = m_pVisualizerWnd)		// // //
+			pWnd->ReportAudioProblem();
 	}
 
 	ResetAPU();
@@ -1023,6 +1071,10 @@ int CSoundGen::ExitInstance()
 	// Make sure sound interface is shut down
 	CloseAudio();
 
+	// // // Free the renderers of start messages that were never handled
+	for (MSG msg; ::PeekMessageW(&msg, NULL, WM_USER_START_RENDER, WM_USER_START_RENDER, PM_REMOVE); )
+		delete reinterpret_cast<std::shared_ptr<CWaveRenderer> *>(msg.wParam);
+
 	m_bRunning = false;
 
 	return CWinThread::ExitInstance();
@@ -1044,40 +1096,19 @@ BOOL CSoundGen::IdleLoop() {
 	if (!IsAudioReady())		// // //
 		return TRUE;
 
-	++m_iFrameCounter;
-
-	// Access the document object, skip if access wasn't granted to avoid gaps in audio playback
-	m_pDocument->Locked([this] {
-		m_pSoundDriver->Tick();		// // //
-	}, 0);
-
-	m_pSoundDriver->ForeachTrack([&] (CChannelHandler &, CTrackerChannel &TrackerChan, stChannelID ID) {		// // //
-		TrackerChan.SetVolumeMeter(m_pAPU->GetVol(ID));		// // //
-	});
-
-	if (FTEnv.GetSettings()->Midi.bMidiArpeggio && m_pArpeggiator)		// // //
-		m_pArpeggiator->Tick(m_pTrackerView->GetSelectedChannelID());
-
-	// Rendering
-	if (CSingleLock l(&m_csRenderer); l.Lock() && m_pWaveRenderer)		// // //
-		if (m_pWaveRenderer->ShouldStopRender())
-			StopRendering();
-		else if (m_pWaveRenderer->ShouldStartPlayer()) {
-			int track = m_pWaveRenderer->GetRenderTrack();
-			StartPlayer(std::make_unique<CPlayerCursor>(*m_pModule->GetSong(track), track));
-		}
-
-	// Update APU registers
-	UpdateAPU();
+	// // // rendered samples never reach the audio driver, see RenderOffline
+	if (m_bRenderOffline) {
+		RenderFrame();
+		return TRUE;
+	}
 
-	if (IsPlaying())		// // //
-		if (stChannelID Channel = m_pInstRecorder->GetRecordChannel(); Channel.Chip != sound_chip_t::none)		// // //
-			m_pInstRecorder->RecordInstrument(GetPlayerTicks(), m_pTrackerView);
+	// // // Wait for the audio device, which renders as many frames as it needs samples
+	if (!m_pAudioDriver->Pump())
+		return TRUE;
 
-	if (m_pSoundDriver->ShouldHalt() || m_bHaltRequest) {		// // //
-		// Halt has been requested, abort playback here
-		HaltPlayer();
-	}
+	// // // Draw graph
+	if (CVisualizerWnd *pWnd = m_pVisualizerWnd)
+		pWnd->FlushSamples(m_pAudioDriver->ReleaseGraphBuffer());
 
 	return TRUE;
 }
@@ -1141,8 +1172,8 @@ void CSoundGen::OnLoadSettings(WPARAM wParam, LPARAM lParam)
 {
 	if (!ResetAudioDevice()) {
 		TRACE(L"SoundGen: Failed to reset audio device!\n");
-		if (m_pVisualizerWnd != NULL)
-			m_pVisualizerWnd->ReportAudioProblem();
+		if (CVisualizerWnd *pWnd = m_pVisualizerWnd)		// // //
+			pWnd->ReportAudioProblem();
 	}
 }
 
@@ -1163,12 +1194,14 @@ void CSoundGen::OnResetPlayer(WPARAM wParam, LPARAM lParam)
 
 void CSoundGen::OnStartRender(WPARAM wParam, LPARAM lParam)
 {
+	auto pRender = std::unique_ptr<std::shared_ptr<CWaveRenderer>> {reinterpret_cast<std::shared_ptr<CWaveRenderer> *>(wParam)};		// // //
+	m_pWaveRenderer = std::move(*pRender);
 	StartRendering();		// // //
+	RenderOffline();		// // //
 }
 
 void CSoundGen::OnStopRender(WPARAM wParam, LPARAM lParam)
 {
-	CSingleLock l(&m_csRenderer); l.Lock();
 	StopRendering();
 }
 
@@ -1197,6 +1230,7 @@ void CSoundGen::OnSetChip(WPARAM wParam, LPARAM lParam)
 	auto Chip = CSoundChipSet::FromFlag(wParam);		// // //
 
 	m_pAPU->SetExternalSound(Chip);
+	m_pSoundDriver->ModuleChipChanged();		// // //
 
 	// Enable internal channels after reset
 	if (Chip.ContainsChip(sound_chip_t::APU)) {
@@ -33,6 +33,7 @@
 #include <vector>		// // //
 #include <map>		// // //
 #include <memory>		// // //
+#include <atomic>		// // //
 #include "SoundGenBase.h"		// // //
 #include "APU/Types.h"
 #include "ft0cc/fs.h"		// // //
@@ -80,7 +81,7 @@ class CTrackerChannel;		// // //
 class CPlayerCursor;		// // //
 class CSoundDriver;		// // //
 class CSoundChipSet;		// // //
-class CSimpleFile;		// // //
+class CModuleSnapshotPublisher;		// // //
 
 namespace ft0cc::doc {
 class dpcm_sample;
@@ -116,7 +117,7 @@ public:
 
 	// Sound
 	bool		InitializeSound(HWND hWnd);
-	void		FlushBuffer(array_view<int16_t> Buffer) override;
+	void		FlushBuffer(array_view<float> Buffer) override;		// // //
 	CDSound		*GetSoundInterface() const;		// // //
 	CAudioDriver *GetAudioDriver() const;		// // //
 
@@ -127,6 +128,7 @@ public:
 	bool		Shutdown();		// // //
 
 	void		DocumentPropertiesChanged(CFamiTrackerDoc *pDocument);
+	void		PublishModule();		// // // called from the main thread after the module is modified
 
 public:
 	int			 ReadPeriodTable(int Index, int Table) const;		// // //
@@ -225,10 +227,12 @@ private:
 	void		CloseAudio();
 	bool		IsAudioReady() const;		// // //
 
-	bool		PlayBuffer() override;
+	bool		RenderFrame();		// // //
+	const CFamiTrackerModule *GetCurrentModule() const;		// // //
 
 	void		StartRendering();		// // //
 	void		StopRendering();		// // //
+	void		RenderOffline();		// // //
 
 	// Player
 	void		UpdateAPU();
@@ -271,15 +275,13 @@ private:
 	std::unique_ptr<CAPU>			m_pAPU;
 
 	std::shared_ptr<const ft0cc::doc::dpcm_sample> m_pPreviewSample;
-	CVisualizerWnd					*m_pVisualizerWnd = nullptr;
+	std::atomic<CVisualizerWnd *>	m_pVisualizerWnd {nullptr};		// // //
 
 	bool				m_bRunning;
 
 	// Thread synchronization
 private:
 	mutable CCriticalSection m_csAPULock;		// // //
-	mutable CCriticalSection m_csVisualizerWndLock;
-	mutable CCriticalSection m_csRenderer;		// // //
 
 	// Handles
 	HANDLE				m_hInterruptEvent;					// Used to interrupt sound buffer syncing
@@ -287,6 +289,7 @@ private:
 // Tracker playing variables
 private:
 	std::shared_ptr<CTempoCounter> m_pTempoCounter;			// // // tempo calculation
+	std::unique_ptr<CModuleSnapshotPublisher> m_pModuleSnapshots;	// // // module data read by the player
 	std::unique_ptr<CSoundDriver> m_pSoundDriver;			// // // main sound engine
 
 	std::unique_ptr<CTempoDisplay> m_pTempoDisplay;			// // // 050B
@@ -303,8 +306,9 @@ private:
 
 	std::unique_ptr<CArpeggiator> m_pArpeggiator;			// // //
 
-	std::shared_ptr<CWaveRenderer> m_pWaveRenderer;			// // //
-	std::shared_ptr<CSimpleFile> m_pRenderFile;				// // //
+	std::shared_ptr<CWaveRenderer> m_pWaveRenderer;			// // // only used by the player thread
+	std::atomic<bool>	m_bRendering {false};				// // //
+	bool				m_bRenderOffline = false;			// // // Samples go straight to the renderer
 	std::unique_ptr<CInstrumentRecorder> m_pInstRecorder;
 
 	std::map<stChannelID, bool> muted_;						// // //
@@ -22,16 +22,16 @@
 
 #include "TextExporter.h"
 #include "SongData.h"		// // //
-#include "SoundGen.h"		// // //
-#include "FamiTrackerDoc.h"
 #include "FamiTrackerModule.h"		// // //
 #include "ChannelMap.h"		// // //
+#include "ChannelOrder.h"		// // //
 #include "version.h"		// // //
 #include "FamiTrackerEnv.h"		// // //
-#include "FamiTrackerViewMessage.h"		// // //
-#include "str_conv/str_conv.hpp"		// // //
 #include "NumConv.h"		// // //
 #include "NoteName.h"		// // //
+#include "TrackData.h"		// // //
+#include "PatternData.h"		// // //
+#include "MappedFile.h"		// // //
 
 #include "ft0cc/doc/dpcm_sample.hpp"		// // //
 #include "ft0cc/doc/groove.hpp"		// // //
@@ -46,9 +46,14 @@
 #include "InstrumentN163.h"		// // //
 #include "SoundChipSet.h"		// // //
 
+#include <array>		// // //
+#include <cstdio>		// // //
+#include <fstream>		// // //
+#include <ostream>		// // //
+#include <stdexcept>		// // //
+#include <system_error>		// // //
 #include <type_traits>		// // //
-
-#define DEBUG_OUT(...) { OutputDebugString(FormattedA(__VA_ARGS__)); }
+#include <vector>		// // //
 
 // command tokens
 enum
@@ -163,98 +168,292 @@ const char *CT[CT_COUNT] = {
 	"ROW",
 };
 
+// // // printf-style formatting for error messages
+template <typename T>
+T FormatArg(T x) {
+	return x;
+}
+
+const char *FormatArg(const std::string &str) {
+	return str.c_str();
+}
+
+template <typename... Args>
+std::string FormatText(const char *fmt, Args... args) {
+	int n = std::snprintf(nullptr, 0, fmt, args...);
+	if (n <= 0)
+		return { };
+	std::string str(n, '\0');
+	std::snprintf(str.data(), n + 1, fmt, args...);
+	return str;
+}
+
+char ToUpper(char ch) noexcept {
+	return (ch >= 'a' && ch <= 'z') ? ch - 'a' + 'A' : ch;
+}
+
+std::string ToUpper(std::string_view sv) {
+	std::string str {sv};
+	for (char &ch : str)
+		ch = ToUpper(ch);
+	return str;
+}
+
+bool EqualsNoCase(std::string_view sv, std::string_view upper) noexcept {
+	if (sv.size() != upper.size())
+		return false;
+	for (std::size_t i = 0; i < sv.size(); ++i)
+		if (ToUpper(sv[i]) != upper[i])
+			return false;
+	return true;
+}
+
+// "00" to "FF", used for every %02X field
+constexpr auto HEX_TABLE = [] {
+	std::array<char, 0x200> table = { };
+	for (unsigned i = 0; i < 0x100; ++i) {
+		table[i * 2] = conv::to_digit<char>(i >> 4);
+		table[i * 2 + 1] = conv::to_digit<char>(i & 0x0F);
+	}
+	return table;
+}();
+
+void AppendHex2(std::string &str, unsigned x) {		// %02X
+	if (x < 0x100)
+		str.append(&HEX_TABLE[x * 2], 2);
+	else
+		str += conv::sv_from_uint_hex(x);
+}
+
+void AppendHex1(std::string &str, unsigned x) {		// %01X
+	if (x < 0x10)
+		str += HEX_TABLE[x * 2 + 1];
+	else
+		AppendHex2(str, x);
+}
+
+void AppendCellText(std::string &str, const stChanNote &stCell, unsigned nEffects, bool bNoise) {
+	if (bNoise && (is_note(stCell.Note) || stCell.Note == note_t::echo)) {		// // //
+		AppendHex1(str, stCell.ToMidiNote() & 0x0F);
+		str += "-#";
+	}
+	else if (stCell.Note != note_t::none && stCell.Note <= note_t::echo)
+		str += GetNoteString(stCell);
+	else
+		str += "...";
+
+	if (stCell.Instrument == MAX_INSTRUMENTS)
+		str += " ..";
+	else if (stCell.Instrument == HOLD_INSTRUMENT)		// // // 050B
+		str += " &&";
+	else {
+		str += ' ';
+		AppendHex2(str, stCell.Instrument);
+	}
+
+	if (stCell.Vol == 0x10)
+		str += " .";
+	else {
+		str += ' ';
+		AppendHex1(str, stCell.Vol);
+	}
+
+	for (unsigned int e = 0; e < nEffects; ++e)
+		if (stCell.Effects[e].fx == effect_t::none)
+			str += " ...";
+		else {
+			str += ' ';
+			str += EFF_CHAR[value_cast(stCell.Effects[e].fx)];
+			AppendHex2(str, stCell.Effects[e].param);
+		}
+}
+
+// // // buffered text output, passed to the stream in large blocks
+class CTextWriter
+{
+public:
+	explicit CTextWriter(std::ostream &os) : os_(os) {
+		buf_.reserve(BLOCK_SIZE + 0x400);
+	}
+
+	CTextWriter &Put(std::string_view sv) {
+		buf_ += sv;
+		return Check();
+	}
+
+	CTextWriter &Put(char ch) {
+		buf_ += ch;
+		return Check();
+	}
+
+	CTextWriter &PutPadded(std::string_view sv, std::size_t width) {		// %-*s
+		buf_ += sv;
+		if (sv.size() < width)
+			buf_.append(width - sv.size(), ' ');
+		return Check();
+	}
+
+	CTextWriter &PutInt(int x, std::size_t width = 0) {		// %*d
+		char digits[12];
+		char *it = std::end(digits);
+		unsigned ux = x < 0 ? 0u - static_cast<unsigned>(x) : x;
+		do {
+			*--it = static_cast<char>('0' + ux % 10);
+			ux /= 10;
+		} while (ux);
+		if (x < 0)
+			*--it = '-';
+		std::size_t len = std::end(digits) - it;
+		if (len < width)
+			buf_.append(width - len, ' ');
+		buf_.append(it, len);
+		return Check();
+	}
+
+	CTextWriter &PutHex(unsigned x) {		// %02X
+		AppendHex2(buf_, x);
+		return Check();
+	}
+
+	CTextWriter &PutString(std::string_view sv) {
+		// puts " at beginning and end of string, replace " with ""
+		buf_ += '\"';
+		for (char c : sv) {
+			if (c == '\"')
+				buf_ += c;
+			buf_ += c;
+		}
+		buf_ += '\"';
+		return Check();
+	}
+
+	CTextWriter &PutCell(const stChanNote &stCell, unsigned nEffects, bool bNoise) {
+		AppendCellText(buf_, stCell, nEffects, bNoise);
+		return Check();
+	}
+
+	void Flush() {
+		os_.write(buf_.data(), buf_.size());
+		buf_.clear();
+	}
+
+private:
+	static constexpr std::size_t BLOCK_SIZE = 0x10000;
+
+	CTextWriter &Check() {
+		if (buf_.size() >= BLOCK_SIZE)
+			Flush();
+		return *this;
+	}
+
+	std::ostream &os_;
+	std::string buf_;
+};
+
 } // namespace
 
 // =============================================================================
 
+// // // reads tokens in place from the text, only quoted strings with escaped quotes and tokens
+// spanning a lone carriage return are copied
 class Tokenizer
 {
 public:
-	explicit Tokenizer(const fs::path &FileName) : text(ReadFromFile(FileName)) { }
-	~Tokenizer() = default;
-
-	void Reset() {
-		last_pos_ = pos = 0;
-		line = 1;
-		linestart = 0;
-	}
+	explicit Tokenizer(std::string_view text) : text(text) { }
 
 	void FinishLine() {
-		if (int newpos = text.Find('\n', pos); newpos >= 0) {		// // //
+		if (auto newpos = text.find('\n', pos); newpos != std::string_view::npos) {		// // //
 			++line;
 			pos = newpos + 1;
 		}
 		else
-			pos = text.GetLength();
-		last_pos_ = linestart = pos;
+			pos = text.size();
+		linestart = pos;
 	}
 
 	int GetColumn() const {
-		return 1 + pos - linestart;
+		return static_cast<int>(1 + pos - linestart);
 	}
 
 	bool Finished() const {
-		return pos >= text.GetLength();
+		return pos >= text.size();
 	}
 
-	CStringA ReadToken() {
+	// note: the returned view is invalidated by the next call
+	std::string_view ReadToken() {
 		ConsumeSpace();
-		CStringA t = "";
 
 		bool isQuoted = TrimChar('\"');		// // //
+		const std::size_t begin = pos;
+		std::size_t end = pos;
+		bool copied = false;
+		const auto copy = [&] {
+			if (!copied) {
+				copied = true;
+				buffer.assign(text, begin, pos - begin);
+			}
+		};
+
 		while (!Finished())
-			switch (char c = text.GetAt(pos)) {
-			case '\r': case '\n':
+			switch (char c = text[pos]) {
+			case '\r':
+				if (!isQuoted)
+					if (auto next = text.find_first_not_of('\r', pos); next == std::string_view::npos || IsDelimiter(text[next]))
+						goto outer;
+				copy();		// old files were read with all carriage returns removed
+				++pos;
+				break;
+			case '\n':
 				if (isQuoted)
 					throw MakeError("incomplete quoted string.");
 				goto outer;
 			case '\"':
 				if (!isQuoted)
 					goto outer;
-				++pos;
-				if (!TrimChar('\"'))
-					goto outer;
-				t += c;
-				break;
+				if (pos + 1 < text.size() && text[pos + 1] == '\"') {		// escaped quote
+					copy();
+					buffer += c;
+					pos += 2;
+					break;
+				}
+				end = pos++;
+				goto quoted;
 			case ' ': case '\t':
 				if (!isQuoted)
 					goto outer;
 				[[fallthrough]];
 			default:
-				t += c;
 				++pos;
+				if (copied)
+					buffer += c;
 			}
-		outer:
+	outer:
+		end = pos;
+	quoted:
 
-		//DEBUG_OUT("ReadToken(%d,%d): '%s'\n", line, GetColumn(), t);
-		last_pos_ = pos;
-		return t;
+		return copied ? std::string_view {buffer} : text.substr(begin, end - begin);
 	}
 
 	int ReadInt(int range_min, int range_max) {
-		if (CStringA t = ReadToken(); !t.IsEmpty()) {
+		if (std::string_view t = ReadToken(); !t.empty()) {
 			if (auto i = conv::to_int(t)) {
-				if (*i >= range_min && *i <= range_max) {
-					last_pos_ = pos;
+				if (*i >= range_min && *i <= range_max)
 					return *i;
-				}
 				throw MakeError("expected integer in range [%d,%d], %d found.", range_min, range_max, *i);
 			}
-			throw MakeError("expected integer, '%s' found.", (LPCSTR)t);
+			throw MakeError("expected integer, '%s' found.", std::string {t});
 		}
 		throw MakeError("expected integer, no token found.");
 	}
 
 	unsigned ReadHex(unsigned range_min, unsigned range_max) {
-		if (CStringA t = ReadToken(); !t.IsEmpty()) {
+		if (std::string_view t = ReadToken(); !t.empty()) {
 			if (auto i = conv::to_uint(t, 16)) {
-				if (*i >= range_min && *i <= range_max) {
-					last_pos_ = pos;
+				if (*i >= range_min && *i <= range_max)
 					return *i;
-				}
 				throw MakeError("expected hexadecimal in range [%X,%X], %X found.", range_min, range_max, *i);
 			}
-			throw MakeError("expected hexadecimal, '%s' found.", (LPCSTR)t);
+			throw MakeError("expected hexadecimal, '%s' found.", std::string {t});
 		}
 		throw MakeError("expected hexadecimal, no token found.");
 	}
@@ -262,68 +461,68 @@ public:
 	// note: finishes line if found
 	void ReadEOL() {
 		ConsumeSpace();
-		if (CStringA s = ReadToken(); !s.IsEmpty())
-			throw MakeError("expected end of line, '%s' found.", (LPCSTR)s);
+		if (std::string_view s = ReadToken(); !s.empty())
+			throw MakeError("expected end of line, '%s' found.", std::string {s});
 		if (!Finished()) {
-			if (char eol = text.GetAt(pos); eol != '\r' && eol != '\n')
+			if (char eol = text[pos]; eol != '\r' && eol != '\n')
 				throw MakeError("expected end of line, '%c' found.", eol);
 			FinishLine();
 		}
-		last_pos_ = pos;
 	}
 
 	// note: finishes line if found
 	bool IsEOL() {
 		ConsumeSpace();
-		if (Finished()) {
-			last_pos_ = pos;
+		if (Finished())
 			return true;
-		}
 
 		if (TrimChar('\n')) {		// // //
 			++line;
-			last_pos_ = linestart = pos;
+			linestart = pos;
 			return true;
 		}
 
 		return false;
 	}
 
-	int ImportHex(const CStringA &sToken) {		// // //
+	int ImportHex(std::string_view sToken) {		// // //
 		auto x = conv::to_int(sToken, 16);
 		if (!x)
-			throw MakeError("hexadecimal number expected, '%s' found.", (LPCSTR)sToken);
+			throw MakeError("hexadecimal number expected, '%s' found.", std::string {sToken});
 		return *x;
 	}
 
 	template <typename... Args>
-	auto MakeError(LPCSTR fmt, Args&&... args) const {		// // //
-		CStringA str = FormattedA("Line %d column %d: ", line, GetColumn());
-		AppendFormatA(str, fmt, std::forward<Args>(args)...);
-		return std::runtime_error {(LPCSTR)str};
+	std::runtime_error MakeError(const char *fmt, const Args &... args) const {		// // //
+		std::string str = FormatText("Line %d column %d: ", line, GetColumn());
+		if constexpr (sizeof...(Args) > 0)
+			str += FormatText(fmt, FormatArg(args)...);
+		else
+			str += fmt;
+		return std::runtime_error {str};
 	}
 
 	stChanNote ImportCellText(unsigned fxMax, stChannelID chan) {		// // //
 		stChanNote Cell;		// // //
 
-		CStringA sNote = ReadToken();
+		std::string_view sNote = ReadToken();
 		if (sNote == "...") { Cell.Note = note_t::none; }
 		else if (sNote == "---") { Cell.Note = note_t::halt; }
 		else if (sNote == "===") { Cell.Note = note_t::release; }
 		else {
-			if (sNote.GetLength() != 3)
-				throw MakeError("note column should be 3 characters wide, '%s' found.", (LPCSTR)sNote);
+			if (sNote.size() != 3)
+				throw MakeError("note column should be 3 characters wide, '%s' found.", std::string {sNote});
 
 			if (IsAPUNoise(chan)) {		// // // noise
-				int h = ImportHex(sNote.Left(1));		// // //
+				int h = ImportHex(sNote.substr(0, 1));		// // //
 				Cell.Note = ft0cc::doc::pitch_from_midi(h);
 				Cell.Octave = ft0cc::doc::oct_from_midi(h);
 
 				// importer is very tolerant about the second and third characters
 				// in a noise note, they can be anything
 			}
-			else if (sNote.GetAt(0) == '^' && sNote.GetAt(1) == '-') {		// // //
-				unsigned o = sNote.GetAt(2) - '0';
+			else if (sNote[0] == '^' && sNote[1] == '-') {		// // //
+				unsigned o = sNote[2] - '0';
 				if (o >= ECHO_BUFFER_LENGTH)
 					throw MakeError("out-of-bound echo buffer accessed.");
 				Cell.Note = note_t::echo;
@@ -331,7 +530,7 @@ public:
 			}
 			else {
 				int n = 1;
-				switch (sNote.GetAt(0)) {
+				switch (sNote[0]) {
 				case 'c': case 'C': n = value_cast(note_t::C); break;
 				case 'd': case 'D': n = value_cast(note_t::D); break;
 				case 'e': case 'E': n = value_cast(note_t::E); break;
@@ -340,74 +539,72 @@ public:
 				case 'a': case 'A': n = value_cast(note_t::A); break;
 				case 'b': case 'B': n = value_cast(note_t::B); break;
 				default:
-					throw MakeError("unrecognized note '%s'.", (LPCSTR)sNote);
+					throw MakeError("unrecognized note '%s'.", std::string {sNote});
 				}
-				switch (sNote.GetAt(1)) {
+				switch (sNote[1]) {
 				case '-': case '.': break;
 				case '#': case '+': ++n; break;
 				case 'b': case 'f': --n; break;
 				default:
-					throw MakeError("unrecognized note '%s'.", (LPCSTR)sNote);
+					throw MakeError("unrecognized note '%s'.", std::string {sNote});
 				}
 				while (n < value_cast(note_t::C)) n += NOTE_RANGE;
 				while (n > value_cast(note_t::B)) n -= NOTE_RANGE;
 				Cell.Note = enum_cast<note_t>(n);
 
-				int o = sNote.GetAt(2) - '0';
+				int o = sNote[2] - '0';
 				if (o < 0 || o >= OCTAVE_RANGE) {
-					throw MakeError("unrecognized octave '%s'.", (LPCSTR)sNote);
+					throw MakeError("unrecognized octave '%s'.", std::string {sNote});
 				}
 				Cell.Octave = o;
 			}
 		}
 
-		CStringA sInst = ReadToken();
+		std::string_view sInst = ReadToken();
 		if (sInst == "..") { Cell.Instrument = MAX_INSTRUMENTS; }
 		else if (sInst == "&&") { Cell.Instrument = HOLD_INSTRUMENT; }		// // // 050B
 		else {
-			if (sInst.GetLength() != 2)
-				throw MakeError("instrument column should be 2 characters wide, '%s' found.", (LPCSTR)sInst);
+			if (sInst.size() != 2)
+				throw MakeError("instrument column should be 2 characters wide, '%s' found.", std::string {sInst});
 			int h = ImportHex(sInst);		// // //
 			if (h >= MAX_INSTRUMENTS)
-				throw MakeError("instrument '%s' is out of bounds.", (LPCSTR)sInst);
+				throw MakeError("instrument '%s' is out of bounds.", std::string {sInst});
 			Cell.Instrument = h;
 		}
 
-		Cell.Vol = [&] (const CStringA &str) -> unsigned {
+		Cell.Vol = [&] (std::string_view str) -> unsigned {
 			if (str == ".")
 				return MAX_VOLUME;
-			const LPCSTR VOL_TEXT[] = {
-				"0", "1", "2", "3", "4", "5", "6", "7",
-				"8", "9", "A", "B", "C", "D", "E", "F",
-			};
-			unsigned v = 0;
-			for (; v < std::size(VOL_TEXT); ++v)
-				if (str == VOL_TEXT[v])
+			if (str.size() == 1)
+				if (auto v = conv::from_digit(str.front()); v < 0x10)		// // //
 					return v;
-			throw MakeError("unrecognized volume token '%s'.", (LPCSTR)str);
-		}(ReadToken().MakeUpper());
+			throw MakeError("unrecognized volume token '%s'.", ToUpper(str));
+		}(ReadToken());
 
 		for (unsigned int e = 0; e < fxMax; ++e) {		// // //
-			CStringA sEff = ReadToken().MakeUpper();
-			if (sEff.GetLength() != 3)
-				throw MakeError("effect column should be 3 characters wide, '%s' found.", (LPCSTR)sEff);
+			std::string_view sEff = ReadToken();
+			if (sEff.size() != 3)
+				throw MakeError("effect column should be 3 characters wide, '%s' found.", ToUpper(sEff));
 
 			if (sEff != "...") {
-				effect_t Eff = FTEnv.GetSoundChipService()->TranslateEffectName(sEff.GetAt(0), chan.Chip);		// // //
+				effect_t Eff = FTEnv.GetSoundChipService()->TranslateEffectName(ToUpper(sEff[0]), chan.Chip);		// // //
 				if (Eff == effect_t::none)
-					throw MakeError("unrecognized effect '%s'.", (LPCSTR)sEff);
-				Cell.Effects[e] = {Eff, static_cast<uint8_t>(ImportHex(sEff.Right(2)))};		// // //
+					throw MakeError("unrecognized effect '%s'.", ToUpper(sEff));
+				Cell.Effects[e] = {Eff, static_cast<uint8_t>(ImportHex(sEff.substr(1)))};		// // //
 			}
 		}
 
-		last_pos_ = pos;
 		return Cell;
 	}
 
 private:
+	static bool IsDelimiter(char ch) noexcept {
+		return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\"';
+	}
+
 	bool TrimChar(char ch) {
 		if (!Finished())
-			if (char x = text.GetAt(pos); x == ch) {
+			if (char x = text[pos]; x == ch) {
 				++pos;
 				return true;
 			}
@@ -415,103 +612,47 @@ private:
 	}
 
 	void ConsumeSpace() {
-		while (TrimChar(' ') || TrimChar('\t'))		// // //
+		while (TrimChar(' ') || TrimChar('\t') || TrimChar('\r'))		// // //
 			;
 	}
 
-	CStringA ReadFromFile(const fs::path &FileName) {
-		CFileException oFileException;
-		if (CStdioFile f; f.Open(FileName.c_str(), CFile::modeRead | CFile::typeBinary, &oFileException)) {
-			CStringA str;
-			while (f.GetPosition() < f.GetLength()) {
-				char buf[1024] = { };
-				ULONGLONG sz = std::min(f.GetLength() - f.GetPosition(), (ULONGLONG)std::size(buf));
-				f.Read(buf, (UINT)sz);
-				CStringA part(buf, (int)sz);
-				part.Replace("\r", "");
-				str += part;
-			}
-			f.Close();
-			return str;
-		}
-
-		WCHAR szError[256];
-		oFileException.GetErrorMessage(szError, std::size(szError));
-		throw std::runtime_error {"Unable to open file:\n" + conv::to_utf8(szError)};
-	}
-
 public:
 	int line = 1;
 
 private:
-	const CStringA text; // TODO: move outside and use string_view
-	int pos = 0;
-	int linestart = 0;
-	int last_pos_ = 0;		// // //
+	const std::string_view text;		// // //
+	std::size_t pos = 0;
+	std::size_t linestart = 0;
+	std::string buffer;		// // // copied tokens
 };
 
 // =============================================================================
 
-CStringA CTextExport::ExportString(const CStringA &s)
-{
-	return ExportString(std::string_view {(LPCSTR)s});
-}
-
-CStringA CTextExport::ExportString(std::string_view s)		// // //
+std::string CTextExport::ExportCellText(const stChanNote &stCell, unsigned int nEffects, bool bNoise)		// // //
 {
-	// puts " at beginning and end of string, replace " with ""
-	CStringA r = "\"";
-	for (char c : s) {
-		if (c == '\"')
-			r += c;
-		r += c;
-	}
-	r += "\"";
-	return r;
-}
-
-// =============================================================================
-
-CStringA CTextExport::ExportCellText(const stChanNote &stCell, unsigned int nEffects, bool bNoise)		// // //
-{
-	CStringA s = "...";
-	if (bNoise && (is_note(stCell.Note) || stCell.Note == note_t::echo))		// // //
-		s = FormattedA("%01X-#", stCell.ToMidiNote() & 0x0F);
-	else if (stCell.Note <= note_t::echo)
-		s = GetNoteString(stCell).data();
-
-	s += (stCell.Instrument == MAX_INSTRUMENTS) ? CStringA(" ..") :
-		(stCell.Instrument == HOLD_INSTRUMENT) ? CStringA(" &&") : FormattedA(" %02X", stCell.Instrument);		// // // 050B
-
-	s += (stCell.Vol == 0x10) ? CStringA(" .") : FormattedA(" %01X", stCell.Vol);		// // //
-
-	for (unsigned int e=0; e < nEffects; ++e)
-		if (stCell.Effects[e].fx == effect_t::none)
-			s.Append(" ...");
-		else
-			AppendFormatA(s, " %c%02X", EFF_CHAR[value_cast(stCell.Effects[e].fx)], stCell.Effects[e].param);
-
+	std::string s;
+	AppendCellText(s, stCell, nEffects, bNoise);
 	return s;
 }
 
 // =============================================================================
 
 #define CHECK_SYMBOL(x) do { \
-		if (CStringA symbol_ = t.ReadToken(); symbol_ != x) \
-			throw t.MakeError("expected '%s', '%s' found.", (LPCSTR)x, (LPCSTR)symbol_); \
+		if (std::string_view symbol_ = t.ReadToken(); symbol_ != x) \
+			throw t.MakeError("expected '%s', '%s' found.", x, std::string {symbol_}); \
 	} while (false)
 
 #define CHECK_COLON() CHECK_SYMBOL(":")
 
-void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
-	// begin a new document
-	if (!Doc.OnNewDocument())
-		throw std::runtime_error {"Unable to create new Famitracker document."};
+void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerModule &modfile) {		// // //
+	CMappedFile file {FileName};
+	ImportText(file.GetText(), modfile);
+}
 
+void CTextExport::ImportText(std::string_view text, CFamiTrackerModule &modfile) {		// // //
 	// parse the file
-	Tokenizer t(FileName);		// // //
+	Tokenizer t(text);		// // //
 
-	auto &modfile = *Doc.GetModule();		// // //
 	auto &InstManager = *modfile.GetInstrumentManager();
 
 	unsigned int dpcm_index = 0;
@@ -524,11 +665,11 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 	while (!t.Finished()) {
 		// read first token on line
 		if (t.IsEOL()) continue; // blank line
-		CStringA command = t.ReadToken().MakeUpper();		// // //
+		std::string_view command = t.ReadToken();		// // //
 
 		int c = 0;
 		for (; c < CT_COUNT; ++c)
-			if (command == CT[c]) break;
+			if (EqualsNoCase(command, CT[c])) break;
 
 		//DEBUG_OUT("Command read: %s\n", command);
 		switch (c) {
@@ -536,15 +677,15 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			t.FinishLine();
 			break;
 		case CT_TITLE:
-			modfile.SetModuleName(LPCSTR(t.ReadToken()));
+			modfile.SetModuleName(t.ReadToken());
 			t.ReadEOL();
 			break;
 		case CT_AUTHOR:
-			modfile.SetModuleArtist(LPCSTR(t.ReadToken()));
+			modfile.SetModuleArtist(t.ReadToken());
 			t.ReadEOL();
 			break;
 		case CT_COPYRIGHT:
-			modfile.SetModuleCopyright(LPCSTR(t.ReadToken()));
+			modfile.SetModuleCopyright(t.ReadToken());
 			t.ReadEOL();
 			break;
 		case CT_COMMENT:
@@ -567,7 +708,9 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			break;
 		case CT_EXPANSION: {
 			auto flag = t.ReadInt(0, CSoundChipSet::NSF_MAX_FLAG);		// // //
-			modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(CSoundChipSet::FromNSFFlag(flag), modfile.GetNamcoChannels()));
+			auto chips = CSoundChipSet::FromNSFFlag(flag);
+			// all N163 channels are exported, N163CHANNELS restores the actual count
+			modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(chips, chips.ContainsChip(sound_chip_t::N163) ? MAX_CHANNELS_N163 : 0));
 			t.ReadEOL();
 			break;
 		}
@@ -641,7 +784,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			dpcm_index = t.ReadInt(0, MAX_DSAMPLES - 1);
 			dpcm_size = t.ReadInt(0, ft0cc::doc::dpcm_sample::max_size);
 			dpcm_sample = std::make_shared<ft0cc::doc::dpcm_sample>();		// // //
-			dpcm_sample->rename(LPCSTR(t.ReadToken()));
+			dpcm_sample->rename(t.ReadToken());
 
 			t.ReadEOL();
 		}
@@ -720,7 +863,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 				pInstN163->SetWavePos(t.ReadInt(0, 256 - 16 * N163count - 1));
 				pInstN163->SetWaveCount(t.ReadInt(1, CInstrumentN163::MAX_WAVE_COUNT));
 			}
-			seqInst->SetName(LPCSTR(t.ReadToken()));
+			seqInst->SetName(t.ReadToken());
 			InstManager.InsertInstrument(inst_index, std::move(pInst));
 			t.ReadEOL();
 		}
@@ -732,7 +875,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			pInst->SetPatch(t.ReadInt(0, 15));
 			for (int r = 0; r < 8; ++r)
 				pInst->SetCustomReg(r, t.ReadHex(0x00, 0xFF));
-			pInst->SetName(LPCSTR(t.ReadToken()));
+			pInst->SetName(t.ReadToken());
 			InstManager.InsertInstrument(inst_index, std::move(pInst));
 			t.ReadEOL();
 		}
@@ -745,7 +888,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			pInst->SetModulationSpeed(t.ReadInt(0, 4095));
 			pInst->SetModulationDepth(t.ReadInt(0, 63));
 			pInst->SetModulationDelay(t.ReadInt(0, 255));
-			pInst->SetName(LPCSTR(t.ReadToken()));
+			pInst->SetName(t.ReadToken());
 			InstManager.InsertInstrument(inst_index, std::move(pInst));
 			t.ReadEOL();
 		}
@@ -846,7 +989,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			pSong->SetSongGroove(UseGroove[track]);		// // //
 			pSong->SetSongSpeed(t.ReadInt(0, MAX_TEMPO));
 			pSong->SetSongTempo(t.ReadInt(0, MAX_TEMPO));
-			pSong->SetTitle((LPCSTR)t.ReadToken());		// // //
+			pSong->SetTitle(t.ReadToken());		// // //
 
 			t.ReadEOL();
 			++track;
@@ -895,7 +1038,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 		break;
 		case CT_COUNT:
 		default:
-			throw t.MakeError("Unrecognized command: '%s'.", (LPCSTR)command);
+			throw t.MakeError("Unrecognized command: '%s'.", ToUpper(command));
 		}
 	}
 
@@ -906,31 +1049,33 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 	}
 	if (N163count != -1)		// // //
 		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(modfile.GetSoundChipSet(), N163count));
-
-	FTEnv.GetSoundGenerator()->AssignModule(modfile);		// / //
-	FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
 }
 
 // =============================================================================
 
-CStringA CTextExport::ExportRows(const fs::path &FileName, const CFamiTrackerModule &modfile) {		// // //
-	CStdioFile f;
-	CFileException oFileException;
-	if (!f.Open(FileName.c_str(), CFile::modeCreate | CFile::modeWrite | CFile::typeText, &oFileException))
-	{
-		WCHAR szError[256];
-		oFileException.GetErrorMessage(szError, std::size(szError));
+namespace {
 
-		return FormattedA("Unable to open file:\n%s", conv::to_utf8(szError).data());
-	}
+std::string OpenError() {		// // //
+	return "Unable to open file:\n" + std::error_code {errno, std::generic_category()}.message();
+}
 
-	const auto WriteString = [&] (const CStringA &str) { // TODO: don't use CStdioFile
-		f.Write(str.GetString(), str.GetLength());
-	};
+} // namespace
 
-	WriteString("ID,SONG,CHIP,SUBINDEX,PATTERN,ROW,NOTE,OCTAVE,INST,VOLUME,FX1,FX1PARAM,FX2,FX2PARAM,FX3,FX3PARAM,FX4,FX4PARAM\n");
+std::string CTextExport::ExportRows(const fs::path &FileName, const CFamiTrackerModule &modfile) {		// // //
+	std::ofstream file {FileName};
+	if (!file)
+		return OpenError();
+	ExportRowText(file, modfile);
+	if (!file.flush())
+		return "Unable to write file.";
+	return "";
+}
+
+void CTextExport::ExportRowText(std::ostream &os, const CFamiTrackerModule &modfile) {		// // //
+	CTextWriter w {os};
+
+	w.Put("ID,SONG,CHIP,SUBINDEX,PATTERN,ROW,NOTE,OCTAVE,INST,VOLUME,FX1,FX1PARAM,FX2,FX2PARAM,FX3,FX3PARAM,FX4,FX4PARAM\n");
 
-	const LPCSTR FMT = "%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n";
 	int id = 0;
 
 	modfile.VisitSongs([&] (const CSongData &song, unsigned t) {
@@ -938,49 +1083,48 @@ CStringA CTextExport::ExportRows(const fs::path &FileName, const CFamiTrackerMod
 		song.VisitPatterns([&] (const CPatternData &pat, stChannelID c, unsigned p) {
 			if (song.IsPatternInUse(c, p))
 				pat.VisitRows(rows, [&] (const stChanNote &stCell, unsigned r) {
-					if (stCell != stChanNote { })
-						WriteString(FormattedA(FMT, id++, t, value_cast(c.Chip), c.Subindex, p, r,
-							stCell.Note, stCell.Octave, stCell.Instrument, stCell.Vol,
-							stCell.Effects[0].fx, stCell.Effects[0].param,
-							stCell.Effects[1].fx, stCell.Effects[1].param,
-							stCell.Effects[2].fx, stCell.Effects[2].param,
-							stCell.Effects[3].fx, stCell.Effects[3].param));
+					if (stCell != stChanNote { }) {
+						w.PutInt(id++).Put(',').PutInt(t).Put(',').PutInt(value_cast(c.Chip)).Put(',').PutInt(c.Subindex).Put(',')
+							.PutInt(p).Put(',').PutInt(r).Put(',')
+							.PutInt(value_cast(stCell.Note)).Put(',').PutInt(stCell.Octave).Put(',')
+							.PutInt(stCell.Instrument).Put(',').PutInt(stCell.Vol);
+						for (const auto &cmd : stCell.Effects)
+							w.Put(',').PutInt(value_cast(cmd.fx)).Put(',').PutInt(cmd.param);
+						w.Put('\n');
+					}
 				});
 		});
 	});
 
-	return "";
+	w.Flush();
 }
 
-CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {		// // //
-	CStdioFile f;
-	CFileException oFileException;
-	if (!f.Open(FileName.c_str(), CFile::modeCreate | CFile::modeWrite | CFile::typeText, &oFileException)) {
-		WCHAR szError[256];
-		oFileException.GetErrorMessage(szError, std::size(szError));
-
-		return FormattedA("Unable to open file:\n%s", conv::to_utf8(szError).data());
-	}
-
-	auto &modfile = *Doc.GetModule();		// // //
+std::string CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerModule &modfile) {		// // //
+	std::ofstream file {FileName};
+	if (!file)
+		return OpenError();
+	ExportText(file, modfile);
+	if (!file.flush())
+		return "Unable to write file.";
+	return "";
+}
 
-	const auto WriteString = [&] (const CStringA &str) { // TODO: don't use CStdioFile
-		f.Write(str.GetString(), str.GetLength());
-	};
+void CTextExport::ExportText(std::ostream &os, CFamiTrackerModule &modfile) {		// // //
+	CTextWriter w {os};
 
-	WriteString(FormattedA("# VT02CC-FamiTracker text export %s\n\n", Get0CCFTVersionString()));		// // //
+	w.Put("# VT02CC-FamiTracker text export ").Put(Get0CCFTVersionString()).Put("\n\n");		// // //
 
-	WriteString("# Module information\n");
-	WriteString(FormattedA("%-15s %s\n", CT[CT_TITLE],     (LPCSTR)ExportString(modfile.GetModuleName())));
-	WriteString(FormattedA("%-15s %s\n", CT[CT_AUTHOR],    (LPCSTR)ExportString(modfile.GetModuleArtist())));
-	WriteString(FormattedA("%-15s %s\n", CT[CT_COPYRIGHT], (LPCSTR)ExportString(modfile.GetModuleCopyright())));
-	WriteString("\n");
+	w.Put("# Module information\n");
+	w.PutPadded(CT[CT_TITLE], 15).Put(' ').PutString(modfile.GetModuleName()).Put('\n');
+	w.PutPadded(CT[CT_AUTHOR], 15).Put(' ').PutString(modfile.GetModuleArtist()).Put('\n');
+	w.PutPadded(CT[CT_COPYRIGHT], 15).Put(' ').PutString(modfile.GetModuleCopyright()).Put('\n');
+	w.Put('\n');
 
-	WriteString("# Module comment\n");
+	w.Put("# Module comment\n");
 	std::string_view sComment = modfile.GetComment();		// // //
 	while (true) {
 		auto n = sComment.find_first_of("\r\n");
-		WriteString(FormattedA("%s %s\n", CT[CT_COMMENT], (LPCSTR)ExportString(sComment.substr(0, n))));
+		w.Put(CT[CT_COMMENT]).Put(' ').PutString(sComment.substr(0, n)).Put('\n');
 		if (n == std::string_view::npos)
 			break;
 		sComment.remove_prefix(n);
@@ -989,30 +1133,27 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 		if (!sComment.empty() && sComment.front() == '\n')
 			sComment.remove_prefix(1);
 	}
-	WriteString("\n");
-
-	WriteString("# Global settings\n");
-	WriteString(FormattedA("%-15s %d\n", CT[CT_MACHINE],   modfile.GetMachine()));
-	WriteString(FormattedA("%-15s %d\n", CT[CT_FRAMERATE], modfile.GetEngineSpeed()));
-	WriteString(FormattedA("%-15s %d\n", CT[CT_EXPANSION], modfile.GetSoundChipSet().GetNSFFlag()));		// // //
-	WriteString(FormattedA("%-15s %d\n", CT[CT_VIBRATO],   modfile.GetVibratoStyle()));
-	WriteString(FormattedA("%-15s %d\n", CT[CT_SPLIT],     modfile.GetSpeedSplitPoint()));
-//	WriteString(FormattedA("%-15s %d %d\n", CT[CT_PLAYBACKRATE]));
+	w.Put('\n');
+
+	w.Put("# Global settings\n");
+	w.PutPadded(CT[CT_MACHINE], 15).Put(' ').PutInt(value_cast(modfile.GetMachine())).Put('\n');
+	w.PutPadded(CT[CT_FRAMERATE], 15).Put(' ').PutInt(modfile.GetEngineSpeed()).Put('\n');
+	w.PutPadded(CT[CT_EXPANSION], 15).Put(' ').PutInt(modfile.GetSoundChipSet().GetNSFFlag()).Put('\n');		// // //
+	w.PutPadded(CT[CT_VIBRATO], 15).Put(' ').PutInt(value_cast(modfile.GetVibratoStyle())).Put('\n');
+	w.PutPadded(CT[CT_SPLIT], 15).Put(' ').PutInt(modfile.GetSpeedSplitPoint()).Put('\n');
 	if (modfile.GetTuningSemitone() || modfile.GetTuningCent())		// // // 050B
-		WriteString(FormattedA("%-15s %d %d\n", CT[CT_TUNING], modfile.GetTuningSemitone(), modfile.GetTuningCent()));
-	WriteString("\n");
+		w.PutPadded(CT[CT_TUNING], 15).Put(' ').PutInt(modfile.GetTuningSemitone()).Put(' ').PutInt(modfile.GetTuningCent()).Put('\n');
+	w.Put('\n');
 
 	int N163count = -1;		// // //
 	if (modfile.HasExpansionChip(sound_chip_t::N163)) {
 		N163count = modfile.GetNamcoChannels();
 		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(modfile.GetSoundChipSet(), MAX_CHANNELS_N163));
-		WriteString(FormattedA("# Namco 163 global settings\n"
-			"%-15s %d\n"
-			"\n",
-			CT[CT_N163CHANNELS], N163count));
+		w.Put("# Namco 163 global settings\n");
+		w.PutPadded(CT[CT_N163CHANNELS], 15).Put(' ').PutInt(N163count).Put("\n\n");
 	}
 
-	WriteString("# Macros\n");
+	w.Put("# Macros\n");
 	const auto &InstManager = *modfile.GetInstrumentManager();
 	const inst_type_t CHIP_MACRO[4] = { INST_2A03, INST_VRC6, INST_N163, INST_S5B };
 	for (int c=0; c<4; ++c) {
@@ -1020,81 +1161,76 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 			for (int seq = 0; seq < MAX_SEQUENCES; ++seq) {
 				const auto pSequence = InstManager.GetSequence(CHIP_MACRO[c], st, seq);
 				if (pSequence && pSequence->GetItemCount() > 0) {
-					WriteString(FormattedA("%-9s %3d %3d %3d %3d %3d :",
-						CT[CT_MACRO + c],
-						st,
-						seq,
-						pSequence->GetLoopPoint(),
-						pSequence->GetReleasePoint(),
-						pSequence->GetSetting()));
+					w.PutPadded(CT[CT_MACRO + c], 9)
+						.Put(' ').PutInt(value_cast(st), 3)
+						.Put(' ').PutInt(seq, 3)
+						.Put(' ').PutInt(pSequence->GetLoopPoint(), 3)
+						.Put(' ').PutInt(pSequence->GetReleasePoint(), 3)
+						.Put(' ').PutInt(value_cast(pSequence->GetSetting()), 3).Put(" :");
 					for (unsigned int i = 0; i < pSequence->GetItemCount(); ++i)
-						WriteString(FormattedA(" %d", pSequence->GetItem(i)));
-					WriteString("\n");
+						w.Put(' ').PutInt(pSequence->GetItem(i));
+					w.Put('\n');
 				}
 			}
 		}
 	}
-	WriteString("\n");
+	w.Put('\n');
 
-	WriteString("# DPCM samples\n");
+	w.Put("# DPCM samples\n");
 	for (int smp=0; smp < MAX_DSAMPLES; ++smp)
 	{
 		if (auto pSample = modfile.GetDSampleManager()->GetDSample(smp)) {		// // //
 			const unsigned int size = pSample->size();
-			WriteString(FormattedA("%s %3d %5d %s\n",
-				CT[CT_DPCMDEF],
-				smp,
-				size,
-				(LPCSTR)ExportString(pSample->name())));
+			w.Put(CT[CT_DPCMDEF]).Put(' ').PutInt(smp, 3).Put(' ').PutInt(size, 5).Put(' ').PutString(pSample->name()).Put('\n');
 
 			for (unsigned int i=0; i < size; i += 32)
 			{
-				WriteString(FormattedA("%s :", CT[CT_DPCM]));
+				w.Put(CT[CT_DPCM]).Put(" :");
 				for (unsigned int j=0; j<32 && (i+j)<size; ++j)
-					WriteString(FormattedA(" %02X", pSample->sample_at(i + j)));
-				WriteString("\n");
+					w.Put(' ').PutHex(pSample->sample_at(i + j));
+				w.Put('\n');
 			}
 		}
 	}
-	WriteString("\n");
+	w.Put('\n');
 
-	WriteString("# Detune settings\n");		// // //
+	w.Put("# Detune settings\n");		// // //
 	for (int i = 0; i < 6; ++i) for (int j = 0; j < NOTE_COUNT; ++j) {
 		int Offset = modfile.GetDetuneOffset(i, j);
 		if (Offset != 0) {
-			WriteString(FormattedA("%s %3d %3d %3d %5d\n", CT[CT_DETUNE], i, j / NOTE_RANGE, j % NOTE_RANGE, Offset));
+			w.Put(CT[CT_DETUNE]).Put(' ').PutInt(i, 3).Put(' ').PutInt(j / NOTE_RANGE, 3).Put(' ').PutInt(j % NOTE_RANGE, 3)
+				.Put(' ').PutInt(Offset, 5).Put('\n');
 		}
 	}
-	WriteString("\n");
+	w.Put('\n');
 
-	WriteString("# Grooves\n");		// // //
+	w.Put("# Grooves\n");		// // //
 	for (int i = 0; i < MAX_GROOVE; ++i) {
 		if (const auto pGroove = modfile.GetGroove(i)) {
-			WriteString(FormattedA("%s %3d %3d :", CT[CT_GROOVE], i, pGroove->size()));
+			w.Put(CT[CT_GROOVE]).Put(' ').PutInt(i, 3).Put(' ').PutInt(pGroove->size(), 3).Put(" :");
 			for (uint8_t entry : *pGroove)
-				WriteString(FormattedA(" %d", entry));
-			WriteString("\n");
+				w.Put(' ').PutInt(entry);
+			w.Put('\n');
 		}
 	}
-	WriteString("\n");
+	w.Put('\n');
 
-	WriteString("# Tracks using default groove\n");		// // //
+	w.Put("# Tracks using default groove\n");		// // //
 	bool UsedGroove = false;
 	modfile.VisitSongs([&] (const CSongData &song) {
 		if (song.GetSongGroove())
 			UsedGroove = true;
 	});
 	if (UsedGroove) {
-		CStringA s = FormattedA("%s :", CT[CT_USEGROOVE]);
+		w.Put(CT[CT_USEGROOVE]).Put(" :");
 		modfile.VisitSongs([&] (const CSongData &song, unsigned index) {
 			if (song.GetSongGroove())
-				AppendFormatA(s, " %d", index + 1);
+				w.Put(' ').PutInt(index + 1);
 		});
-		WriteString(s);
-		WriteString("\n\n");
+		w.Put("\n\n");
 	}
 
-	WriteString("# Instruments\n");
+	w.Put("# Instruments\n");
 	for (unsigned int i=0; i<MAX_INSTRUMENTS; ++i) {
 		auto pInst = InstManager.GetInstrument(i);
 		if (!pInst) continue;
@@ -1110,14 +1246,12 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 		case INST_NONE: default:
 			continue;
 		}
-		WriteString(FormattedA("%-8s %3d   ", CTstr, i));
+		w.PutPadded(CTstr, 8).Put(' ').PutInt(i, 3).Put("   ");
 
 		if (auto seqInst = std::dynamic_pointer_cast<CSeqInstrument>(pInst)) {
 			if (seqInst->GetType() != INST_FDS) {
-				CStringA s;
 				for (auto j : enum_values<sequence_t>())
-					AppendFormatA(s, "%3d ", seqInst->GetSeqEnable(j) ? seqInst->GetSeqIndex(j) : -1);
-				WriteString(s);
+					w.PutInt(seqInst->GetSeqEnable(j) ? seqInst->GetSeqIndex(j) : -1, 3).Put(' ');
 			}
 		}
 
@@ -1126,35 +1260,31 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 		case INST_N163:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentN163>(pInst);
-				WriteString(FormattedA("%3d %3d %3d ",
-					pDI->GetWaveSize(),
-					pDI->GetWavePos(),
-					pDI->GetWaveCount()));
+				w.PutInt(pDI->GetWaveSize(), 3).Put(' ')
+					.PutInt(pDI->GetWavePos(), 3).Put(' ')
+					.PutInt(pDI->GetWaveCount(), 3).Put(' ');
 			}
 			break;
 		case INST_VRC7:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentVRC7>(pInst);
-				CStringA patch = FormattedA("%3d ", pDI->GetPatch());
+				w.PutInt(pDI->GetPatch(), 3).Put(' ');
 				for (int j = 0; j < 8; ++j)
-					AppendFormatA(patch, "%02X ", pDI->GetCustomReg(j));
-				WriteString(patch);
+					w.PutHex(pDI->GetCustomReg(j)).Put(' ');
 			}
 			break;
 		case INST_FDS:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentFDS>(pInst);
-				WriteString(FormattedA("%3d %3d %3d %3d ",
-					pDI->GetModulationEnable(),
-					pDI->GetModulationSpeed(),
-					pDI->GetModulationDepth(),
-					pDI->GetModulationDelay()));
+				w.PutInt(pDI->GetModulationEnable(), 3).Put(' ')
+					.PutInt(pDI->GetModulationSpeed(), 3).Put(' ')
+					.PutInt(pDI->GetModulationDepth(), 3).Put(' ')
+					.PutInt(pDI->GetModulationDelay(), 3).Put(' ');
 			}
 			break;
 		}
 
-		WriteString((LPCSTR)ExportString(pInst->GetName()));
-		WriteString("\n");
+		w.PutString(pInst->GetName()).Put('\n');
 
 		switch (pInst->GetType())
 		{
@@ -1164,15 +1294,15 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 				for (int n = 0; n < NOTE_COUNT; ++n) {
 					if (unsigned smp = pDI->GetSampleIndex(n); smp != CInstrument2A03::NO_DPCM) {
 						int d = pDI->GetSampleDeltaValue(n);
-						WriteString(FormattedA("%s %3d %3d %3d   %3u %3d %3d %5d %3d\n",
-							CT[CT_KEYDPCM],
-							i,
-							ft0cc::doc::oct_from_midi(n), value_cast(ft0cc::doc::pitch_from_midi(n)) - 1,
-							smp,
-							pDI->GetSamplePitch(n) & 0x0F,
-							pDI->GetSampleLoop(n) ? 1 : 0,
-							pDI->GetSampleLoopOffset(n),
-							(d >= 0 && d <= 127) ? d : -1));
+						w.Put(CT[CT_KEYDPCM])
+							.Put(' ').PutInt(i, 3)
+							.Put(' ').PutInt(ft0cc::doc::oct_from_midi(n), 3)
+							.Put(' ').PutInt(value_cast(ft0cc::doc::pitch_from_midi(n)) - 1, 3)
+							.Put("   ").PutInt(smp, 3)
+							.Put(' ').PutInt(pDI->GetSamplePitch(n) & 0x0F, 3)
+							.Put(' ').PutInt(pDI->GetSampleLoop(n) ? 1 : 0, 3)
+							.Put(' ').PutInt(pDI->GetSampleLoopOffset(n), 5)
+							.Put(' ').PutInt((d >= 0 && d <= 127) ? d : -1, 3).Put('\n');
 					}
 				}
 			}
@@ -1180,109 +1310,114 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 		case INST_N163:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentN163>(pInst);
-				for (int w=0; w < pDI->GetWaveCount(); ++w)
+				for (int wave = 0; wave < pDI->GetWaveCount(); ++wave)
 				{
-					WriteString(FormattedA("%s %3d %3d :", CT[CT_N163WAVE], i, w));
+					w.Put(CT[CT_N163WAVE]).Put(' ').PutInt(i, 3).Put(' ').PutInt(wave, 3).Put(" :");
 
-					for (int smp : pDI->GetSamples(w))		// // //
-						WriteString(FormattedA(" %d", smp));
-					WriteString("\n");
+					for (int smp : pDI->GetSamples(wave))		// // //
+						w.Put(' ').PutInt(smp);
+					w.Put('\n');
 				}
 			}
 			break;
 		case INST_FDS:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentFDS>(pInst);
-				WriteString(FormattedA("%-8s %3d :", CT[CT_FDSWAVE], i));
+				w.PutPadded(CT[CT_FDSWAVE], 8).Put(' ').PutInt(i, 3).Put(" :");
 				for (unsigned char smp : pDI->GetSamples())		// // //
-					WriteString(FormattedA(" %2d", smp));
-				WriteString("\n");
+					w.Put(' ').PutInt(smp, 2);
+				w.Put('\n');
 
-				WriteString(FormattedA("%-8s %3d :", CT[CT_FDSMOD], i));
-				for (unsigned char m : pDI->GetModTable()) {		// // //
-					WriteString(FormattedA(" %2d", m));
-				}
-				WriteString("\n");
+				w.PutPadded(CT[CT_FDSMOD], 8).Put(' ').PutInt(i, 3).Put(" :");
+				for (unsigned char m : pDI->GetModTable())		// // //
+					w.Put(' ').PutInt(m, 2);
+				w.Put('\n');
 
 				for (auto seq : enum_values<sequence_t>()) {
 					const auto pSequence = pDI->GetSequence(seq);		// // //
 					if (!pSequence || pSequence->GetItemCount() < 1)
 						continue;
 
-					WriteString(FormattedA("%-8s %3d %3d %3d %3d %3d :",
-						CT[CT_FDSMACRO],
-						i,
-						seq,
-						pSequence->GetLoopPoint(),
-						pSequence->GetReleasePoint(),
-						pSequence->GetSetting()));
+					w.PutPadded(CT[CT_FDSMACRO], 8)
+						.Put(' ').PutInt(i, 3)
+						.Put(' ').PutInt(value_cast(seq), 3)
+						.Put(' ').PutInt(pSequence->GetLoopPoint(), 3)
+						.Put(' ').PutInt(pSequence->GetReleasePoint(), 3)
+						.Put(' ').PutInt(value_cast(pSequence->GetSetting()), 3).Put(" :");
 					for (unsigned int j=0; j < pSequence->GetItemCount(); ++j)
-						WriteString(FormattedA(" %d", pSequence->GetItem(j)));
-					WriteString("\n");
+						w.Put(' ').PutInt(pSequence->GetItem(j));
+					w.Put('\n');
 				}
 			}
 			break;
 		}
 	}
-	WriteString("\n");
+	w.Put('\n');
 
-	WriteString("# Tracks\n\n");
+	w.Put("# Tracks\n\n");
 
 	const CChannelOrder &order = modfile.GetChannelOrder();		// // //
 
 	modfile.VisitSongs([&] (const CSongData &song) {
-		WriteString(FormattedA("%s %3d %3d %3d %s\n",
-			CT[CT_TRACK],
-			song.GetPatternLength(),
-			song.GetSongSpeed(),
-			song.GetSongTempo(),
-			(LPCSTR)ExportString(song.GetTitle())));
-
-		WriteString(FormattedA("%s :", CT[CT_COLUMNS]));
+		w.Put(CT[CT_TRACK])
+			.Put(' ').PutInt(song.GetPatternLength(), 3)
+			.Put(' ').PutInt(song.GetSongSpeed(), 3)
+			.Put(' ').PutInt(song.GetSongTempo(), 3)
+			.Put(' ').PutString(song.GetTitle()).Put('\n');
+
+		w.Put(CT[CT_COLUMNS]).Put(" :");
 		order.ForeachChannel([&] (stChannelID c) {
-			WriteString(FormattedA(" %d", song.GetEffectColumnCount(c)));
+			w.Put(' ').PutInt(song.GetEffectColumnCount(c));
 		});
-		WriteString("\n\n");
+		w.Put("\n\n");
 
 		for (unsigned int o=0; o < song.GetFrameCount(); ++o) {
-			WriteString(FormattedA("%s %02X :", CT[CT_ORDER], o));
+			w.Put(CT[CT_ORDER]).Put(' ').PutHex(o).Put(" :");
 			order.ForeachChannel([&] (stChannelID c) {
-				WriteString(FormattedA(" %02X", song.GetFramePattern(o, c)));
+				w.Put(' ').PutHex(song.GetFramePattern(o, c));
 			});
-			WriteString("\n");
+			w.Put('\n');
 		}
-		WriteString("\n");
+		w.Put('\n');
+
+		struct stTrackCells {		// // //
+			const CTrackData *pTrack;
+			unsigned Columns;
+			bool Noise;
+		};
+		std::vector<stTrackCells> tracks;
+		order.ForeachChannel([&] (stChannelID c) {
+			tracks.push_back({song.GetTrack(c), song.GetEffectColumnCount(c), IsAPUNoise(c)});
+		});
 
 		for (int p=0; p < MAX_PATTERN; ++p)
 		{
 			// detect and skip empty patterns
 			bool bUsed = false;
-			order.ForeachChannel([&] (stChannelID c) {
-				if (!bUsed && !song.GetPattern(c, p).IsEmpty())
+			for (const auto &x : tracks)
+				if (!x.pTrack->GetPattern(p).IsEmpty()) {
 					bUsed = true;
-			});
+					break;
+				}
 			if (!bUsed)
 				continue;
 
-			WriteString(FormattedA("%s %02X\n", CT[CT_PATTERN], p));
+			w.Put(CT[CT_PATTERN]).Put(' ').PutHex(p).Put('\n');
 
 			for (unsigned int r=0; r < song.GetPatternLength(); ++r) {
-				WriteString(FormattedA("%s %02X", CT[CT_ROW], r));
-				order.ForeachChannel([&] (stChannelID c) {
-					WriteString(" : ");
-					WriteString(ExportCellText(song.GetPattern(c, p).GetNoteOn(r), song.GetEffectColumnCount(c), IsAPUNoise(c)));		// // //
-				});
-				WriteString("\n");
+				w.Put(CT[CT_ROW]).Put(' ').PutHex(r);
+				for (const auto &x : tracks)
+					w.Put(" : ").PutCell(x.pTrack->GetPattern(p).GetNoteOn(r), x.Columns, x.Noise);		// // //
+				w.Put('\n');
 			}
-			WriteString("\n");
+			w.Put('\n');
 		}
 	});
 
 	if (N163count != -1)		// // //
 		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(modfile.GetSoundChipSet(), N163count));
-	WriteString("# End of export\n");
-	FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
-	return "";
+	w.Put("# End of export\n");
+	w.Flush();
 }
 
 // end of file
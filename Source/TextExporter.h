@@ -23,24 +23,25 @@
 
 #pragma once
 
-#include "stdafx.h"		// // //
+#include <string>		// // //
 #include <string_view>		// // //
+#include <iosfwd>		// // //
 #include "ft0cc/fs.h"		// // //
 
-class CFamiTrackerDoc; // forward declaration
 class CFamiTrackerModule;		// // //
 class stChanNote;		// // //
 
 struct CTextExport {
-	static CStringA ExportCellText(const stChanNote &stCell, unsigned int nEffects, bool bNoise);		// // //
+	static std::string ExportCellText(const stChanNote &stCell, unsigned int nEffects, bool bNoise);		// // //
 
-	void ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc);		// // //
+	// throws std::runtime_error on failure, the module should be newly created
+	void ImportFile(const fs::path &FileName, CFamiTrackerModule &modfile);		// // //
+	void ImportText(std::string_view text, CFamiTrackerModule &modfile);		// // //
 
 	// returns an empty string on success, otherwise returns a descriptive error
-	CStringA ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc);		// // //
-	CStringA ExportRows(const fs::path &FileName, const CFamiTrackerModule &modfile);		// // //
+	std::string ExportFile(const fs::path &FileName, CFamiTrackerModule &modfile);		// // //
+	std::string ExportRows(const fs::path &FileName, const CFamiTrackerModule &modfile);		// // //
 
-private:		// // //
-	static CStringA ExportString(const CStringA &s);
-	static CStringA ExportString(std::string_view s);
+	void ExportText(std::ostream &os, CFamiTrackerModule &modfile);		// // //
+	void ExportRowText(std::ostream &os, const CFamiTrackerModule &modfile);		// // //
 };
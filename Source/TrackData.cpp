@@ -51,6 +51,13 @@ unsigned CTrackData::GetEffectColumnCount() const {
 	return m_iEffectColumns;
 }
 
+stChanNote CTrackData::GetActiveNote(unsigned Frame, unsigned Row) const {		// // //
+	stChanNote Note = GetPatternOnFrame(Frame).GetNoteOn(Row);
+	for (unsigned i = GetEffectColumnCount(); i < MAX_EFFECT_COLUMNS; ++i)
+		Note.Effects[i] = { };
+	return Note;
+}
+
 void CTrackData::SetEffectColumnCount(unsigned Count) {
 	m_iEffectColumns = Count;
 }
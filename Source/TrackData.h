@@ -40,6 +40,8 @@ public:
 	unsigned GetEffectColumnCount() const;
 	void SetEffectColumnCount(unsigned Count);
 
+	stChanNote GetActiveNote(unsigned Frame, unsigned Row) const;		// // //
+
 	// void (*F)(CPatternData &pattern [, std::size_t p_index])
 	template <typename F>
 	void VisitPatterns(F f) {
@@ -71,30 +71,22 @@ void CTrackerChannel::Reset()
 
 void CTrackerChannel::SetVolumeMeter(int Value)
 {
-	std::lock_guard<std::mutex> lock {m_csNoteLock};		// // //
-
-	m_iVolumeMeter = Value;
+	m_iVolumeMeter.store(Value, std::memory_order_relaxed);		// // //
 }
 
 int CTrackerChannel::GetVolumeMeter() const
 {
-	std::lock_guard<std::mutex> lock {m_csNoteLock};		// // //
-
-	return m_iVolumeMeter;
+	return m_iVolumeMeter.load(std::memory_order_relaxed);		// // //
 }
 
 void CTrackerChannel::SetPitch(int Pitch)
 {
-	std::lock_guard<std::mutex> lock {m_csNoteLock};		// // //
-
-	m_iPitch = Pitch;
+	m_iPitch.store(Pitch, std::memory_order_relaxed);		// // //
 }
 
 int CTrackerChannel::GetPitch() const
 {
-	std::lock_guard<std::mutex> lock {m_csNoteLock};		// // //
-
-	return m_iPitch;
+	return m_iPitch.load(std::memory_order_relaxed);		// // //
 }
 
 bool IsInstrumentCompatible(sound_chip_t Chip, inst_type_t Type) {		// // //
@@ -26,6 +26,7 @@
 // CTrackerChannel
 
 #include <mutex>		// // //
+#include <atomic>		// // //
 #include "PatternNote.h"		// // //
 #include "APU/Types_fwd.h"		// // //
 
@@ -58,8 +59,8 @@ private:
 	stChanNote m_Note;
 	note_prio_t m_iNotePriority = NOTE_PRIO_0;
 
-	int m_iVolumeMeter = 0;
-	int m_iPitch = 0;
+	std::atomic<int> m_iVolumeMeter {0};		// // // latest values, written without locking
+	std::atomic<int> m_iPitch {0};		// // //
 
 	bool m_bNewNote = false;
 
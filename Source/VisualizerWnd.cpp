@@ -71,12 +71,6 @@ void CVisualizerWnd::LockedState(F f) const {		// // //
 	f();
 }
 
-template <typename F>
-void CVisualizerWnd::LockedBuffer(F f) const {		// // //
-	CSingleLock l(&m_csBufferSelect, TRUE);
-	f();
-}
-
 BEGIN_MESSAGE_MAP(CVisualizerWnd, CWnd)
 	ON_WM_ERASEBKGND()
 	ON_WM_LBUTTONDOWN()
@@ -113,15 +107,14 @@ void CVisualizerWnd::FlushSamples(array_view<int16_t> Samples)		// // //
 	if (!m_bThreadRunning)
 		return;
 
-	LockedBuffer([&] {
-		if (Samples.size() != m_pBuffer1.size()) {
-			m_pBuffer1 = std::vector<int16_t>(Samples.size());		// // //
-			m_pBuffer2 = std::vector<int16_t>(Samples.size());
-		}
-		Samples.copy(m_pBuffer1.data(), Samples.size());
-	});
-
-	SetEvent(m_hNewSamples);
+	// // // Called from the sound thread, which must not wait; drop the samples if the
+	// visualizer falls behind
+	if (auto pBlock = m_SampleBlocks.BeginWrite()) {
+		pBlock->resize(Samples.size());
+		Samples.copy(pBlock->data(), Samples.size());
+		m_SampleBlocks.EndWrite();
+		SetEvent(m_hNewSamples);
+	}
 }
 
 void CVisualizerWnd::ReportAudioProblem()
@@ -140,15 +133,20 @@ UINT CVisualizerWnd::ThreadProc()
 	while (m_bThreadRunning && ::WaitForSingleObject(m_hNewSamples, INFINITE) == WAIT_OBJECT_0) {
 		m_bNoAudio = false;
 
-		// Switch buffers
-		LockedBuffer([&] {
-			m_pBuffer1.swap(m_pBuffer2);
-		});
+		// // // Take the latest sample block, the slots keep their storage for reuse
+		bool NewSamples = false;
+		while (auto pBlock = m_SampleBlocks.BeginRead()) {
+			pBlock->swap(m_pSamples);
+			m_SampleBlocks.EndRead();
+			NewSamples = true;
+		}
+		if (!NewSamples)
+			continue;
 
 		// Draw
 		LockedState([&] {
 			if (CDC *pDC = GetDC()) {
-				m_pStates[m_iCurrentState]->SetSampleData(m_pBuffer2);
+				m_pStates[m_iCurrentState]->SetSampleData(m_pSamples);
 				m_pStates[m_iCurrentState]->Draw();
 				m_pStates[m_iCurrentState]->Display(pDC, false);
 				ReleaseDC(pDC);
@@ -28,7 +28,9 @@
 #include "stdafx.h"		// // //
 #include <memory>		// // //
 #include <vector>		// // //
+#include <atomic>		// // //
 #include "array_view.h"		// // //
+#include "SPSCRing.h"		// // //
 
 class CVisualizerBase;		// // //
 
@@ -55,14 +57,12 @@ private:
 	UINT ThreadProc();
 	template <typename F>
 	void LockedState(F f) const;
-	template <typename F>
-	void LockedBuffer(F f) const;
 
 	std::vector<std::unique_ptr<CVisualizerBase>> m_pStates;		// // //
 	unsigned int m_iCurrentState;
 
-	std::vector<int16_t> m_pBuffer1;		// // //
-	std::vector<int16_t> m_pBuffer2;
+	CSPSCRing<std::vector<int16_t>, 4> m_SampleBlocks;		// // // filled by the sound thread
+	std::vector<int16_t> m_pSamples;		// // //
 
 	HANDLE m_hNewSamples;
 
@@ -70,9 +70,8 @@ private:
 
 	// Thread
 	CWinThread *m_pWorkerThread = nullptr;
-	bool m_bThreadRunning;
+	std::atomic<bool> m_bThreadRunning;		// // //
 
-	mutable CCriticalSection m_csBufferSelect;
 	mutable CCriticalSection m_csBuffer;
 
 public:
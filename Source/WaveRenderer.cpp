@@ -38,7 +38,8 @@ void CWaveRenderer::CloseOutputStream() {
 
 void CWaveRenderer::Start() {
 	m_bStarted = true;
-	m_pWaveStream->WriteWAVHeader();
+	if (m_pWaveStream)		// // // the output may go through an audio sink instead
+		m_pWaveStream->WriteWAVHeader();
 }
 
 bool CWaveRenderer::ShouldStartPlayer() {
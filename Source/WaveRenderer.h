@@ -26,6 +26,7 @@
 #include <memory>
 #include <cstdint>
 #include <string>
+#include <atomic>		// // //
 #include "array_view.h"
 #include "WaveStream.h"
 
@@ -63,8 +64,8 @@ protected:
 
 private:
 	std::unique_ptr<COutputWaveStream> m_pWaveStream;
-	bool m_bStarted = false;
-	bool m_bFinished = false;
+	std::atomic<bool> m_bStarted {false};		// // //
+	std::atomic<bool> m_bFinished {false};		// // //
 
 	bool m_bRequestRenderStop = false;
 	bool m_bStoppingRender = false;		// // //
@@ -85,7 +86,7 @@ private:
 
 private:
 	unsigned m_iTicksToRender;
-	unsigned m_iRenderTick = 0;
+	std::atomic<unsigned> m_iRenderTick {0u};		// // // read by the progress dialog
 	double m_fFrameRate;
 };
 
@@ -100,5 +101,5 @@ private:
 
 private:
 	unsigned m_iRowsToRender;
-	unsigned m_iRenderRow = 0;
+	std::atomic<unsigned> m_iRenderRow {0u};		// // // read by the progress dialog
 };
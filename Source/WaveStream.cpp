@@ -42,11 +42,13 @@ COutputWaveStream::COutputWaveStream(std::shared_ptr<CSimpleFile> file, const CW
 	file_(std::move(file)), fmt_(fmt), start_pos_(file_->GetPosition())
 {
 	Assert(fmt.Format == CWaveFileFormat::format_code::pcm || fmt.Format == CWaveFileFormat::format_code::ieee_float);
+	buffer_.reserve(WRITE_BUFFER_SIZE + 16u);		// // //
 }
 
 COutputWaveStream::~COutputWaveStream() noexcept {
 	while (sample_count_ % fmt_.Channels)
 		WriteSample(0);
+	FlushWriteBuffer();		// // //
 
 	if (write_count_ % 2) {
 		file_->WriteInt8(0);
@@ -89,3 +91,8 @@ void COutputWaveStream::WriteWAVHeader() {
 	file_->WriteInt32(0); // to be written later
 	write_count_ += 8;
 }
+
+void COutputWaveStream::FlushWriteBuffer() {		// // //
+	file_->WriteBytes(array_view<char> {buffer_.data(), buffer_.size()});
+	buffer_.clear();
+}
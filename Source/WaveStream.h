@@ -28,6 +28,7 @@
 #include <type_traits>
 #include <algorithm>
 #include <cmath>
+#include <vector>		// // //
 #include "array_view.h"
 #include "SimpleFile.h"
 
@@ -164,6 +165,8 @@ public:
 
 		write_count_ += fmt_.BytesPerSample() * samples.size();
 		sample_count_ += samples.size();
+		if (buffer_.size() >= WRITE_BUFFER_SIZE)		// // //
+			FlushWriteBuffer();
 	}
 
 private:
@@ -186,27 +189,31 @@ private:
 			return DoWriteSample(u.i);
 		}
 		else if constexpr (std::is_integral_v<T>) {
-			if constexpr (sizeof(T) == sizeof(std::uint8_t))
-				file_->WriteInt8(x);
-			else if constexpr (sizeof(T) == sizeof(std::int16_t))
-				file_->WriteInt16(x);
-			else if constexpr (sizeof(T) == sizeof(std::int32_t))
-				file_->WriteInt32(x);
-			else {
-				auto x2 = static_cast<std::make_unsigned_t<T>>(x) >> (8 * (sizeof(T) - fmt_.BytesPerSample()));
-				for (std::size_t i = 0; i < fmt_.BytesPerSample(); ++i) {
-					file_->WriteInt8(static_cast<std::uint8_t>(x2 & 0xFFu));
-					x2 >>= 8;
-				}
+			// // // little-endian, into the write buffer
+			auto x2 = static_cast<std::make_unsigned_t<T>>(x);
+			std::size_t bytes = sizeof(T);
+			if constexpr (sizeof(T) > sizeof(std::int32_t)) {
+				bytes = fmt_.BytesPerSample();
+				x2 >>= 8 * (sizeof(T) - bytes);
+			}
+			for (std::size_t i = 0; i < bytes; ++i) {
+				buffer_.push_back(static_cast<char>(x2 & 0xFFu));
+				x2 >>= 8;
 			}
 		}
 		else
-			file_->WriteBytes(array_view<T> {&x, 1}.as_bytes());
+			for (unsigned char b : array_view<T> {&x, 1}.as_bytes())		// // //
+				buffer_.push_back(static_cast<char>(b));
 	}
 
+	void FlushWriteBuffer();		// // //
+
+	static constexpr std::size_t WRITE_BUFFER_SIZE = 0x10000u;		// // //
+
 	std::shared_ptr<CSimpleFile> file_;
 	CWaveFileFormat fmt_;
 	std::size_t start_pos_;
 	std::size_t write_count_ = 0u;
 	std::size_t sample_count_ = 0u;
+	std::vector<char> buffer_;		// // // samples not yet written to the file
 };